@@ -2,4 +2,5 @@ TEMPLATE = subdirs
 
 SUBDIRS = \
     appman-bench \
+    startup-bench \
 
@@ -0,0 +1,303 @@
+#!/bin/bash
+#############################################################################
+##
+## Copyright (C) 2019 Luxoft Sweden AB
+## Copyright (C) 2018 Pelagicore AG
+## Contact: https://www.qt.io/licensing/
+##
+## This file is part of the Qt Application Manager.
+##
+## $QT_BEGIN_LICENSE:BSD-QTAS$
+## Commercial License Usage
+## Licensees holding valid commercial Qt Automotive Suite licenses may use
+## this file in accordance with the commercial license agreement provided
+## with the Software or, alternatively, in accordance with the terms
+## contained in a written agreement between you and The Qt Company.  For
+## licensing terms and conditions see https://www.qt.io/terms-conditions.
+## For further information use the contact form at https://www.qt.io/contact-us.
+##
+## BSD License Usage
+## Alternatively, you may use this file under the terms of the BSD license
+## as follows:
+##
+## "Redistribution and use in source and binary forms, with or without
+## modification, are permitted provided that the following conditions are
+## met:
+##   * Redistributions of source code must retain the above copyright
+##     notice, this list of conditions and the following disclaimer.
+##   * Redistributions in binary form must reproduce the above copyright
+##     notice, this list of conditions and the following disclaimer in
+##     the documentation and/or other materials provided with the
+##     distribution.
+##   * Neither the name of The Qt Company Ltd nor the names of its
+##     contributors may be used to endorse or promote products derived
+##     from this software without specific prior written permission.
+##
+##
+## THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+## "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+## LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+## A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+## OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+## SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+## LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+## DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+## THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+## (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+## OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+##
+## $QT_END_LICENSE$
+##
+## SPDX-License-Identifier: BSD-3-Clause
+##
+#############################################################################
+
+
+SCRIPT=$(cd "$(dirname "$0")" && pwd)
+usage()
+{
+     echo "$0 [-n <package counts>][-i <iterations>][-p <properties>][-f <format>][-o <file>][-w] <appman-binary>"
+     echo ""
+     echo "This script benchmarks the startup of the application-manager binary provided by <appman-binary>."
+     echo "For each package count, a synthetic package tree (including intents) and config file is"
+     echo "generated and the System-UI is started headless (offscreen QPA) repeatedly. The checkpoints"
+     echo "recorded by the StartupTimer are collected and min/median/p95 values are reported per"
+     echo "checkpoint in milliseconds."
+     echo ""
+     echo "The following options are accepted:"
+     echo "-n <package counts>  : Space separated list of package counts. Default: '10 100 1000 5000'"
+     echo "-i <iterations>      : How often the System-UI is started per package count. Default: 10"
+     echo "-p <properties>      : Number of synthetic system properties in the config file. Default: 100"
+     echo "-f <format>          : Output format, either 'csv' or 'json'. Default: 'csv'"
+     echo "-o <file>            : Write the results to this file instead of stdout"
+     echo "-w                   : Keep the package database cache between runs (measures warm starts)"
+     echo ""
+     exit 1
+}
+
+
+COUNTS="10 100 1000 5000"
+ITERATIONS=10
+PROPERTIES=100
+FORMAT=csv
+OUTPUT=
+RECREATE_DATABASE=-r
+
+while getopts ":n:i:p:f:o:w" option
+do
+case "${option}"
+in
+n) COUNTS=${OPTARG};;
+i) ITERATIONS=${OPTARG};;
+p) PROPERTIES=${OPTARG};;
+f) FORMAT=${OPTARG};;
+o) OUTPUT=${OPTARG};;
+w) RECREATE_DATABASE=;;
+*) usage;;
+esac
+done
+
+[ "$#" -lt 1 ] && usage
+APPMAN=$(realpath "${@: -1}")
+[ ! -x "$APPMAN" ] && usage
+[ "$FORMAT" != "csv" ] && [ "$FORMAT" != "json" ] && usage
+
+temp_folder=$(mktemp -d)
+trap 'rm -rf "$temp_folder"' EXIT
+trap exit INT QUIT
+
+generate_packages()
+{
+    local folder="$1"
+    local count="$2"
+
+    mkdir -p "$folder/apps"
+    for (( i=1; i<=$count; i++ ))
+    do
+        local pkgid="com.example.startup.pkg$i"
+        mkdir -p "$folder/apps/$pkgid"
+        cp "$SCRIPT/templates/icon.png" "$SCRIPT/templates/main.qml" "$folder/apps/$pkgid/"
+        cat >"$folder/apps/$pkgid/info.yaml" <<EOT
+formatVersion: 1
+formatType: am-package
+---
+id: '$pkgid'
+icon: 'icon.png'
+name:
+  en: 'Startup Benchmark $i'
+  de: 'Start-Benchmark $i'
+description:
+  en: 'Synthetic package number $i'
+categories: [ 'benchmark', 'synthetic' ]
+applications:
+- id: '$pkgid.app'
+  code: 'main.qml'
+  runtime: 'qml'
+  capabilities: [ 'cameraAccess', 'locationAccess' ]
+  applicationProperties:
+    protected:
+      index: $i
+      ratio: 0.5
+- id: '$pkgid.helper'
+  code: 'main.qml'
+  runtime: 'qml'
+intents:
+- id: 'show-$i'
+  handlingApplicationId: '$pkgid.app'
+  parameterMatch:
+    mimeType: '^image/.*\$'
+- id: 'share'
+  handlingApplicationId: '$pkgid.helper'
+  visibility: 'public'
+  name:
+    en: 'Share'
+EOT
+    done
+}
+
+generate_config()
+{
+    local folder="$1"
+    local count="$2"
+
+    cat >"$folder/am-config.yaml" <<EOT
+formatVersion: 1
+formatType: am-configuration
+---
+applications:
+  builtinAppsManifestDir: "\${CONFIG_PWD}/apps"
+  installedAppsManifestDir: "\${CONFIG_PWD}/manifests"
+  appImageMountDir: "\${CONFIG_PWD}/image-mounts"
+  database: "\${CONFIG_PWD}/apps.db"
+
+logging:
+  rules:
+    - "*=false"
+    - "*.critical=true"
+
+ui:
+  fullscreen: no
+  mainQml: "\${CONFIG_PWD}/system-ui/main.qml"
+
+flags:
+  noSecurity: yes
+  noUiWatchdog: yes
+
+systemProperties:
+  public:
+    # checked by the System-UI: a package that fails to load would silently skew the results
+    expectedPackageCount: $count
+EOT
+    for (( i=1; i<=$PROPERTIES; i++ ))
+    do
+        echo "    property$i: { enabled: yes, value: $i, factor: $i.5, name: 'property $i' }" >>"$folder/am-config.yaml"
+    done
+}
+
+# Parses the StartupTimer reports given as arguments and prints one line per checkpoint and
+# sample: "<package count>\t<checkpoint>\t<msec>"
+collect_checkpoints()
+{
+    local count="$1"
+    shift
+    awk -v count="$count" '
+        /^[0-9]+\x27[0-9][0-9][0-9]\.[0-9][0-9][0-9] / {
+            split($1, t, /[\x27.]/)
+            msec = t[1] * 1000 + t[2] + t[3] / 1000
+            name = substr($0, length($1) + 2)
+            sub(/ *#*$/, "", name)
+            printf "%s\t%s\t%.3f\n", count, name, msec
+        }' "$@"
+}
+
+# Reads the output of collect_checkpoints and prints min/median/p95 statistics per package count
+# and checkpoint in the requested format, keeping the order in which the checkpoints occurred
+print_statistics()
+{
+    awk -F '\t' -v format="$FORMAT" '
+        {
+            key = $1 SUBSEP $2
+            if (!(key in n)) {
+                order[++keys] = key
+                counts[keys] = $1
+                names[keys] = $2
+            }
+            values[key, ++n[key]] = $3
+        }
+        END {
+            if (format == "csv")
+                print "packages,checkpoint,samples,min_ms,median_ms,p95_ms"
+            else
+                print "["
+            for (k = 1; k <= keys; ++k) {
+                key = order[k]
+                cnt = n[key]
+                for (i = 1; i <= cnt; ++i)
+                    v[i] = values[key, i]
+                for (i = 2; i <= cnt; ++i) { # insertion sort: the sample counts are small
+                    x = v[i]
+                    for (j = i - 1; j > 0 && v[j] > x; --j)
+                        v[j + 1] = v[j]
+                    v[j + 1] = x
+                }
+                median = (cnt % 2) ? v[(cnt + 1) / 2] : (v[cnt / 2] + v[cnt / 2 + 1]) / 2
+                p95 = int(0.95 * cnt)
+                if (p95 < 0.95 * cnt)
+                    ++p95
+                name = names[k]
+                if (format == "csv") {
+                    gsub(/"/, "\"\"", name)
+                    printf "%d,\"%s\",%d,%.3f,%.3f,%.3f\n", counts[k], name, cnt, v[1], median, v[p95]
+                } else {
+                    gsub(/\\/, "\\\\", name)
+                    gsub(/"/, "\\\"", name)
+                    printf "  { \"packages\": %d, \"checkpoint\": \"%s\", \"samples\": %d, \"min_ms\": %.3f, \"median_ms\": %.3f, \"p95_ms\": %.3f }%s\n", \
+                           counts[k], name, cnt, v[1], median, v[p95], (k < keys) ? "," : ""
+                }
+            }
+            if (format == "json")
+                print "]"
+        }'
+}
+
+run_benchmark()
+{
+    for count in $COUNTS
+    do
+        local folder="$temp_folder/$count"
+        mkdir -p "$folder"
+        cp -a "$SCRIPT/system-ui" "$folder/"
+        generate_packages "$folder" "$count"
+        generate_config "$folder" "$count"
+
+        echo "Running $ITERATIONS iterations with $count packages in $folder" >&2
+        for (( run=1; run<=$ITERATIONS; run++ ))
+        do
+            (cd "$folder" && AM_STARTUP_TIMER="$folder/report-$run.txt" QT_QPA_PLATFORM=offscreen \
+                $APPMAN -c am-config.yaml $RECREATE_DATABASE --no-dlt-logging >"$folder/log-$run.txt" 2>&1)
+            local result=$?
+            if [ $result -eq 2 ]
+            then
+                # the System-UI did not see all the generated packages: the numbers are meaningless
+                echo "Run $run with $count packages did not load all packages:" >&2
+                cat "$folder/log-$run.txt" >&2
+                exit 1
+            elif [ $result -ne 0 ]
+            then
+                echo "Run $run with $count packages failed" >&2
+                rm -f "$folder/report-$run.txt"
+            fi
+        done
+        collect_checkpoints "$count" "$folder"/report-*.txt
+        rm -rf "$folder"
+    done
+}
+
+run_benchmark >"$temp_folder/samples.txt" || exit 1
+
+if [ -n "$OUTPUT" ]
+then
+    print_statistics <"$temp_folder/samples.txt" >"$OUTPUT"
+else
+    print_statistics <"$temp_folder/samples.txt"
+fi
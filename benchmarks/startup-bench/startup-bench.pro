@@ -0,0 +1,7 @@
+TEMPLATE = aux
+
+OTHER_FILES = \
+    README \
+    run.sh \
+    system-ui/*.qml \
+    templates/* \
@@ -4,7 +4,7 @@ MODULE = appman_application
 
 load(am-config)
 
-QT = core network
+QT = core network concurrent
 QT_FOR_PRIVATE *= \
     appman_common-private \
 
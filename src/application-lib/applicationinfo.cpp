@@ -42,6 +42,7 @@
 
 #include <QDataStream>
 #include <QBuffer>
+#include <QAtomicInt>
 
 #include "applicationinfo.h"
 #include "exception.h"
@@ -53,13 +54,26 @@ QT_BEGIN_NAMESPACE_AM
 
 
 //TODO Make this really unique
-static int uniqueCounter = 0;
+// (atomic, since the PackageDatabase is scanning manifests in parallel)
+static QBasicAtomicInt uniqueCounter = Q_BASIC_ATOMIC_INITIALIZER(0);
 static int nextUniqueNumber() {
-    uniqueCounter++;
-    if (uniqueCounter > 999)
-        uniqueCounter = 0;
+    int current, next;
+    do {
+        current = uniqueCounter.loadAcquire();
+        next = (current >= 999) ? 0 : current + 1;
+    } while (!uniqueCounter.testAndSetOrdered(current, next));
 
-    return uniqueCounter;
+    return next;
+}
+
+static void updateUniqueCounter(int uniqueNumber)
+{
+    int current;
+    do {
+        current = uniqueCounter.loadAcquire();
+        if (current >= uniqueNumber)
+            return;
+    } while (!uniqueCounter.testAndSetOrdered(current, uniqueNumber));
 }
 
 ApplicationInfo::ApplicationInfo(PackageInfo *packageInfo)
@@ -103,7 +117,8 @@ void ApplicationInfo::writeToDataStream(QDataStream &ds) const
        << m_runtimeParameters
        << m_supportsApplicationInterface
        << m_capabilities
-       << m_openGLConfiguration;
+       << m_openGLConfiguration
+       << m_supportedMimeTypes;
 }
 
 ApplicationInfo *ApplicationInfo::readFromDataStream(PackageInfo *pkg, QDataStream &ds)
@@ -119,9 +134,10 @@ ApplicationInfo *ApplicationInfo::readFromDataStream(PackageInfo *pkg, QDataStre
        >> app->m_runtimeParameters
        >> app->m_supportsApplicationInterface
        >> app->m_capabilities
-       >> app->m_openGLConfiguration;
+       >> app->m_openGLConfiguration
+       >> app->m_supportedMimeTypes;
 
-    uniqueCounter = qMax(uniqueCounter, app->m_uniqueNumber);
+    updateUniqueCounter(app->m_uniqueNumber);
     app->m_capabilities.sort();
 
     return app.take();
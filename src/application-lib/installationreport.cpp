@@ -45,6 +45,7 @@
 #include <QDataStream>
 #include <QDebug>
 #include <QMessageAuthenticationCode>
+#include <QScopedPointer>
 
 #include <exception>
 
@@ -171,75 +172,81 @@ bool InstallationReport::deserialize(QIODevice *from)
     m_digest.clear();
     m_files.clear();
 
-    QtYaml::ParseError error;
-    QVector<QVariant> docs = QtYaml::variantDocumentsFromYaml(from->readAll(), &error);
+    try {
+        YamlParser p(from->readAll());
 
-    if (error.error != QJsonParseError::NoError)
-        return false;
+        auto header = p.parseHeader();
+        if ((header.first != qL1S("am-installation-report")) || (header.second != 3))
+            throw false;
 
-    try {
-        checkYamlFormat(docs, 3 /*number of expected docs*/, { "am-installation-report" }, 3 /*version*/);
-    } catch (const Exception &) {
-        return false;
-    }
+        if (!p.nextDocument())
+            throw false;
 
-    const QVariantMap &root = docs.at(1).toMap();
+        QString packageId;
+        p.parseFields({
+            { "packageId", true, YamlParser::Scalar, [&packageId](YamlParser *p) {
+                  packageId = p->parseString(); } },
+            { "diskSpaceUsed", true, YamlParser::Scalar, [this](YamlParser *p) {
+                  m_diskSpaceUsed = p->parseScalar().toULongLong(); } },
+            { "digest", true, YamlParser::Scalar, [this](YamlParser *p) {
+                  m_digest = QByteArray::fromHex(p->parseString().toLatin1());
+                  if (m_digest.isEmpty())
+                      throw false;
+              } },
+            { "developerSignature", false, YamlParser::Scalar, [this](YamlParser *p) {
+                  m_developerSignature = QByteArray::fromBase64(p->parseString().toLatin1());
+                  if (m_developerSignature.isEmpty())
+                      throw false;
+              } },
+            { "storeSignature", false, YamlParser::Scalar, [this](YamlParser *p) {
+                  m_storeSignature = QByteArray::fromBase64(p->parseString().toLatin1());
+                  if (m_storeSignature.isEmpty())
+                      throw false;
+              } },
+            { "extra", false, YamlParser::Map, [this](YamlParser *p) {
+                  m_extraMetaData = p->parseMap();
+                  if (m_extraMetaData.isEmpty())
+                      throw false;
+              } },
+            { "extraSigned", false, YamlParser::Map, [this](YamlParser *p) {
+                  m_extraSignedMetaData = p->parseMap();
+                  if (m_extraSignedMetaData.isEmpty())
+                      throw false;
+              } },
+            { "files", true, YamlParser::List, [this](YamlParser *p) {
+                  m_files = p->parseStringOrStringList();
+                  if (m_files.isEmpty())
+                      throw false;
+              } }
+        });
 
-    try {
         if (m_packageId.isEmpty()) {
-            m_packageId = root[qSL("packageId")].toString();
+            m_packageId = packageId;
             if (m_packageId.isEmpty())
                 throw false;
-        } else if (root[qSL("packageId")].toString() != m_packageId) {
+        } else if (packageId != m_packageId) {
             throw false;
         }
 
-        m_diskSpaceUsed = root[qSL("diskSpaceUsed")].toULongLong();
-        m_digest = QByteArray::fromHex(root[qSL("digest")].toString().toLatin1());
-        if (m_digest.isEmpty())
+        if (!p.nextDocument())
             throw false;
 
-        auto devSig = root.find(qSL("developerSignature"));
-        if (devSig != root.end()) {
-            m_developerSignature = QByteArray::fromBase64(devSig.value().toString().toLatin1());
-            if (m_developerSignature.isEmpty())
-                throw false;
-        }
-        auto storeSig = root.find(qSL("storeSignature"));
-        if (storeSig != root.end()) {
-            m_storeSignature = QByteArray::fromBase64(storeSig.value().toString().toLatin1());
-            if (m_storeSignature.isEmpty())
-                throw false;
-        }
-        auto extra = root.find(qSL("extra"));
-        if (extra != root.end()) {
-            m_extraMetaData = extra.value().toMap();
-            if (m_extraMetaData.isEmpty())
-                throw false;
-        }
-        auto extraSigned = root.find(qSL("extraSigned"));
-        if (extraSigned != root.end()) {
-            m_extraSignedMetaData = extraSigned.value().toMap();
-            if (m_extraSignedMetaData.isEmpty())
-                throw false;
-        }
-        m_files = root[qSL("files")].toStringList();
-        if (m_files.isEmpty())
-            throw false;
+        QByteArray hmacFile;
+        p.parseFields({
+            { "hmac", true, YamlParser::Scalar, [&hmacFile](YamlParser *p) {
+                  hmacFile = QByteArray::fromHex(p->parseString().toLatin1()); } }
+        });
 
-        // see if the file has been tampered with by checking the hmac
-        QByteArray hmacFile = QByteArray::fromHex(docs[2].toMap().value(qSL("hmac")).toString().toLatin1());
-        QByteArray hmacKey = QByteArray::fromRawData(reinterpret_cast<const char *>(privateHmacKeyData),
-                                                     sizeof(privateHmacKeyData));
-        QByteArray hmacCalc= QMessageAuthenticationCode::hash(QtYaml::yamlFromVariantDocuments({ docs[0], docs[1] }, QtYaml::BlockStyle),
-                                                              hmacKey,
-                                                              QCryptographicHash::Sha256);
+        if (p.nextDocument())
+            throw false;
 
-        if (hmacFile != hmacCalc)
+        // see if the file has been tampered with by checking the hmac: the parsed data is
+        // turned back into exactly the same documents that serialize() has been signing
+        if (hmacFile != calculateHmac())
             throw false;
 
         return true;
-    } catch (bool) {
+    } catch (...) { // both parse Exceptions and the bool
         m_digest.clear();
         m_diskSpaceUsed = 0;
         m_files.clear();
@@ -248,11 +255,8 @@ bool InstallationReport::deserialize(QIODevice *from)
     }
 }
 
-bool InstallationReport::serialize(QIODevice *to) const
+QVector<QVariant> InstallationReport::toVariantDocuments() const
 {
-    if (!isValid() || !to || !to->isWritable())
-        return false;
-
     QVariantMap header {
         { "formatVersion", 3 },
         { "formatType", "am-installation-report" }
@@ -273,18 +277,26 @@ bool InstallationReport::serialize(QIODevice *to) const
 
     root[qSL("files")] = files();
 
-    QVector<QVariant> docs;
-    docs << header;
-    docs << root;
+    return { header, root };
+}
 
-    // generate hmac to prevent tampering
+QByteArray InstallationReport::calculateHmac() const
+{
     QByteArray hmacKey = QByteArray::fromRawData(reinterpret_cast<const char *>(privateHmacKeyData),
                                                  sizeof(privateHmacKeyData));
-    QByteArray hmacCalc= QMessageAuthenticationCode::hash(QtYaml::yamlFromVariantDocuments({ docs[0], docs[1] }, QtYaml::BlockStyle),
-                                                          hmacKey,
-                                                          QCryptographicHash::Sha256);
+    return QMessageAuthenticationCode::hash(QtYaml::yamlFromVariantDocuments(toVariantDocuments(), QtYaml::BlockStyle),
+                                            hmacKey, QCryptographicHash::Sha256);
+}
 
-    QVariantMap footer { { qSL("hmac"), QString::fromLatin1(hmacCalc.toHex()) } };
+bool InstallationReport::serialize(QIODevice *to) const
+{
+    if (!isValid() || !to || !to->isWritable())
+        return false;
+
+    QVector<QVariant> docs = toVariantDocuments();
+
+    // generate hmac to prevent tampering
+    QVariantMap footer { { qSL("hmac"), QString::fromLatin1(calculateHmac().toHex()) } };
     docs << footer;
 
     QByteArray out = QtYaml::yamlFromVariantDocuments(docs, QtYaml::BlockStyle);
@@ -292,4 +304,36 @@ bool InstallationReport::serialize(QIODevice *to) const
     return (to->write(out) == out.size());
 }
 
+void InstallationReport::writeToDataStream(QDataStream &ds) const
+{
+    // no hmac needed here: this is only used for the package database cache, which in turn is
+    // only ever created from reports that passed the hmac check in deserialize()
+    ds << m_packageId
+       << m_digest
+       << m_diskSpaceUsed
+       << m_files
+       << m_developerSignature
+       << m_storeSignature
+       << m_extraMetaData
+       << m_extraSignedMetaData;
+}
+
+InstallationReport *InstallationReport::readFromDataStream(QDataStream &ds)
+{
+    QScopedPointer<InstallationReport> report(new InstallationReport);
+
+    ds >> report->m_packageId
+       >> report->m_digest
+       >> report->m_diskSpaceUsed
+       >> report->m_files
+       >> report->m_developerSignature
+       >> report->m_storeSignature
+       >> report->m_extraMetaData
+       >> report->m_extraSignedMetaData;
+
+    if ((ds.status() != QDataStream::Ok) || !report->isValid())
+        return nullptr;
+    return report.take();
+}
+
 QT_END_NAMESPACE_AM
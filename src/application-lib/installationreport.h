@@ -46,9 +46,11 @@
 #include <QStringList>
 #include <QByteArray>
 #include <QVariantMap>
+#include <QVector>
 #include <QtAppManCommon/global.h>
 
 QT_FORWARD_DECLARE_CLASS(QIODevice)
+QT_FORWARD_DECLARE_CLASS(QDataStream)
 
 QT_BEGIN_NAMESPACE_AM
 
@@ -86,7 +88,13 @@ public:
     bool deserialize(QIODevice *from);
     bool serialize(QIODevice *to) const;
 
+    void writeToDataStream(QDataStream &ds) const;
+    static InstallationReport *readFromDataStream(QDataStream &ds);
+
 private:
+    QVector<QVariant> toVariantDocuments() const;
+    QByteArray calculateHmac() const;
+
     QString m_packageId;
     QByteArray m_digest;
     quint64 m_diskSpaceUsed = 0;
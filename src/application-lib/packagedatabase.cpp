@@ -41,7 +41,15 @@
 
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QCryptographicHash>
 #include <QScopedPointer>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <limits>
 
 #include "packagedatabase.h"
 #include "packageinfo.h"
@@ -51,6 +59,9 @@
 #include "exception.h"
 #include "logging.h"
 
+// use QtConcurrent to scan the package directories, if there are more than x packages
+#define AM_PARALLEL_THRESHOLD  4
+
 QT_BEGIN_NAMESPACE_AM
 
 PackageDatabase::PackageDatabase(const QStringList &builtInPackagesDirs,
@@ -70,6 +81,18 @@ QString PackageDatabase::installedPackagesDir() const
     return m_installedPackagesDir;
 }
 
+QString PackageDatabase::cacheFilePath() const
+{
+    return m_cacheFilePath;
+}
+
+void PackageDatabase::setCacheFilePath(const QString &cacheFilePath)
+{
+    if (m_parsed)
+        qCWarning(LogSystem) << "PackageDatabase cannot change the cache file after the initial load";
+    m_cacheFilePath = cacheFilePath;
+}
+
 void PackageDatabase::enableLoadFromCache()
 {
     if (m_parsed)
@@ -84,15 +107,153 @@ void PackageDatabase::enableSaveToCache()
     m_saveToCache = true;
 }
 
+// The cache file keeps the simple QDataStream layout: magic, version and source checksum,
+// followed by the built-in and then the installed packages (manifest path + PackageInfo each).
+// All packages are decoded right away: Main and the PackageManager touch every PackageInfo
+// directly after parse(), so neither mapping the file nor decoding lazily would save anything.
+static const quint32 CacheMagicHeader = 0x7a6f3e91;
+static const quint32 CacheVersion = 1;
+
+// The cache is only valid as long as no package directory has been added, removed or modified.
+// Instead of re-parsing all the manifests, we only stat the files that we would parse and create
+// a checksum over their names, sizes and modification times.
+QByteArray PackageDatabase::sourceChecksum() const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    auto addDir = [&hash](const QString &manifestDir, bool scanningBuiltInApps) {
+        auto flags = scanningBuiltInApps ? QDir::Dirs | QDir::NoDotAndDotDot
+                                         : QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks;
+        const QDir baseDir(manifestDir);
+        const QStringList pkgDirNames = baseDir.entryList(flags, QDir::Name);
+
+        hash.addData(baseDir.absolutePath().toUtf8());
+        hash.addData(scanningBuiltInApps ? "B" : "I", 1);
+
+        for (const QString &pkgDirName : pkgDirNames) {
+            hash.addData(pkgDirName.toUtf8());
+
+            for (const QString &fileName : { qSL("info.yaml"), qSL(".installation-report.yaml") }) {
+                const QFileInfo fi(baseDir.absoluteFilePath(pkgDirName + qL1C('/') + fileName));
+                if (fi.exists()) {
+                    QByteArray stamp = QByteArray::number(fi.lastModified().toMSecsSinceEpoch())
+                            + ':' + QByteArray::number(fi.size());
+                    hash.addData(stamp);
+                } else {
+                    hash.addData("-", 1);
+                }
+            }
+        }
+    };
+
+    for (const QString &dir : m_builtInPackagesDirs)
+        addDir(dir, true);
+    if (!m_installedPackagesDir.isEmpty())
+        addDir(m_installedPackagesDir, false);
+
+    return hash.result();
+}
+
 bool PackageDatabase::loadFromCache()
 {
-    return false;
-    //TODO: read cache file
+    if (!m_singlePackagePath.isEmpty() || m_cacheFilePath.isEmpty())
+        return false;
+
+    QFile cacheFile(m_cacheFilePath);
+    if (!cacheFile.open(QFile::ReadOnly))
+        return false;
+
+    QMap<PackageInfo *, QString> builtInPackages;
+    QMap<PackageInfo *, QString> installedPackages;
+
+    try {
+        if (cacheFile.size() > std::numeric_limits<int>::max())
+            throw Exception("cache file is too big");
+
+        // one read for the whole file instead of many small buffered reads through QFile
+        const QByteArray cacheBuffer = cacheFile.readAll();
+        if (cacheBuffer.size() != cacheFile.size())
+            throw Exception(cacheFile, "failed to read the cache file");
+
+        QDataStream ds(cacheBuffer);
+        quint32 magic = 0;
+        quint32 version = 0;
+        QByteArray checksum;
+
+        ds >> magic >> version;
+        if ((magic != CacheMagicHeader) || (version != CacheVersion))
+            throw Exception("failed to read cache header");
+
+        ds >> checksum;
+        if (ds.status() != QDataStream::Ok)
+            throw Exception("failed to read cache checksum");
+        if (checksum != sourceChecksum())
+            throw Exception("the package directories have changed since the cache was written");
+
+        auto readPackages = [&ds](QMap<PackageInfo *, QString> &packages) {
+            int count = 0;
+            ds >> count;
+            for (int i = 0; (i < count) && (ds.status() == QDataStream::Ok); ++i) {
+                QString manifestPath;
+                ds >> manifestPath;
+                PackageInfo *pkg = PackageInfo::readFromDataStream(ds);
+                if (!pkg)
+                    throw Exception("failed to read package from cache");
+                packages.insert(pkg, manifestPath);
+            }
+            if (ds.status() != QDataStream::Ok)
+                throw Exception("failed to read cache content");
+        };
+
+        readPackages(builtInPackages);
+        readPackages(installedPackages);
+
+        m_builtInPackages = builtInPackages;
+        m_installedPackages = installedPackages;
+
+        qCDebug(LogSystem) << "Loaded" << (m_builtInPackages.size() + m_installedPackages.size())
+                           << "packages from the package database cache";
+        return true;
+
+    } catch (const Exception &e) {
+        qCDebug(LogSystem) << "Not using the package database cache:" << e.what();
+        qDeleteAll(builtInPackages.keys());
+        qDeleteAll(installedPackages.keys());
+        return false;
+    }
 }
 
 void PackageDatabase::saveToCache()
 {
-    //TODO: write cache file
+    if (!m_singlePackagePath.isEmpty() || m_cacheFilePath.isEmpty())
+        return;
+
+    try {
+        QDir().mkpath(QFileInfo(m_cacheFilePath).absolutePath());
+
+        QFile cacheFile(m_cacheFilePath);
+        if (!cacheFile.open(QFile::WriteOnly | QFile::Truncate))
+            throw Exception(cacheFile, "failed to open file for writing");
+
+        QDataStream ds(&cacheFile);
+        ds << CacheMagicHeader << CacheVersion << sourceChecksum();
+
+        auto writePackages = [&ds](const QMap<PackageInfo *, QString> &packages) {
+            ds << packages.size();
+            for (auto it = packages.cbegin(); it != packages.cend(); ++it) {
+                ds << it.value();
+                it.key()->writeToDataStream(ds);
+            }
+        };
+
+        writePackages(m_builtInPackages);
+        writePackages(m_installedPackages);
+
+        if (ds.status() != QDataStream::Ok)
+            throw Exception("error writing package database cache content");
+    } catch (const Exception &e) {
+        qCWarning(LogSystem) << "Failed to write the package database cache:" << e.what();
+    }
 }
 
 bool PackageDatabase::canBeRevertedToBuiltIn(PackageInfo *pi)
@@ -109,23 +270,40 @@ bool PackageDatabase::canBeRevertedToBuiltIn(PackageInfo *pi)
 
 QMap<PackageInfo *, QString> PackageDatabase::loadManifestsFromDir(YamlPackageScanner *yps, const QString &manifestDir, bool scanningBuiltInApps)
 {
-    QMap<PackageInfo *, QString> result;
-
     auto flags = scanningBuiltInApps ? QDir::Dirs | QDir::NoDotAndDotDot
                                      : QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks;
     const QDir baseDir(manifestDir);
-    const QStringList pkgDirNames = baseDir.entryList(flags);
+    const QStringList pkgDirNames = baseDir.entryList(flags, QDir::Name);
+
+    struct ScanItem
+    {
+        QString pkgDirName;
+        QString manifestPath;
+        PackageInfo *pkg = nullptr;
+        QString error;
+    };
+    QVector<ScanItem> scanItems;
+    scanItems.reserve(pkgDirNames.size());
 
     for (const QString &pkgDirName : pkgDirNames) {
-        try {
-            // ignore left-overs from the installer
-            if (pkgDirName.endsWith('+') || pkgDirName.endsWith('-'))
-                continue;
+        // ignore left-overs from the installer
+        if (pkgDirName.endsWith('+') || pkgDirName.endsWith('-'))
+            continue;
+        ScanItem item;
+        item.pkgDirName = pkgDirName;
+        scanItems << item;
+    }
+
+    // scans a single package directory - defined as lambda to be usable both via QtConcurrent
+    // and via std::for_each. Errors are only recorded here and reported in order afterwards.
+    auto scanPackageDir = [this, yps, &baseDir, scanningBuiltInApps](ScanItem &item) {
+        const QString &pkgDirName = item.pkgDirName;
 
+        try {
             // ignore filesystem problems
             QDir pkgDir = baseDir.absoluteFilePath(pkgDirName);
             if (!pkgDir.exists())
-                continue;
+                return;
 
             // ignore directory names with weird/forbidden characters
             QString pkgIdError;
@@ -158,9 +336,46 @@ QMap<PackageInfo *, QString> PackageDatabase::loadManifestsFromDir(YamlPackageSc
                 pkg->setInstallationReport(report.take());
                 pkg->setBaseDir(QDir(m_installedPackagesDir).filePath(pkg->id()));
             }
-            result.insert(pkg.take(), manifestPath);
+            item.manifestPath = manifestPath;
+            item.pkg = pkg.take();
         } catch (const Exception &e) {
-            qCDebug(LogSystem) << "Ignoring package" << pkgDirName << ":" << e.what();
+            item.error = e.errorString();
+        }
+    };
+
+    if (scanItems.size() > AM_PARALLEL_THRESHOLD)
+        QtConcurrent::blockingMap(scanItems, scanPackageDir);
+    else
+        std::for_each(scanItems.begin(), scanItems.end(), scanPackageDir);
+
+    // merge the results in manifest path order, so that the outcome does not depend on the
+    // scheduling (failed items have no manifest path and sort first - they only log an error)
+    std::sort(scanItems.begin(), scanItems.end(), [](const ScanItem &a, const ScanItem &b) {
+        return a.manifestPath < b.manifestPath;
+    });
+
+    // The ApplicationInfo constructor hands out the unique numbers, so with a parallel scan their
+    // order is random: re-distribute the very same numbers in manifest path order.
+    QVector<int> uniqueNumbers;
+    for (const ScanItem &item : qAsConst(scanItems)) {
+        if (item.pkg) {
+            const auto apps = item.pkg->applications();
+            for (const ApplicationInfo *app : apps)
+                uniqueNumbers << app->m_uniqueNumber;
+        }
+    }
+    std::sort(uniqueNumbers.begin(), uniqueNumbers.end());
+
+    QMap<PackageInfo *, QString> result;
+    int uniqueNumberIndex = 0;
+    for (const ScanItem &item : qAsConst(scanItems)) {
+        if (item.pkg) {
+            const auto apps = item.pkg->applications();
+            for (ApplicationInfo *app : apps)
+                app->m_uniqueNumber = uniqueNumbers.at(uniqueNumberIndex++);
+            result.insert(item.pkg, item.manifestPath);
+        } else if (!item.error.isEmpty()) {
+            qCDebug(LogSystem) << "Ignoring package" << item.pkgDirName << ":" << item.error;
         }
     }
     return result;
@@ -184,8 +399,10 @@ void PackageDatabase::parse()
     m_parsed = true;
 
     if (m_loadFromCache) {
-        if (loadFromCache())
+        if (loadFromCache()) {
+            m_loadedFromCache = true;
             return;
+        }
     }
 
     YamlPackageScanner yps;
@@ -208,14 +425,19 @@ void PackageDatabase::parse()
         saveToCache();
 }
 
+bool PackageDatabase::isLoadedFromCache() const
+{
+    return m_loadedFromCache;
+}
+
 QVector<PackageInfo *> PackageDatabase::installedPackages() const
 {
-    return m_installedPackages.keys().toVector();
+    return sortedByManifestPath(m_installedPackages);
 }
 
 QVector<PackageInfo *> PackageDatabase::builtInPackages() const
 {
-    return m_builtInPackages.keys().toVector();
+    return sortedByManifestPath(m_builtInPackages);
 }
 
 QT_END_NAMESPACE_AM
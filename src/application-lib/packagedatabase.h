@@ -61,10 +61,13 @@ public:
 
     QString installedPackagesDir() const;
 
+    QString cacheFilePath() const;
+    void setCacheFilePath(const QString &cacheFilePath);
     void enableLoadFromCache();
     void enableSaveToCache();
 
     void parse();
+    bool isLoadedFromCache() const;
 
     QVector<PackageInfo *> builtInPackages() const;
     QVector<PackageInfo *> installedPackages() const;
@@ -80,13 +83,16 @@ private:
 
     bool loadFromCache();
     void saveToCache();
+    QByteArray sourceChecksum() const;
 
     bool m_loadFromCache = false;
     bool m_saveToCache = false;
     bool m_parsed = false;
+    bool m_loadedFromCache = false;
     QStringList m_builtInPackagesDirs;
     QString m_installedPackagesDir;
     QString m_singlePackagePath;
+    QString m_cacheFilePath;
 
     QMap<PackageInfo *, QString> m_builtInPackages;
     QMap<PackageInfo *, QString> m_installedPackages;
@@ -40,7 +40,6 @@
 ****************************************************************************/
 
 #include <QDataStream>
-#include <QBuffer>
 
 #include "packageinfo.h"
 #include "applicationinfo.h"
@@ -162,14 +161,6 @@ void PackageInfo::setInstallationReport(InstallationReport *report)
 
 void PackageInfo::writeToDataStream(QDataStream &ds) const
 {
-    QByteArray serializedReport;
-
-    if (auto report = installationReport()) {
-        QBuffer buffer(&serializedReport);
-        buffer.open(QBuffer::WriteOnly);
-        report->serialize(&buffer);
-    }
-
     ds << m_id
        << m_name
        << m_icon
@@ -179,8 +170,12 @@ void PackageInfo::writeToDataStream(QDataStream &ds) const
        << m_builtIn
        << m_uid
        << m_dltConfiguration
-       << m_baseDir.absolutePath()
-       << serializedReport;
+       << m_baseDir.absolutePath();
+
+    const InstallationReport *report = installationReport();
+    ds << bool(report);
+    if (report)
+        report->writeToDataStream(ds);
 
     ds << m_applications.size();
     for (const auto &app : m_applications)
@@ -196,7 +191,7 @@ PackageInfo *PackageInfo::readFromDataStream(QDataStream &ds)
     QScopedPointer<PackageInfo> pkg(new PackageInfo);
 
     QString baseDir;
-    QByteArray installationReport;
+    bool hasInstallationReport = false;
 
     ds >> pkg->m_id
        >> pkg->m_name
@@ -208,18 +203,28 @@ PackageInfo *PackageInfo::readFromDataStream(QDataStream &ds)
        >> pkg->m_uid
        >> pkg->m_dltConfiguration
        >> baseDir
-       >> installationReport;
+       >> hasInstallationReport;
 
     pkg->m_baseDir.setPath(baseDir);
 
-    if (!installationReport.isEmpty()) {
-        QBuffer buffer(&installationReport);
-        buffer.open(QBuffer::ReadOnly);
-        pkg->m_installationReport.reset(new InstallationReport(pkg->id()));
-        if (!pkg->m_installationReport->deserialize(&buffer))
-            pkg->m_installationReport.reset();
-    }
+    if (hasInstallationReport)
+        pkg->m_installationReport.reset(InstallationReport::readFromDataStream(ds));
+
+    int applicationsSize = 0;
+    ds >> applicationsSize;
+    for (int i = 0; (i < applicationsSize) && (ds.status() == QDataStream::Ok); ++i)
+        pkg->m_applications << ApplicationInfo::readFromDataStream(pkg.data(), ds);
 
+    int intentsSize = 0;
+    ds >> intentsSize;
+    for (int i = 0; (i < intentsSize) && (ds.status() == QDataStream::Ok); ++i)
+        pkg->m_intents << IntentInfo::readFromDataStream(pkg.data(), ds);
+
+    if (ds.status() != QDataStream::Ok) {
+        qDeleteAll(pkg->m_applications);
+        qDeleteAll(pkg->m_intents);
+        return nullptr;
+    }
     return pkg.take();
 }
 
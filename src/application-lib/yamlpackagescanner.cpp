@@ -40,10 +40,6 @@
 **
 ****************************************************************************/
 
-#include <QJsonDocument>
-#include <QJsonParseError>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QFile>
 #include <QFileInfo>
 #include <QScopedPointer>
@@ -58,8 +54,6 @@
 #include "yamlpackagescanner.h"
 #include "utilities.h"
 
-using Fields = std::vector<std::tuple<QByteArray, bool, const std::function<void(const QVariant &value)>>>;
-
 QT_BEGIN_NAMESPACE_AM
 
 
@@ -68,154 +62,146 @@ YamlPackageScanner::YamlPackageScanner()
 
 PackageInfo *YamlPackageScanner::scan(const QString &filePath) Q_DECL_NOEXCEPT_EXPR(false)
 {
-    auto parseMap = [](const QVariantMap &map, const Fields &fields) {
-        QStringList keys = map.keys();
-
-        for (const auto &field : fields) {
-            QString fieldName = qL1S(std::get<0>(field));
-
-            auto it = map.constFind(fieldName);
-            if (it != map.cend()) {
-                std::get<2>(field)(it.value());
-            } else if (std::get<1>(field)) { // missing, but required
-                throw Exception("required field missing in YAML: %1").arg(fieldName);
-            }
-            keys.removeOne(fieldName);
-        }
-        if (!keys.isEmpty())
-            throw Exception("unsupported fields found in YAML: %1").arg(keys.join(qSL(", ")));
-    };
-
-
     try {
         QFile f(filePath);
         if (!f.open(QIODevice::ReadOnly))
             throw Exception(f, "could not open file for reading");
 
-        QtYaml::ParseError parseError;
-        QVector<QVariant> docs = QtYaml::variantDocumentsFromYaml(f.readAll(), &parseError);
-
-        if (parseError.error != QJsonParseError::NoError) {
-            throw Exception(Error::IO, "YAML parse error at line %1, column %2: %3")
-                    .arg(parseError.line).arg(parseError.column).arg(parseError.errorString());
-        }
+        YamlParser p(f.readAll(), filePath);
 
         bool legacy = false;
         try {
-            checkYamlFormat(docs, 2 /*number of expected docs*/, { "am-package" }, 1);
-        } catch (const Exception &e) {
-            try {
-                checkYamlFormat(docs, 2 /*number of expected docs*/, { "am-application" }, 1);
-                qCDebug(LogSystem) << "Manifest file" << f.fileName() << "is still using the legacy 'am-application' format";
+            auto header = p.parseHeader();
+            if (header.first == qL1S("am-application")) {
                 legacy = true;
-            } catch (const Exception &) {
-                throw Exception(Error::Parse, "not a valid YAML application meta-data file: %1").arg(e.errorString());
+            } else if (header.first != qL1S("am-package")) {
+                throw Exception("wrong formatType header: expected 'am-package', got '%1'")
+                        .arg(header.first);
+            }
+            if (header.second != 1) {
+                throw Exception("wrong formatVersion header: expected 1, got %1")
+                        .arg(header.second);
             }
+            if (legacy)
+                qCDebug(LogSystem) << "Manifest file" << f.fileName() << "is still using the legacy 'am-application' format";
+        } catch (const Exception &e) {
+            throw Exception(Error::Parse, "not a valid YAML application meta-data file: %1").arg(e.errorString());
         }
 
+        if (!p.nextDocument())
+            throw Exception(Error::Parse, "not a valid YAML application meta-data file: wrong number of YAML documents: expected 2, got 1");
+
         QStringList appIds; // duplicate check
         QScopedPointer<PackageInfo> pkgInfo(new PackageInfo);
         pkgInfo->setBaseDir(QFileInfo(f).absoluteDir());
 
         QScopedPointer<ApplicationInfo> legacyAppInfo(legacy ? new ApplicationInfo(pkgInfo.data()) : nullptr);
 
+        // intents can be listed before the applications in the YAML stream, so the
+        // handlingApplicationId can only be checked after the whole document has been parsed
+        QVector<QPair<IntentInfo *, QString>> intentHandlers;
+
+        auto parseStringMap = [](YamlParser *p, QMap<QString, QString> &result) {
+            const QVariantMap map = p->parseMap();
+            for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+                result.insert(it.key(), it.value().toString());
+        };
+
+        auto parseOpenGL = [](YamlParser *p, QVariantMap &openGLConfiguration) {
+            p->parseFields({
+                { "desktopProfile", false, YamlParser::Scalar, [&openGLConfiguration](YamlParser *p) {
+                      openGLConfiguration.insert(qSL("desktopProfile"), p->parseScalar()); } },
+                { "esMajorVersion", false, YamlParser::Scalar, [&openGLConfiguration](YamlParser *p) {
+                      openGLConfiguration.insert(qSL("esMajorVersion"), p->parseScalar()); } },
+                { "esMinorVersion", false, YamlParser::Scalar, [&openGLConfiguration](YamlParser *p) {
+                      openGLConfiguration.insert(qSL("esMinorVersion"), p->parseScalar()); } }
+            });
+        };
+
+        auto parseApplicationProperties = [](YamlParser *p, ApplicationInfo *appInfo) {
+            const QVariantMap rawMap = p->parseMap();
+            appInfo->m_sysAppProperties = rawMap.value(qSL("protected")).toMap();
+            appInfo->m_allAppProperties = appInfo->m_sysAppProperties;
+            const QVariantMap pri = rawMap.value(qSL("private")).toMap();
+            for (auto it = pri.cbegin(); it != pri.cend(); ++it)
+                appInfo->m_allAppProperties.insert(it.key(), it.value());
+        };
+
         // ----------------- package -----------------
 
-        Fields fields;
-        fields.emplace_back("id", true, [&pkgInfo, &legacyAppInfo](const QVariant &v) {
-            QString id = v.toString();
+        YamlParser::Fields fields;
+        fields.emplace_back("id", true, YamlParser::Scalar, [&pkgInfo, &legacyAppInfo, &appIds](YamlParser *p) {
+            QString id = p->parseString();
             if (id.isEmpty())
                 throw Exception(Error::Parse, "packages need to have an id");
             pkgInfo->m_id = id;
-            if (legacyAppInfo)
+            if (legacyAppInfo) {
                 legacyAppInfo->m_id = pkgInfo->id();
+                appIds << pkgInfo->id();
+            }
         });
-        fields.emplace_back("icon", true, [&pkgInfo](const QVariant &v) {
-            pkgInfo->m_icon = v.toString();
+        fields.emplace_back("icon", true, YamlParser::Scalar, [&pkgInfo](YamlParser *p) {
+            pkgInfo->m_icon = p->parseString();
         });
-        fields.emplace_back("name", true, [&pkgInfo](const QVariant &v) {
-            auto nameMap = v.toMap();
-            for (auto it = nameMap.constBegin(); it != nameMap.constEnd(); ++it)
-                pkgInfo->m_name.insert(it.key(), it.value().toString());
+        fields.emplace_back("name", true, YamlParser::Map, [&pkgInfo, &parseStringMap](YamlParser *p) {
+            parseStringMap(p, pkgInfo->m_name);
 
             if (pkgInfo->m_name.isEmpty())
                 throw Exception(Error::Parse, "the 'name' field must not be empty");
         });
         if (!legacy) {
-            fields.emplace_back("description", false, [&pkgInfo](const QVariant &v) {
-                auto descriptionMap = v.toMap();
-                for (auto it = descriptionMap.constBegin(); it != descriptionMap.constEnd(); ++it)
-                    pkgInfo->m_description.insert(it.key(), it.value().toString());
+            fields.emplace_back("description", false, YamlParser::Map, [&pkgInfo, &parseStringMap](YamlParser *p) {
+                parseStringMap(p, pkgInfo->m_description);
             });
         }
-        fields.emplace_back("categories", false, [&pkgInfo](const QVariant &v) {
-            pkgInfo->m_categories = variantToStringList(v);
+        fields.emplace_back("categories", false, YamlParser::Scalar | YamlParser::List, [&pkgInfo](YamlParser *p) {
+            pkgInfo->m_categories = p->parseStringOrStringList();
             pkgInfo->m_categories.sort();
         });
-        fields.emplace_back("version", false, [&pkgInfo](const QVariant &v) {
-            pkgInfo->m_version = v.toString();
+        fields.emplace_back("version", false, YamlParser::Scalar, [&pkgInfo](YamlParser *p) {
+            pkgInfo->m_version = p->parseString();
         });
-        fields.emplace_back("logging", false, [&pkgInfo](const QVariant &v) {
-            const QVariantMap logging = v.toMap();
-            if (!logging.isEmpty()) {
-                if (logging.size() > 1 || logging.firstKey() != qSL("dlt"))
-                    throw Exception(Error::Parse, "'logging' only supports the 'dlt' key");
-                pkgInfo->m_dltConfiguration = logging.value(qSL("dlt")).toMap();
-
-                // sanity check
-                for (auto it = pkgInfo->m_dltConfiguration.cbegin(); it != pkgInfo->m_dltConfiguration.cend(); ++it) {
-                    if (it.key() != qSL("id") && it.key() != qSL("description"))
-                        throw Exception(Error::Parse, "unsupported key in 'logging/dlt'");
-                }
-            }
+        fields.emplace_back("logging", false, YamlParser::Map, [&pkgInfo](YamlParser *p) {
+            p->parseFields({
+                { "dlt", false, YamlParser::Map, [&pkgInfo](YamlParser *p) {
+                      p->parseFields({
+                          { "id", false, YamlParser::Scalar, [&pkgInfo](YamlParser *p) {
+                                pkgInfo->m_dltConfiguration.insert(qSL("id"), p->parseString()); } },
+                          { "description", false, YamlParser::Scalar, [&pkgInfo](YamlParser *p) {
+                                pkgInfo->m_dltConfiguration.insert(qSL("description"), p->parseString()); } }
+                      });
+                  } }
+            });
         });
         if (legacy) {
-            fields.emplace_back("code", true, [&legacyAppInfo](const QVariant &v) {
-                legacyAppInfo->m_codeFilePath = v.toString();
+            fields.emplace_back("code", true, YamlParser::Scalar, [&legacyAppInfo](YamlParser *p) {
+                legacyAppInfo->m_codeFilePath = p->parseString();
             });
-            fields.emplace_back("runtime", true, [&legacyAppInfo](const QVariant &v) {
-                legacyAppInfo->m_runtimeName = v.toString();
+            fields.emplace_back("runtime", true, YamlParser::Scalar, [&legacyAppInfo](YamlParser *p) {
+                legacyAppInfo->m_runtimeName = p->parseString();
             });
-            fields.emplace_back("runtimeParameters", false, [&legacyAppInfo](const QVariant &v) {
-                legacyAppInfo->m_runtimeParameters = v.toMap();
+            fields.emplace_back("runtimeParameters", false, YamlParser::Map, [&legacyAppInfo](YamlParser *p) {
+                legacyAppInfo->m_runtimeParameters = p->parseMap();
             });
-            fields.emplace_back("supportsApplicationInterface", false, [&legacyAppInfo](const QVariant &v) {
-                legacyAppInfo->m_supportsApplicationInterface = v.toBool();
+            fields.emplace_back("supportsApplicationInterface", false, YamlParser::Scalar, [&legacyAppInfo](YamlParser *p) {
+                legacyAppInfo->m_supportsApplicationInterface = p->parseScalar().toBool();
             });
-            fields.emplace_back("capabilities", false, [&legacyAppInfo](const QVariant &v) {
-                legacyAppInfo->m_capabilities = variantToStringList(v);
+            fields.emplace_back("capabilities", false, YamlParser::Scalar | YamlParser::List, [&legacyAppInfo](YamlParser *p) {
+                legacyAppInfo->m_capabilities = p->parseStringOrStringList();
                 legacyAppInfo->m_capabilities.sort();
             });
-            fields.emplace_back("opengl", false, [&legacyAppInfo](const QVariant &v) {
-                legacyAppInfo->m_openGLConfiguration = v.toMap();
-
-                // sanity check - could be rewritten using the "fields" mechanism
-                static QStringList validKeys = {
-                    qSL("desktopProfile"),
-                    qSL("esMajorVersion"),
-                    qSL("esMinorVersion")
-                };
-                for (auto it = legacyAppInfo->m_openGLConfiguration.cbegin();
-                     it != legacyAppInfo->m_openGLConfiguration.cend(); ++it) {
-                    if (!validKeys.contains(it.key())) {
-                        throw Exception(Error::Parse, "the 'opengl' object contains the unsupported key '%1'")
-                                .arg(it.key());
-                    }
-                }
+            fields.emplace_back("opengl", false, YamlParser::Map, [&legacyAppInfo, &parseOpenGL](YamlParser *p) {
+                parseOpenGL(p, legacyAppInfo->m_openGLConfiguration);
             });
-            fields.emplace_back("applicationProperties", false, [&legacyAppInfo](const QVariant &v) {
-                const QVariantMap rawMap = v.toMap();
-                legacyAppInfo->m_sysAppProperties = rawMap.value(qSL("protected")).toMap();
-                legacyAppInfo->m_allAppProperties = legacyAppInfo->m_sysAppProperties;
-                const QVariantMap pri = rawMap.value(qSL("private")).toMap();
-                for (auto it = pri.cbegin(); it != pri.cend(); ++it)
-                    legacyAppInfo->m_allAppProperties.insert(it.key(), it.value());
+            fields.emplace_back("applicationProperties", false, YamlParser::Map, [&legacyAppInfo, &parseApplicationProperties](YamlParser *p) {
+                parseApplicationProperties(p, legacyAppInfo.data());
             });
-            fields.emplace_back("documentUrl", false, [](const QVariant &) {
+            fields.emplace_back("documentUrl", false, YamlParser::Scalar, [](YamlParser *p) {
                 qCDebug(LogSystem) << " ignoring 'documentUrl'";
+                (void) p->parseScalar();
             });
-            fields.emplace_back("mimeTypes", false, [&legacyAppInfo](const QVariant &v) {
-                legacyAppInfo->m_supportedMimeTypes = variantToStringList(v);
+            fields.emplace_back("mimeTypes", false, YamlParser::Scalar | YamlParser::List, [&legacyAppInfo](YamlParser *p) {
+                legacyAppInfo->m_supportedMimeTypes = p->parseStringOrStringList();
                 legacyAppInfo->m_supportedMimeTypes.sort();
             });
         }
@@ -223,149 +209,127 @@ PackageInfo *YamlPackageScanner::scan(const QString &filePath) Q_DECL_NOEXCEPT_E
         // ----------------- applications -----------------
 
         if (!legacy) {
-            fields.emplace_back("applications", true, [&pkgInfo, &appIds, &parseMap](const QVariant &v) {
-                QVariantList apps = v.toList();
-
-                for (auto appsIt = apps.constBegin(); appsIt != apps.constEnd(); ++appsIt) {
+            fields.emplace_back("applications", true, YamlParser::List, [&pkgInfo, &appIds, &parseOpenGL, &parseApplicationProperties](YamlParser *p) {
+                p->parseList([&pkgInfo, &appIds, &parseOpenGL, &parseApplicationProperties](YamlParser *p) {
                     QScopedPointer<ApplicationInfo> appInfo(new ApplicationInfo(pkgInfo.data()));
-                    Fields appFields;
-
-                    appFields.emplace_back("id", true, [&appInfo, &appIds](const QVariant &v) {
-                        QString id = v.toString();
-                        if (id.isEmpty())
-                            throw Exception(Error::Intents, "applications need to have an id");
-                        if (appIds.contains(id))
-                            throw Exception(Error::Intents, "found two applications with id %1").arg(id);
-                        appInfo->m_id = id;
-                    });
-                    appFields.emplace_back("code", true, [&appInfo](const QVariant &v) {
-                        appInfo->m_codeFilePath = v.toString();
-                    });
-                    appFields.emplace_back("runtime", true, [&appInfo](const QVariant &v) {
-                        appInfo->m_runtimeName = v.toString();
-                    });
-                    appFields.emplace_back("runtimeParameters", false, [&appInfo](const QVariant &v) {
-                        appInfo->m_runtimeParameters = v.toMap();
-                    });
-                    appFields.emplace_back("supportsApplicationInterface", false, [&appInfo](const QVariant &v) {
-                        appInfo->m_supportsApplicationInterface = v.toBool();
-                    });
-                    appFields.emplace_back("capabilities", false, [&appInfo](const QVariant &v) {
-                        appInfo->m_capabilities = variantToStringList(v);
-                        appInfo->m_capabilities.sort();
-                    });
-                    appFields.emplace_back("opengl", false, [&appInfo](const QVariant &v) {
-                        appInfo->m_openGLConfiguration = v.toMap();
-
-                        // sanity check - could be rewritten using the "fields" mechanism
-                        static QStringList validKeys = {
-                            qSL("desktopProfile"),
-                            qSL("esMajorVersion"),
-                            qSL("esMinorVersion")
-                        };
-                        for (auto it = appInfo->m_openGLConfiguration.cbegin();
-                             it != appInfo->m_openGLConfiguration.cend(); ++it) {
-                            if (!validKeys.contains(it.key())) {
-                                throw Exception(Error::Parse, "the 'opengl' object contains the unsupported key '%1'")
-                                        .arg(it.key());
-                            }
-                        }
-                    });
-                    appFields.emplace_back("applicationProperties", false, [&appInfo](const QVariant &v) {
-                        const QVariantMap rawMap = v.toMap();
-                        appInfo->m_sysAppProperties = rawMap.value(qSL("protected")).toMap();
-                        appInfo->m_allAppProperties = appInfo->m_sysAppProperties;
-                        const QVariantMap pri = rawMap.value(qSL("private")).toMap();
-                        for (auto it = pri.cbegin(); it != pri.cend(); ++it)
-                            appInfo->m_allAppProperties.insert(it.key(), it.value());
+
+                    p->parseFields({
+                        { "id", true, YamlParser::Scalar, [&appInfo, &appIds](YamlParser *p) {
+                              QString id = p->parseString();
+                              if (id.isEmpty())
+                                  throw Exception(Error::Intents, "applications need to have an id");
+                              if (appIds.contains(id))
+                                  throw Exception(Error::Intents, "found two applications with id %1").arg(id);
+                              appInfo->m_id = id;
+                              appIds << id;
+                          } },
+                        { "code", true, YamlParser::Scalar, [&appInfo](YamlParser *p) {
+                              appInfo->m_codeFilePath = p->parseString(); } },
+                        { "runtime", true, YamlParser::Scalar, [&appInfo](YamlParser *p) {
+                              appInfo->m_runtimeName = p->parseString(); } },
+                        { "runtimeParameters", false, YamlParser::Map, [&appInfo](YamlParser *p) {
+                              appInfo->m_runtimeParameters = p->parseMap(); } },
+                        { "supportsApplicationInterface", false, YamlParser::Scalar, [&appInfo](YamlParser *p) {
+                              appInfo->m_supportsApplicationInterface = p->parseScalar().toBool(); } },
+                        { "capabilities", false, YamlParser::Scalar | YamlParser::List, [&appInfo](YamlParser *p) {
+                              appInfo->m_capabilities = p->parseStringOrStringList();
+                              appInfo->m_capabilities.sort();
+                          } },
+                        { "opengl", false, YamlParser::Map, [&appInfo, &parseOpenGL](YamlParser *p) {
+                              parseOpenGL(p, appInfo->m_openGLConfiguration); } },
+                        { "applicationProperties", false, YamlParser::Map, [&appInfo, &parseApplicationProperties](YamlParser *p) {
+                              parseApplicationProperties(p, appInfo.data()); } }
                     });
 
-                    parseMap(appsIt->toMap(), appFields);
                     pkgInfo->m_applications << appInfo.take();
-                }
+                });
             });
         }
 
         // ----------------- intents -----------------
 
-        fields.emplace_back("intents", false, [&pkgInfo, &parseMap, &appIds, legacy](const QVariant &v) {
-            QVariantList intents = v.toList();
+        fields.emplace_back("intents", false, YamlParser::List, [&pkgInfo, &intentHandlers, &parseStringMap, legacy](YamlParser *p) {
             QStringList intentIds; // duplicate check
 
-            for (auto intentsIt = intents.constBegin(); intentsIt != intents.constEnd(); ++intentsIt) {
+            p->parseList([&pkgInfo, &intentHandlers, &intentIds, &parseStringMap, legacy](YamlParser *p) {
                 QScopedPointer<IntentInfo> intentInfo(new IntentInfo(pkgInfo.data()));
-                Fields intentFields;
-
-                intentFields.emplace_back("id", true, [&intentInfo, &intentIds, &pkgInfo](const QVariant &v) {
-                    QString id = v.toString();
-                    if (id.isEmpty())
-                        throw Exception(Error::Intents, "intents need to have an id (package %1)").arg(pkgInfo->id());
-                    if (intentIds.contains(id))
-                        throw Exception(Error::Intents, "found two intent handlers for intent %2 (package %1)").arg(pkgInfo->id()).arg(id);
-                    intentInfo->m_id = id;
-                });
-                intentFields.emplace_back("visibility", false, [&intentInfo](const QVariant &v) {
-                    const QString visibilityStr = v.toString();
-                    if (visibilityStr == qL1S("private")) {
-                        intentInfo->m_visibility = IntentInfo::Private;
-                    } else if (visibilityStr != qL1S("public")) {
-                        throw Exception(Error::Intents, "intent visibilty '%2' is invalid on intent %1 (valid values are either 'public' or 'private'")
-                                .arg(intentInfo->m_id).arg(visibilityStr);
-                    }
-                });
-                intentFields.emplace_back(legacy ? "handledBy" : "handlingApplicationId", legacy ? false : true, [&pkgInfo, &intentInfo, &appIds](const QVariant &v) {
-                    QString appId = v.toString();
-
-                    if (appId.isEmpty()) {
-                        if (pkgInfo->m_applications.count() == 1) {
-                            intentInfo->m_handlingApplicationId = pkgInfo->m_applications.constFirst()->id();
-                        } else {
-                            throw Exception(Error::Intents, "a 'handlingApplicationId' field on intent %1 is needed if more than one application is defined")
-                                    .arg(intentInfo->m_id);
-                        }
-                    } else {
-                        if (appIds.contains(appId)) {
-                            intentInfo->m_handlingApplicationId = appId;
-                        } else {
-                            throw Exception(Error::Intents, "the 'handlingApplicationId' field on intent %1 points to the unknown application id %2")
-                                    .arg(intentInfo->m_id).arg(appId);
-                        }
-                    }
-                });
-                intentFields.emplace_back("requiredCapabilities", false, [&intentInfo](const QVariant &v) {
-                    intentInfo->m_requiredCapabilities = variantToStringList(v);
-                });
-                intentFields.emplace_back("parameterMatch", false, [&intentInfo](const QVariant &v) {
-                    intentInfo->m_parameterMatch = v.toMap();
-                });
-                intentFields.emplace_back("icon", false, [&intentInfo](const QVariant &v) {
-                    intentInfo->m_icon = v.toString();
-                });
-                intentFields.emplace_back("name", false, [&intentInfo](const QVariant &v) {
-                    auto nameMap = v.toMap();
-                    for (auto it = nameMap.constBegin(); it != nameMap.constEnd(); ++it)
-                        intentInfo->m_name.insert(it.key(), it.value().toString());
-                });
-                intentFields.emplace_back("description", false, [&intentInfo](const QVariant &v) {
-                    auto descriptionMap = v.toMap();
-                    for (auto it = descriptionMap.constBegin(); it != descriptionMap.constEnd(); ++it)
-                        intentInfo->m_description.insert(it.key(), it.value().toString());
-                });
-                intentFields.emplace_back("categories", false, [&intentInfo](const QVariant &v) {
-                    intentInfo->m_categories = variantToStringList(v);
-                    intentInfo->m_categories.sort();
+                bool hasHandler = false;
+                QString handlerId;
+
+                p->parseFields({
+                    { "id", true, YamlParser::Scalar, [&intentInfo, &intentIds, &pkgInfo](YamlParser *p) {
+                          QString id = p->parseString();
+                          if (id.isEmpty())
+                              throw Exception(Error::Intents, "intents need to have an id (package %1)").arg(pkgInfo->id());
+                          if (intentIds.contains(id))
+                              throw Exception(Error::Intents, "found two intent handlers for intent %2 (package %1)").arg(pkgInfo->id()).arg(id);
+                          intentInfo->m_id = id;
+                          intentIds << id;
+                      } },
+                    { "visibility", false, YamlParser::Scalar, [&intentInfo](YamlParser *p) {
+                          const QString visibilityStr = p->parseString();
+                          if (visibilityStr == qL1S("private")) {
+                              intentInfo->m_visibility = IntentInfo::Private;
+                          } else if (visibilityStr != qL1S("public")) {
+                              throw Exception(Error::Intents, "intent visibilty '%2' is invalid on intent %1 (valid values are either 'public' or 'private'")
+                                      .arg(intentInfo->m_id).arg(visibilityStr);
+                          }
+                      } },
+                    { legacy ? "handledBy" : "handlingApplicationId", !legacy, YamlParser::Scalar, [&hasHandler, &handlerId](YamlParser *p) {
+                          hasHandler = true;
+                          handlerId = p->parseString();
+                      } },
+                    { "requiredCapabilities", false, YamlParser::Scalar | YamlParser::List, [&intentInfo](YamlParser *p) {
+                          intentInfo->m_requiredCapabilities = p->parseStringOrStringList(); } },
+                    { "parameterMatch", false, YamlParser::Map, [&intentInfo](YamlParser *p) {
+                          intentInfo->m_parameterMatch = p->parseMap(); } },
+                    { "icon", false, YamlParser::Scalar, [&intentInfo](YamlParser *p) {
+                          intentInfo->m_icon = p->parseString(); } },
+                    { "name", false, YamlParser::Map, [&intentInfo, &parseStringMap](YamlParser *p) {
+                          parseStringMap(p, intentInfo->m_name); } },
+                    { "description", false, YamlParser::Map, [&intentInfo, &parseStringMap](YamlParser *p) {
+                          parseStringMap(p, intentInfo->m_description); } },
+                    { "categories", false, YamlParser::Scalar | YamlParser::List, [&intentInfo](YamlParser *p) {
+                          intentInfo->m_categories = p->parseStringOrStringList();
+                          intentInfo->m_categories.sort();
+                      } }
                 });
 
-                parseMap(intentsIt->toMap(), intentFields);
+                if (hasHandler)
+                    intentHandlers.append(qMakePair(intentInfo.data(), handlerId));
                 pkgInfo->m_intents << intentInfo.take();
-            }
+            });
         });
 
-        parseMap(docs.at(1).toMap(), fields);
+        p.parseFields(fields);
+
+        if (p.nextDocument())
+            throw Exception(Error::Parse, "not a valid YAML application meta-data file: wrong number of YAML documents: expected 2, got more");
 
         if (legacy)
             pkgInfo->m_applications << legacyAppInfo.take();
 
+        for (const auto &intentHandler : qAsConst(intentHandlers)) {
+            IntentInfo *intentInfo = intentHandler.first;
+            const QString &appId = intentHandler.second;
+
+            if (appId.isEmpty()) {
+                if (pkgInfo->m_applications.count() == 1) {
+                    intentInfo->m_handlingApplicationId = pkgInfo->m_applications.constFirst()->id();
+                } else {
+                    throw Exception(Error::Intents, "a 'handlingApplicationId' field on intent %1 is needed if more than one application is defined")
+                            .arg(intentInfo->m_id);
+                }
+            } else {
+                if (appIds.contains(appId)) {
+                    intentInfo->m_handlingApplicationId = appId;
+                } else {
+                    throw Exception(Error::Intents, "the 'handlingApplicationId' field on intent %1 points to the unknown application id %2")
+                            .arg(intentInfo->m_id).arg(appId);
+                }
+            }
+        }
+
         // validate the ids, runtime names and all referenced files
         pkgInfo->validate();
         return pkgInfo.take();
@@ -0,0 +1,169 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QDataStream>
+#include <cstring>
+
+#include "binaryconfiguration.h"
+#include "exception.h"
+
+#if defined(Q_OS_UNIX)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/stat.h>
+#endif
+#if defined(Q_OS_LINUX)
+#  include <sys/syscall.h>
+#  include <linux/memfd.h>
+#endif
+
+QT_BEGIN_NAMESPACE_AM
+
+namespace BinaryConfiguration {
+
+static const char Magic[4] = { 'A', 'M', 'C', 'F' };
+static const quint32 Version = 1;
+static const QDataStream::Version StreamVersion = QDataStream::Qt_5_6;
+
+// anything bigger is a sure sign of a corrupted file descriptor
+static const qint64 MaximumSize = 64 * 1024 * 1024;
+
+QByteArray serialize(const QVariantMap &config)
+{
+    QByteArray data;
+    QDataStream ds(&data, QIODevice::WriteOnly);
+    ds.setVersion(StreamVersion);
+    ds.writeRawData(Magic, sizeof(Magic));
+    ds << Version << config;
+    return data;
+}
+
+QVariantMap deserialize(const QByteArray &data) Q_DECL_NOEXCEPT_EXPR(false)
+{
+    QDataStream ds(data);
+    ds.setVersion(StreamVersion);
+
+    char magic[sizeof(Magic)];
+    quint32 version = 0;
+    if ((ds.readRawData(magic, sizeof(magic)) != sizeof(magic)) || memcmp(magic, Magic, sizeof(Magic)))
+        throw Exception("the binary configuration has an invalid header");
+    ds >> version;
+    if (version != Version)
+        throw Exception("the binary configuration has version %1, but only version %2 is supported")
+            .arg(version).arg(Version);
+
+    QVariantMap config;
+    ds >> config;
+    if (ds.status() != QDataStream::Ok)
+        throw Exception("the binary configuration is truncated or corrupt");
+    return config;
+}
+
+int createFileDescriptor(const QVariantMap &config)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_memfd_create)
+    const QByteArray data = serialize(config);
+
+    int fd = int(syscall(SYS_memfd_create, "am-config", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (fd < 0)
+        return -1;
+
+    const char *ptr = data.constData();
+    qint64 todo = data.size();
+    while (todo > 0) {
+        ssize_t written = ::write(fd, ptr, size_t(todo));
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0) {
+            ::close(fd);
+            return -1;
+        }
+        ptr += written;
+        todo -= written;
+    }
+    // the receiver can rely on the content never changing, even if the fd is shared with others
+    if ((fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+            || (lseek(fd, 0, SEEK_SET) != 0)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    Q_UNUSED(config)
+    return -1;
+#endif
+}
+
+QVariantMap readFileDescriptor(int fd) Q_DECL_NOEXCEPT_EXPR(false)
+{
+#if defined(Q_OS_UNIX)
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        throw Exception(errno, "could not access the binary configuration file descriptor");
+    if (st.st_size <= 0 || st.st_size > MaximumSize)
+        throw Exception("the binary configuration has an invalid size of %1 bytes").arg(qint64(st.st_size));
+
+    QByteArray data(int(st.st_size), Qt::Uninitialized);
+    qint64 done = 0;
+    while (done < data.size()) {
+        // pread: we might not be the first reader of this fd
+        ssize_t bytesRead = ::pread(fd, data.data() + done, size_t(data.size() - done), off_t(done));
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+        if (bytesRead < 0)
+            throw Exception(errno, "could not read the binary configuration");
+        if (bytesRead == 0)
+            break;
+        done += bytesRead;
+    }
+    data.truncate(int(done));
+    return deserialize(data);
+#else
+    Q_UNUSED(fd)
+    throw Exception("binary configurations via file descriptors are not supported on this platform");
+#endif
+}
+
+} // namespace BinaryConfiguration
+
+QT_END_NAMESPACE_AM
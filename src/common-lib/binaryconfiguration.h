@@ -0,0 +1,68 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QVariantMap>
+
+#include <QtAppManCommon/global.h>
+
+QT_BEGIN_NAMESPACE_AM
+
+// A compact, versioned binary encoding of the configuration map that the application-manager
+// hands over to its runtime launchers. This is a lot cheaper to produce and to parse than the
+// YAML encoding in the AM_CONFIG environment variable and - when passed via a file descriptor -
+// it is also not subject to any environment size limits.
+namespace BinaryConfiguration {
+
+QByteArray serialize(const QVariantMap &config);
+QVariantMap deserialize(const QByteArray &data) Q_DECL_NOEXCEPT_EXPR(false);
+
+// Returns a sealed, read-only memfd containing the serialized config, or -1 on failure (or if
+// memfds are not supported on this platform). The fd has the close-on-exec flag set.
+int createFileDescriptor(const QVariantMap &config);
+QVariantMap readFileDescriptor(int fd) Q_DECL_NOEXCEPT_EXPR(false);
+
+} // namespace BinaryConfiguration
+
+QT_END_NAMESPACE_AM
@@ -30,6 +30,7 @@ SOURCES += \
     crashhandler.cpp \
     logging.cpp \
     dbus-utilities.cpp \
+    binaryconfiguration.cpp \
 
 qtHaveModule(qml):SOURCES += \
     qml-utilities.cpp \
@@ -44,7 +45,8 @@ HEADERS += \
     unixsignalhandler.h \
     processtitle.h \
     crashhandler.h \
-    logging.h
+    logging.h \
+    binaryconfiguration.h
 
 qtHaveModule(qml):HEADERS += \
     qml-utilities.h \
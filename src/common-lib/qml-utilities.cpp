@@ -41,6 +41,9 @@
 ****************************************************************************/
 
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
 #include <QQmlComponent>
 #include <QQmlContext>
 #include <private/qqmlmetatype_p.h>
@@ -114,4 +117,67 @@ void loadQmlDummyDataFiles(QQmlEngine *engine, const QString &directory)
     }
 }
 
+QStringList qmlModuleImports(const QString &qmlFile)
+{
+    QStringList imports;
+    QFile f(qmlFile);
+    if (!f.open(QIODevice::ReadOnly))
+        return imports;
+
+    static const QRegularExpression importRe(qSL("^import\\s+([A-Za-z_][A-Za-z0-9_.]*)\\s+(\\d+\\.\\d+)(\\s+as\\s+\\w+)?\\s*;?$"));
+    bool inComment = false;
+
+    while (!f.atEnd()) {
+        QString line = QString::fromUtf8(f.readLine()).trimmed();
+        if (inComment) {
+            inComment = !line.contains(qSL("*/"));
+            continue;
+        }
+        if (line.startsWith(qSL("/*"))) {
+            inComment = !line.contains(qSL("*/"));
+            continue;
+        }
+        int lineComment = line.indexOf(qSL("//"));
+        if (lineComment >= 0)
+            line = line.left(lineComment).trimmed();
+        if (line.isEmpty() || line.startsWith(qSL("pragma")))
+            continue;
+        if (!line.startsWith(qSL("import")))
+            break; // end of the header
+
+        auto match = importRe.match(line);
+        if (match.hasMatch())
+            imports << match.captured(1) + qL1C(' ') + match.captured(2);
+    }
+    return imports;
+}
+
+bool isQmlModuleInImportPaths(const QString &uri, const QString &version, const QStringList &importPaths)
+{
+    const QStringList parts = uri.split(qL1C('.'));
+    const QString majorVersion = version.section(qL1C('.'), 0, 0);
+
+    // the same candidates the QML engine checks: the fully versioned, the major versioned and
+    // the unversioned module directory, with the version appended to each part of the uri
+    QStringList relativePaths;
+    for (const QString &v : { version, majorVersion }) {
+        if (v.isEmpty())
+            continue;
+        for (int i = parts.size() - 1; i >= 0; --i) {
+            QStringList versionedParts = parts;
+            versionedParts[i] += qL1C('.') + v;
+            relativePaths << versionedParts.join(qL1C('/'));
+        }
+    }
+    relativePaths << parts.join(qL1C('/'));
+
+    for (const QString &importPath : importPaths) {
+        for (const QString &relativePath : qAsConst(relativePaths)) {
+            if (QFileInfo(importPath + qL1C('/') + relativePath + qSL("/qmldir")).isFile())
+                return true;
+        }
+    }
+    return false;
+}
+
 QT_END_NAMESPACE_AM
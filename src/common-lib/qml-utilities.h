@@ -54,4 +54,12 @@ void fixNullValuesForQml(QVariantMap &map);
 
 void loadQmlDummyDataFiles(QQmlEngine *engine, const QString &directory);
 
+// Returns the module imports ("<module> <version>") from the header of a QML file. Directory and
+// JavaScript imports are skipped.
+QStringList qmlModuleImports(const QString &qmlFile);
+
+// Returns true if the QML module \a uri in \a version has a qmldir file in one of the given
+// \a importPaths. Versioned module directories (e.g. "Foo/Bar.2") are found as well.
+bool isQmlModuleInImportPaths(const QString &uri, const QString &version, const QStringList &importPaths);
+
 QT_END_NAMESPACE_AM
@@ -41,174 +41,282 @@
 ****************************************************************************/
 
 #include <QVariant>
-#include <QRegExp>
 #include <QDebug>
 #include <QtNumeric>
+#include <QHash>
+#include <QFileInfo>
+#include <QDir>
 
 #include <yaml.h>
 
 #include "global.h"
 #include "qtyaml.h"
+#include "exception.h"
+#include "utilities.h"
 
 QT_BEGIN_NAMESPACE
 
 namespace QtYaml {
 
-static QVariant convertYamlNodeToVariant(yaml_document_t *doc, yaml_node_t *node)
+// Single pass classification and conversion of plain scalars that look like numbers. This
+// implements the same rules as these regular expressions would:
+//   binary:       [-+]?0b[0-1_]+
+//   hexadecimal:  [-+]?0x[0-9a-fA-F_]+
+//   octal:        [-+]?0[0-7_]+
+//   decimal:      [-+]?(0|[1-9][0-9_]*)
+//   float:        [-+]?([0-9][0-9_]*)?\.[0-9.]*([eE][-+][0-9]+)?
+// Returns an invalid QVariant, if the scalar is not a number.
+static QVariant convertYamlNumberToVariant(const char *data, int length)
 {
-    QVariant result;
+    const char *end = data + length;
+    const char *p = data;
+    bool negative = false;
+
+    if ((p < end) && (*p == '+' || *p == '-'))
+        negative = (*p++ == '-');
+    if (p == end)
+        return QVariant();
+
+    int base = 0;
+    const char *digits = p;
+
+    if ((end - p > 2) && (p[0] == '0') && (p[1] == 'b')) {
+        base = 2;
+        digits = p + 2;
+    } else if ((end - p > 2) && (p[0] == '0') && (p[1] == 'x')) {
+        base = 16;
+        digits = p + 2;
+    } else if ((end - p > 1) && (p[0] == '0') && (p[1] != '.')) {
+        base = 8;
+        digits = p + 1;
+    } else if ((*p >= '0') && (*p <= '9') && ((*p != '0') || (end - p == 1))) {
+        base = 10;
+    }
 
-    if (!doc)
-        return result;
-    if (!node)
-        return result;
+    if (base) {
+        quint64 value = 0;
+        bool overflow = false;
+        bool hasDigits = (base == 8) || (base == 10); // the leading 0 or [1-9] is a digit already
+
+        for (const char *c = digits; c < end; ++c) {
+            if (*c == '_')
+                continue;
+
+            int digit;
+            if (*c >= '0' && *c <= '9')
+                digit = *c - '0';
+            else if (*c >= 'a' && *c <= 'f')
+                digit = *c - 'a' + 10;
+            else if (*c >= 'A' && *c <= 'F')
+                digit = *c - 'A' + 10;
+            else
+                digit = base; // invalid
 
-    switch (node->type) {
-    case YAML_SCALAR_NODE: {
-        const QByteArray ba = QByteArray::fromRawData(reinterpret_cast<const char *>(node->data.scalar.value),
-                                                int(node->data.scalar.length));
+            if (digit >= base) {
+                // "01.5" or "1.5" are not integers, but might still be floats
+                value = 0;
+                base = 0;
+                break;
+            }
+            if (value > (std::numeric_limits<quint64>::max() - quint64(digit)) / quint64(base))
+                overflow = true;
+            value = value * quint64(base) + quint64(digit);
+            hasDigits = true;
+        }
 
-        if (node->data.scalar.style == YAML_SINGLE_QUOTED_SCALAR_STYLE
-                || node->data.scalar.style == YAML_DOUBLE_QUOTED_SCALAR_STYLE) {
-            result = QString::fromUtf8(ba);
-            break;
+        if (base) {
+            if (overflow || !hasDigits)
+                return QVariant();
+            if (!negative) {
+                if (value <= quint64(std::numeric_limits<qint32>::max()))
+                    return qint32(value);
+                else if (value <= quint64(std::numeric_limits<qint64>::max()))
+                    return qint64(value);
+                else
+                    return value;
+            } else {
+                if (value <= quint64(std::numeric_limits<qint32>::max()) + 1)
+                    return qint32(-qint64(value));
+                else if (value <= quint64(std::numeric_limits<qint64>::max()) + 1)
+                    return qint64(0 - value);
+                else
+                    return QVariant();
+            }
         }
+    }
 
-        enum ValueIndex {
-            ValueNull,
-            ValueTrue,
-            ValueFalse,
-            ValueNaN,
-            ValueInf
-        };
+    // float: ([0-9][0-9_]*)?\.[0-9.]*([eE][-+][0-9]+)?
+    bool hasUnderscore = false;
+    if ((p < end) && (*p >= '0') && (*p <= '9')) {
+        while ((p < end) && (((*p >= '0') && (*p <= '9')) || (*p == '_'))) {
+            if (*p == '_')
+                hasUnderscore = true;
+            ++p;
+        }
+    }
+    if ((p == end) || (*p != '.'))
+        return QVariant();
+    ++p;
+    while ((p < end) && (((*p >= '0') && (*p <= '9')) || (*p == '.')))
+        ++p;
+    if ((p < end) && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if ((p == end) || (*p != '+' && *p != '-'))
+            return QVariant();
+        ++p;
+        if (p == end)
+            return QVariant();
+        while ((p < end) && (*p >= '0') && (*p <= '9'))
+            ++p;
+    }
+    if (p != end)
+        return QVariant();
+
+    bool ok = false;
+    double d;
+    if (hasUnderscore) {
+        QByteArray ba(data, length);
+        d = ba.replace('_', QByteArray()).toDouble(&ok);
+    } else {
+        d = QByteArray::fromRawData(data, length).toDouble(&ok);
+    }
+    return ok ? QVariant(d) : QVariant();
+}
 
-        struct StaticMapping
-        {
-            const char *text;
-            ValueIndex index;
-        };
+// data needs to be '\0' terminated (libyaml guarantees that for all scalars)
+static QVariant convertYamlScalarToVariant(const char *data, int length, yaml_scalar_style_t style)
+{
+    if (style == YAML_SINGLE_QUOTED_SCALAR_STYLE || style == YAML_DOUBLE_QUOTED_SCALAR_STYLE)
+        return QString::fromUtf8(data, length);
+
+    static const QVariant valueNull;
+    static const QVariant valueTrue(true);
+    static const QVariant valueFalse(false);
+    static const QVariant valueNaN(qQNaN());
+    static const QVariant valueInf(qInf());
+
+    auto is = [data](const char *lower, const char *capitalized, const char *upper) {
+        return !strcmp(data, lower) || !strcmp(data, capitalized) || !strcmp(data, upper);
+    };
+
+    // cheap dispatch on the length and the first character, instead of a (b)search over
+    // all the special values
+    const char firstChar = length ? data[0] : 0;
+
+    switch (length) {
+    case 0:
+        return valueNull;
+    case 1:
+        switch (firstChar) {
+        case '~': return valueNull;
+        case 'y': case 'Y': return valueTrue;
+        case 'n': case 'N': return valueFalse;
+        default: break;
+        }
+        break;
+    case 2:
+        if (is("on", "On", "ON"))
+            return valueTrue;
+        if (is("no", "No", "NO"))
+            return valueFalse;
+        break;
+    case 3:
+        if (is("yes", "Yes", "YES"))
+            return valueTrue;
+        if (is("off", "Off", "OFF"))
+            return valueFalse;
+        break;
+    case 4:
+        if (firstChar == '.') {
+            if (is(".inf", ".Inf", ".INF"))
+                return valueInf;
+            if (is(".nan", ".NaN", ".NAN"))
+                return valueNaN;
+        } else {
+            if (is("true", "True", "TRUE"))
+                return valueTrue;
+            if (is("null", "Null", "NULL"))
+                return valueNull;
+        }
+        break;
+    case 5:
+        if (is("false", "False", "FALSE"))
+            return valueFalse;
+        break;
+    default:
+        break;
+    }
 
-        static QVariant staticValues[] = {
-            QVariant(),                    // ValueNull
-            QVariant(true),                // ValueTrue
-            QVariant(false),               // ValueFalse
-            QVariant(qQNaN()),             // ValueNaN
-            QVariant(qInf()),              // ValueInf
-        };
+    if ((firstChar >= '0' && firstChar <= '9')   // cheap check to avoid the number parsing
+            || firstChar == '+' || firstChar == '-' || firstChar == '.') {
+        QVariant number = convertYamlNumberToVariant(data, length);
+        if (number.isValid())
+            return number;
+    }
+    return QString::fromUtf8(data, length);
+}
+
+QVariant convertPlainScalarToVariant(const QByteArray &scalar)
+{
+    // a QByteArray that is not created via fromRawData() is always '\0' terminated
+    return convertYamlScalarToVariant(scalar.constData(), scalar.size(), YAML_PLAIN_SCALAR_STYLE);
+}
 
-        static const StaticMapping staticMappings[] = { // keep this sorted for bsearch !!
-            { "",      ValueNull },
-            { ".INF",  ValueInf },
-            { ".Inf",  ValueInf },
-            { ".NAN",  ValueNaN },
-            { ".NaN",  ValueNaN },
-            { ".inf",  ValueInf },
-            { ".nan",  ValueNaN },
-            { "FALSE", ValueFalse },
-            { "False", ValueFalse },
-            { "N",     ValueFalse },
-            { "NO",    ValueFalse },
-            { "NULL",  ValueNull },
-            { "No",    ValueFalse },
-            { "Null",  ValueNull },
-            { "OFF",   ValueFalse },
-            { "Off",   ValueFalse },
-            { "ON",    ValueTrue },
-            { "On",    ValueTrue },
-            { "TRUE",  ValueTrue },
-            { "True",  ValueTrue },
-            { "Y",     ValueTrue },
-            { "YES",   ValueTrue },
-            { "Yes",   ValueTrue },
-            { "false", ValueFalse },
-            { "n",     ValueFalse },
-            { "no",    ValueFalse },
-            { "null",  ValueNull },
-            { "off",   ValueFalse },
-            { "on",    ValueTrue },
-            { "true",  ValueTrue },
-            { "y",     ValueTrue },
-            { "yes",   ValueTrue },
-            { "~",     ValueNull }
+// The keys in manifests and config files are mostly from a small, fixed set: sharing the
+// QStrings for these avoids allocating a new string for every single mapping key.
+// Returns a null QString for all other keys.
+static QString knownYamlKey(const char *data, int length)
+{
+    static const QHash<QByteArray, QString> knownKeys = []() {
+        static const char *keys[] = {
+            // headers
+            "formatType", "formatVersion",
+            // manifests
+            "id", "icon", "name", "description", "categories", "version", "logging", "dlt", "code",
+            "runtime", "runtimeParameters", "supportsApplicationInterface", "capabilities",
+            "opengl", "desktopProfile", "esMajorVersion", "esMinorVersion", "applicationProperties",
+            "protected", "private", "documentUrl", "mimeTypes", "applications", "intents",
+            "visibility", "handlingApplicationId", "handledBy", "requiredCapabilities",
+            "parameterMatch", "loadDummyData", "importPaths", "resources", "pluginPaths",
+            "environmentVariables", "arguments", "en", "en_US", "de", "de_DE",
+            // installation reports
+            "packageId", "diskSpaceUsed", "digest", "developerSignature", "storeSignature",
+            "extra", "extraSigned", "files", "hmac",
+            // configs
+            "applicationUserIdSeparation", "builtinAppsManifestDir", "caCertificates",
+            "containers", "crashAction", "database", "dbus", "debug", "developmentMode",
+            "disable", "documentDir", "enableTouchEmulation", "flags", "forceMultiProcess",
+            "forceSingleProcess", "fullscreen", "iconThemeName", "iconThemeSearchPaths", "idleLoad",
+            "installationDir", "installationLocations", "installer", "interfaceName", "mainQml",
+            "messagePattern", "noSecurity", "noUiWatchdog", "plugins", "policy", "quicklaunch",
+            "register", "rules", "runtimes", "runtimesPerContainer", "selection", "style",
+            "systemProperties", "telnetAddress", "telnetPort", "timeouts", "type", "ui",
+            "useAMConsoleLogger", "windowIcon", "public"
         };
+        QHash<QByteArray, QString> hash;
+        for (const char *key : keys)
+            hash.insert(QByteArray(key), QString::fromLatin1(key));
+        return hash;
+    }();
+
+    auto it = knownKeys.constFind(QByteArray::fromRawData(data, length));
+    return (it != knownKeys.cend()) ? it.value() : QString();
+}
 
-        static const char *firstCharStaticMappings = ".FNOTYfnoty~";
-        char firstChar = ba.isEmpty() ? 0 : ba.at(0);
-
-        if (strchr(firstCharStaticMappings, firstChar)) { // cheap check to avoid expensive bsearch
-            StaticMapping key { ba.constData(), ValueNull };
-            auto found = bsearch(&key,
-                                 staticMappings,
-                                 sizeof(staticMappings)/sizeof(staticMappings[0]),
-                    sizeof(staticMappings[0]),
-                    [](const void *m1, const void *m2) {
-                return strcmp(static_cast<const StaticMapping *>(m1)->text,
-                              static_cast<const StaticMapping *>(m2)->text); });
-
-            if (found) {
-                result = staticValues[static_cast<StaticMapping *>(found)->index];
-                break;
-            }
-        }
+static QVariant convertYamlNodeToVariant(yaml_document_t *doc, yaml_node_t *node)
+{
+    QVariant result;
 
-        QString str = QString::fromUtf8(ba);
-        result = str;
-
-        if ((firstChar >= '0' && firstChar <= '9')   // cheap check to avoid expensive regexps
-                || firstChar == '+' || firstChar == '-' || firstChar == '.') {
-            static const QRegExp numberRegExps[] = {
-                QRegExp(qSL("[-+]?0b[0-1_]+")),        // binary
-                QRegExp(qSL("[-+]?0x[0-9a-fA-F_]+")),  // hexadecimal
-                QRegExp(qSL("[-+]?0[0-7_]+")),         // octal
-                QRegExp(qSL("[-+]?(0|[1-9][0-9_]*)")), // decimal
-                QRegExp(qSL("[-+]?([0-9][0-9_]*)?\\.[0-9.]*([eE][-+][0-9]+)?")), // float
-                QRegExp()
-            };
-
-            for (int numberIndex = 0; !numberRegExps[numberIndex].isEmpty(); ++numberIndex) {
-                if (numberRegExps[numberIndex].exactMatch(str)) {
-                    bool ok = false;
-                    QVariant val;
-
-                    // YAML allows _ as a grouping separator
-                    if (str.contains(qL1C('_')))
-                        str = str.replace(qL1C('_'), qSL(""));
-
-                    if (numberIndex == 4) {
-                        val = str.toDouble(&ok);
-                    } else {
-                        int base = 10;
-
-                        switch (numberIndex) {
-                        case 0: base = 2; str.replace(qSL("0b"), qSL("")); break; // Qt chokes on 0b
-                        case 1: base = 16; break;
-                        case 2: base = 8; break;
-                        case 3: base = 10; break;
-                        }
-
-                        qint64 s64 = str.toLongLong(&ok, base);
-                        if (ok && (s64 <= std::numeric_limits<qint32>::max())) {
-                            val = qint32(s64);
-                        } else if (ok) {
-                            val = s64;
-                        } else {
-                            quint64 u64 = str.toULongLong(&ok, base);
-
-                            if (ok && (u64 <= std::numeric_limits<quint32>::max()))
-                                val = quint32(u64);
-                            else if (ok)
-                                val = u64;
-                        }
-                    }
-                    if (ok) {
-                        result = val;
-                        break;
-                    }
-                }
-            }
-        }
+    if (!doc)
+        return result;
+    if (!node)
+        return result;
+
+    switch (node->type) {
+    case YAML_SCALAR_NODE:
+        result = convertYamlScalarToVariant(reinterpret_cast<const char *>(node->data.scalar.value),
+                                            int(node->data.scalar.length), node->data.scalar.style);
         break;
-    }
     case YAML_SEQUENCE_NODE: {
         QVariantList array;
         for (auto seq = node->data.sequence.items.start; seq < node->data.sequence.items.top; ++seq) {
@@ -227,11 +335,18 @@ static QVariant convertYamlNodeToVariant(yaml_document_t *doc, yaml_node_t *node
             yaml_node_t *keyNode = yaml_document_get_node(doc, map->key);
             yaml_node_t *valueNode = yaml_document_get_node(doc, map->value);
             if (keyNode && valueNode) {
-                QVariant key = convertYamlNodeToVariant(doc, keyNode);
-                QString keyStr = key.toString();
+                QString keyStr;
+                if (keyNode->type == YAML_SCALAR_NODE) {
+                    keyStr = knownYamlKey(reinterpret_cast<const char *>(keyNode->data.scalar.value),
+                                          int(keyNode->data.scalar.length));
+                }
+                if (keyStr.isNull()) {
+                    QVariant key = convertYamlNodeToVariant(doc, keyNode);
+                    keyStr = key.toString();
 
-                if (key.type() != QVariant::String)
-                    qWarning() << "YAML Parser: converting non-string mapping key to string for JSON compatibility";
+                    if (key.type() != QVariant::String)
+                        qWarning() << "YAML Parser: converting non-string mapping key to string for JSON compatibility";
+                }
                 if (object.contains(keyStr))
                     qWarning() << "YAML Parser: duplicate key" << keyStr << "found in mapping";
 
@@ -415,3 +530,419 @@ QByteArray yamlFromVariantDocuments(const QVector<QVariant> &documents, YamlStyl
 } // namespace QtYaml
 
 QT_END_NAMESPACE
+
+
+QT_BEGIN_NAMESPACE_AM
+
+class YamlParserPrivate
+{
+public:
+    QString sourcePath;
+    QByteArray data;
+    bool parserInitialized = false;
+    yaml_parser_t parser;
+    yaml_event_t event;
+    QHash<QByteArray, QVariant> anchors;
+};
+
+static QByteArray anchorOfEvent(const yaml_event_t &event)
+{
+    const yaml_char_t *anchor = nullptr;
+
+    switch (event.type) {
+    case YAML_SCALAR_EVENT:         anchor = event.data.scalar.anchor; break;
+    case YAML_MAPPING_START_EVENT:  anchor = event.data.mapping_start.anchor; break;
+    case YAML_SEQUENCE_START_EVENT: anchor = event.data.sequence_start.anchor; break;
+    default: break;
+    }
+    return anchor ? QByteArray(reinterpret_cast<const char *>(anchor)) : QByteArray();
+}
+
+static bool isNullScalar(const char *data, int length)
+{
+    switch (length) {
+    case 0: return true;
+    case 1: return data[0] == '~';
+    case 4: return !strcmp(data, "null") || !strcmp(data, "Null") || !strcmp(data, "NULL");
+    default: return false;
+    }
+}
+
+// a plain null scalar ("key:" or "key: ~") is accepted wherever a map is expected and treated
+// as an empty map, the same way QVariant::toMap() did for documents parsed in one go
+static bool isNullScalarEvent(const yaml_event_t &event)
+{
+    return (event.type == YAML_SCALAR_EVENT)
+            && (event.data.scalar.style == YAML_PLAIN_SCALAR_STYLE)
+            && isNullScalar(reinterpret_cast<const char *>(event.data.scalar.value),
+                            int(event.data.scalar.length));
+}
+
+YamlParser::YamlParser(const QByteArray &data, const QString &fileName)
+    : d(new YamlParserPrivate)
+{
+    d->data = data;
+    d->sourcePath = fileName;
+    memset(&d->event, 0, sizeof(d->event)); // == YAML_NO_EVENT
+
+    if (yaml_parser_initialize(&d->parser)) {
+        yaml_parser_set_input_string(&d->parser, reinterpret_cast<const uchar *>(d->data.constData()),
+                                     static_cast<size_t>(d->data.size()));
+        d->parserInitialized = true;
+    }
+}
+
+YamlParser::~YamlParser()
+{
+    if (d->event.type != YAML_NO_EVENT)
+        yaml_event_delete(&d->event);
+    if (d->parserInitialized)
+        yaml_parser_delete(&d->parser);
+    delete d;
+}
+
+QVector<QVariant> YamlParser::parseAllDocuments(const QByteArray &yaml)
+{
+    YamlParser p(yaml);
+    QVector<QVariant> result;
+    while (p.nextDocument())
+        result << p.parseVariant();
+    return result;
+}
+
+QString YamlParser::sourcePath() const
+{
+    return d->sourcePath.isEmpty() ? QString() : QFileInfo(d->sourcePath).absoluteFilePath();
+}
+
+QString YamlParser::sourceDir() const
+{
+    return d->sourcePath.isEmpty() ? QString() : QFileInfo(d->sourcePath).absolutePath();
+}
+
+QString YamlParser::sourceName() const
+{
+    return d->sourcePath.isEmpty() ? QString() : QFileInfo(d->sourcePath).fileName();
+}
+
+QPair<QString, int> YamlParser::parseHeader()
+{
+    if (!nextDocument())
+        throw Exception("wrong number of YAML documents: expected at least 1, got 0");
+    if (!isMap())
+        throwParseError(qSL("the header document is not a map"));
+
+    // this is a tiny map, so we do not bother with parseFields() here
+    const QVariantMap header = parseMap();
+    return qMakePair(header.value(qSL("formatType")).toString(),
+                     header.value(qSL("formatVersion")).toInt());
+}
+
+bool YamlParser::nextDocument()
+{
+    if (!d->parserInitialized)
+        throw Exception("could not initialize YAML parser");
+
+    if (d->event.type == YAML_NO_EVENT) // first call
+        nextEvent();
+    if (d->event.type == YAML_STREAM_START_EVENT)
+        nextEvent();
+    if (d->event.type == YAML_DOCUMENT_END_EVENT)
+        nextEvent();
+
+    switch (d->event.type) {
+    case YAML_DOCUMENT_START_EVENT:
+        d->anchors.clear();
+        nextEvent();
+        return true;
+    case YAML_STREAM_END_EVENT:
+        return false;
+    default:
+        throwParseError(qSL("unexpected content at the end of the document"));
+    }
+}
+
+void YamlParser::nextEvent()
+{
+    if (d->event.type != YAML_NO_EVENT)
+        yaml_event_delete(&d->event);
+
+    if (!yaml_parser_parse(&d->parser, &d->event)) {
+        if (d->parser.error == YAML_READER_ERROR) {
+            throw Exception(Error::Parse, "YAML parse error at offset %1: %2")
+                    .arg(d->parser.problem_offset).arg(QString::fromLocal8Bit(d->parser.problem));
+        } else {
+            throw Exception(Error::Parse, "YAML parse error at line %1, column %2: %3")
+                    .arg(d->parser.problem_mark.line + 1).arg(d->parser.problem_mark.column)
+                    .arg(QString::fromLocal8Bit(d->parser.problem));
+        }
+    }
+}
+
+bool YamlParser::isScalar() const
+{
+    return d->event.type == YAML_SCALAR_EVENT;
+}
+
+bool YamlParser::isMap() const
+{
+    return d->event.type == YAML_MAPPING_START_EVENT;
+}
+
+bool YamlParser::isList() const
+{
+    return d->event.type == YAML_SEQUENCE_START_EVENT;
+}
+
+QString YamlParser::parseString()
+{
+    QVariant value;
+    if (resolveAlias(&value)) {
+        if ((value.type() == QVariant::Map) || (value.type() == QVariant::List))
+            throwParseError(qSL("expected a string value"));
+        return value.toString();
+    }
+    if (!isScalar())
+        throwParseError(qSL("expected a string value"));
+
+    const char *data = reinterpret_cast<const char *>(d->event.data.scalar.value);
+    const int length = int(d->event.data.scalar.length);
+    QString str;
+
+    // we only need to special case null values here: everything else is taken verbatim
+    if ((d->event.data.scalar.style != YAML_PLAIN_SCALAR_STYLE) || !isNullScalar(data, length))
+        str = QString::fromUtf8(data, length);
+    storeAnchor(anchorOfEvent(d->event), str);
+    nextEvent();
+    return str;
+}
+
+QVariant YamlParser::parseScalar()
+{
+    QVariant value;
+    if (resolveAlias(&value))
+        return value;
+    if (!isScalar())
+        throwParseError(qSL("expected a scalar value"));
+
+    value = QT_PREPEND_NAMESPACE(QtYaml)::convertYamlScalarToVariant(
+                reinterpret_cast<const char *>(d->event.data.scalar.value),
+                int(d->event.data.scalar.length), d->event.data.scalar.style);
+    storeAnchor(anchorOfEvent(d->event), value);
+    nextEvent();
+    return value;
+}
+
+QVariantMap YamlParser::parseMap()
+{
+    QVariant value;
+    if (resolveAlias(&value)) {
+        if (value.type() != QVariant::Map)
+            throwParseError(qSL("expected a map"));
+        return value.toMap();
+    }
+    if (isNullScalarEvent(d->event)) {
+        nextEvent();
+        return QVariantMap();
+    }
+    if (!isMap())
+        throwParseError(qSL("expected a map"));
+
+    const QByteArray anchor = anchorOfEvent(d->event);
+    nextEvent();
+
+    QVariantMap map;
+    while (d->event.type != YAML_MAPPING_END_EVENT) {
+        QString keyStr;
+        if (isScalar()) {
+            keyStr = QT_PREPEND_NAMESPACE(QtYaml)::knownYamlKey(
+                        reinterpret_cast<const char *>(d->event.data.scalar.value),
+                        int(d->event.data.scalar.length));
+        }
+        if (!keyStr.isNull()) {
+            storeAnchor(anchorOfEvent(d->event), keyStr);
+            nextEvent();
+        } else {
+            const QVariant key = parseScalar();
+            keyStr = key.toString();
+
+            if (key.type() != QVariant::String)
+                qWarning() << "YAML Parser: converting non-string mapping key to string for JSON compatibility";
+        }
+        if (map.contains(keyStr))
+            qWarning() << "YAML Parser: duplicate key" << keyStr << "found in mapping";
+
+        map.insert(keyStr, parseVariant());
+    }
+    nextEvent();
+    storeAnchor(anchor, map);
+    return map;
+}
+
+QVariantList YamlParser::parseList()
+{
+    QVariant value;
+    if (resolveAlias(&value)) {
+        if (value.type() != QVariant::List)
+            throwParseError(qSL("expected a list"));
+        return value.toList();
+    }
+    if (!isList())
+        throwParseError(qSL("expected a list"));
+
+    const QByteArray anchor = anchorOfEvent(d->event);
+    nextEvent();
+
+    QVariantList list;
+    while (d->event.type != YAML_SEQUENCE_END_EVENT)
+        list.append(parseVariant());
+    nextEvent();
+    storeAnchor(anchor, list);
+    return list;
+}
+
+void YamlParser::parseList(const std::function<void(YamlParser *)> &parseCallback)
+{
+    if (d->event.type == YAML_ALIAS_EVENT)
+        throwParseError(qSL("aliases are not supported in this context"));
+    if (!isList())
+        throwParseError(qSL("expected a list"));
+    nextEvent();
+
+    while (d->event.type != YAML_SEQUENCE_END_EVENT) {
+        const auto position = d->event.start_mark.index;
+        const auto type = d->event.type;
+        parseCallback(this);
+        if ((d->event.start_mark.index == position) && (d->event.type == type))
+            throwParseError(qSL("internal error: the list item has not been consumed"));
+    }
+    nextEvent();
+}
+
+QVariant YamlParser::parseVariant()
+{
+    QVariant value;
+    if (resolveAlias(&value))
+        return value;
+
+    switch (d->event.type) {
+    case YAML_SCALAR_EVENT:         return parseScalar();
+    case YAML_MAPPING_START_EVENT:  return parseMap();
+    case YAML_SEQUENCE_START_EVENT: return parseList();
+    default: throwParseError(qSL("expected a scalar, a list or a map"));
+    }
+}
+
+QStringList YamlParser::parseStringOrStringList()
+{
+    QVariant value;
+    if (resolveAlias(&value))
+        return variantToStringList(value);
+
+    QStringList result;
+    if (isList()) {
+        parseList([&result](YamlParser *p) { result << p->parseString(); });
+    } else {
+        const QString str = parseString();
+        if (!str.isNull())
+            result << str;
+    }
+    return result;
+}
+
+void YamlParser::parseFields(const Fields &fields)
+{
+    if (d->event.type == YAML_ALIAS_EVENT)
+        throwParseError(qSL("aliases are not supported in this context"));
+
+    std::vector<bool> found(fields.size(), false);
+
+    // a null value is an empty map: only the check for required fields below applies
+    const bool isEmpty = isNullScalarEvent(d->event);
+    if (!isEmpty) {
+        if (!isMap())
+            throwParseError(qSL("expected a map"));
+        nextEvent();
+    }
+
+    while (!isEmpty && (d->event.type != YAML_MAPPING_END_EVENT)) {
+        if (!isScalar())
+            throwParseError(qSL("only scalar keys are supported in this map"));
+
+        // compare the raw key data: no need to create QStrings for every key
+        const char *key = reinterpret_cast<const char *>(d->event.data.scalar.value);
+        const size_t keyLength = d->event.data.scalar.length;
+        size_t index = 0;
+        for (; index < fields.size(); ++index) {
+            const QByteArray &name = fields[index].name;
+            if ((size_t(name.size()) == keyLength) && !memcmp(name.constData(), key, keyLength))
+                break;
+        }
+        if (index == fields.size())
+            throwParseError(qSL("field '%1' is not supported").arg(QString::fromUtf8(key, int(keyLength))));
+
+        const Field &field = fields[index];
+        if (found[index])
+            throwParseError(qSL("field '%1' is specified multiple times").arg(QString::fromLatin1(field.name)));
+        found[index] = true;
+        nextEvent();
+
+        FieldType type = Scalar;
+        switch (d->event.type) {
+        case YAML_MAPPING_START_EVENT:  type = Map; break;
+        case YAML_SEQUENCE_START_EVENT: type = List; break;
+        case YAML_ALIAS_EVENT: {
+            const QVariant aliased = d->anchors.value(QByteArray(reinterpret_cast<const char *>(d->event.data.alias.anchor)));
+            type = (aliased.type() == QVariant::Map) ? Map : (aliased.type() == QVariant::List) ? List : Scalar;
+            break;
+        }
+        case YAML_SCALAR_EVENT:
+            if (field.types.testFlag(Map) && !field.types.testFlag(Scalar) && isNullScalarEvent(d->event))
+                type = Map;
+            break;
+        default: break;
+        }
+        if (!field.types.testFlag(type))
+            throwParseError(qSL("field '%1' has an invalid type").arg(QString::fromLatin1(field.name)));
+
+        const auto position = d->event.start_mark.index;
+        const auto eventType = d->event.type;
+        field.callback(this);
+        if ((d->event.start_mark.index == position) && (d->event.type == eventType))
+            throwParseError(qSL("internal error: field '%1' has not been consumed").arg(QString::fromLatin1(field.name)));
+    }
+    nextEvent();
+
+    for (size_t index = 0; index < fields.size(); ++index) {
+        if (fields[index].required && !found[index])
+            throwParseError(qSL("required field '%1' is missing").arg(QString::fromLatin1(fields[index].name)));
+    }
+}
+
+void YamlParser::throwParseError(const QString &message) const Q_DECL_NOEXCEPT_EXPR(false)
+{
+    throw Exception(Error::Parse, "YAML parse error at line %1, column %2: %3")
+            .arg(d->event.start_mark.line + 1).arg(d->event.start_mark.column).arg(message);
+}
+
+bool YamlParser::resolveAlias(QVariant *value)
+{
+    if (d->event.type != YAML_ALIAS_EVENT)
+        return false;
+
+    const QByteArray anchor(reinterpret_cast<const char *>(d->event.data.alias.anchor));
+    auto it = d->anchors.constFind(anchor);
+    if (it == d->anchors.cend())
+        throwParseError(qSL("unknown alias '%1'").arg(QString::fromUtf8(anchor)));
+    *value = it.value();
+    nextEvent();
+    return true;
+}
+
+void YamlParser::storeAnchor(const QByteArray &anchor, const QVariant &value)
+{
+    if (!anchor.isEmpty())
+        d->anchors.insert(anchor, value);
+}
+
+QT_END_NAMESPACE_AM
@@ -43,12 +43,17 @@
 #pragma once
 
 #include <functional>
+#include <vector>
 
 #include <QJsonParseError>
 #include <QVector>
 #include <QByteArray>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
+#include <QPair>
+
+#include <QtAppManCommon/global.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -83,6 +88,10 @@ private:
 
 QVector<QVariant> variantDocumentsFromYaml(const QByteArray &yaml, ParseError *error = nullptr);
 
+// Converts a plain (unquoted) scalar to null, bool, int, double or string, just like both
+// parsers do internally. This is only exported for the unit tests and benchmarks.
+QVariant convertPlainScalarToVariant(const QByteArray &scalar);
+
 enum YamlStyle { FlowStyle, BlockStyle };
 
 QByteArray yamlFromVariantDocuments(const QVector<QVariant> &maps, YamlStyle style = BlockStyle);
@@ -90,3 +99,84 @@ QByteArray yamlFromVariantDocuments(const QVector<QVariant> &maps, YamlStyle sty
 } // namespace QtYaml
 
 QT_END_NAMESPACE
+
+QT_BEGIN_NAMESPACE_AM
+
+class YamlParserPrivate;
+
+/*! \internal
+    A streaming YAML parser: in contrast to QtYaml::variantDocumentsFromYaml(), this class
+    works directly on the libyaml event stream, without building a document tree first.
+    Structured data (like manifests) can be parsed via parseFields() without allocating a
+    QVariant for every node.
+
+    All parse functions consume the current node, i.e. after they return, the parser is
+    positioned on the node following the one that was just parsed. All errors are reported
+    by throwing an Exception.
+*/
+class YamlParser
+{
+public:
+    YamlParser(const QByteArray &data, const QString &fileName = QString());
+    ~YamlParser();
+
+    static QVector<QVariant> parseAllDocuments(const QByteArray &yaml);
+
+    QString sourcePath() const;
+    QString sourceDir() const;
+    QString sourceName() const;
+
+    QPair<QString, int> parseHeader();
+
+    bool nextDocument();
+    void nextEvent();
+
+    bool isScalar() const;
+    bool isMap() const;
+    bool isList() const;
+
+    QString parseString();
+    QVariant parseScalar();
+    QVariantMap parseMap();
+    QVariantList parseList();
+    void parseList(const std::function<void(YamlParser *p)> &parseCallback);
+    QVariant parseVariant();
+
+    // convenience
+    QStringList parseStringOrStringList();
+
+    enum FieldType { Scalar = 0x01, List = 0x02, Map = 0x04 };
+    Q_DECLARE_FLAGS(FieldTypes, FieldType)
+
+    struct Field
+    {
+        QByteArray name;
+        bool required;
+        FieldTypes types;
+        std::function<void(YamlParser *)> callback;
+
+        Field(const char *_name, bool _required, FieldTypes _types,
+              const std::function<void(YamlParser *)> &_callback)
+            : name(_name)
+            , required(_required)
+            , types(_types)
+            , callback(_callback)
+        { }
+    };
+    typedef std::vector<Field> Fields;
+
+    void parseFields(const Fields &fields);
+
+    Q_NORETURN void throwParseError(const QString &message) const Q_DECL_NOEXCEPT_EXPR(false);
+
+private:
+    Q_DISABLE_COPY(YamlParser)
+    bool resolveAlias(QVariant *value);
+    void storeAnchor(const QByteArray &anchor, const QVariant &value);
+
+    YamlParserPrivate *d;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(YamlParser::FieldTypes)
+
+QT_END_NAMESPACE_AM
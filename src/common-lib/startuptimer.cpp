@@ -46,6 +46,11 @@
 #  define _WIN32_WINNT _WIN32_WINNT_VISTA
 #endif
 
+#include <chrono>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+
 #include "startuptimer.h"
 #include "utilities.h"
 
@@ -94,6 +99,40 @@
     is running in multi-process mode, additional reports will also be printed for every QML
     application that is started. Note that the bar widths can only be compared within a report.
 
+    Instead of the human readable report, a machine-readable export can be requested by setting
+    the \c $AM_STARTUP_TIMER_FORMAT environment variable:
+
+    \table
+    \header
+        \li Value
+        \li Format
+    \row
+        \li \c text
+        \li The default, human readable report shown below.
+    \row
+        \li \c json
+        \li One JSON object per line and checkpoint (JSON Lines), containing the \c process
+            name (QCoreApplication::applicationName), the \c pid, the \c report title (either
+            \c System-UI or the application id), the \c checkpoint name, the time in
+            microseconds since the process was started (\c sinceStart) and an absolute
+            \c timestamp in microseconds, based on the system's monotonic clock. The
+            application start events (see below) carry the same \c process and \c pid fields.
+    \row
+        \li \c trace
+        \li The Chrome trace-event format (JSON array format), which can be loaded into
+            \c{chrome://tracing} or Perfetto. Each process is shown as a separate track, with one
+            slice per checkpoint.
+    \endtable
+
+    In both machine-readable formats, the output file is opened in append mode, so that the
+    System-UI and all the launcher processes (which inherit the environment) write into the same
+    file. Since all timestamps are based on the same monotonic clock, this results in a single
+    timeline across all processes. In addition, the System-UI records the major steps of every
+    application start (starting at ApplicationManager::startApplication) as events carrying the
+    application id and the pid of the application's process. This makes it possible to follow the
+    startup of an application all the way from the request in the System-UI to the first frame
+    drawn in the launcher.
+
     The application-manager and its QML launcher will already create a lot of checkpoints on their
     own and will also call createReport themselves after all the C++ side setup has finished. You
     can however add arbitrary checkpoints yourself using the QML API: access to the StartupTimer
@@ -199,6 +238,13 @@ struct SplitSeconds
     int usec;
 };
 
+static quint64 monotonicMicroSecs()
+{
+    // this is the same clock for all processes: CLOCK_MONOTONIC on Linux
+    using namespace std::chrono;
+    return quint64(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
 static SplitSeconds splitMicroSecs(quint64 micros)
 {
     SplitSeconds ss;
@@ -221,10 +267,30 @@ StartupTimer::StartupTimer()
     QByteArray useTimer = qgetenv("AM_STARTUP_TIMER");
     if (useTimer.isNull())
         return;
-    else if (useTimer.isEmpty() || useTimer == "1")
+
+    const QByteArray format = qgetenv("AM_STARTUP_TIMER_FORMAT");
+    if (format == "json")
+        m_format = JsonFormat;
+    else if (format == "trace")
+        m_format = ChromeTraceFormat;
+    else if (!format.isEmpty() && format != "text")
+        qWarning("StartupTimer: unknown output format '%s' - using 'text' instead", format.constData());
+
+    if (useTimer.isEmpty() || useTimer == "1") {
         m_output = stderr;
-    else
+    } else if (m_format == TextFormat) {
         m_output = fopen(useTimer, "w");
+    } else {
+        // all processes append their records to the same file to get a combined timeline
+        m_output = fopen(useTimer, "a");
+    }
+
+    // the JSON array format does not require a closing ']', which makes it possible to simply
+    // keep on appending events
+    if (m_output && (m_format == ChromeTraceFormat)) {
+        if ((fseek(m_output, 0, SEEK_END) == 0) && (ftell(m_output) == 0))
+            fputs("[\n", m_output);
+    }
 
 #if defined(Q_OS_WIN)
     // Windows reports FILETIMEs in 100nsec steps: divide by 10 to get usec
@@ -363,8 +429,10 @@ StartupTimer::StartupTimer()
     m_initialized = false;
 #endif
 
-    if (m_initialized)
+    if (m_initialized) {
         m_timer.start();
+        m_timerStartTime = monotonicMicroSecs();
+    }
 }
 
 StartupTimer *StartupTimer::s_instance = new StartupTimer();
@@ -415,6 +483,8 @@ void StartupTimer::reset()
     if (m_initialized) {
         SplitSeconds delta = splitMicroSecs(quint64(m_timer.nsecsElapsed() / 1000) + m_processCreation);
         m_timer.restart();
+        m_timerStartTime = monotonicMicroSecs();
+        m_lastReportedCheckpoint = 0;
         m_checkpoints.clear();
         m_processCreation = 0;
 
@@ -424,6 +494,54 @@ void StartupTimer::reset()
     }
 }
 
+void StartupTimer::timelineEvent(const char *name, const QString &applicationId, qint64 applicationPid)
+{
+    if (Q_LIKELY(!m_initialized || !m_output || (m_format == TextFormat)))
+        return;
+
+    const quint64 pid = quint64(QCoreApplication::applicationPid());
+    const quint64 now = monotonicMicroSecs();
+
+    if (m_format == JsonFormat) {
+        writeRecord(QJsonDocument(QJsonObject {
+            { qSL("process"), QCoreApplication::applicationName() },
+            { qSL("pid"), double(pid) },
+            { qSL("event"), qL1S(name) },
+            { qSL("applicationId"), applicationId },
+            { qSL("applicationPid"), double(applicationPid) },
+            { qSL("timestamp"), double(now) }
+        }).toJson(QJsonDocument::Compact));
+    } else {
+        // a global instant event is drawn as a line across all tracks
+        writeRecord(QJsonDocument(QJsonObject {
+            { qSL("name"), QString(qL1S(name) + qSL(": ") + applicationId) },
+            { qSL("cat"), qSL("application") },
+            { qSL("ph"), qSL("i") },
+            { qSL("s"), qSL("g") },
+            { qSL("pid"), double(pid) },
+            { qSL("tid"), double(pid) },
+            { qSL("ts"), double(now) },
+            { qSL("args"), QJsonObject {
+                  { qSL("applicationId"), applicationId },
+                  { qSL("applicationPid"), double(applicationPid) }
+              } }
+        }).toJson(QJsonDocument::Compact));
+    }
+}
+
+quint64 StartupTimer::processStartTime() const
+{
+    return m_timerStartTime - m_processCreation;
+}
+
+void StartupTimer::writeRecord(const QByteArray &json)
+{
+    // one fwrite per record: the file is shared with other processes in append mode
+    const QByteArray line = json + ((m_format == ChromeTraceFormat) ? ",\n" : "\n");
+    fwrite(line.constData(), 1, size_t(line.size()), m_output);
+    fflush(m_output);
+}
+
 void StartupTimer::createAutomaticReport(const QString &title)
 {
     if (m_automaticReporting)
@@ -445,7 +563,51 @@ void StartupTimer::setAutomaticReporting(bool enableAutomaticReporting)
 
 void StartupTimer::createReport(const QString &title)
 {
-    if (m_output && !m_checkpoints.isEmpty()) {
+    if (m_output && !m_checkpoints.isEmpty() && (m_format != TextFormat)) {
+        const quint64 pid = quint64(QCoreApplication::applicationPid());
+        const quint64 processStart = processStartTime();
+
+        if (m_format == ChromeTraceFormat) {
+            writeRecord(QJsonDocument(QJsonObject {
+                { qSL("name"), qSL("process_name") },
+                { qSL("ph"), qSL("M") },
+                { qSL("pid"), double(pid) },
+                { qSL("args"), QJsonObject { { qSL("name"), title } } }
+            }).toJson(QJsonDocument::Compact));
+        }
+
+        quint64 lastUsec = m_lastReportedCheckpoint;
+        for (const auto &cp : qAsConst(m_checkpoints)) {
+            const quint64 usec = cp.first;
+            const QString text = QString::fromLocal8Bit(cp.second);
+
+            if (m_format == JsonFormat) {
+                writeRecord(QJsonDocument(QJsonObject {
+                    { qSL("process"), QCoreApplication::applicationName() },
+                    { qSL("pid"), double(pid) },
+                    { qSL("report"), title },
+                    { qSL("checkpoint"), text },
+                    { qSL("sinceStart"), double(usec) },
+                    { qSL("timestamp"), double(processStart + usec) }
+                }).toJson(QJsonDocument::Compact));
+            } else {
+                // a complete event, spanning the time since the previous checkpoint
+                writeRecord(QJsonDocument(QJsonObject {
+                    { qSL("name"), text },
+                    { qSL("cat"), qSL("startup") },
+                    { qSL("ph"), qSL("X") },
+                    { qSL("pid"), double(pid) },
+                    { qSL("tid"), double(pid) },
+                    { qSL("ts"), double(processStart + lastUsec) },
+                    { qSL("dur"), double(usec > lastUsec ? usec - lastUsec : 0) },
+                    { qSL("args"), QJsonObject { { qSL("sinceStart"), double(usec) } } }
+                }).toJson(QJsonDocument::Compact));
+            }
+            lastUsec = usec;
+        }
+        m_lastReportedCheckpoint = lastUsec;
+        m_checkpoints.clear();
+    } else if (m_output && !m_checkpoints.isEmpty()) {
         bool ansiColorSupport = false;
         if (m_output == stderr)
             getOutputInformation(&ansiColorSupport, nullptr, nullptr);
@@ -70,6 +70,7 @@ public:
     bool automaticReporting() const;
 
     void checkpoint(const char *name);
+    void timelineEvent(const char *name, const QString &applicationId, qint64 applicationPid = 0);
     void createAutomaticReport(const QString &title);
     void checkFirstFrame();
     void reset();
@@ -83,15 +84,26 @@ signals:
     void automaticReportingChanged(bool setAutomaticReporting);
 
 private:
+    enum OutputFormat {
+        TextFormat,
+        JsonFormat,
+        ChromeTraceFormat
+    };
+
     StartupTimer();
+    void writeRecord(const QByteArray &json);
+    quint64 processStartTime() const;
     static StartupTimer *s_instance;
 
     FILE *m_output = nullptr;
+    OutputFormat m_format = TextFormat;
     bool m_initialized = false;
     bool m_automaticReporting = true;
     quint64 m_processCreation = 0;
     quint64 m_timeToFirstFrame = 0;
     quint64 m_systemUpTime = 0;
+    quint64 m_timerStartTime = 0; // monotonic clock, in usec
+    quint64 m_lastReportedCheckpoint = 0;
     QElapsedTimer m_timer;
     QVector<QPair<quint64, QByteArray>> m_checkpoints;
 
@@ -353,16 +353,7 @@ qint64 getParentPid(qint64 pid)
     qint64 ppid = 0;
 
 #if defined(Q_OS_LINUX)
-    static QString proc = qSL("/proc/%1/stat");
-    QFile f(proc.arg(pid));
-    if (f.open(QIODevice::ReadOnly)) {
-        // we need just the 4th field, but the 2nd is the binary name, which could be long
-        QByteArray ba = f.read(512);
-        // the binary name could contain ')' and/or ' ' and the kernel escapes neither...
-        int pos = ba.lastIndexOf(')');
-        if (pos > 0 && ba.length() > (pos + 5))
-            ppid = strtoll(ba.constData() + pos + 4, nullptr, 10);
-    }
+    getProcessStat(pid, &ppid, nullptr);
 
 #elif defined(Q_OS_MACOS) || defined(Q_OS_IOS)
     int mibNames[] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, (pid_t) pid };
@@ -395,6 +386,47 @@ qint64 getParentPid(qint64 pid)
     return ppid;
 }
 
+quint64 getProcessStartTime(qint64 pid)
+{
+    quint64 startTime = 0;
+    getProcessStat(pid, nullptr, &startTime);
+    return startTime;
+}
+
+bool getProcessStat(qint64 pid, qint64 *parentPid, quint64 *startTime)
+{
+    if (parentPid)
+        *parentPid = 0;
+    if (startTime)
+        *startTime = 0;
+
+#if defined(Q_OS_LINUX)
+    static QString proc = qSL("/proc/%1/stat");
+    QFile f(proc.arg(pid));
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray ba = f.read(1024);
+    // the 2nd field is the binary name, which could contain ')' and/or ' ' and the kernel
+    // escapes neither: the fields after the binary name start with the 3rd one
+    int pos = ba.lastIndexOf(')');
+    if (pos <= 0)
+        return false;
+    const QList<QByteArray> fields = ba.mid(pos + 2).split(' ');
+    if (fields.size() <= 19)
+        return false;
+    if (parentPid)
+        *parentPid = fields.at(1).toLongLong(); // the 4th field
+    if (startTime)
+        *startTime = fields.at(19).toULongLong(); // the 22nd field
+    return true;
+#else
+    if (parentPid)
+        *parentPid = getParentPid(pid);
+    return false;
+#endif
+}
+
 int timeoutFactor()
 {
     static int tf = 0;
@@ -134,6 +134,12 @@ bool safeRemove(const QString &path, RecursiveOperationType type);
 void getOutputInformation(bool *ansiColorSupport, bool *runningInCreator, int *consoleWidth);
 
 qint64 getParentPid(qint64 pid);
+// The start time of a process in clock ticks since boot: together with the pid this uniquely
+// identifies a process, even if pids get recycled. Returns 0 if the time cannot be determined.
+quint64 getProcessStartTime(qint64 pid);
+// Both of the above with a single read of /proc/<pid>/stat (Linux only). Returns false if the
+// process does not exist (anymore) or if the information is not available on this platform.
+bool getProcessStat(qint64 pid, qint64 *parentPid, quint64 *startTime);
 
 QVector<QObject *> loadPlugins_helper(const char *type, const QStringList &files, const char *iid) Q_DECL_NOEXCEPT_EXPR(false);
 
@@ -17,6 +17,8 @@ QT_FOR_PRIVATE *= \
 CONFIG *= static internal_module
 CONFIG -= create_cmake
 
+linux:LIBS *= -ldl
+
 DBUS_INTERFACES += ../dbus-lib/io.qt.applicationmanager.intentinterface.xml
 
 SOURCES += \
@@ -25,7 +27,8 @@ SOURCES += \
     qmlapplicationinterfaceextension.cpp \
     qmlnotification.cpp \
     launchermain.cpp \
-    intentclientdbusimplementation.cpp
+    intentclientdbusimplementation.cpp \
+    zygote.cpp
 
 !headless:SOURCES += \
     applicationmanagerwindow.cpp \
@@ -46,7 +49,8 @@ HEADERS += \
     qmlapplicationinterfaceextension.h \
     qmlnotification.h \
     launchermain.h \
-    intentclientdbusimplementation.h
+    intentclientdbusimplementation.h \
+    zygote.h
 
 !headless:HEADERS += \
     applicationmanagerwindow_p.h
@@ -49,6 +49,11 @@
 #include <QtAppManCommon/exception.h>
 
 #include <QtAppManCommon/qtyaml.h>
+#include <QtAppManCommon/binaryconfiguration.h>
+
+#if defined(Q_OS_UNIX)
+#  include <unistd.h>
+#endif
 
 #if !defined(AM_HEADLESS) && defined(QT_WAYLANDCLIENT_LIB)
 #  include <QWindow>
@@ -193,10 +198,33 @@ void LauncherMain::setApplicationId(const QString &applicationId)
 
 void LauncherMain::loadConfiguration(const QByteArray &configYaml) Q_DECL_NOEXCEPT_EXPR(false)
 {
-    auto docs = QtYaml::variantDocumentsFromYaml(configYaml.isEmpty() ? qgetenv("AM_CONFIG")
-                                                                      : configYaml);
-    if (docs.size() == 1)
-        m_configuration = docs.first().toMap();
+    const QByteArray configFd = qgetenv("AM_CONFIG_FD");
+
+    if (configYaml.isEmpty() && !configFd.isEmpty()) {
+        // The application manager handed us a sealed memfd with the binary encoded configuration.
+        // Close it right away: neither the app nor any of its children should ever see it.
+        bool ok;
+        int fd = configFd.toInt(&ok);
+        qunsetenv("AM_CONFIG_FD");
+        if (!ok || fd < 0)
+            throw Exception("Runtime launcher received an invalid AM_CONFIG_FD: %1").arg(configFd);
+        QString errorString;
+        try {
+            m_configuration = BinaryConfiguration::readFileDescriptor(fd);
+        } catch (const Exception &e) {
+            errorString = e.errorString();
+        }
+#if defined(Q_OS_UNIX)
+        ::close(fd);
+#endif
+        if (!errorString.isEmpty())
+            throw Exception("Runtime launcher could not read its configuration: %1").arg(errorString);
+    } else {
+        auto docs = QtYaml::variantDocumentsFromYaml(configYaml.isEmpty() ? qgetenv("AM_CONFIG")
+                                                                          : configYaml);
+        if (docs.size() == 1)
+            m_configuration = docs.first().toMap();
+    }
 
     m_baseDir = m_configuration.value(qSL("baseDir")).toString() + qL1C('/');
     m_runtimeConfiguration = m_configuration.value(qSL("runtimeConfiguration")).toMap();
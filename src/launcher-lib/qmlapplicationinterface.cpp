@@ -125,6 +125,9 @@ bool QmlApplicationInterface::initialize()
     if (!ok)
         qCritical("ERROR: could not connect the RuntimeInterface via D-Bus: %s", qPrintable(m_runtimeIf->lastError().name()));
 
+    // optional: only used to pre-warm idle quick-launchers
+    connect(m_runtimeIf, SIGNAL(preloadImports(QStringList)), this, SIGNAL(preloadImports(QStringList)));
+
     ok = ok && connect(m_applicationIf, SIGNAL(quit()), this, SIGNAL(quit()));
     ok = ok && connect(m_applicationIf, SIGNAL(memoryLowWarning()), this, SIGNAL(memoryLowWarning()));
     ok = ok && connect(m_applicationIf, SIGNAL(memoryCriticalWarning()), this, SIGNAL(memoryCriticalWarning()));
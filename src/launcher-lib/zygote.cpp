@@ -0,0 +1,300 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QStringList>
+#include <QVector>
+
+#if defined(Q_OS_LINUX)
+#  include <errno.h>
+#  include <poll.h>
+#  include <signal.h>
+#  include <stdio.h>
+#  include <stdlib.h>
+#  include <string.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <dlfcn.h>
+#  include <sys/prctl.h>
+#  include <sys/socket.h>
+#  include <sys/wait.h>
+#endif
+
+#include "zygote.h"
+
+QT_BEGIN_NAMESPACE_AM
+
+#if defined(Q_OS_LINUX)
+
+// The wire format is shared with the ZygoteProcess in manager-lib's processcontainer.cpp: every
+// message is a native-endian quint32 size, followed by a QDataStream serialized payload.
+//  request:  quint32 requestId, QStringList arguments, QStringList environment, QString workingDir
+//            (optionally with the binary configuration fd attached via SCM_RIGHTS - see AM_CONFIG_FD)
+//  replies:  'S' quint32 requestId, qint64 pid  - the child has been forked
+//            'E' quint32 requestId, qint32 errno - fork failed
+//            'F' qint64 pid, qint32 exitCode, bool crashed - a child has terminated
+
+static bool readFully(int fd, char *data, size_t size)
+{
+    while (size) {
+        ssize_t result = ::read(fd, data, size);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return false;
+        data += result;
+        size -= size_t(result);
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const char *data, size_t size)
+{
+    while (size) {
+        ssize_t result = ::write(fd, data, size);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return false;
+        data += result;
+        size -= size_t(result);
+    }
+    return true;
+}
+
+static bool writeMessage(int fd, const QByteArray &payload)
+{
+    quint32 size = quint32(payload.size());
+    return writeFully(fd, reinterpret_cast<const char *>(&size), sizeof(size))
+            && writeFully(fd, payload.constData(), size_t(payload.size()));
+}
+
+static bool readMessage(int fd, QByteArray *payload, int *receivedFd)
+{
+    *receivedFd = -1;
+
+    // a file descriptor is always attached to the first byte of a message: the kernel makes sure
+    // that we do not receive it together with the end of the previous message.
+    quint32 size;
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct iovec iov = { &size, sizeof(size) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    ssize_t result;
+    do {
+        result = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (result < 0 && errno == EINTR);
+    if (result <= 0)
+        return false;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS)
+                && (cmsg->cmsg_len == CMSG_LEN(sizeof(int)))) {
+            memcpy(receivedFd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    if (!readFully(fd, reinterpret_cast<char *>(&size) + result, sizeof(size) - size_t(result))
+            || size > 16 * 1024 * 1024) {
+        return false;
+    }
+    payload->resize(int(size));
+    return readFully(fd, payload->data(), size);
+}
+
+static void sigChildHandler(int)
+{
+    // only needed to interrupt ppoll()
+}
+
+void Zygote::runIfRequested(int &argc, char **&argv)
+{
+    const char *fdString = getenv("AM_ZYGOTE_FD");
+    if (!fdString)
+        return;
+    int fd = atoi(fdString);
+    unsetenv("AM_ZYGOTE_FD");
+    if (fd <= 2)
+        return;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    // make sure to go down together with the application manager
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+    // Libraries that are loaded here are shared (copy-on-write) by all children: this saves the
+    // dynamic linking at startup as well as memory.
+    if (const char *preload = getenv("AM_ZYGOTE_PRELOAD")) {
+        const QList<QByteArray> libraries = QByteArray(preload).split(':');
+        for (const QByteArray &library : libraries) {
+            if (!library.isEmpty() && !dlopen(library.constData(), RTLD_NOW | RTLD_GLOBAL))
+                fprintf(stderr, "zygote: could not preload %s: %s\n", library.constData(), dlerror());
+        }
+        unsetenv("AM_ZYGOTE_PRELOAD");
+    }
+
+    // SIGCHLD is only delivered while waiting in ppoll(), so we cannot miss a terminated child
+    sigset_t childMask;
+    sigset_t originalMask;
+    sigemptyset(&childMask);
+    sigaddset(&childMask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &childMask, &originalMask);
+
+    struct sigaction sa;
+    struct sigaction originalSa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sigChildHandler;
+    sa.sa_flags = SA_NOCLDSTOP;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGCHLD, &sa, &originalSa);
+
+    forever {
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            QByteArray reply;
+            QDataStream ds(&reply, QIODevice::WriteOnly);
+            bool crashed = WIFSIGNALED(status);
+            ds << quint8('F') << qint64(pid) << qint32(crashed ? WTERMSIG(status) : WEXITSTATUS(status)) << crashed;
+            if (!writeMessage(fd, reply))
+                _exit(0);
+        }
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (ppoll(&pfd, 1, nullptr, &originalMask) < 0) {
+            if (errno == EINTR)
+                continue;
+            _exit(1);
+        }
+        if (!(pfd.revents & POLLIN))
+            _exit(0); // the application manager closed the connection
+
+        QByteArray request;
+        int configFd;
+        if (!readMessage(fd, &request, &configFd))
+            _exit(0);
+
+        quint32 requestId;
+        QStringList arguments;
+        QStringList environment;
+        QString workingDirectory;
+        QDataStream ds(request);
+        ds >> requestId >> arguments >> environment >> workingDirectory;
+        if (ds.status() != QDataStream::Ok) {
+            if (configFd >= 0)
+                ::close(configFd);
+            continue;
+        }
+
+        pid_t child = fork();
+        if (child == 0) {
+            ::close(fd);
+            sigaction(SIGCHLD, &originalSa, nullptr);
+            sigprocmask(SIG_SETMASK, &originalMask, nullptr);
+            // the zygote is single-threaded, so this also covers the death of the zygote process
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+            clearenv();
+            for (const QString &variable : qAsConst(environment)) {
+                int eq = variable.indexOf(QLatin1Char('='));
+                if (eq > 0)
+                    setenv(variable.left(eq).toLocal8Bit().constData(), variable.mid(eq + 1).toLocal8Bit().constData(), 1);
+            }
+            // the fd number in the application manager is meaningless in here
+            if (configFd >= 0)
+                setenv("AM_CONFIG_FD", QByteArray::number(configFd).constData(), 1);
+            else
+                unsetenv("AM_CONFIG_FD");
+            if (!workingDirectory.isEmpty() && (chdir(workingDirectory.toLocal8Bit().constData()) != 0)) {
+                fprintf(stderr, "zygote: could not change the working directory to %s: %s\n",
+                        qPrintable(workingDirectory), strerror(errno));
+                _exit(2);
+            }
+
+            // the child's command line needs to stay valid for the lifetime of the process
+            static QVector<QByteArray> argumentStorage;
+            static QVector<char *> argumentPointers;
+            argumentStorage << QByteArray(argv[0]);
+            for (const QString &argument : qAsConst(arguments))
+                argumentStorage << argument.toLocal8Bit();
+            for (QByteArray &argument : argumentStorage)
+                argumentPointers << argument.data();
+            argumentPointers << nullptr;
+
+            argc = argumentStorage.size();
+            argv = argumentPointers.data();
+            return;
+        }
+
+        if (configFd >= 0)
+            ::close(configFd);
+
+        QByteArray reply;
+        QDataStream rds(&reply, QIODevice::WriteOnly);
+        if (child < 0)
+            rds << quint8('E') << requestId << qint32(errno);
+        else
+            rds << quint8('S') << requestId << qint64(child);
+        if (!writeMessage(fd, reply))
+            _exit(0);
+    }
+}
+
+#else
+
+void Zygote::runIfRequested(int &argc, char **&argv)
+{
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+}
+
+#endif
+
+QT_END_NAMESPACE_AM
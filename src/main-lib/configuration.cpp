@@ -355,7 +355,7 @@ void Configuration::parseWithArguments(const QStringList &arguments, QStringList
     }
 
     // reads a single config file and calculates its hash - defined as lambda to be usable
-    // both via QtConcurrent and via std:for_each
+    // both via QtConcurrent and via std::for_each
     auto readConfigFile = [&useCache, &deploymentWarnings](ConfigFile &cf) {
         QFile file(cf.filePath);
         if (!file.open(QIODevice::ReadOnly))
@@ -394,22 +394,26 @@ void Configuration::parseWithArguments(const QStringList &arguments, QStringList
         m_config = cache;
     } else if (!configFilePaths.isEmpty()) {
         auto parseConfigFile = [](ConfigFile &cf) {
-            QtYaml::ParseError parseError;
-            QVector<QVariant> docs = QtYaml::variantDocumentsFromYaml(cf.content, &parseError);
+            try {
+                YamlParser p(cf.content, cf.filePath);
+                auto header = p.parseHeader();
+                if (header.first != qL1S("am-configuration")) {
+                    throw Exception("wrong formatType header: expected 'am-configuration', got '%1'")
+                            .arg(header.first);
+                }
+                if (header.second != 1)
+                    throw Exception("wrong formatVersion header: expected 1, got %1").arg(header.second);
+                if (!p.nextDocument())
+                    throw Exception("wrong number of YAML documents: expected 2, got 1");
 
-            if (parseError.error != QJsonParseError::NoError) {
-                throw Exception("Could not parse config file '%1', line %2, column %3: %4.\n")
-                        .arg(cf.filePath).arg(parseError.line).arg(parseError.column)
-                        .arg(parseError.errorString());
-            }
+                cf.config = p.parseMap();
 
-            try {
-                checkYamlFormat(docs, 2 /*number of expected docs*/, { "am-configuration" }, 1);
+                if (p.nextDocument())
+                    throw Exception("wrong number of YAML documents: expected 2, got more");
             } catch (const Exception &e) {
                 throw Exception("Could not parse config file '%1': %2.\n")
                         .arg(cf.filePath).arg(e.errorString());
             }
-            cf.config = docs.at(1).toMap();
         };
 
         try {
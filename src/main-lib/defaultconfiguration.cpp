@@ -84,6 +84,11 @@ DefaultConfiguration::DefaultConfiguration(const QStringList &defaultConfigFileP
         "                    on the console. Anything other than 1 will be interpreted\n"
         "                    as the name of a file that is used instead of the console.\n"
         "\n"
+        "  AM_STARTUP_TIMER_FORMAT  can be set to 'json' (JSON Lines) or 'trace' (Chrome\n"
+        "                           trace-event format) to get a machine-readable startup\n"
+        "                           analysis of the System-UI and all launchers, instead\n"
+        "                           of the default 'text' report.\n"
+        "\n"
         "  AM_FORCE_COLOR_OUTPUT  can be set to 'on' to force color output to the console\n"
         "                         and to 'off' to disable it. Any other value will result\n"
         "                         in the default, auto-detection behavior.\n";
@@ -483,6 +488,12 @@ bool DefaultConfiguration::applicationUserIdSeparation(uint *minUserId, uint *ma
     return false;
 }
 
+int DefaultConfiguration::maximumConcurrentApplicationStarts() const
+{
+    QVariant maximum = value<QVariant>(nullptr, { "applications", "maximumConcurrentStarts" });
+    return maximum.isValid() ? qMax(0, maximum.toInt()) : 2;
+}
+
 qreal DefaultConfiguration::quickLaunchIdleLoad() const
 {
     return value<QVariant>(nullptr, { "quicklaunch", "idleLoad" }).toReal();
@@ -498,6 +509,27 @@ int DefaultConfiguration::quickLaunchRuntimesPerContainer() const
     return qBound(0, rpc, 10);
 }
 
+int DefaultConfiguration::quickLaunchMaximumRuntimesPerContainer() const
+{
+    int rpc = quickLaunchRuntimesPerContainer();
+    int maximum = value<QVariant>(nullptr, { "quicklaunch", "maximumRuntimesPerContainer" }).toInt();
+    if (maximum <= 0)
+        maximum = 2 * rpc;
+
+    // same reasoning as above
+    return qBound(rpc, maximum, 10);
+}
+
+qreal DefaultConfiguration::quickLaunchMemoryPressureThreshold() const
+{
+    return qBound(qreal(0), value<QVariant>(nullptr, { "quicklaunch", "memoryPressureThreshold" }).toReal(), qreal(1));
+}
+
+int DefaultConfiguration::notificationUpdateCoalescingInterval() const
+{
+    return qMax(0, value<QVariant>(nullptr, { "notifications", "updateCoalescingInterval" }).toInt());
+}
+
 QString DefaultConfiguration::waylandSocketName() const
 {
 #if !defined(AM_HEADLESS)
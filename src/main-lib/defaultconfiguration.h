@@ -113,9 +113,14 @@ public:
     QVariantMap rawSystemProperties() const;
 
     bool applicationUserIdSeparation(uint *minUserId, uint *maxUserId, uint *commonGroupId) const;
+    int maximumConcurrentApplicationStarts() const;
 
     qreal quickLaunchIdleLoad() const;
     int quickLaunchRuntimesPerContainer() const;
+    int quickLaunchMaximumRuntimesPerContainer() const;
+    qreal quickLaunchMemoryPressureThreshold() const;
+
+    int notificationUpdateCoalescingInterval() const;
 
     QString waylandSocketName() const;
 
@@ -150,6 +150,7 @@
 #include "memorystatus.h"
 #include "monitormodel.h"
 #include "processstatus.h"
+#include "controlgroupstatus.h"
 
 #include "../plugin-interfaces/startupinterface.h"
 
@@ -240,10 +241,14 @@ void Main::setup(const DefaultConfiguration *cfg, const QStringList &deploymentW
                                cfg->containerConfigurations(), cfg->pluginFilePaths("container"),
                                cfg->iconThemeSearchPaths(), cfg->iconThemeName());
 
-    loadPackageDatabase(cfg->recreateDatabase(), cfg->singleApp());
+    loadPackageDatabase(cfg->database(), cfg->recreateDatabase(), cfg->singleApp());
 
     setupSingletons(cfg->containerSelectionConfiguration(), cfg->quickLaunchRuntimesPerContainer(),
                     cfg->quickLaunchIdleLoad());
+    m_applicationManager->setMaximumConcurrentStarts(cfg->maximumConcurrentApplicationStarts());
+    m_notificationManager->setUpdateCoalescingInterval(cfg->notificationUpdateCoalescingInterval());
+    m_quickLauncher->setMaximumRuntimesPerContainer(cfg->quickLaunchMaximumRuntimesPerContainer());
+    m_quickLauncher->setMemoryPressureThreshold(cfg->quickLaunchMemoryPressureThreshold());
 
     if (m_installationDir.isEmpty() || cfg->disableInstaller()) {
         StartupTimer::instance()->checkpoint("skipping installer");
@@ -428,12 +433,14 @@ void Main::setupRuntimesAndContainers(const QVariantMap &runtimeConfigurations,
     StartupTimer::instance()->checkpoint("after runtime registration");
 }
 
-void Main::loadPackageDatabase(bool recreateDatabase, const QString &singlePackage) Q_DECL_NOEXCEPT_EXPR(false)
+void Main::loadPackageDatabase(const QString &databaseCache, bool recreateDatabase,
+                               const QString &singlePackage) Q_DECL_NOEXCEPT_EXPR(false)
 {
     if (!singlePackage.isEmpty()) {
         m_packageDatabase = new PackageDatabase(singlePackage);
     } else {
         m_packageDatabase = new PackageDatabase(m_builtinAppsManifestDirs, m_installationDir);
+        m_packageDatabase->setCacheFilePath(databaseCache);
         if (!recreateDatabase)
             m_packageDatabase->enableLoadFromCache();
         m_packageDatabase->enableSaveToCache();
@@ -619,6 +626,7 @@ void Main::setupQmlEngine(const QStringList &importPaths, const QString &quickCo
     qmlRegisterType<MemoryStatus>("QtApplicationManager", 2, 0, "MemoryStatus");
     qmlRegisterType<MonitorModel>("QtApplicationManager", 2, 0, "MonitorModel");
     qmlRegisterType<ProcessStatus>("QtApplicationManager.SystemUI", 2, 0, "ProcessStatus");
+    qmlRegisterType<ControlGroupStatus>("QtApplicationManager.SystemUI", 2, 0, "ControlGroupStatus");
 
     StartupTimer::instance()->checkpoint("after QML registrations");
 
@@ -113,6 +113,11 @@ QString AbstractContainer::mapHostPathToContainer(const QString &hostPath) const
     return hostPath;
 }
 
+bool AbstractContainer::supportsBinaryConfiguration() const
+{
+    return false;
+}
+
 AbstractContainerProcess *AbstractContainer::process() const
 {
     return m_process;
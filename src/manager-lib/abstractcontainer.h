@@ -118,6 +118,11 @@ public:
     virtual QString mapContainerPathToHost(const QString &containerPath) const;
     virtual QString mapHostPathToContainer(const QString &hostPath) const;
 
+    // If a container supports this, the runtime does not need to add the YAML encoded AM_CONFIG
+    // variable to the runtimeEnvironment: the container will instead pass amConfig on to the
+    // program in a more efficient way (see AM_CONFIG_FD in launchermain.cpp).
+    virtual bool supportsBinaryConfiguration() const;
+
     virtual AbstractContainerProcess *start(const QStringList &arguments,
                                             const QMap<QString, QString> &runtimeEnvironment,
                                             const QVariantMap &amConfig) = 0;
@@ -150,6 +150,12 @@ bool AbstractRuntime::attachApplicationToQuickLauncher(Application *app)
     return false;
 }
 
+bool AbstractRuntime::preloadImports(const QStringList &imports)
+{
+    Q_UNUSED(imports)
+    return false;
+}
+
 Am::RunState AbstractRuntime::state() const
 {
     return m_state;
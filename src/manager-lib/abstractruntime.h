@@ -119,6 +119,7 @@ public:
     virtual bool needsLauncher() const;
     virtual bool isQuickLauncher() const;
     virtual bool attachApplicationToQuickLauncher(Application *app);
+    virtual bool preloadImports(const QStringList &imports);
 
     Am::RunState state() const;
 
@@ -142,6 +143,8 @@ public:
 signals:
     void stateChanged(QT_PREPEND_NAMESPACE_AM(Am::RunState) newState);
     void finished(int exitCode, Am::ExitStatus status);
+    // emitted by a quick-launcher, as soon as an application can be attached to it
+    void quickLauncherReady();
 
 #if !defined(AM_HEADLESS)
     // these signals are for in-process mode runtimes only
@@ -49,12 +49,20 @@
 #include <QUuid>
 #include <QThread>
 #include <QMimeDatabase>
+#include <QVarLengthArray>
+#include <algorithm>
 #if defined(QT_GUI_LIB)
 #  include <QDesktopServices>
 #endif
 #if defined(Q_OS_UNIX)
 #  include <signal.h>
 #endif
+#if defined(Q_OS_LINUX)
+#  include <errno.h>
+#  include <poll.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#endif
 
 #include "global.h"
 #include "applicationinfo.h"
@@ -74,7 +82,9 @@
 #include "utilities.h"
 #include "qtyaml.h"
 #include "debugwrapper.h"
+#include "startuptimer.h"
 #include "amnamespace.h"
+#include "applicationstartqueue.h"
 
 /*!
     \qmltype ApplicationManager
@@ -303,11 +313,49 @@
     identified by \a id. An empty list in the \a changedRoles argument means that all roles should
     be considered modified.
 
+    This signal and the model's \c dataChanged signal are delivered asynchronously: all changes that
+    happen within one event loop iteration are collected and reported once, with the union of the
+    changed roles. Reading the model right after a change will already return the new data, but
+    the corresponding change signals will only arrive later. Changes are always reported before
+    rows are added to or removed from the model.
+
     \note In addition to the normal "low-level" QAbstractListModel signals, the application-manager
           will also emit these "high-level" signals for System-UIs that cannot work directly on the
           ApplicationManager model: applicationAdded, applicationAboutToBeRemoved and applicationChanged.
 */
 
+/*!
+    \qmlsignal ApplicationManager::queuedApplicationStartFinished(int requestId, string id, bool success, var timings)
+
+    This signal is emitted when the start of the application identified by \a id, that was
+    requested via queueApplicationStart() and returned \a requestId, has finished. \a success is
+    \c true if the application is running now.
+
+    The \a timings object holds the duration in milliseconds of each stage of the start (a stage
+    that was not reached is missing):
+
+    \table
+    \header
+        \li Name
+        \li Description
+    \row
+        \li \c queued
+        \li The time spent waiting in the start queue.
+    \row
+        \li \c preflight
+        \li The time needed to check the application's files (done on a worker thread).
+    \row
+        \li \c start
+        \li The time needed to create the container and the runtime, and to launch the process.
+    \row
+        \li \c startup
+        \li The time from launching the process until the application was reported as running.
+    \row
+        \li \c total
+        \li The time from calling queueApplicationStart() until this signal was emitted.
+    \endtable
+*/
+
 /*!
     \qmlproperty bool ApplicationManager::windowManagerCompositorReady
     \readonly
@@ -372,9 +420,110 @@ ApplicationManagerPrivate::ApplicationManagerPrivate()
 
 ApplicationManagerPrivate::~ApplicationManagerPrivate()
 {
+    clearAncestorCache();
     qDeleteAll(apps);
 }
 
+// A pidfd refers to exactly one process, even if its pid gets recycled later on. It becomes
+// readable as soon as that process has exited, so validating a cached pid is a single poll()
+// instead of opening and parsing /proc/<pid>/stat.
+static int openPidFd(qint64 pid)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_open)
+    static bool supported = true;
+    if (supported) {
+        int fd = int(syscall(SYS_pidfd_open, pid_t(pid), 0));
+        if (fd >= 0)
+            return fd;
+        if (errno == ENOSYS)
+            supported = false;
+    }
+#else
+    Q_UNUSED(pid)
+#endif
+    return -1;
+}
+
+static void closePidFd(int fd)
+{
+#if defined(Q_OS_LINUX)
+    if (fd >= 0)
+        ::close(fd);
+#else
+    Q_UNUSED(fd)
+#endif
+}
+
+bool ApplicationManagerPrivate::isAncestorCacheEntryValid(qint64 pid, const AncestorCacheEntry &entry) const
+{
+    if (!entry.app->currentRuntime() || (entry.app->currentRuntime()->applicationProcessId() != entry.appPid))
+        return false;
+
+#if defined(Q_OS_LINUX)
+    if (entry.pidFd >= 0) {
+        struct pollfd pfd = { entry.pidFd, POLLIN, 0 };
+        return (::poll(&pfd, 1, 0) == 0);
+    }
+#endif
+    // The descendant might have exited in the meantime and its pid might have been recycled
+    // by an unrelated process: without a pidfd this is detected by comparing the start times.
+    return (getProcessStartTime(pid) == entry.startTime);
+}
+
+void ApplicationManagerPrivate::clearAncestorCache() const
+{
+    for (const AncestorCacheEntry &entry : qAsConst(ancestorCache))
+        closePidFd(entry.pidFd);
+    ancestorCache.clear();
+}
+
+void ApplicationManagerPrivate::updateRuntimeIndexes(Application *app)
+{
+    const QByteArray oldToken = runningApps.take(app);
+    if (!oldToken.isEmpty())
+        securityTokenIndex.remove(oldToken);
+
+    if (AbstractRuntime *rt = app->currentRuntime()) {
+        const QByteArray token = rt->securityToken();
+        runningApps.insert(app, token);
+        securityTokenIndex.insert(token, app);
+    }
+    processIdIndex.clear();
+
+    // a runtime was started or has finished: we have no way of knowing which of the cached
+    // descendant processes are gone, so we need to start from scratch
+    clearAncestorCache();
+}
+
+Application *ApplicationManagerPrivate::lookupProcessId(qint64 pid, bool *indexRebuilt) const
+{
+    auto isMatch = [pid](Application *app) {
+        return app && app->currentRuntime() && (app->currentRuntime()->applicationProcessId() == pid);
+    };
+
+    Application *app = processIdIndex.value(pid);
+    if (isMatch(app))
+        return app;
+
+    // the process ids of runtimes are not known upfront, so we have to (re)build the index
+    // lazily - but only once per lookup and only from the apps that are actually running
+    if (!*indexRebuilt) {
+        *indexRebuilt = true;
+        processIdIndex.clear();
+        for (auto it = runningApps.cbegin(); it != runningApps.cend(); ++it) {
+            if (AbstractRuntime *rt = it.key()->currentRuntime()) {
+                qint64 appPid = rt->applicationProcessId();
+                if (appPid > 0)
+                    processIdIndex.insert(appPid, it.key());
+            }
+        }
+        app = processIdIndex.value(pid);
+        if (isMatch(app))
+            return app;
+    }
+    return nullptr;
+}
+
 ApplicationManager *ApplicationManager::s_instance = nullptr;
 
 ApplicationManager *ApplicationManager::createInstance(bool singleProcess)
@@ -429,6 +578,24 @@ ApplicationManager::ApplicationManager(bool singleProcess, QObject *parent)
     connect(this, &QAbstractItemModel::rowsRemoved, this, &ApplicationManager::countChanged);
     connect(this, &QAbstractItemModel::layoutChanged, this, &ApplicationManager::countChanged);
     connect(this, &QAbstractItemModel::modelReset, this, &ApplicationManager::countChanged);
+
+    d->dataChangedCoalescer.reset(new DataChangedCoalescer(this, [this](QObject *item) {
+        return d->appRowIndex.value(static_cast<Application *>(item), -1);
+    }, [this](int firstRow, int lastRow, const QVector<int> &roles) {
+        emit dataChanged(index(firstRow), index(lastRow), roles);
+    }, [this](QObject *item, const QVector<int> &roles) {
+        static const auto appChanged = QMetaMethod::fromSignal(&ApplicationManager::applicationChanged);
+        if (isSignalConnected(appChanged)) {
+            QStringList stringRoles;
+            for (auto role : roles)
+                stringRoles << qL1S(d->roleNames[role]);
+            emit applicationChanged(static_cast<Application *>(item)->id(), stringRoles);
+        }
+    }));
+
+    d->startQueue = new ApplicationStartQueue(this);
+    connect(d->startQueue, &ApplicationStartQueue::startFinished,
+            this, &ApplicationManager::queuedApplicationStartFinished);
 }
 
 ApplicationManager::~ApplicationManager()
@@ -505,26 +672,64 @@ QVector<Application *> ApplicationManager::applications() const
 
 Application *ApplicationManager::fromId(const QString &id) const
 {
-    for (Application *app : d->apps) {
-        if (app->id() == id)
-            return app;
-    }
-    return nullptr;
+    int row = d->appIdIndex.value(id, -1);
+    return (row < 0) ? nullptr : d->apps.at(row);
 }
 
 Application *ApplicationManager::fromProcessId(qint64 pid) const
 {
     // pid could be an indirect child (e.g. when started via gdbserver)
+    auto cached = d->ancestorCache.find(pid);
+    if (cached != d->ancestorCache.end()) {
+        if (d->isAncestorCacheEntryValid(pid, *cached))
+            return cached->app;
+        closePidFd(cached->pidFd);
+        d->ancestorCache.erase(cached);
+    }
+
+    struct Descendant
+    {
+        qint64 pid;
+        quint64 startTime;
+        int pidFd;
+    };
+
     qint64 appmanPid = QCoreApplication::applicationPid();
+    bool indexRebuilt = false;
+    Application *app = nullptr;
+    QVarLengthArray<Descendant, 8> descendants;
 
     while ((pid > 1) && (pid != appmanPid)) {
-        for (Application *app : d->apps) {
-            if (app->currentRuntime() && (app->currentRuntime()->applicationProcessId() == pid))
-                return app;
+        app = d->lookupProcessId(pid, &indexRebuilt);
+        if (app)
+            break;
+
+        // the pidfd has to be opened before reading the stat file: if the pid gets recycled
+        // in between, the pidfd will already be readable when the cache entry is validated.
+        Descendant descendant = { pid, 0, openPidFd(pid) };
+        qint64 ppid = 0;
+        getProcessStat(pid, &ppid, &descendant.startTime);
+        descendants.append(descendant);
+        pid = ppid;
+    }
+
+    for (const Descendant &descendant : qAsConst(descendants)) {
+        // Only positive results are cached: a pid that does not belong to an app right now
+        // might very well belong to a newly forked child of an app the next time around.
+        // Without a pidfd or a start time, a recycled pid could not be detected later on.
+        if (app && ((descendant.pidFd >= 0) || descendant.startTime)) {
+            // every entry holds a file descriptor, so the cache needs to stay small
+            if (d->ancestorCache.size() >= 256)
+                d->clearAncestorCache();
+            auto existing = d->ancestorCache.constFind(descendant.pid);
+            if (existing != d->ancestorCache.cend())
+                closePidFd(existing->pidFd);
+            d->ancestorCache.insert(descendant.pid, { app, pid, descendant.startTime, descendant.pidFd });
+        } else {
+            closePidFd(descendant.pidFd);
         }
-        pid = getParentPid(pid);
     }
-    return nullptr;
+    return app;
 }
 
 Application *ApplicationManager::fromSecurityToken(const QByteArray &securityToken) const
@@ -532,41 +737,17 @@ Application *ApplicationManager::fromSecurityToken(const QByteArray &securityTok
     if (securityToken.size() != AbstractRuntime::SecurityTokenSize)
         return nullptr;
 
-    for (Application *app : d->apps) {
-        if (app->currentRuntime() && app->currentRuntime()->securityToken() == securityToken)
-            return app;
-    }
-    return nullptr;
+    return d->securityTokenIndex.value(securityToken);
 }
 
 QVector<Application *> ApplicationManager::schemeHandlers(const QString &scheme) const
 {
-    QVector<Application *> handlers;
-
-    for (Application *app : d->apps) {
-        const auto mimeTypes = app->supportedMimeTypes();
-        for (const QString &mime : mimeTypes) {
-            int pos = mime.indexOf(QLatin1Char('/'));
-
-            if ((pos > 0)
-                    && (mime.left(pos) == qL1S("x-scheme-handler"))
-                    && (mime.mid(pos + 1) == scheme)) {
-                handlers << app;
-            }
-        }
-    }
-    return handlers;
+    return d->schemeIndex.value(scheme);
 }
 
 QVector<Application *> ApplicationManager::mimeTypeHandlers(const QString &mimeType) const
 {
-    QVector<Application *> handlers;
-
-    for (Application *app : d->apps) {
-        if (app->supportedMimeTypes().contains(mimeType))
-            handlers << app;
-    }
-    return handlers;
+    return d->mimeTypeIndex.value(mimeType);
 }
 
 void ApplicationManager::registerMimeTypes()
@@ -575,15 +756,8 @@ void ApplicationManager::registerMimeTypes()
     QSet<QString> schemes;
     schemes << qSL("file") << qSL("http") << qSL("https");
 
-    for (Application *app : qAsConst(d->apps)) {
-        const auto mimeTypes = app->supportedMimeTypes();
-        for (const QString &mime : mimeTypes) {
-            int pos = mime.indexOf(QLatin1Char('/'));
-
-            if ((pos > 0) && (mime.left(pos) == qL1S("x-scheme-handler")))
-                schemes << mime.mid(pos + 1);
-        }
-    }
+    for (auto it = d->schemeIndex.cbegin(); it != d->schemeIndex.cend(); ++it)
+        schemes << it.key();
     QSet<QString> registerSchemes = schemes;
     registerSchemes.subtract(d->registeredMimeSchemes);
     QSet<QString> unregisterSchemes = d->registeredMimeSchemes;
@@ -674,6 +848,8 @@ bool ApplicationManager::startApplicationInternal(const QString &appId, const QS
         }
     }
 
+    StartupTimer::instance()->timelineEvent("start requested", app->id());
+
     AbstractContainer *container = nullptr;
     QString containerId;
 
@@ -770,6 +946,10 @@ bool ApplicationManager::startApplicationInternal(const QString &appId, const QS
     }
 
     connect(runtime, &AbstractRuntime::stateChanged, this, [this, app](Am::RunState newRuntimeState) {
+        if (newRuntimeState == Am::Running) {
+            StartupTimer::instance()->timelineEvent("running", app->id(), app->currentRuntime()
+                                                    ? app->currentRuntime()->applicationProcessId() : 0);
+        }
         app->setRunState(newRuntimeState);
         emit applicationRunStateChanged(app->id(), newRuntimeState);
         emitDataChanged(app, QVector<int> { IsRunning, IsStartingUp, IsShuttingDown });
@@ -791,6 +971,8 @@ bool ApplicationManager::startApplicationInternal(const QString &appId, const QS
         bool ok = runtime->start();
         if (!ok)
             runtime->deleteLater();
+        else
+            StartupTimer::instance()->timelineEvent("runtime started", app->id());
         return ok;
     } else {
         // We can only start the app when both the container and the windowmanager are ready.
@@ -800,8 +982,13 @@ bool ApplicationManager::startApplicationInternal(const QString &appId, const QS
         auto doStartInContainer = [app, attachRuntime, runtime]() -> bool {
             bool successfullyStarted = attachRuntime ? runtime->attachApplicationToQuickLauncher(app)
                                                      : runtime->start();
-            if (!successfullyStarted)
+            if (!successfullyStarted) {
                 runtime->deleteLater(); // ~Runtime() will clean app->m_runtime
+            } else {
+                StartupTimer::instance()->timelineEvent(attachRuntime ? "attached to quick-launcher"
+                                                                      : "runtime started",
+                                                        app->id(), runtime->applicationProcessId());
+            }
 
             return successfullyStarted;
         };
@@ -869,6 +1056,38 @@ bool ApplicationManager::startApplication(const QString &id, const QString &docu
     }
 }
 
+/*!
+    \qmlmethod int ApplicationManager::queueApplicationStart(string id, string document)
+
+    Queues the start of the application identified by its unique \a id. The optional argument
+    \a document is handled just like in startApplication.
+
+    In contrast to startApplication, this function returns immediately: the application is started
+    asynchronously and the queue makes sure that only a limited number of applications are
+    starting up at the same time (see \c applications/maximumConcurrentStarts in the
+    \l{Configuration}{configuration}). The checks of the application's files that precede the
+    actual start are done on a worker thread. This is the preferred way to start a whole batch of
+    applications - for example all the autostart applications when the System UI comes up - without
+    blocking the System UI while doing so.
+
+    Returns a request id that is passed to the queuedApplicationStartFinished signal once the
+    start has finished, or \c -1 if the application manager is shutting down or \a id is not
+    known.
+
+    \sa startApplication, queuedApplicationStartFinished
+*/
+int ApplicationManager::queueApplicationStart(const QString &id, const QString &documentUrl)
+{
+    if (d->shuttingDown || !fromId(id))
+        return -1;
+    return d->startQueue->enqueue(id, documentUrl);
+}
+
+void ApplicationManager::setMaximumConcurrentStarts(int maximum)
+{
+    d->startQueue->setMaximumConcurrentStarts(maximum);
+}
+
 /*!
     \qmlmethod bool ApplicationManager::debugApplication(string id, string debugWrapper, string document)
 
@@ -1080,6 +1299,130 @@ void ApplicationManager::acknowledgeOpenUrlRequest(const QString &requestId, con
     }
 }
 
+/*!
+    \qmlmethod list<object> ApplicationManager::quickLaunchStatistics()
+
+    Returns the state of the quick-launch pool: there is one object for each container/runtime
+    combination, with the following fields:
+
+    \table
+    \header
+        \li Name
+        \li Type
+        \li Description
+    \row
+        \li \c containerId
+        \li string
+        \li The id of the container.
+    \row
+        \li \c runtimeId
+        \li string
+        \li The id of the runtime - empty, if the runtime does not support quick-launching.
+    \row
+        \li \c available
+        \li int
+        \li The number of quick launchers that are currently ready.
+    \row
+        \li \c target
+        \li int
+        \li The number of quick launchers the pool currently aims for, based on the demand. This
+            value is between \c minimum and \c maximum, or \c 0 while the system is under memory
+            pressure.
+    \row
+        \li \c minimum
+        \li int
+        \li The configured \c quicklaunch/runtimesPerContainer value.
+    \row
+        \li \c maximum
+        \li int
+        \li The configured \c quicklaunch/maximumRuntimesPerContainer value.
+    \row
+        \li \c hits
+        \li int
+        \li The number of application starts that were served from the pool.
+    \row
+        \li \c misses
+        \li int
+        \li The number of application starts that had to wait for a cold start.
+    \row
+        \li \c launchesPerMinute
+        \li real
+        \li The recent launch rate, averaged over roughly the last minute.
+    \row
+        \li \c spawned
+        \li int
+        \li The number of quick launchers that were created so far.
+    \row
+        \li \c averageSpawnTime
+        \li real
+        \li The time it took until a new quick launcher was ready to have an application attached,
+            in milliseconds (moving average). This also determines how many launches the pool
+            expects while it is refilled.
+    \row
+        \li \c maximumSpawnTime
+        \li int
+        \li The longest time it took until a new quick launcher was ready, in milliseconds.
+    \row
+        \li \c memoryPressure
+        \li bool
+        \li \c true, if the pool currently backs off due to memory pressure.
+    \endtable
+
+    The list is empty in single-process mode or if quick-launching is disabled.
+*/
+QVariantList ApplicationManager::quickLaunchStatistics() const
+{
+    return QuickLauncher::instance()->statistics();
+}
+
+/*!
+    \qmlmethod int ApplicationManager::prepareApplicationStart(string id)
+
+    Gives the application manager a hint that the application identified by \a id is likely to be
+    started soon - for example, based on a launch prediction in the System UI.
+
+    For QML applications, the QML modules that are imported by the application's main QML file are
+    preloaded into the idle quick launcher(s) of its runtime, so that they do not have to be
+    loaded anymore when the application is actually started. Only modules that are found in the
+    runtime's own import paths are preloaded, so the quick launchers can still be used for any
+    other application. Modules that the application ships itself (in the directory of its main
+    QML file or in the \c importPaths of its runtime parameters) are never preloaded, since the
+    application would otherwise end up with the system's version of such a module.
+
+    Returns the number of quick launchers that were asked to preload the modules.
+
+    \sa quickLaunchStatistics()
+*/
+int ApplicationManager::prepareApplicationStart(const QString &id)
+{
+    Application *app = fromId(id);
+    if (!app || app->currentRuntime() || isSingleProcess())
+        return 0;
+
+    const QString codeFile = app->info()->absoluteCodeFilePath();
+    if (!codeFile.endsWith(qSL(".qml")))
+        return 0;
+
+    // modules that the application ships itself must not be preloaded from the system's import
+    // paths: the application would get the preloaded system version instead of its own one
+    QStringList appImportPaths { QFileInfo(codeFile).absolutePath() };
+    const QStringList importPaths = variantToStringList(app->runtimeParameters().value(qSL("importPaths")));
+    for (const QString &path : importPaths)
+        appImportPaths << toAbsoluteFilePath(path, app->codeDir());
+
+    QStringList imports = qmlModuleImports(codeFile);
+    imports.erase(std::remove_if(imports.begin(), imports.end(), [&appImportPaths](const QString &import) {
+        return isQmlModuleInImportPaths(import.section(qL1C(' '), 0, 0), import.section(qL1C(' '), 1, 1),
+                                        appImportPaths);
+    }), imports.end());
+    if (imports.isEmpty())
+        return 0;
+
+    int count = QuickLauncher::instance()->preloadImports(app->info()->runtimeName(), imports);
+    qCDebug(LogSystem) << "Preloading imports of" << id << "in" << count << "quick launcher(s):" << imports;
+    return count;
+}
+
 /*!
     \qmlmethod ApplicationManager::rejectOpenUrlRequest(string requestId)
 
@@ -1127,6 +1470,7 @@ void ApplicationManager::shutDown()
 {
     d->shuttingDown = true;
     emit shuttingDownChanged();
+    d->startQueue->cancelAll();
 
     auto shutdownHelper = [this]() {
         bool activeRuntime = false;
@@ -1163,18 +1507,9 @@ void ApplicationManager::openUrlRelay(const QUrl &url)
 
 void ApplicationManager::emitDataChanged(Application *app, const QVector<int> &roles)
 {
-    int row = d->apps.indexOf(app);
-    if (row >= 0) {
-        emit dataChanged(index(row), index(row), roles);
-
-        static const auto appChanged = QMetaMethod::fromSignal(&ApplicationManager::applicationChanged);
-        if (isSignalConnected(appChanged)) {
-            QStringList stringRoles;
-            for (auto role : roles)
-                stringRoles << qL1S(d->roleNames[role]);
-            emit applicationChanged(app->id(), stringRoles);
-        }
-    }
+    // the actual signals are emitted in batches once per event loop iteration
+    if (d->appRowIndex.contains(app))
+        d->dataChangedCoalescer->add(app, roles);
 }
 
 void ApplicationManager::emitActivated(Application *app)
@@ -1323,11 +1658,7 @@ Application *ApplicationManager::application(const QString &id) const
 */
 int ApplicationManager::indexOfApplication(const QString &id) const
 {
-    for (int i = 0; i < d->apps.size(); ++i) {
-        if (d->apps.at(i)->id() == id)
-            return i;
-    }
-    return -1;
+    return d->appIdIndex.value(id, -1);
 }
 
 /*!
@@ -1394,7 +1725,34 @@ void ApplicationManager::addApplication(Application *app)
         emitDataChanged(app, QVector<int> { IsBlocked });
     });
 
+    connect(app, &Application::runtimeChanged,
+            this, [this, app]() {
+        d->updateRuntimeIndexes(app);
+    });
+
+    int row = d->apps.size();
     d->apps << app;
+
+    // the first app with a given id wins, just like with the linear search before
+    if (!d->appIdIndex.contains(app->id()))
+        d->appIdIndex.insert(app->id(), row);
+    d->appRowIndex.insert(app, row);
+
+    const auto mimeTypes = app->supportedMimeTypes();
+    for (const QString &mime : mimeTypes) {
+        auto &mimeHandlers = d->mimeTypeIndex[mime];
+        if (mimeHandlers.isEmpty() || (mimeHandlers.constLast() != app))
+            mimeHandlers << app;
+
+        int pos = mime.indexOf(QLatin1Char('/'));
+        if ((pos > 0) && (mime.left(pos) == qL1S("x-scheme-handler"))) {
+            auto &handlers = d->schemeIndex[mime.mid(pos + 1)];
+            if (handlers.isEmpty() || (handlers.constLast() != app))
+                handlers << app;
+        }
+    }
+    if (app->currentRuntime())
+        d->updateRuntimeIndexes(app);
 }
 
 QT_END_NAMESPACE_AM
@@ -144,6 +144,12 @@ public:
     Q_INVOKABLE void acknowledgeOpenUrlRequest(const QString &requestId, const QString &appId);
     Q_INVOKABLE void rejectOpenUrlRequest(const QString &requestId);
 
+    Q_INVOKABLE QVariantList quickLaunchStatistics() const;
+    Q_INVOKABLE int prepareApplicationStart(const QString &id);
+    Q_INVOKABLE int queueApplicationStart(const QString &id, const QString &documentUrl = QString());
+
+    void setMaximumConcurrentStarts(int maximum);
+
     // DBus interface
     Q_SCRIPTABLE QStringList applicationIds() const;
     Q_SCRIPTABLE QVariantMap get(const QString &id) const;
@@ -171,6 +177,7 @@ signals:
     Q_SCRIPTABLE void applicationChanged(const QString &id, const QStringList &changedRoles);
 
     void openUrlRequested(const QString &requestId, const QString &url, const QString &mimeType, const QStringList &possibleAppIds);
+    void queuedApplicationStartFinished(int requestId, const QString &id, bool success, const QVariantMap &timings);
 
     void memoryLowWarning();
     void memoryCriticalWarning();
@@ -46,11 +46,15 @@
 #include <QVariantMap>
 #include <QJSValue>
 #include <QSet>
+#include <QScopedPointer>
 #include <QtAppManCommon/global.h>
 #include <QtAppManManager/applicationmanager.h>
+#include <QtAppManManager/datachangedcoalescer.h>
 
 QT_BEGIN_NAMESPACE_AM
 
+class ApplicationStartQueue;
+
 class ApplicationManagerPrivate
 {
 public:
@@ -63,11 +67,43 @@ public:
     QVector<PackageInfo> packages;
     QVector<Application *> apps;
 
+    // lookup indexes for apps: these need to be kept in sync with the apps vector
+    QHash<QString, int> appIdIndex;
+    QHash<const Application *, int> appRowIndex;
+    QHash<QString, QVector<Application *>> mimeTypeIndex;
+    QHash<QString, QVector<Application *>> schemeIndex;
+
+    // lookup indexes for apps that currently have a runtime: the security token of a runtime
+    // never changes, but its process id might only be known after the process has been started,
+    // so the pid index is rebuilt on demand.
+    QHash<Application *, QByteArray> runningApps;
+    QHash<QByteArray, Application *> securityTokenIndex;
+    mutable QHash<qint64, Application *> processIdIndex;
+
+    // maps the pids of indirect children (e.g. started via gdbserver or a shell wrapper) to their
+    // app, so that walking up the process tree via /proc is only needed for the first lookup
+    struct AncestorCacheEntry
+    {
+        Application *app;
+        qint64 appPid;
+        quint64 startTime; // detects recycled pids, if no pidfd is available
+        int pidFd;         // becomes readable when the process exits (-1 if not supported)
+    };
+    mutable QHash<qint64, AncestorCacheEntry> ancestorCache;
+    bool isAncestorCacheEntryValid(qint64 pid, const AncestorCacheEntry &entry) const;
+    void clearAncestorCache() const;
+
+    void updateRuntimeIndexes(Application *app);
+    Application *lookupProcessId(qint64 pid, bool *indexRebuilt) const;
+
     QString currentLocale;
     QHash<int, QByteArray> roleNames;
+    QScopedPointer<DataChangedCoalescer> dataChangedCoalescer;
 
     QVector<IpcProxyObject *> interfaceExtensions;
 
+    ApplicationStartQueue *startQueue = nullptr;
+
     QList<QPair<QString, QString>> containerSelectionConfig;
     QJSValue containerSelectionFunction;
 
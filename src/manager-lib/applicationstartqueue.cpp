@@ -0,0 +1,249 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+
+#include "logging.h"
+#include "exception.h"
+#include "application.h"
+#include "applicationinfo.h"
+#include "applicationmanager.h"
+#include "applicationstartqueue.h"
+
+QT_BEGIN_NAMESPACE_AM
+
+// An app that is still starting up after this time does not block the queue any longer, although
+// its start is only reported as finished once it is actually running.
+static const int SlotTimeout = 10000;
+
+// This runs on a worker thread, so it must not touch any QObjects.
+static QString preflightCheck(const QString &codeFilePath, bool needsExecutable)
+{
+    if (codeFilePath.isEmpty())
+        return QString();
+
+    QFileInfo fi(codeFilePath);
+    if (!fi.exists())
+        return qSL("the code file %1 does not exist").arg(codeFilePath);
+    if (!fi.isReadable())
+        return qSL("the code file %1 is not readable").arg(codeFilePath);
+    if (needsExecutable && !fi.isExecutable())
+        return qSL("the code file %1 is not executable").arg(codeFilePath);
+    return QString();
+}
+
+ApplicationStartQueue::ApplicationStartQueue(ApplicationManager *manager)
+    : QObject(manager)
+    , m_manager(manager)
+{
+    m_clock.start();
+
+    m_dispatchTimer.setSingleShot(true);
+    m_dispatchTimer.setInterval(0);
+    connect(&m_dispatchTimer, &QTimer::timeout, this, &ApplicationStartQueue::dispatch);
+
+    connect(manager, &ApplicationManager::applicationRunStateChanged,
+            this, &ApplicationStartQueue::runStateChanged);
+}
+
+ApplicationStartQueue::~ApplicationStartQueue()
+{
+    qDeleteAll(m_queue);
+    qDeleteAll(m_active);
+}
+
+int ApplicationStartQueue::maximumConcurrentStarts() const
+{
+    return m_maximumConcurrentStarts;
+}
+
+void ApplicationStartQueue::setMaximumConcurrentStarts(int maximum)
+{
+    m_maximumConcurrentStarts = qMax(0, maximum);
+    scheduleDispatch();
+}
+
+int ApplicationStartQueue::enqueue(const QString &appId, const QString &documentUrl)
+{
+    Request *request = new Request;
+    request->id = ++m_nextRequestId;
+    request->appId = appId;
+    request->documentUrl = documentUrl;
+    request->enqueued = m_clock.elapsed();
+    m_queue.append(request);
+
+    scheduleDispatch();
+    return request->id;
+}
+
+void ApplicationStartQueue::cancelAll()
+{
+    const auto queued = m_queue;
+    const auto active = m_active.values();
+    for (Request *request : queued)
+        finish(request, false);
+    for (Request *request : active)
+        finish(request, false);
+}
+
+void ApplicationStartQueue::scheduleDispatch()
+{
+    if (!m_queue.isEmpty() && !m_dispatchTimer.isActive())
+        m_dispatchTimer.start();
+}
+
+void ApplicationStartQueue::dispatch()
+{
+    while (!m_queue.isEmpty()
+           && ((m_maximumConcurrentStarts == 0) || (m_slotsInUse < m_maximumConcurrentStarts))) {
+        Request *request = m_queue.takeFirst();
+        request->dequeued = m_clock.elapsed();
+        request->holdsSlot = true;
+        ++m_slotsInUse;
+        m_active.insert(request->id, request);
+
+        Application *app = m_manager->fromId(request->appId);
+        if (!app) {
+            qCWarning(LogSystem) << "Cannot start application: id" << request->appId << "is not known";
+            finish(request, false);
+            continue;
+        }
+
+        const QString codeFilePath = app->info()->absoluteCodeFilePath();
+        const bool needsExecutable = (app->info()->runtimeName() == qL1S("native"));
+        const int requestId = request->id;
+
+        auto watcher = new QFutureWatcher<QString>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, requestId]() {
+            preflightFinished(requestId, watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(preflightCheck, codeFilePath, needsExecutable));
+    }
+}
+
+void ApplicationStartQueue::preflightFinished(int requestId, const QString &errorString)
+{
+    Request *request = m_active.value(requestId);
+    if (!request)
+        return; // cancelled in the meantime
+
+    request->checked = m_clock.elapsed();
+    if (!errorString.isEmpty()) {
+        qCWarning(LogSystem) << "Cannot start application" << request->appId << ":" << errorString;
+        finish(request, false);
+        return;
+    }
+
+    bool ok = false;
+    try {
+        ok = m_manager->startApplicationInternal(request->appId, request->documentUrl);
+    } catch (const Exception &e) {
+        qCWarning(LogSystem) << e.what();
+    }
+    request->startReturned = m_clock.elapsed();
+
+    if (!ok) {
+        finish(request, false);
+    } else if (m_manager->applicationRunState(request->appId) == Am::Running) {
+        // the app was already running or was started synchronously
+        finish(request, true);
+    } else {
+        request->started = true;
+        QTimer::singleShot(SlotTimeout, this, [this, requestId]() {
+            if (Request *pending = m_active.value(requestId))
+                releaseSlot(pending);
+        });
+    }
+}
+
+void ApplicationStartQueue::runStateChanged(const QString &appId, Am::RunState runState)
+{
+    if (runState != Am::Running && runState != Am::NotRunning)
+        return;
+
+    const auto active = m_active.values();
+    for (Request *request : active) {
+        if (request->started && (request->appId == appId))
+            finish(request, runState == Am::Running);
+    }
+}
+
+void ApplicationStartQueue::releaseSlot(Request *request)
+{
+    if (request->holdsSlot) {
+        request->holdsSlot = false;
+        --m_slotsInUse;
+        scheduleDispatch();
+    }
+}
+
+void ApplicationStartQueue::finish(Request *request, bool success)
+{
+    const qint64 now = m_clock.elapsed();
+
+    QVariantMap timings;
+    auto addTiming = [&timings](const char *stage, qint64 from, qint64 to) {
+        if (from >= 0 && to >= 0)
+            timings.insert(qL1S(stage), to - from);
+    };
+    addTiming("queued", request->enqueued, request->dequeued);
+    addTiming("preflight", request->dequeued, request->checked);
+    addTiming("start", request->checked, request->startReturned);
+    if (success)
+        addTiming("startup", request->startReturned, now);
+    addTiming("total", request->enqueued, now);
+
+    m_queue.removeOne(request);
+    m_active.remove(request->id);
+    releaseSlot(request);
+
+    qCDebug(LogSystem) << "Queued start of application" << request->appId
+                       << (success ? "succeeded" : "failed") << "- timings:" << timings;
+
+    emit startFinished(request->id, request->appId, success, timings);
+    delete request;
+}
+
+QT_END_NAMESPACE_AM
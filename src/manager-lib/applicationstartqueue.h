@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QVariantMap>
+#include <QtAppManCommon/global.h>
+#include <QtAppManManager/amnamespace.h>
+
+QT_BEGIN_NAMESPACE_AM
+
+class ApplicationManager;
+
+// An asynchronous queue for application starts: at most maximumConcurrentStarts() applications
+// are in the process of starting up at the same time, each start is dispatched in its own event
+// loop iteration and the file system checks that precede a start are done on a worker thread.
+// This keeps a burst of starts (e.g. all the autostart apps at boot) from blocking the System UI.
+class ApplicationStartQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ApplicationStartQueue(ApplicationManager *manager);
+    ~ApplicationStartQueue() override;
+
+    int maximumConcurrentStarts() const;
+    void setMaximumConcurrentStarts(int maximum);
+
+    int enqueue(const QString &appId, const QString &documentUrl);
+    void cancelAll();
+
+signals:
+    void startFinished(int requestId, const QString &appId, bool success, const QVariantMap &timings);
+
+private:
+    struct Request
+    {
+        int id;
+        QString appId;
+        QString documentUrl;
+        bool holdsSlot = false;
+        bool started = false;
+        qint64 enqueued = -1;
+        qint64 dequeued = -1;
+        qint64 checked = -1;
+        qint64 startReturned = -1;
+    };
+
+    void scheduleDispatch();
+    void dispatch();
+    void preflightFinished(int requestId, const QString &errorString);
+    void runStateChanged(const QString &appId, Am::RunState runState);
+    void releaseSlot(Request *request);
+    void finish(Request *request, bool success);
+
+    ApplicationManager *m_manager;
+    int m_maximumConcurrentStarts = 2;
+    int m_slotsInUse = 0;
+    int m_nextRequestId = 0;
+    QList<Request *> m_queue;
+    QHash<int, Request *> m_active;
+    QElapsedTimer m_clock;
+    QTimer m_dispatchTimer;
+};
+
+QT_END_NAMESPACE_AM
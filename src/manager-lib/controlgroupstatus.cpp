@@ -0,0 +1,303 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include "controlgroupstatus.h"
+
+#include <QCoreApplication>
+#include <QtQml/qqmlinfo.h>
+
+#include "abstractruntime.h"
+#include "applicationmanager.h"
+
+/*!
+    \qmltype ControlGroupStatus
+    \inqmlmodule QtApplicationManager.SystemUI
+    \ingroup system-ui
+    \brief Provides the resource usage of the control group an application runs in.
+
+    ControlGroupStatus reports the CPU, I/O and memory usage that the Linux kernel accounts for
+    the \c cgroup of an application's process. In contrast to ProcessStatus, this includes all
+    other processes within the same control group, such as helper processes started by the
+    application, and it is considerably cheaper to sample, since it only needs to read a few small
+    files from the \c cgroup file-system instead of the memory maps of every process.
+
+    Applications are only placed in separate control groups, if the container is configured to do
+    so (see \l{control group mapping}{controlGroups}). Both the \c cgroup v1 (\c cpuacct, \c blkio
+    and \c memory controllers) and the unified \c cgroup v2 hierarchy are supported. On other
+    platforms, all values are 0.
+
+    \qml
+    import QtQuick 2.11
+    import QtApplicationManager 2.0
+    import QtApplicationManager.SystemUI 2.0
+    ...
+    MonitorModel {
+        running: true
+        ControlGroupStatus {
+            applicationId: "some.app.id"
+        }
+    }
+    \endqml
+
+    The following are the keys supported in the \l memory property:
+
+    \table
+    \header
+        \li Key
+        \li Description
+    \row
+        \li \c total
+        \li The sum of all the values below, in bytes.
+    \row
+        \li \c anon
+        \li The amount of anonymous memory (e.g. the heap), in bytes.
+    \row
+        \li \c file
+        \li The amount of page cache memory (e.g. memory mapped files), in bytes.
+    \row
+        \li \c kernel
+        \li The amount of kernel memory used on behalf of the group, in bytes. Not available with
+            \c cgroup v1.
+    \row
+        \li \c shmem
+        \li The amount of shared memory, in bytes. This is part of \c file.
+    \endtable
+*/
+
+QT_USE_NAMESPACE_AM
+
+ControlGroupStatus::ControlGroupStatus(QObject *parent)
+    : QObject(parent)
+{ }
+
+ControlGroupStatus::~ControlGroupStatus()
+{ }
+
+/*!
+    \qmlmethod ControlGroupStatus::update
+
+    Updates the cpuLoad, ioReadRate, ioWriteRate, and memory properties. The rates are calculated
+    over the interval since the previous call, so the very first update only reports 0 for those.
+*/
+void ControlGroupStatus::update()
+{
+    // applications can be moved to a different group at any time via Container::controlGroup
+    determineGroupPath();
+
+    if (m_reader) {
+        m_reader->update();
+        const ControlGroupReader::Memory mem = m_reader->memory();
+        m_memory[qSL("total")] = mem.anon + mem.file + mem.kernel;
+        m_memory[qSL("anon")] = mem.anon;
+        m_memory[qSL("file")] = mem.file;
+        m_memory[qSL("kernel")] = mem.kernel;
+        m_memory[qSL("shmem")] = mem.shmem;
+    } else {
+        m_memory.clear();
+    }
+    emit updated();
+}
+
+/*!
+    \qmlproperty string ControlGroupStatus::applicationId
+
+    Holds the \l{ApplicationObject::id}{ID} of the \l{ApplicationObject}{application} whose
+    control group is to be monitored. As with ProcessStatus, an empty string refers to the System
+    UI's process.
+*/
+QString ControlGroupStatus::applicationId() const
+{
+    return m_appId;
+}
+
+void ControlGroupStatus::setApplicationId(const QString &appId)
+{
+    if (m_appId != appId || m_appId.isNull()) {
+        if (m_application) {
+            disconnect(m_application, nullptr, this, nullptr);
+            m_application = nullptr;
+        }
+        m_appId = appId;
+        if (!appId.isEmpty()) {
+            int appIndex = ApplicationManager::instance()->indexOfApplication(appId);
+            if (appIndex < 0) {
+                qmlWarning(this) << "Invalid application ID:" << appId;
+            } else {
+                m_application = ApplicationManager::instance()->application(appIndex);
+                connect(m_application.data(), &Application::runStateChanged, this, &ControlGroupStatus::onRunStateChanged);
+            }
+        }
+        determinePid();
+        emit applicationIdChanged(appId);
+    }
+}
+
+void ControlGroupStatus::onRunStateChanged(Am::RunState state)
+{
+    if (state == Am::Running || state == Am::NotRunning)
+        determinePid();
+}
+
+void ControlGroupStatus::determinePid()
+{
+    qint64 newId;
+    if (m_appId.isEmpty()) {
+        newId = QCoreApplication::applicationPid();
+    } else {
+        Q_ASSERT(m_application);
+        if (ApplicationManager::instance()->isSingleProcess())
+            newId = 0;
+        else
+            newId = m_application->currentRuntime() ? m_application->currentRuntime()->applicationProcessId() : 0;
+    }
+
+    if (newId != m_pid) {
+        m_pid = newId;
+        emit processIdChanged(m_pid);
+        determineGroupPath();
+    }
+}
+
+void ControlGroupStatus::determineGroupPath()
+{
+    QMap<QByteArray, QByteArray> groupPaths;
+#if defined(Q_OS_LINUX)
+    if (m_pid)
+        groupPaths = fetchCGroupProcessInfo(m_pid);
+#endif
+    if (groupPaths == m_groupPaths)
+        return;
+
+    m_groupPaths = groupPaths;
+    m_reader.reset(m_groupPaths.isEmpty() ? nullptr : new ControlGroupReader(m_groupPaths));
+    if (m_reader && !m_reader->isValid())
+        m_reader.reset();
+    emit groupPathChanged(groupPath());
+}
+
+/*!
+    \qmlproperty int ControlGroupStatus::processId
+    \readonly
+
+    This property holds the process identifier (PID) that is used to determine the control group.
+    The property is 0, if there is no process associated with the \l applicationId.
+*/
+qint64 ControlGroupStatus::processId() const
+{
+    return m_pid;
+}
+
+/*!
+    \qmlproperty string ControlGroupStatus::groupPath
+    \readonly
+
+    The path of the monitored control group, relative to the root of the \c cgroup hierarchy. With
+    \c cgroup v1, this is the group within the \c memory controller.
+*/
+QString ControlGroupStatus::groupPath() const
+{
+    QByteArray path = m_groupPaths.value(QByteArray());
+    if (path.isEmpty())
+        path = m_groupPaths.value("memory");
+    return QString::fromLocal8Bit(path);
+}
+
+/*!
+    \qmlproperty real ControlGroupStatus::cpuLoad
+    \readonly
+
+    This property holds the CPU utilization of all processes in the control group during the
+    previous measurement interval. A value of 1 means that the equivalent of one core was used.
+*/
+qreal ControlGroupStatus::cpuLoad() const
+{
+    return m_reader ? m_reader->cpuLoad() : 0;
+}
+
+/*!
+    \qmlproperty real ControlGroupStatus::ioReadRate
+    \readonly
+
+    This property holds the number of bytes per second read from block devices by all processes in
+    the control group during the previous measurement interval.
+*/
+qreal ControlGroupStatus::ioReadRate() const
+{
+    return m_reader ? m_reader->ioReadRate() : 0;
+}
+
+/*!
+    \qmlproperty real ControlGroupStatus::ioWriteRate
+    \readonly
+
+    This property holds the number of bytes per second written to block devices by all processes
+    in the control group during the previous measurement interval.
+*/
+qreal ControlGroupStatus::ioWriteRate() const
+{
+    return m_reader ? m_reader->ioWriteRate() : 0;
+}
+
+/*!
+    \qmlproperty var ControlGroupStatus::memory
+    \readonly
+
+    A map of the memory usage of the control group, broken down by type. See the table of
+    supported keys above.
+*/
+QVariantMap ControlGroupStatus::memory() const
+{
+    return m_memory;
+}
+
+/*!
+    \qmlproperty list<string> ControlGroupStatus::roleNames
+    \readonly
+
+    Names of the roles that ControlGroupStatus provides when used as a data source for MonitorModel.
+
+    \sa MonitorModel
+*/
+QStringList ControlGroupStatus::roleNames() const
+{
+    return { qSL("cpuLoad"), qSL("ioReadRate"), qSL("ioWriteRate"), qSL("memory") };
+}
@@ -0,0 +1,111 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QVariantMap>
+
+#include <QtAppManCommon/global.h>
+#include <QtAppManManager/amnamespace.h>
+#include <QtAppManManager/application.h>
+#include <QtAppManMonitor/systemreader.h>
+
+QT_BEGIN_NAMESPACE_AM
+
+class ControlGroupStatus : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("AM-QmlType", "QtApplicationManager.SystemUI/ControlGroupStatus 2.0")
+    Q_PROPERTY(QString applicationId READ applicationId WRITE setApplicationId NOTIFY applicationIdChanged)
+    Q_PROPERTY(qint64 processId READ processId NOTIFY processIdChanged)
+    Q_PROPERTY(QString groupPath READ groupPath NOTIFY groupPathChanged)
+    Q_PROPERTY(qreal cpuLoad READ cpuLoad NOTIFY updated)
+    Q_PROPERTY(qreal ioReadRate READ ioReadRate NOTIFY updated)
+    Q_PROPERTY(qreal ioWriteRate READ ioWriteRate NOTIFY updated)
+    Q_PROPERTY(QVariantMap memory READ memory NOTIFY updated)
+    Q_PROPERTY(QStringList roleNames READ roleNames CONSTANT)
+
+public:
+    ControlGroupStatus(QObject *parent = nullptr);
+    ~ControlGroupStatus() override;
+
+    QStringList roleNames() const;
+
+    Q_INVOKABLE void update();
+
+    QString applicationId() const;
+    void setApplicationId(const QString &appId);
+
+    qint64 processId() const;
+    QString groupPath() const;
+
+    qreal cpuLoad() const;
+    qreal ioReadRate() const;
+    qreal ioWriteRate() const;
+    QVariantMap memory() const;
+
+signals:
+    void applicationIdChanged(const QString &applicationId);
+    void processIdChanged(qint64 processId);
+    void groupPathChanged(const QString &groupPath);
+    void updated();
+
+private slots:
+    void onRunStateChanged(Am::RunState state);
+
+private:
+    void determinePid();
+    void determineGroupPath();
+
+    QString m_appId;
+    qint64 m_pid = 0;
+    QPointer<Application> m_application;
+
+    QMap<QByteArray, QByteArray> m_groupPaths;
+    QScopedPointer<ControlGroupReader> m_reader;
+    QVariantMap m_memory;
+};
+
+QT_END_NAMESPACE_AM
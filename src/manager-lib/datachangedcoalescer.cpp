@@ -0,0 +1,139 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QObject>
+#include <QTimer>
+#include <algorithm>
+
+#include "datachangedcoalescer.h"
+
+QT_BEGIN_NAMESPACE_AM
+
+DataChangedCoalescer::DataChangedCoalescer(QObject *context,
+                                           const std::function<int (QObject *)> &rowOf,
+                                           const std::function<void (int, int, const QVector<int> &)> &rangeChanged,
+                                           const std::function<void (QObject *, const QVector<int> &)> &itemChanged)
+    : m_context(context)
+    , m_rowOf(rowOf)
+    , m_rangeChanged(rangeChanged)
+    , m_itemChanged(itemChanged)
+{ }
+
+void DataChangedCoalescer::add(QObject *item, const QVector<int> &roles)
+{
+    auto it = m_pending.find(item);
+    if (it == m_pending.end()) {
+        m_pending.insert(item, roles);
+    } else if (!it->isEmpty()) {
+        if (roles.isEmpty()) {
+            it->clear();
+        } else {
+            for (int role : roles) {
+                if (!it->contains(role))
+                    it->append(role);
+            }
+        }
+    }
+
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, m_context, [this]() { flush(); });
+    }
+}
+
+void DataChangedCoalescer::remove(QObject *item)
+{
+    m_pending.remove(item);
+}
+
+void DataChangedCoalescer::flush()
+{
+    m_flushScheduled = false;
+    if (m_pending.isEmpty())
+        return;
+
+    // the signals emitted below could trigger new changes
+    const QHash<QObject *, QVector<int>> pending = m_pending;
+    m_pending.clear();
+
+    QVector<QPair<int, QObject *>> rows;
+    rows.reserve(pending.size());
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        int row = m_rowOf(it.key());
+        if (row >= 0)
+            rows.append(qMakePair(row, it.key()));
+    }
+    std::sort(rows.begin(), rows.end());
+
+    for (int first = 0; first < rows.size(); ) {
+        int last = first;
+        bool allRoles = pending.value(rows.at(first).second).isEmpty();
+        QVector<int> roles = pending.value(rows.at(first).second);
+
+        while ((last + 1 < rows.size()) && (rows.at(last + 1).first == rows.at(last).first + 1)) {
+            ++last;
+            if (!allRoles) {
+                const QVector<int> &itemRoles = pending.value(rows.at(last).second);
+                if (itemRoles.isEmpty()) {
+                    allRoles = true;
+                    roles.clear();
+                } else {
+                    for (int role : itemRoles) {
+                        if (!roles.contains(role))
+                            roles.append(role);
+                    }
+                }
+            }
+        }
+        std::sort(roles.begin(), roles.end());
+        if (m_rangeChanged)
+            m_rangeChanged(rows.at(first).first, rows.at(last).first, roles);
+        first = last + 1;
+    }
+
+    if (m_itemChanged) {
+        for (const auto &row : qAsConst(rows))
+            m_itemChanged(row.second, pending.value(row.second));
+    }
+}
+
+QT_END_NAMESPACE_AM
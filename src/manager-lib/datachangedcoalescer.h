@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QHash>
+#include <QVector>
+#include <QtAppManCommon/global.h>
+
+QT_FORWARD_DECLARE_CLASS(QObject)
+
+QT_BEGIN_NAMESPACE_AM
+
+// Collects role changes for the items of a list model and reports them in batches once per event
+// loop iteration: changes to the same item are merged and adjacent rows are reported as a single
+// range with the union of their roles.
+// The model has to call flush() before inserting, removing or moving rows, so that its consumers
+// never see a structural change before a data change that happened earlier.
+class DataChangedCoalescer
+{
+public:
+    // context is the model: the batches are delivered via its event loop.
+    // rowOf maps an item to its current row (or -1, if it is not part of the model anymore),
+    // rangeChanged is called for every range of adjacent rows (the model emits dataChanged) and
+    // itemChanged is called once per item and batch with all the roles that changed.
+    DataChangedCoalescer(QObject *context,
+                         const std::function<int(QObject *item)> &rowOf,
+                         const std::function<void(int firstRow, int lastRow, const QVector<int> &roles)> &rangeChanged,
+                         const std::function<void(QObject *item, const QVector<int> &roles)> &itemChanged);
+
+    // an empty roles vector means that all roles have changed
+    void add(QObject *item, const QVector<int> &roles);
+    void remove(QObject *item);
+    void flush();
+
+private:
+    QObject *m_context;
+    std::function<int(QObject *)> m_rowOf;
+    std::function<void(int, int, const QVector<int> &)> m_rangeChanged;
+    std::function<void(QObject *, const QVector<int> &)> m_itemChanged;
+    QHash<QObject *, QVector<int>> m_pending;
+    bool m_flushScheduled = false;
+};
+
+QT_END_NAMESPACE_AM
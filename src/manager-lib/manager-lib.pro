@@ -4,7 +4,7 @@ MODULE = appman_manager
 
 load(am-config)
 
-QT = core network qml
+QT = core network qml concurrent
 !headless:QT *= gui gui-private quick qml-private quick-private
 QT_FOR_PRIVATE *= \
     appman_common-private \
@@ -56,13 +56,17 @@ HEADERS += \
     amnamespace.h \
     intentaminterface.h \
     processstatus.h \
+    controlgroupstatus.h \
     package.h \
     packagemanager.h \
     packagemanager_p.h \
+    datachangedcoalescer.h \
+    applicationstartqueue.h \
 
 !headless:HEADERS += \
     qmlinprocessapplicationmanagerwindow.h \
-    inprocesssurfaceitem.h
+    inprocesssurfaceitem.h \
+    notificationimageprovider.h
 
 qtHaveModule(qml):HEADERS += \
     qmlinprocessruntime.h \
@@ -84,12 +88,16 @@ SOURCES += \
     debugwrapper.cpp \
     intentaminterface.cpp \
     processstatus.cpp \
+    controlgroupstatus.cpp \
     packagemanager.cpp \
     package.cpp \
+    datachangedcoalescer.cpp \
+    applicationstartqueue.cpp \
 
 !headless:SOURCES += \
     qmlinprocessapplicationmanagerwindow.cpp \
-    inprocesssurfaceitem.cpp
+    inprocesssurfaceitem.cpp \
+    notificationimageprovider.cpp
 
 qtHaveModule(qml):SOURCES += \
     qmlinprocessruntime.cpp \
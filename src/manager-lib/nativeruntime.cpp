@@ -306,7 +306,6 @@ bool NativeRuntime::start()
         { qSL("QT_QPA_PLATFORM"), qSL("wayland") },
         { qSL("QT_IM_MODULE"), QString() },     // Applications should use wayland text input
         { qSL("QT_SCALE_FACTOR"), QString() },  // do not scale wayland clients
-        { qSL("AM_CONFIG"), QString::fromUtf8(QtYaml::yamlFromVariantDocuments({ config })) },
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
         { qSL("QT_WAYLAND_SHELL_INTEGRATION"), qSL("xdg-shell")},
@@ -315,6 +314,11 @@ bool NativeRuntime::start()
 #endif
     };
 
+    // Launchers can also receive the configuration in binary form, which saves the YAML round
+    // trip on every start. Native applications and container plugins still get the YAML variant.
+    if (!m_startedViaLauncher || !m_container->supportsBinaryConfiguration())
+        env.insert(qSL("AM_CONFIG"), QString::fromUtf8(QtYaml::yamlFromVariantDocuments({ config })));
+
     if (!Logging::isDltEnabled()) {
         // sadly we still need this, since we need to disable DLT as soon as possible
         env.insert(qSL("AM_NO_DLT_LOGGING"), qSL("1"));
@@ -465,6 +469,8 @@ void NativeRuntime::onApplicationFinishedInitialization()
             startApplicationViaLauncher();
 
         setState(Am::Running);
+    } else if (m_isQuickLauncher) {
+        emit quickLauncherReady();
     }
 }
 
@@ -482,6 +488,16 @@ bool NativeRuntime::startApplicationViaLauncher()
     return true;
 }
 
+bool NativeRuntime::preloadImports(const QStringList &imports)
+{
+    // only possible while the quick-launcher is idle and already listening on the peer D-Bus
+    if (!isQuickLauncher() || !m_runtimeInterface || !m_connectedToRuntimeInterface)
+        return false;
+
+    emit m_runtimeInterface->preloadImports(imports);
+    return true;
+}
+
 qint64 NativeRuntime::applicationProcessId() const
 {
     return m_process ? m_process->processId() : 0;
@@ -84,6 +84,7 @@ public:
 
     bool isQuickLauncher() const override;
     bool attachApplicationToQuickLauncher(Application *app) override;
+    bool preloadImports(const QStringList &imports) override;
 
     qint64 applicationProcessId() const override;
     void openDocument(const QString &document, const QString &mimeType) override;
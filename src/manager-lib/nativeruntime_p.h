@@ -84,6 +84,7 @@ signals:
     Q_SCRIPTABLE void startApplication(const QString &baseDir, const QString &app, const QString &document,
                                        const QString &mimeType, const QVariantMap &application,
                                        const QVariantMap &systemProperties);
+    Q_SCRIPTABLE void preloadImports(const QStringList &imports);
 
 private:
     NativeRuntime *m_runtime;
@@ -0,0 +1,417 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QVariant>
+#include <QMutexLocker>
+#if defined(QT_DBUS_LIB)
+#  include <QDBusArgument>
+#  include <QDBusUnixFileDescriptor>
+#endif
+#include <string.h>
+#if defined(Q_OS_LINUX)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+#include "logging.h"
+#include "notificationimageprovider.h"
+
+QT_BEGIN_NAMESPACE_AM
+
+namespace {
+
+// anything bigger is most likely a broken or malicious client
+static const int MaximumImageSize = 4096;
+
+struct RawImage
+{
+    int width = 0;
+    int height = 0;
+    int rowStride = 0;
+    bool hasAlpha = false;
+    int bitsPerSample = 0;
+    int channels = 0;
+
+    // the spec does not require the last row to be padded to the full row stride
+    qint64 minimumByteSize() const
+    {
+        return qint64(rowStride) * (height - 1) + qint64(width) * channels;
+    }
+
+    qint64 paddedByteSize() const
+    {
+        return qint64(rowStride) * height;
+    }
+
+    bool isValid() const
+    {
+        return (width > 0) && (width <= MaximumImageSize)
+                && (height > 0) && (height <= MaximumImageSize)
+                && (bitsPerSample == 8) && (channels == (hasAlpha ? 4 : 3))
+                && (rowStride >= width * channels);
+    }
+
+    QImage::Format format() const
+    {
+        // the spec defines the byte order as RGB(A) with non-premultiplied alpha
+        return hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+    }
+};
+
+static void releaseByteArray(void *data)
+{
+    delete static_cast<QByteArray *>(data);
+}
+
+// QImage expects every row - including the last one - to be rowStride bytes long, so a buffer
+// without padding after the last row cannot be referenced directly: copy the pixels instead.
+static QImage copyImage(const RawImage &raw, const uchar *data)
+{
+    QImage image(raw.width, raw.height, raw.format());
+    if (image.isNull())
+        return image;
+    const int rowSize = raw.width * raw.channels;
+    for (int y = 0; y < raw.height; ++y)
+        memcpy(image.scanLine(y), data + qint64(y) * raw.rowStride, size_t(rowSize));
+    return image;
+}
+
+static QImage imageFromByteArray(const RawImage &raw, const QByteArray &pixels)
+{
+    if (!raw.isValid() || pixels.size() < raw.minimumByteSize()) {
+        qCWarning(LogNotifications) << "Ignoring invalid image-data hint:" << raw.width << "x" << raw.height
+                                    << "stride:" << raw.rowStride << "channels:" << raw.channels
+                                    << "bps:" << raw.bitsPerSample << "data size:" << pixels.size();
+        return QImage();
+    }
+    const auto *data = reinterpret_cast<const uchar *>(pixels.constData());
+    if (pixels.size() < raw.paddedByteSize())
+        return copyImage(raw, data);
+
+    // The pixels have already been copied out of the D-Bus message into the QByteArray, but
+    // there is no need for a second copy: the QImage keeps a shallow copy of the array alive.
+    auto *buffer = new QByteArray(pixels);
+    return QImage(data, raw.width, raw.height, raw.rowStride, raw.format(), releaseByteArray, buffer);
+}
+
+#if defined(QT_DBUS_LIB) && defined(Q_OS_LINUX) && defined(F_GET_SEALS)
+
+struct MemFdMapping
+{
+    void *address;
+    size_t size;
+};
+
+static void releaseMemFdMapping(void *data)
+{
+    auto *mapping = static_cast<MemFdMapping *>(data);
+    munmap(mapping->address, mapping->size);
+    delete mapping;
+}
+
+static QImage imageFromMemFd(const RawImage &raw, const QDBusUnixFileDescriptor &memFd)
+{
+    if (!raw.isValid() || !memFd.isValid()) {
+        qCWarning(LogNotifications) << "Ignoring invalid memfd image hint";
+        return QImage();
+    }
+    int fd = memFd.fileDescriptor();
+
+    // The sender must not be able to modify or truncate the buffer while we are using it:
+    // otherwise we would risk reading garbage or even crashing with a SIGBUS.
+    const int requiredSeals = F_SEAL_SHRINK | F_SEAL_WRITE;
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & requiredSeals) != requiredSeals) {
+        qCWarning(LogNotifications) << "Ignoring memfd image hint: the file descriptor is not sealed against"
+                                       " writing and shrinking";
+        return QImage();
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < raw.minimumByteSize()) {
+        qCWarning(LogNotifications) << "Ignoring memfd image hint: the buffer is too small";
+        return QImage();
+    }
+    const bool isPadded = (st.st_size >= raw.paddedByteSize());
+    size_t size = size_t(isPadded ? raw.paddedByteSize() : raw.minimumByteSize());
+    void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        qCWarning(LogNotifications) << "Ignoring memfd image hint: could not map the buffer:" << strerror(errno);
+        return QImage();
+    }
+    if (!isPadded) {
+        QImage image = copyImage(raw, static_cast<const uchar *>(address));
+        munmap(address, size);
+        return image;
+    }
+    // the mapping stays valid after the file descriptor is closed
+    return QImage(static_cast<const uchar *>(address), raw.width, raw.height, raw.rowStride,
+                  raw.format(), releaseMemFdMapping, new MemFdMapping { address, size });
+}
+
+#endif
+
+// Only the visible pixels are hashed - the padding at the end of each row is undefined.
+static uint contentHash(const QImage &image)
+{
+    uint hash = qHash(image.width()) ^ qHash(image.height()) ^ qHash(int(image.format()));
+    const size_t rowSize = size_t(image.width()) * size_t(image.depth()) / 8;
+    for (int y = 0; y < image.height(); ++y)
+        hash = qHashBits(image.constScanLine(y), rowSize, hash);
+    return hash;
+}
+
+// Splits a hint into its geometry and its pixel data: a QByteArray or, for memfd hints, a
+// QDBusUnixFileDescriptor. Nothing is decoded yet.
+static bool parseImageHint(const QVariant &hint, bool isMemFd, RawImage *raw, QVariant *data)
+{
+    if (hint.userType() == QMetaType::QVariantList) {
+        // in-process: the same layout as on D-Bus, but as a plain list
+        const QVariantList list = hint.toList();
+        if (list.size() != 7)
+            return false;
+        raw->width = list.at(0).toInt();
+        raw->height = list.at(1).toInt();
+        raw->rowStride = list.at(2).toInt();
+        raw->hasAlpha = list.at(3).toBool();
+        raw->bitsPerSample = list.at(4).toInt();
+        raw->channels = list.at(5).toInt();
+        *data = list.at(6);
+    }
+#if defined(QT_DBUS_LIB)
+    else if (hint.userType() == qMetaTypeId<QDBusArgument>()) {
+        const QDBusArgument arg = hint.value<QDBusArgument>();
+        if (arg.currentType() != QDBusArgument::StructureType)
+            return false;
+
+        arg.beginStructure();
+        arg >> raw->width >> raw->height >> raw->rowStride >> raw->hasAlpha >> raw->bitsPerSample >> raw->channels;
+        if (isMemFd) {
+            QDBusUnixFileDescriptor memFd;
+            arg >> memFd;
+            *data = QVariant::fromValue(memFd);
+        } else {
+            // this copies the pixels out of the D-Bus message
+            QByteArray pixels;
+            arg >> pixels;
+            *data = pixels;
+        }
+        arg.endStructure();
+    }
+#endif
+    else {
+        return false;
+    }
+
+    if (!isMemFd)
+        return (data->userType() == QMetaType::QByteArray);
+#if defined(QT_DBUS_LIB)
+    return (data->userType() == qMetaTypeId<QDBusUnixFileDescriptor>());
+#else
+    return false;
+#endif
+}
+
+static QImage decodeRawImage(const RawImage &raw, const QVariant &data, bool isMemFd)
+{
+    if (!isMemFd)
+        return imageFromByteArray(raw, data.toByteArray());
+#if defined(QT_DBUS_LIB) && defined(Q_OS_LINUX) && defined(F_GET_SEALS)
+    return imageFromMemFd(raw, data.value<QDBusUnixFileDescriptor>());
+#else
+    Q_UNUSED(raw)
+    Q_UNUSED(data)
+    qCWarning(LogNotifications) << "Ignoring memfd image hint: not supported on this platform";
+    return QImage();
+#endif
+}
+
+// Identifies the content of a hint without looking at the pixels. The pixels of a memfd are
+// identified by the file itself, since its content cannot change after sealing. Returns an
+// empty key if the hint cannot be identified this way.
+static QVector<qint64> sourceKey(const RawImage &raw, const QVariant &data, bool isMemFd)
+{
+    QVector<qint64> key { raw.width, raw.height, raw.rowStride, raw.hasAlpha, raw.bitsPerSample, raw.channels };
+    if (!isMemFd)
+        return key;
+#if defined(QT_DBUS_LIB) && defined(Q_OS_LINUX)
+    const auto memFd = data.value<QDBusUnixFileDescriptor>();
+    struct stat st;
+    if (memFd.isValid() && (fstat(memFd.fileDescriptor(), &st) == 0)) {
+        key << qint64(st.st_dev) << qint64(st.st_ino) << qint64(st.st_size);
+        return key;
+    }
+#else
+    Q_UNUSED(data)
+#endif
+    return QVector<qint64>();
+}
+
+static QString imageUrl(uint notificationId, uint generation)
+{
+    return qSL("image://%1/%2/%3").arg(qL1S(NotificationImageCache::providerId())).arg(notificationId).arg(generation);
+}
+
+} // anonymous namespace
+
+
+const char *NotificationImageCache::providerId()
+{
+    return "notification";
+}
+
+QString NotificationImageCache::insert(uint notificationId, const QImage &image)
+{
+    // The generation is derived from the pixel content: a changed image gets a new url, which
+    // makes sure that QML does not use a cached, stale pixmap. Re-sending the same image on the
+    // other hand keeps the url stable, so the image role of the model does not change.
+    const uint generation = contentHash(image);
+
+    QMutexLocker locker(&m_mutex);
+    Entry &entry = m_images[notificationId];
+    entry.generation = generation;
+    entry.image = image;
+    entry.sourceKey.clear();
+    entry.sourcePixels.clear();
+    return imageUrl(notificationId, generation);
+}
+
+QString NotificationImageCache::insertImageHint(uint notificationId, const QVariant &hint, bool isMemFd)
+{
+    RawImage raw;
+    QVariant data;
+    QVector<qint64> key;
+    QByteArray pixels;
+
+    if (hint.userType() == QMetaType::QImage) {
+        key = { hint.value<QImage>().cacheKey() };
+    } else {
+        if (!parseImageHint(hint, isMemFd, &raw, &data))
+            return QString();
+        key = sourceKey(raw, data, isMemFd);
+        if (!isMemFd)
+            pixels = data.toByteArray(); // shallow copy: usually shared with the decoded image
+    }
+
+    // Replace-updates typically only change the body or the progress, but re-send the same
+    // image. Comparing the raw data is a lot cheaper than decoding and hashing it again: the
+    // shared data pointer matches for in-process clients, otherwise memcmp() stops at the
+    // first difference.
+    if (!key.isEmpty()) {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_images.constFind(notificationId);
+        if ((it != m_images.cend()) && (it->sourceKey == key)
+                && ((it->sourcePixels.constData() == pixels.constData()) || (it->sourcePixels == pixels))) {
+            return imageUrl(notificationId, it->generation);
+        }
+    }
+
+    const QImage image = (hint.userType() == QMetaType::QImage) ? hint.value<QImage>()
+                                                               : decodeRawImage(raw, data, isMemFd);
+    if (image.isNull())
+        return QString();
+
+    const QString url = insert(notificationId, image);
+
+    QMutexLocker locker(&m_mutex);
+    Entry &entry = m_images[notificationId];
+    entry.sourceKey = key;
+    entry.sourcePixels = pixels;
+    return url;
+}
+
+void NotificationImageCache::remove(uint notificationId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_images.remove(notificationId);
+}
+
+QImage NotificationImageCache::image(uint notificationId, uint generation) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.constFind(notificationId);
+    if (it == m_images.cend() || it->generation != generation)
+        return QImage();
+    return it->image;
+}
+
+QImage NotificationImageCache::decodeImageHint(const QVariant &hint, bool isMemFd)
+{
+    if (hint.userType() == QMetaType::QImage)
+        return hint.value<QImage>();
+
+    RawImage raw;
+    QVariant data;
+    if (!parseImageHint(hint, isMemFd, &raw, &data))
+        return QImage();
+    return decodeRawImage(raw, data, isMemFd);
+}
+
+
+NotificationImageProvider::NotificationImageProvider(const QSharedPointer<NotificationImageCache> &cache)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_cache(cache)
+{ }
+
+QImage NotificationImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    // id is "<notification id>/<generation>"
+    int slash = id.indexOf(qL1C('/'));
+    if (slash < 0)
+        return QImage();
+    QImage image = m_cache->image(id.leftRef(slash).toUInt(), id.midRef(slash + 1).toUInt());
+    if (image.isNull())
+        return image;
+
+    if (size)
+        *size = image.size();
+    if (requestedSize.width() > 0 && requestedSize.height() > 0)
+        image = image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    else if (requestedSize.width() > 0)
+        image = image.scaledToWidth(requestedSize.width(), Qt::SmoothTransformation);
+    else if (requestedSize.height() > 0)
+        image = image.scaledToHeight(requestedSize.height(), Qt::SmoothTransformation);
+    return image;
+}
+
+QT_END_NAMESPACE_AM
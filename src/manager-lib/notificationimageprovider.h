@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+#include <QQuickImageProvider>
+#include <QtAppManCommon/global.h>
+
+QT_FORWARD_DECLARE_CLASS(QVariant)
+
+QT_BEGIN_NAMESPACE_AM
+
+// Holds the decoded raw images of all active notifications. The cache is shared between the
+// NotificationManager (GUI thread) and the image provider, which may be called from QML's image
+// loader threads.
+class NotificationImageCache
+{
+public:
+    static const char *providerId();
+
+    // returns the image:// url under which the image can be requested from QML
+    QString insert(uint notificationId, const QImage &image);
+    // Decodes and inserts an image hint (see decodeImageHint()). If the hint carries the same
+    // data as the previous one for this notification, the pixels are neither decoded nor hashed
+    // again. Returns an empty string, if the hint is invalid.
+    QString insertImageHint(uint notificationId, const QVariant &hint, bool isMemFd = false);
+    void remove(uint notificationId);
+    QImage image(uint notificationId, uint generation) const;
+
+    // Decodes a freedesktop.org image-data hint - the D-Bus signature is "(iiibiiay)". The
+    // pixels are copied once when demarshalling the D-Bus message; the returned QImage then
+    // shares this buffer instead of copying it again (unless the last row is not padded to the
+    // full row stride). In addition to the standard variant, the pixels can also be handed over
+    // via a sealed memfd (D-Bus signature "(iiibiih)"), which is then mmap'ed read-only.
+    // In-process applications can pass the same structure as a QVariantList, or a QImage directly.
+    static QImage decodeImageHint(const QVariant &hint, bool isMemFd = false);
+
+private:
+    struct Entry
+    {
+        uint generation;
+        QImage image;
+        // the hint the image was decoded from (geometry or memfd identity, plus the raw pixels)
+        QVector<qint64> sourceKey;
+        QByteArray sourcePixels;
+    };
+    mutable QMutex m_mutex;
+    QHash<uint, Entry> m_images;
+};
+
+class NotificationImageProvider : public QQuickImageProvider
+{
+public:
+    NotificationImageProvider(const QSharedPointer<NotificationImageCache> &cache);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+private:
+    QSharedPointer<NotificationImageCache> m_cache;
+};
+
+QT_END_NAMESPACE_AM
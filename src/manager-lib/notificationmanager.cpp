@@ -43,7 +43,12 @@
 #include <QVariant>
 #include <QCoreApplication>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QMetaObject>
+#include <QVector>
+#include <QMultiMap>
+
+#include <limits>
 
 #include "global.h"
 #include "logging.h"
@@ -52,6 +57,11 @@
 #include "notificationmanager.h"
 #include "qml-utilities.h"
 #include "dbus-utilities.h"
+#if !defined(AM_HEADLESS)
+#  include <QSharedPointer>
+#  include <QQmlEngine>
+#  include "notificationimageprovider.h"
+#endif
 
 /*!
     \externalpage https://developer.gnome.org/notification-spec/
@@ -118,6 +128,18 @@
         \li \c image
         \li url
         \li See the client side documentation of Notification::image
+
+            If the client sent raw pixel data via the \c image-data hint (or one of its deprecated
+            aliases \c image_data and \c icon_data), this is an \c{image://notification/...} url,
+            which can be used directly as the \c source of an Image item. The pixels are copied
+            once out of the D-Bus message, but not again when creating the image. The url only
+            changes if the pixels do, so re-sending an identical image does not update this role.
+
+            As an application-manager specific extension, clients can avoid copying large images
+            through the D-Bus daemon altogether by sending a \c memfd file descriptor in the
+            \c{x-pelagicore-image-memfd} hint instead (D-Bus signature \c{(iiibiih)}). The file
+            descriptor has to be sealed with at least \c F_SEAL_SHRINK and \c F_SEAL_WRITE; it is
+            then mapped read-only for as long as the notification is active.
     \row
         \li \c actions
         \li object
@@ -206,26 +228,28 @@ enum Roles
 
 struct NotificationData
 {
-    uint id;
-    Application *application;
-    uint priority;
+    uint id = 0;
+    Application *application = nullptr;
+    uint priority = 0;
     QString summary;
     QString body;
     QString category;
     QString iconUrl;
     QString imageUrl;
-    bool showActionIcons;
+    bool showActionIcons = false;
     QVariantList actions; // list of single element maps: <id (as string) --> text (as string)>
-    bool dismissOnAction;
-    bool isSticky;
-    bool isClickable;
-    bool isSystemNotification;
-    bool isShowingProgress;
-    qreal progress;
-    int timeout;
+    bool dismissOnAction = false;
+    bool isSticky = false;
+    bool isClickable = false;
+    bool isSystemNotification = false;
+    bool isShowingProgress = false;
+    qreal progress = 0;
+    int timeout = 0;
     QVariantMap extended;
 
-    QTimer *timer = nullptr;
+    qint64 expiryTime = 0; // msec on NotificationManagerPrivate::timeoutClock, 0 if there is no timeout
+    QStringList rawActions; // as received via D-Bus
+    qint64 lastUpdateTime = 0; // only used when coalescing updates
 };
 
 enum CloseReason
@@ -247,18 +271,55 @@ public:
 
     int findNotificationById(uint id) const
     {
-        for (int i = 0; i < notifications.count(); ++i) {
-            if (notifications.at(i)->id == id)
-                return i;
-        }
-        return -1;
+        return rowIndex.value(id, -1);
     }
 
     void closeNotification(uint id, CloseReason reason);
+    QVector<int> setNotificationData(NotificationData *n, const QString &app_icon, const QString &summary,
+                                     const QString &body, const QStringList &actions,
+                                     const QVariantMap &hints, int timeout);
+    void updateNotification(NotificationData *n, const QString &app_icon, const QString &summary,
+                            const QString &body, const QStringList &actions, const QVariantMap &hints,
+                            int timeout);
+    void flushPendingUpdates();
+    void scheduleTimeout(NotificationData *n, int timeout);
+    void cancelTimeout(NotificationData *n);
+    void startTimeoutTimer();
+    void expireTimeouts();
 
     NotificationManager *q;
     QHash<int, QByteArray> roleNames;
     QList<NotificationData *> notifications;
+    // lookup index: needs to be kept in sync with the notifications list
+    QHash<uint, int> rowIndex;
+
+    // All timeouts are handled by a single-shot timer, which is always armed for the earliest
+    // deadline in the (deadline ordered) expiry map. Every notification with a timeout has
+    // exactly one entry in this map: it is moved on updates and removed when closed.
+    QMultiMap<qint64, uint> expiryMap;
+    QElapsedTimer timeoutClock;
+    QTimer timeoutTimer;
+
+    // Replace-updates that arrive within updateCoalescingInterval msec of the previous update of
+    // the same notification are merged: only the latest one is applied when the timer fires.
+    struct PendingUpdate
+    {
+        QString appIcon;
+        QString summary;
+        QString body;
+        QStringList actions;
+        QVariantMap hints;
+        int timeout;
+    };
+    int updateCoalescingInterval = 0;
+    QHash<uint, PendingUpdate> pendingUpdates;
+    QElapsedTimer updateClock;
+    QTimer updateTimer;
+
+#if !defined(AM_HEADLESS)
+    // decoded image-data hints, served to QML via the "notification" image provider
+    QSharedPointer<NotificationImageCache> imageCache { new NotificationImageCache };
+#endif
 };
 
 NotificationManager *NotificationManager::s_instance = nullptr;
@@ -281,8 +342,15 @@ NotificationManager *NotificationManager::instance()
     return s_instance;
 }
 
-QObject *NotificationManager::instanceForQml(QQmlEngine *, QJSEngine *)
+QObject *NotificationManager::instanceForQml(QQmlEngine *qmlEngine, QJSEngine *)
 {
+#if !defined(AM_HEADLESS)
+    const QString providerId = qL1S(NotificationImageCache::providerId());
+    if (qmlEngine && !qmlEngine->imageProvider(providerId))
+        qmlEngine->addImageProvider(providerId, new NotificationImageProvider(instance()->d->imageCache));
+#else
+    Q_UNUSED(qmlEngine)
+#endif
     QQmlEngine::setObjectOwnership(instance(), QQmlEngine::CppOwnership);
     return instance();
 }
@@ -297,6 +365,13 @@ NotificationManager::NotificationManager(QObject *parent)
     connect(this, &QAbstractItemModel::modelReset, this, &NotificationManager::countChanged);
 
     d->q = this;
+    d->timeoutClock.start();
+    d->timeoutTimer.setSingleShot(true);
+    d->timeoutTimer.setTimerType(Qt::PreciseTimer); // a coarse timer could fire too early
+    connect(&d->timeoutTimer, &QTimer::timeout, this, [this]() { d->expireTimeouts(); });
+    d->updateTimer.setSingleShot(true);
+    connect(&d->updateTimer, &QTimer::timeout, this, [this]() { d->flushPendingUpdates(); });
+
     d->roleNames.insert(Id, "id");
     d->roleNames.insert(ApplicationId, "applicationId");
     d->roleNames.insert(Priority, "priority");
@@ -556,6 +631,21 @@ uint NotificationManager::Notify(const QString &app_name, uint replaces_id, cons
     }
 }
 
+/*! \internal
+    Replace-updates for the same notification that arrive within \a msec milliseconds of each
+    other are merged and only the last one is reported to the System UI. 0 disables this.
+*/
+void NotificationManager::setUpdateCoalescingInterval(int msec)
+{
+    d->updateCoalescingInterval = qMax(0, msec);
+    if (d->updateCoalescingInterval && !d->updateClock.isValid())
+        d->updateClock.start();
+    if (!d->updateCoalescingInterval && d->updateTimer.isActive()) {
+        d->updateTimer.stop();
+        d->flushPendingUpdates();
+    }
+}
+
 uint NotificationManager::notifyHelper(const QString &app_name, uint id, bool replaces, const QString &app_icon,
                                        const QString &summary, const QString &body, const QStringList &actions,
                                        const QVariantMap &hints, int timeout)
@@ -563,6 +653,8 @@ uint NotificationManager::notifyHelper(const QString &app_name, uint id, bool re
     Q_ASSERT(id);
     NotificationData *n = nullptr;
 
+    Application *app = ApplicationManager::instance()->fromId(app_name);
+
     if (replaces) {
        int i = d->findNotificationById(id);
 
@@ -571,71 +663,199 @@ uint NotificationManager::notifyHelper(const QString &app_name, uint id, bool re
            return 0;
        }
        n = d->notifications.at(i);
+
+       if (app != n->application) {
+           // no hijacking allowed
+           qCDebug(LogNotifications) << "  -> failed to update notification, due to hijacking attempt";
+           return 0;
+       }
+
+       if (d->updateCoalescingInterval > 0) {
+           // report the first update of a burst right away, but coalesce all following ones
+           const qint64 now = d->updateClock.elapsed();
+           if (d->pendingUpdates.contains(id)
+                   || ((now - n->lastUpdateTime) < d->updateCoalescingInterval)) {
+               qCDebug(LogNotifications) << "  -> coalescing update of existing notification";
+               d->pendingUpdates.insert(id, { app_icon, summary, body, actions, hints, timeout });
+               if (!d->updateTimer.isActive()) {
+                   d->updateTimer.start(int(qBound(qint64(0), n->lastUpdateTime + d->updateCoalescingInterval - now,
+                                                   qint64(d->updateCoalescingInterval))));
+               }
+               return id;
+           }
+           n->lastUpdateTime = now;
+       }
        qCDebug(LogNotifications) << "  -> updating existing notification";
+       d->updateNotification(n, app_icon, summary, body, actions, hints, timeout);
     } else {
         n = new NotificationData;
         n->id = id;
+        n->application = app;
+        d->setNotificationData(n, app_icon, summary, body, actions, hints, timeout);
+        if (d->updateCoalescingInterval > 0)
+            n->lastUpdateTime = d->updateClock.elapsed();
 
-        beginInsertRows(QModelIndex(), rowCount(), rowCount());
         qCDebug(LogNotifications) << "  -> adding new notification with id" << id;
+        beginInsertRows(QModelIndex(), rowCount(), rowCount());
+        d->rowIndex.insert(n->id, d->notifications.count());
+        d->notifications << n;
+        endInsertRows();
+        emit notificationAdded(n->id);
+
+        d->scheduleTimeout(n, n->timeout);
     }
 
-    Application *app = ApplicationManager::instance()->fromId(app_name);
+    qCDebug(LogNotifications) << "  -> returning id" << id;
+    return id;
+}
 
-    if (replaces && app != n->application) {
-        // no hijacking allowed
-        qCDebug(LogNotifications) << "  -> failed to update notification, due to hijacking attempt";
-        return 0;
+QVector<int> NotificationManagerPrivate::setNotificationData(NotificationData *n, const QString &app_icon,
+                                                             const QString &summary, const QString &body,
+                                                             const QStringList &actions,
+                                                             const QVariantMap &hints, int timeout)
+{
+    QVector<int> changedRoles;
+    const uint priority = hints.value(qSL("urgency"), QVariant(0)).toUInt();
+    if (priority != n->priority) {
+        n->priority = priority;
+        changedRoles << Priority;
     }
-    n->application = app;
-    n->priority = hints.value(qSL("urgency"), QVariant(0)).toUInt();
-    n->summary = summary;
-    n->body = body;
-    n->category = hints.value(qSL("category")).toString();
-    n->iconUrl = app_icon;
-
-    if (hints.contains(qSL("image-data"))) {
-        //TODO: how can we parse this - the dbus sig of value is "(iiibiiay)"
-    } else if (hints.contains(qSL("image-path"))) {
-        n->imageUrl = hints.value(qSL("image-path")).toString();
+    if (summary != n->summary) {
+        n->summary = summary;
+        changedRoles << Summary;
+    }
+    if (body != n->body) {
+        n->body = body;
+        changedRoles << Body;
+    }
+    const QString category = hints.value(qSL("category")).toString();
+    if (category != n->category) {
+        n->category = category;
+        changedRoles << Category;
+    }
+    if (app_icon != n->iconUrl) {
+        n->iconUrl = app_icon;
+        changedRoles << Icon;
     }
 
-    n->showActionIcons = hints.value(qSL("action-icons")).toBool();
-    n->actions.clear();
-    for (int ai = 0; ai != (actions.size() & ~1); ai += 2)
-        n->actions.append(QVariantMap { { actions.at(ai), actions.at(ai + 1) } });
-    n->dismissOnAction = !hints.value(qSL("resident")).toBool();
-
-    n->isSystemNotification = hints.value(qSL("x-pelagicore-system-notification")).toBool();
-    n->isShowingProgress = hints.value(qSL("x-pelagicore-show-progress")).toBool();
-    n->progress = hints.value(qSL("x-pelagicore-progress")).toReal();
-    n->timeout = qMax(0, timeout);
-    n->extended = convertFromDBusVariant(hints.value(qSL("x-pelagicore-extended"))).toMap();
+    // image-data takes precedence over image-path - the deprecated names are still supported
+    QVariant imageData;
+    bool imageIsMemFd = false;
+    for (const char *key : { "x-pelagicore-image-memfd", "image-data", "image_data", "icon_data" }) {
+        imageData = hints.value(qL1S(key));
+        if (imageData.isValid()) {
+            imageIsMemFd = (key[0] == 'x');
+            break;
+        }
+    }
 
-    if (replaces) {
-        QModelIndex idx = index(d->notifications.indexOf(n), 0);
-        emit dataChanged(idx, idx);
-        static const auto nChanged = QMetaMethod::fromSignal(&NotificationManager::notificationChanged);
-        if (isSignalConnected(nChanged)) {
-            // we could do better here and actually find out which fields changed...
-            emit notificationChanged(n->id, QStringList());
+#if !defined(AM_HEADLESS)
+    if (imageData.isValid()) {
+        const QString imageUrl = imageCache->insertImageHint(n->id, imageData, imageIsMemFd);
+        if (!imageUrl.isEmpty() && (imageUrl != n->imageUrl)) {
+            n->imageUrl = imageUrl;
+            changedRoles << Image;
+        }
+    } else if (hints.contains(qSL("image-path"))) {
+#else
+    Q_UNUSED(imageIsMemFd)
+    if (!imageData.isValid() && hints.contains(qSL("image-path"))) {
+#endif
+        const QString imageUrl = hints.value(qSL("image-path")).toString();
+        if (imageUrl != n->imageUrl) {
+            n->imageUrl = imageUrl;
+            changedRoles << Image;
         }
-    } else {
-        d->notifications << n;
-        endInsertRows();
-        emit notificationAdded(n->id);
     }
 
-    if (timeout > 0) {
-        delete n->timer;
-        QTimer *t = new QTimer(this);
-        connect(t, &QTimer::timeout, [this,id,t]() { d->closeNotification(id, TimeoutExpired); t->deleteLater(); });
-        t->start(timeout);
-        n->timer = t;
+    const bool showActionIcons = hints.value(qSL("action-icons")).toBool();
+    if (showActionIcons != n->showActionIcons) {
+        n->showActionIcons = showActionIcons;
+        changedRoles << ShowActionsAsIcons;
+    }
+    // only rebuild the action list, if the actions did actually change
+    if (actions != n->rawActions) {
+        n->rawActions = actions;
+        n->actions.clear();
+        for (int ai = 0; ai != (actions.size() & ~1); ai += 2)
+            n->actions.append(QVariantMap { { actions.at(ai), actions.at(ai + 1) } });
+        changedRoles << Actions << IsClickable;
+    }
+    const bool dismissOnAction = !hints.value(qSL("resident")).toBool();
+    if (dismissOnAction != n->dismissOnAction) {
+        n->dismissOnAction = dismissOnAction;
+        changedRoles << DismissOnAction;
     }
 
-    qCDebug(LogNotifications) << "  -> returning id" << id;
-    return id;
+    const bool isSystemNotification = hints.value(qSL("x-pelagicore-system-notification")).toBool();
+    if (isSystemNotification != n->isSystemNotification) {
+        n->isSystemNotification = isSystemNotification;
+        changedRoles << IsSystemNotification;
+    }
+    const bool isShowingProgress = hints.value(qSL("x-pelagicore-show-progress")).toBool();
+    if (isShowingProgress != n->isShowingProgress) {
+        n->isShowingProgress = isShowingProgress;
+        changedRoles << IsShowingProgress << Progress;
+    }
+    const qreal progress = hints.value(qSL("x-pelagicore-progress")).toReal();
+    if (progress != n->progress) {
+        n->progress = progress;
+        if (!changedRoles.contains(Progress))
+            changedRoles << Progress;
+    }
+    timeout = qMax(0, timeout);
+    if (timeout != n->timeout) {
+        if ((timeout == 0) != (n->timeout == 0))
+            changedRoles << IsSticky;
+        n->timeout = timeout;
+        changedRoles << Timeout;
+    }
+    const QVariantMap extended = convertFromDBusVariant(hints.value(qSL("x-pelagicore-extended"))).toMap();
+    if (extended != n->extended) {
+        n->extended = extended;
+        changedRoles << Extended;
+    }
+    return changedRoles;
+}
+
+void NotificationManagerPrivate::updateNotification(NotificationData *n, const QString &app_icon,
+                                                    const QString &summary, const QString &body,
+                                                    const QStringList &actions, const QVariantMap &hints,
+                                                    int timeout)
+{
+    const QVector<int> changedRoles = setNotificationData(n, app_icon, summary, body, actions, hints, timeout);
+
+    // a replace-update always restarts the timeout, even if it did not change
+    scheduleTimeout(n, n->timeout);
+
+    if (changedRoles.isEmpty())
+        return;
+
+    QModelIndex idx = q->index(findNotificationById(n->id), 0);
+    emit q->dataChanged(idx, idx, changedRoles);
+    static const auto nChanged = QMetaMethod::fromSignal(&NotificationManager::notificationChanged);
+    if (q->isSignalConnected(nChanged)) {
+        QStringList changedRoleNames;
+        for (int role : changedRoles)
+            changedRoleNames << QString::fromLatin1(roleNames.value(role));
+        emit q->notificationChanged(n->id, changedRoleNames);
+    }
+}
+
+void NotificationManagerPrivate::flushPendingUpdates()
+{
+    const auto pending = pendingUpdates;
+    pendingUpdates.clear();
+    const qint64 now = updateClock.elapsed();
+
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        int i = findNotificationById(it.key());
+        if (i < 0)
+            continue; // closed in the meantime
+        NotificationData *n = notifications.at(i);
+        n->lastUpdateTime = now;
+        updateNotification(n, it->appIcon, it->summary, it->body, it->actions, it->hints, it->timeout);
+    }
 }
 
 /*! \internal
@@ -657,13 +877,77 @@ void NotificationManagerPrivate::closeNotification(uint id, CloseReason reason)
 
         q->beginRemoveRows(QModelIndex(), i, i);
         auto n = notifications.takeAt(i);
+        rowIndex.remove(id);
+        pendingUpdates.remove(id);
+        cancelTimeout(n);
+        for (int row = i; row < notifications.count(); ++row)
+            rowIndex[notifications.at(row)->id] = row;
         q->endRemoveRows();
 
         emit q->NotificationClosed(id, uint(reason));
 
+#if !defined(AM_HEADLESS)
+        imageCache->remove(id);
+#endif
         qCDebug(LogNotifications) << "Deleting notification with id:" << id;
         delete n;
     }
 }
 
+void NotificationManagerPrivate::scheduleTimeout(NotificationData *n, int timeout)
+{
+    // a replace-update supersedes the old deadline and a sticky notification has none at all
+    cancelTimeout(n);
+    if (timeout <= 0)
+        return;
+
+    // 0 is reserved for "no timeout"
+    n->expiryTime = qMax(qint64(1), timeoutClock.elapsed() + timeout);
+    const bool isEarliest = expiryMap.isEmpty() || (n->expiryTime < expiryMap.firstKey());
+    expiryMap.insert(n->expiryTime, n->id);
+    if (isEarliest)
+        startTimeoutTimer();
+}
+
+void NotificationManagerPrivate::cancelTimeout(NotificationData *n)
+{
+    if (!n->expiryTime)
+        return;
+
+    const bool wasEarliest = (n->expiryTime == expiryMap.firstKey());
+    expiryMap.remove(n->expiryTime, n->id);
+    n->expiryTime = 0;
+
+    if (expiryMap.isEmpty())
+        timeoutTimer.stop();
+    else if (wasEarliest)
+        startTimeoutTimer();
+}
+
+void NotificationManagerPrivate::startTimeoutTimer()
+{
+    const qint64 msecToExpiry = expiryMap.firstKey() - timeoutClock.elapsed();
+    timeoutTimer.start(int(qBound(qint64(0), msecToExpiry, qint64(std::numeric_limits<int>::max()))));
+}
+
+void NotificationManagerPrivate::expireTimeouts()
+{
+    const qint64 now = timeoutClock.elapsed();
+    QVector<uint> expired;
+
+    while (!expiryMap.isEmpty() && (expiryMap.firstKey() <= now)) {
+        const uint id = expiryMap.take(expiryMap.firstKey());
+        int row = findNotificationById(id);
+        if (row >= 0)
+            notifications.at(row)->expiryTime = 0;
+        expired.append(id);
+    }
+    if (!expiryMap.isEmpty())
+        startTimeoutTimer();
+
+    // closing might re-enter via QML signal handlers, so the map has to be consistent by now
+    for (uint id : qAsConst(expired))
+        closeNotification(id, TimeoutExpired);
+}
+
 QT_END_NAMESPACE_AM
@@ -81,6 +81,8 @@ public:
     Q_INVOKABLE void triggerNotificationAction(uint id, const QString &actionId);
     Q_INVOKABLE void dismissNotification(uint id);
 
+    void setUpdateCoalescingInterval(int msec);
+
     // vv libnotify DBus interface
     Q_SCRIPTABLE QString GetServerInformation(QString &vendor, QString &version, QString &spec_version);
     Q_SCRIPTABLE QStringList GetCapabilities();
@@ -176,6 +176,20 @@ PackageManager::PackageManager(PackageDatabase *packageDatabase,
     d->database = packageDatabase;
     d->installationPath = packageDatabase->installedPackagesDir();
     d->documentPath = documentPath;
+
+    d->dataChangedCoalescer.reset(new DataChangedCoalescer(this, [this](QObject *item) {
+        return d->packages.indexOf(static_cast<Package *>(item));
+    }, [this](int firstRow, int lastRow, const QVector<int> &roles) {
+        emit dataChanged(index(firstRow), index(lastRow), roles);
+    }, [this](QObject *item, const QVector<int> &roles) {
+        static const auto pkgChanged = QMetaMethod::fromSignal(&PackageManager::packageChanged);
+        if (isSignalConnected(pkgChanged)) {
+            QStringList stringRoles;
+            for (auto role : roles)
+                stringRoles << qL1S(s_roleNames[role]);
+            emit packageChanged(static_cast<Package *>(item)->id(), stringRoles);
+        }
+    }));
 }
 
 PackageManager::~PackageManager()
@@ -196,18 +210,10 @@ Package *PackageManager::fromId(const QString &id) const
 
 void PackageManager::emitDataChanged(Package *package, const QVector<int> &roles)
 {
-    int row = d->packages.indexOf(package);
-    if (row >= 0) {
-        emit dataChanged(index(row), index(row), roles);
-
-        static const auto pkgChanged = QMetaMethod::fromSignal(&PackageManager::packageChanged);
-        if (isSignalConnected(pkgChanged)) {
-            QStringList stringRoles;
-            for (auto role : roles)
-                stringRoles << qL1S(s_roleNames[role]);
-            emit packageChanged(package->id(), stringRoles);
-        }
-    }
+    // the actual signals are emitted in batches once per event loop iteration: this is
+    // important for the progress updates during installations
+    if (d->packages.contains(package))
+        d->dataChangedCoalescer->add(package, roles);
 }
 
 // item model part
@@ -1056,6 +1062,8 @@ bool PackageManager::startingPackageInstallation(PackageInfo *info)
 
         Q_ASSERT(package->block());
 
+        // pending changes have to be reported before the rows change
+        d->dataChangedCoalescer->flush();
         beginInsertRows(QModelIndex(), d->packages.count(), d->packages.count());
 
         QQmlEngine::setObjectOwnership(package, QQmlEngine::CppOwnership);
@@ -1130,6 +1138,7 @@ bool PackageManager::finishedPackageInstall(const QString &id)
         break;
 
     case Package::BeingRemoved: {
+        d->dataChangedCoalescer->flush();
         int row = d->packages.indexOf(package);
         if (row >= 0) {
             emit packageAboutToBeRemoved(package->id());
@@ -1137,6 +1146,7 @@ bool PackageManager::finishedPackageInstall(const QString &id)
             d->packages.removeAt(row);
             endRemoveRows();
         }
+        d->dataChangedCoalescer->remove(package);
         delete package;
         break;
     }
@@ -1158,6 +1168,7 @@ bool PackageManager::canceledPackageInstall(const QString &id)
         return false;
 
     case Package::BeingInstalled: {
+        d->dataChangedCoalescer->flush();
         int row = d->packages.indexOf(package);
         if (row >= 0) {
             emit packageAboutToBeRemoved(package->id());
@@ -1165,6 +1176,7 @@ bool PackageManager::canceledPackageInstall(const QString &id)
             d->packages.removeAt(row);
             endRemoveRows();
         }
+        d->dataChangedCoalescer->remove(package);
         delete package;
         break;
     }
@@ -51,6 +51,7 @@
 #include <QtAppManManager/packagemanager.h>
 #include <QtAppManApplication/packagedatabase.h>
 #include <QtAppManManager/asynchronoustask.h>
+#include <QtAppManManager/datachangedcoalescer.h>
 #include <QtAppManCommon/global.h>
 
 QT_BEGIN_NAMESPACE_AM
@@ -62,6 +63,7 @@ class PackageManagerPrivate
 public:
     PackageDatabase *database = nullptr;
     QVector<Package *> packages;
+    QScopedPointer<DataChangedCoalescer> dataChangedCoalescer;
 
     bool developmentMode = false;
     bool allowInstallationOfUnsignedPackages = false;
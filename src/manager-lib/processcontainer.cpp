@@ -40,8 +40,17 @@
 **
 ****************************************************************************/
 
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QHash>
+#include <QSocketNotifier>
+#include <algorithm>
+
 #include "global.h"
 #include "logging.h"
+#include "utilities.h"
+#include "qtyaml.h"
+#include "binaryconfiguration.h"
 #include "containerfactory.h"
 #include "application.h"
 #include "processcontainer.h"
@@ -53,6 +62,11 @@
 #  include <unistd.h>
 #  include <fcntl.h>
 #endif
+#if defined(Q_OS_LINUX)
+#  include <errno.h>
+#  include <string.h>
+#  include <sys/socket.h>
+#endif
 
 QT_BEGIN_NAMESPACE_AM
 
@@ -75,12 +89,16 @@ protected:
                 ::close(fd);
             }
         }
+        // only clear the close-on-exec flag in the child, so these fds do not leak anywhere else
+        for (int fd : qAsConst(m_inheritedFds))
+            fcntl(fd, F_SETFD, 0);
 #endif
     }
 
 public:
     bool m_stopBeforeExec = false;
     QVector<int> m_stdioRedirections;
+    QVector<int> m_inheritedFds;
 };
 
 
@@ -182,6 +200,410 @@ void HostProcess::setStopBeforeExec(bool stopBeforeExec)
     m_process->m_stopBeforeExec = stopBeforeExec;
 }
 
+void HostProcess::setInheritedFileDescriptors(const QVector<int> &fds)
+{
+    m_process->m_inheritedFds = fds;
+}
+
+
+#if defined(Q_OS_LINUX)
+
+// The connection to a zygote process: see launcher-lib's zygote.cpp for the protocol. There is
+// one zygote per launcher executable and set of preloaded libraries. It is started on demand and
+// forks a child for every ZygoteProcess that is started.
+class ZygoteConnection : public QObject // clazy:exclude=missing-qobject-macro
+{
+public:
+    static ZygoteConnection *instance(const QString &program, const QStringList &preloadLibraries,
+                                      const QProcessEnvironment &environment);
+
+    bool fork(ZygoteProcess *process, const QStringList &arguments, const QProcessEnvironment &environment,
+              const QString &workingDirectory, int configFd);
+    void forget(ZygoteProcess *process);
+
+private:
+    ZygoteConnection(const QString &key, const QString &program, const QStringList &preloadLibraries,
+                     const QProcessEnvironment &environment);
+    ~ZygoteConnection() override;
+
+    bool startZygote();
+    void readReplies();
+    void handleReply(const QByteArray &payload);
+    void zygoteDied();
+
+    QString m_key;
+    QString m_program;
+    QStringList m_preloadLibraries;
+    QProcessEnvironment m_environment;
+    HostQProcess *m_zygote = nullptr;
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QByteArray m_buffer;
+    quint32 m_nextRequestId = 0;
+    QHash<quint32, ZygoteProcess *> m_pending;
+    QHash<qint64, ZygoteProcess *> m_running;
+    bool m_dead = false;
+
+    static QHash<QString, ZygoteConnection *> s_connections;
+};
+
+QHash<QString, ZygoteConnection *> ZygoteConnection::s_connections;
+
+ZygoteConnection *ZygoteConnection::instance(const QString &program, const QStringList &preloadLibraries,
+                                             const QProcessEnvironment &environment)
+{
+    // The children get their complete environment with every request, but the zygote itself also
+    // needs the runtime's environment: everything that is evaluated before the fork (e.g. by the
+    // dynamic linker or by the static initializers of preloaded libraries) would be missing
+    // otherwise. Only the per-instance configuration is left out, so that the zygote can be
+    // shared by all processes with the same environment.
+    QProcessEnvironment zygoteEnvironment = environment;
+    zygoteEnvironment.remove(qSL("AM_CONFIG"));
+    zygoteEnvironment.remove(qSL("AM_CONFIG_FD"));
+    QStringList variables = zygoteEnvironment.toStringList();
+    variables.sort();
+
+    const QString key = program + qL1C('\n') + preloadLibraries.join(qL1C(':')) + qL1C('\n')
+            + variables.join(qL1C('\n'));
+    ZygoteConnection *zc = s_connections.value(key);
+    if (!zc) {
+        zc = new ZygoteConnection(key, program, preloadLibraries, zygoteEnvironment);
+        if (!zc->startZygote()) {
+            delete zc;
+            return nullptr;
+        }
+        s_connections.insert(key, zc);
+    }
+    return zc;
+}
+
+ZygoteConnection::ZygoteConnection(const QString &key, const QString &program, const QStringList &preloadLibraries,
+                                   const QProcessEnvironment &environment)
+    : QObject(qApp)
+    , m_key(key)
+    , m_program(program)
+    , m_preloadLibraries(preloadLibraries)
+    , m_environment(environment)
+{ }
+
+ZygoteConnection::~ZygoteConnection()
+{
+    if (s_connections.value(m_key) == this)
+        s_connections.remove(m_key);
+    for (ZygoteProcess *process : qAsConst(m_pending))
+        process->m_zygote = nullptr;
+    for (ZygoteProcess *process : qAsConst(m_running))
+        process->m_zygote = nullptr;
+    if (m_fd >= 0)
+        ::close(m_fd);
+    // deleting the QProcess kills the zygote and hence all its children
+}
+
+bool ZygoteConnection::startZygote()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        qCWarning(LogSystem) << "Could not create a socket pair for the zygote:" << strerror(errno);
+        return false;
+    }
+
+    m_zygote = new HostQProcess;
+    m_zygote->setParent(this);
+    m_zygote->setProcessChannelMode(QProcess::ForwardedChannels);
+    m_zygote->setInputChannelMode(QProcess::ForwardedInputChannel);
+    QProcessEnvironment env = m_environment;
+    env.insert(qSL("AM_ZYGOTE_FD"), QString::number(sv[1]));
+    if (!m_preloadLibraries.isEmpty())
+        env.insert(qSL("AM_ZYGOTE_PRELOAD"), m_preloadLibraries.join(qL1C(':')));
+    m_zygote->setProcessEnvironment(env);
+
+    // The zygote's end of the socket has to survive the exec, but must not leak into any other
+    // child that is started in the meantime: the close-on-exec flag is only cleared in the child.
+    m_zygote->m_inheritedFds = { sv[1] };
+    m_zygote->start(m_program, QStringList());
+    ::close(sv[1]);
+
+    if (!m_zygote->waitForStarted()) {
+        qCWarning(LogSystem) << "Could not start the zygote" << m_program << ":" << m_zygote->errorString();
+        ::close(sv[0]);
+        return false;
+    }
+    m_fd = sv[0];
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, [this]() { readReplies(); });
+    connect(m_zygote, static_cast<void (QProcess::*)(int,QProcess::ExitStatus)>(&QProcess::finished),
+            this, [this]() { zygoteDied(); });
+
+    qCDebug(LogSystem) << "Started zygote" << m_program << "with pid" << m_zygote->processId();
+    return true;
+}
+
+bool ZygoteConnection::fork(ZygoteProcess *process, const QStringList &arguments,
+                            const QProcessEnvironment &environment, const QString &workingDirectory,
+                            int configFd)
+{
+    if (m_dead)
+        return false;
+
+    quint32 requestId = ++m_nextRequestId;
+    QByteArray payload;
+    QDataStream ds(&payload, QIODevice::WriteOnly);
+    ds << requestId << arguments << environment.toStringList() << workingDirectory;
+
+    quint32 size = quint32(payload.size());
+    QByteArray message(reinterpret_cast<const char *>(&size), sizeof(size));
+    message.append(payload);
+
+    const char *data = message.constData();
+    qint64 todo = message.size();
+
+    // the configuration fd is attached to the first byte of the message
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    bool sendConfigFd = (configFd >= 0);
+
+    while (todo > 0) {
+        ssize_t written;
+        if (sendConfigFd) {
+            struct iovec iov = { const_cast<char *>(data), size_t(todo) };
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            memset(&control, 0, sizeof(control));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control.buffer;
+            msg.msg_controllen = sizeof(control.buffer);
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &configFd, sizeof(int));
+
+            written = ::sendmsg(m_fd, &msg, MSG_NOSIGNAL);
+            if (written > 0)
+                sendConfigFd = false;
+        } else {
+            written = ::write(m_fd, data, size_t(todo));
+        }
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0) {
+            qCWarning(LogSystem) << "Could not send a request to the zygote" << m_program << ":" << strerror(errno);
+            return false;
+        }
+        data += written;
+        todo -= written;
+    }
+    m_pending.insert(requestId, process);
+    return true;
+}
+
+void ZygoteConnection::forget(ZygoteProcess *process)
+{
+    for (auto it = m_pending.begin(); it != m_pending.end(); ) {
+        if (it.value() == process)
+            it = m_pending.erase(it);
+        else
+            ++it;
+    }
+    if (process->m_pid)
+        m_running.remove(process->m_pid);
+}
+
+void ZygoteConnection::readReplies()
+{
+    bool eof = false;
+    char buffer[4096];
+    forever {
+        ssize_t bytesRead = ::recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytesRead > 0)
+            m_buffer.append(buffer, int(bytesRead));
+        else if (bytesRead < 0 && errno == EINTR)
+            continue;
+        else {
+            eof = (bytesRead == 0) || (errno != EAGAIN && errno != EWOULDBLOCK);
+            break;
+        }
+    }
+
+    while (m_buffer.size() >= int(sizeof(quint32))) {
+        quint32 size;
+        memcpy(&size, m_buffer.constData(), sizeof(size));
+        if (m_buffer.size() < int(sizeof(size) + size))
+            break;
+        const QByteArray payload = m_buffer.mid(sizeof(size), int(size));
+        m_buffer.remove(0, int(sizeof(size) + size));
+        handleReply(payload);
+    }
+
+    if (eof)
+        zygoteDied();
+}
+
+void ZygoteConnection::handleReply(const QByteArray &payload)
+{
+    QDataStream ds(payload);
+    quint8 type;
+    ds >> type;
+
+    switch (type) {
+    case 'S': {
+        quint32 requestId;
+        qint64 pid;
+        ds >> requestId >> pid;
+        if (ZygoteProcess *process = m_pending.take(requestId)) {
+            m_running.insert(pid, process);
+            process->forked(pid);
+        } else {
+            ::kill(pid_t(pid), SIGKILL); // nobody is interested in this child anymore
+        }
+        break;
+    }
+    case 'E': {
+        quint32 requestId;
+        qint32 error;
+        ds >> requestId >> error;
+        qCWarning(LogSystem) << "The zygote" << m_program << "could not fork:" << strerror(error);
+        if (ZygoteProcess *process = m_pending.take(requestId))
+            process->forkFailed();
+        break;
+    }
+    case 'F': {
+        qint64 pid;
+        qint32 exitCode;
+        bool crashed;
+        ds >> pid >> exitCode >> crashed;
+        if (ZygoteProcess *process = m_running.take(pid))
+            process->exited(exitCode, crashed);
+        break;
+    }
+    default:
+        qCWarning(LogSystem) << "Received an invalid reply from the zygote" << m_program;
+        break;
+    }
+}
+
+void ZygoteConnection::zygoteDied()
+{
+    if (m_dead)
+        return;
+    m_dead = true;
+    m_notifier->setEnabled(false);
+    s_connections.remove(m_key);
+
+    qCWarning(LogSystem) << "The zygote" << m_program << "died - all its children have been killed";
+
+    // all the children die together with the zygote (see PR_SET_PDEATHSIG in zygote.cpp)
+    const auto pending = m_pending.values();
+    const auto running = m_running.values();
+    m_pending.clear();
+    m_running.clear();
+    for (ZygoteProcess *process : pending)
+        process->forkFailed();
+    for (ZygoteProcess *process : running)
+        process->exited(-1, true);
+
+    deleteLater();
+}
+
+#endif // Q_OS_LINUX
+
+
+ZygoteProcess::ZygoteProcess()
+{ }
+
+ZygoteProcess::~ZygoteProcess()
+{
+#if defined(Q_OS_LINUX)
+    if (m_zygote)
+        m_zygote->forget(this);
+#endif
+}
+
+bool ZygoteProcess::start(const QString &program, const QStringList &arguments, const QProcessEnvironment &environment,
+                          const QString &workingDirectory, const QStringList &preloadLibraries, int configFd)
+{
+#if defined(Q_OS_LINUX)
+    m_zygote = ZygoteConnection::instance(program, preloadLibraries, environment);
+    if (!m_zygote || !m_zygote->fork(this, arguments, environment, workingDirectory, configFd)) {
+        m_zygote = nullptr;
+        return false;
+    }
+    setState(Am::StartingUp);
+    return true;
+#else
+    Q_UNUSED(program)
+    Q_UNUSED(arguments)
+    Q_UNUSED(environment)
+    Q_UNUSED(workingDirectory)
+    Q_UNUSED(preloadLibraries)
+    Q_UNUSED(configFd)
+    return false;
+#endif
+}
+
+qint64 ZygoteProcess::processId() const
+{
+    return m_pid;
+}
+
+Am::RunState ZygoteProcess::state() const
+{
+    return m_state;
+}
+
+void ZygoteProcess::kill()
+{
+    sendSignal(SIGKILL);
+}
+
+void ZygoteProcess::terminate()
+{
+    sendSignal(SIGTERM);
+}
+
+void ZygoteProcess::setState(Am::RunState state)
+{
+    if (state != m_state) {
+        m_state = state;
+        emit stateChanged(state);
+    }
+}
+
+void ZygoteProcess::sendSignal(int signal)
+{
+    if (m_state == Am::Running && m_pid)
+        ::kill(pid_t(m_pid), signal);
+    else if (m_state == Am::StartingUp)
+        m_pendingSignal = signal; // we do not know the pid yet
+}
+
+void ZygoteProcess::forked(qint64 pid)
+{
+    m_pid = pid;
+    if (m_pendingSignal)
+        ::kill(pid_t(pid), m_pendingSignal);
+    setState(Am::Running);
+    emit started();
+}
+
+void ZygoteProcess::forkFailed()
+{
+    m_zygote = nullptr;
+    setState(Am::NotRunning);
+    emit errorOccured(Am::FailedToStart);
+}
+
+void ZygoteProcess::exited(int exitCode, bool crashed)
+{
+    m_zygote = nullptr;
+    setState(Am::NotRunning);
+    emit finished(exitCode, crashed ? Am::CrashExit : Am::NormalExit);
+}
+
 
 ProcessContainer::ProcessContainer(ProcessContainerManager *manager, Application *app,
                                    const QVector<int> &stdioRedirections,
@@ -201,49 +623,90 @@ QString ProcessContainer::controlGroup() const
     return m_currentControlGroup;
 }
 
-bool ProcessContainer::setControlGroup(const QString &groupName)
+static bool writeControlGroupFiles(const QString &program, qint64 pid, const QStringList &files)
 {
-    if (groupName == m_currentControlGroup)
-        return true;
+    QByteArray pidString = QByteArray::number(pid);
+    pidString.append('\n');
+
+    for (const QString &file : files) {
+        QFile f(file);
+        bool ok = f.open(QFile::WriteOnly);
+        ok = ok && (f.write(pidString) == pidString.size());
 
+        if (!ok) {
+            qWarning() << "Failed setting cgroup for" << program << ", pid" << pid << ":" << file;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ProcessContainer::controlGroupFiles(const QString &groupName, QStringList *files, QString *memoryUserClass) const
+{
     QVariantMap map = m_manager->configuration().value(qSL("controlGroups")).toMap();
     auto git = map.constFind(groupName);
-    if (git != map.constEnd()) {
-        QVariantMap mapping = (*git).toMap();
-        QByteArray pidString = QByteArray::number(m_process->processId());
-        pidString.append('\n');
+    if (git == map.constEnd())
+        return false;
+
+    QVariantMap mapping = (*git).toMap();
+    for (auto it = mapping.cbegin(); it != mapping.cend(); ++it) {
+        const QString &resource = it.key();
+        const QString &userclass = it.value().toString();
+
+#if defined(Q_OS_LINUX)
+        // with cgroup v2 all controllers share a single hierarchy
+        QString file = hasUnifiedCGroupHierarchy()
+                ? QString(qSL("/sys/fs/cgroup/%1/cgroup.procs")).arg(userclass)
+                : QString(qSL("/sys/fs/cgroup/%1/%2/cgroup.procs")).arg(resource, userclass);
+#else
+        QString file = QString(qSL("/sys/fs/cgroup/%1/%2/cgroup.procs")).arg(resource, userclass);
+#endif
+        *files << file;
+        if (resource == qSL("memory"))
+            *memoryUserClass = userclass;
+    }
+    return true;
+}
 
-        for (auto it = mapping.cbegin(); it != mapping.cend(); ++it) {
-            const QString &resource = it.key();
-            const QString &userclass = it.value().toString();
+void ProcessContainer::controlGroupChanged(const QString &groupName, const QString &memoryUserClass)
+{
+    if (!memoryUserClass.isEmpty()) {
+        if (!m_memWatcher) {
+            m_memWatcher = new MemoryWatcher(this);
+            connect(m_memWatcher, &MemoryWatcher::memoryLow,
+                    this, &ProcessContainer::memoryLowWarning);
+            connect(m_memWatcher, &MemoryWatcher::memoryCritical,
+                    this, &ProcessContainer::memoryCriticalWarning);
+        }
+        m_memWatcher->startWatching(memoryUserClass);
+    }
+    m_currentControlGroup = groupName;
+}
 
-            //qWarning() << "Setting cgroup for" << m_program << ", pid" << m_process->processId() << ":" << resource << "->" << userclass;
+bool ProcessContainer::setControlGroup(const QString &groupName)
+{
+    if (groupName == m_currentControlGroup)
+        return true;
 
-            QString file = QString(qSL("/sys/fs/cgroup/%1/%2/cgroup.procs")).arg(resource, userclass);
-            QFile f(file);
-            bool ok = f.open(QFile::WriteOnly);
-            ok = ok && (f.write(pidString) == pidString.size());
+    QStringList files;
+    QString memoryUserClass;
+    if (!controlGroupFiles(groupName, &files, &memoryUserClass))
+        return false;
 
-            if (!ok) {
-                qWarning() << "Failed setting cgroup for" << m_program << ", pid" << m_process->processId() << ":" << resource << "->" << userclass;
-                return false;
-            }
+    if (!writeControlGroupFiles(m_program, m_process->processId(), files))
+        return false;
+    controlGroupChanged(groupName, memoryUserClass);
+    return true;
+}
 
-            if (resource == qSL("memory")) {
-                if (!m_memWatcher) {
-                    m_memWatcher = new MemoryWatcher(this);
-                    connect(m_memWatcher, &MemoryWatcher::memoryLow,
-                            this, &ProcessContainer::memoryLowWarning);
-                    connect(m_memWatcher, &MemoryWatcher::memoryCritical,
-                            this, &ProcessContainer::memoryCriticalWarning);
-                }
-                m_memWatcher->startWatching(userclass);
-            }
-        }
-        m_currentControlGroup = groupName;
-        return true;
-    }
-    return false;
+// The default group is assigned synchronously as soon as the pid is known: this way the process
+// never runs in the application manager's own group for longer than necessary, and a later
+// explicit setControlGroup() cannot be overwritten by a delayed default assignment.
+void ProcessContainer::setDefaultControlGroup()
+{
+    const QString groupName = configuration().value(qSL("defaultControlGroup")).toString();
+    if (!groupName.isEmpty() && m_currentControlGroup.isEmpty())
+        setControlGroup(groupName);
 }
 
 bool ProcessContainer::isReady()
@@ -251,12 +714,19 @@ bool ProcessContainer::isReady()
     return true;
 }
 
+bool ProcessContainer::supportsBinaryConfiguration() const
+{
+#if defined(Q_OS_LINUX)
+    return true;
+#else
+    return false;
+#endif
+}
+
 AbstractContainerProcess *ProcessContainer::start(const QStringList &arguments,
                                                   const QMap<QString, QString> &runtimeEnvironment,
                                                   const QVariantMap &amConfig)
 {
-    Q_UNUSED(amConfig)
-
     if (m_process) {
         qWarning() << "Process" << m_program << "is already started and cannot be started again";
         return nullptr;
@@ -281,11 +751,52 @@ AbstractContainerProcess *ProcessContainer::start(const QStringList &arguments,
             penv.insert(it.key(), it.value());
     }
 
+    // The runtime leaves it up to us to hand over the configuration (see supportsBinaryConfiguration).
+    // We use a sealed memfd, which gets inherited by the child - falling back to YAML if need be.
+    int configFd = -1;
+    if (!runtimeEnvironment.contains(qSL("AM_CONFIG"))) {
+        configFd = BinaryConfiguration::createFileDescriptor(amConfig);
+        if (configFd >= 0) {
+            penv.insert(qSL("AM_CONFIG_FD"), QString::number(configFd));
+        } else {
+            qCWarning(LogSystem) << "Could not create a binary configuration for" << m_program
+                                 << "- falling back to YAML";
+            penv.insert(qSL("AM_CONFIG"), QString::fromUtf8(QtYaml::yamlFromVariantDocuments({ amConfig })));
+        }
+    }
+
+    const QVariantMap runtimeConfig = amConfig.value(qSL("runtimeConfiguration")).toMap();
+    const bool stopBeforeExec = configuration().value(qSL("stopBeforeExec")).toBool();
+
+    // The zygote can only be used, if the launcher supports it and if we do not need to change
+    // anything that is only possible via fork/exec.
+    if (runtimeConfig.value(qSL("zygote")).toBool() && m_debugWrapperCommand.isEmpty() && !stopBeforeExec
+            && std::all_of(m_stdioRedirections.cbegin(), m_stdioRedirections.cend(), [](int fd) { return fd < 0; })) {
+        ZygoteProcess *process = new ZygoteProcess();
+        // the pid is only known after the zygote has forked
+        connect(process, &ZygoteProcess::started, this, &ProcessContainer::setDefaultControlGroup);
+
+        qCDebug(LogSystem) << "Forking from zygote:" << m_program << "arguments:" << arguments;
+
+        if (process->start(m_program, arguments, penv, m_baseDirectory,
+                           variantToStringList(runtimeConfig.value(qSL("zygotePreload"))), configFd)) {
+            // the zygote received its own copy of the configuration fd
+            if (configFd >= 0)
+                ::close(configFd);
+            m_process = process;
+            return process;
+        }
+        delete process;
+        qCWarning(LogSystem) << "Could not fork" << m_program << "from a zygote - falling back to fork/exec";
+    }
+
     HostProcess *process = new HostProcess();
     process->setWorkingDirectory(m_baseDirectory);
     process->setProcessEnvironment(penv);
-    process->setStopBeforeExec(configuration().value(qSL("stopBeforeExec")).toBool());
+    process->setStopBeforeExec(stopBeforeExec);
     process->setStdioRedirections(m_stdioRedirections);
+    if (configFd >= 0)
+        process->setInheritedFileDescriptors({ configFd });
 
     QString command = m_program;
     QStringList args = arguments;
@@ -298,10 +809,16 @@ AbstractContainerProcess *ProcessContainer::start(const QStringList &arguments,
     }
     qCDebug(LogSystem) << "Running command:" << command << "arguments:" << args;
 
+    // the pid is only known once the process has actually started
+    connect(process, &HostProcess::started, this, &ProcessContainer::setDefaultControlGroup);
+
     process->start(command, args);
     m_process = process;
 
-    setControlGroup(configuration().value(qSL("defaultControlGroup")).toString());
+    // the child has its own copy of the fd by now
+    if (configFd >= 0)
+        ::close(configFd);
+
     return process;
 }
 
@@ -89,12 +89,51 @@ public slots:
 
     void start(const QString &program, const QStringList &arguments);
     void setStopBeforeExec(bool stopBeforeExec);
+    void setInheritedFileDescriptors(const QVector<int> &fds);
 
 private:
     HostQProcess *m_process;
     qint64 m_pid = 0;
 };
 
+class ZygoteConnection;
+
+// A process that is forked by a pre-initialized launcher process (the zygote), instead of being
+// started via fork/exec by the application manager itself.
+class ZygoteProcess : public AbstractContainerProcess
+{
+    Q_OBJECT
+
+public:
+    ZygoteProcess();
+    ~ZygoteProcess() override;
+
+    qint64 processId() const override;
+    Am::RunState state() const override;
+
+    bool start(const QString &program, const QStringList &arguments, const QProcessEnvironment &environment,
+               const QString &workingDirectory, const QStringList &preloadLibraries, int configFd = -1);
+
+public slots:
+    void kill() override;
+    void terminate() override;
+
+private:
+    void setState(Am::RunState state);
+    void sendSignal(int signal);
+
+    void forked(qint64 pid);
+    void forkFailed();
+    void exited(int exitCode, bool crashed);
+
+    qint64 m_pid = 0;
+    Am::RunState m_state = Am::NotRunning;
+    int m_pendingSignal = 0;
+    ZygoteConnection *m_zygote = nullptr;
+
+    friend class ZygoteConnection;
+};
+
 class ProcessContainer : public AbstractContainer
 {
     Q_OBJECT
@@ -111,11 +150,17 @@ public:
 
     bool isReady() override;
 
+    bool supportsBinaryConfiguration() const override;
+
     AbstractContainerProcess *start(const QStringList &arguments,
                                     const QMap<QString, QString> &runtimeEnvironment,
                                     const QVariantMap &amConfig) override;
 
 private:
+    bool controlGroupFiles(const QString &groupName, QStringList *files, QString *memoryUserClass) const;
+    void controlGroupChanged(const QString &groupName, const QString &memoryUserClass);
+    void setDefaultControlGroup();
+
     QString m_currentControlGroup;
     QVector<int> m_stdioRedirections;
     QMap<QString, QString> m_debugWrapperEnvironment;
@@ -48,6 +48,7 @@
 
 #include "abstractruntime.h"
 #include "applicationmanager.h"
+#include "processsampler.h"
 #include "logging.h"
 
 #include <limits>
@@ -123,27 +124,26 @@
         \li The amount of memory used by the heap, in bytes. The heap is private, dynamically
             allocated memory, for example through \c malloc or \c mmap on Linux.
     \endtable
+
+    The \c text and \c heap keys are only available if \l memoryDetailsEnabled is \c true.
 */
 
 QT_USE_NAMESPACE_AM
 
-QThread *ProcessStatus::m_workerThread = nullptr;
-
 ProcessStatus::ProcessStatus(QObject *parent)
     : QObject(parent)
 {
-    if (!m_workerThread) {
-        m_workerThread = new QThread;
-        m_workerThread->start();
-    }
-
-    m_reader.reset(new ProcessReader);
-    connect(m_reader.data(), &ProcessReader::updated, this, [this]() {
-        emit cpuLoadChanged();
-        fetchMemoryReadings();
-        m_pendingUpdate = false;
+    // All ProcessStatus objects share a single sampler: multiple objects monitoring the same
+    // process also share the same reader and all updates requested within the same event loop
+    // iteration are sampled in one batch.
+    connect(ProcessSampler::instance(), &ProcessSampler::updated,
+            this, [this](const QSet<qint64> &pids) {
+        if (m_pendingUpdate && m_reader && pids.contains(m_pid)) {
+            m_pendingUpdate = false;
+            emit cpuLoadChanged();
+            fetchMemoryReadings();
+        }
     });
-    connect(this, &ProcessStatus::processIdChanged, m_reader.data(), &ProcessReader::setProcessId);
 }
 
 /*!
@@ -153,9 +153,14 @@ ProcessStatus::ProcessStatus(QObject *parent)
 */
 void ProcessStatus::update()
 {
-    if (!m_pendingUpdate) {
+    if (!m_reader) {
+        // there is no process to sample
+        emit cpuLoadChanged();
+        fetchMemoryReadings();
+    } else if (!m_pendingUpdate) {
         m_pendingUpdate = true;
-        QMetaObject::invokeMethod(m_reader.data(), &ProcessReader::update);
+        ProcessSampler::instance()->requestUpdate(m_pid, m_memoryDetailsEnabled ? ProcessReader::FullMemoryReport
+                                                                                : ProcessReader::TotalMemoryOnly);
     }
 }
 
@@ -219,6 +224,8 @@ void ProcessStatus::determinePid()
 
     if (newId != m_pid) {
         m_pid = newId;
+        m_reader = m_pid ? ProcessSampler::instance()->reader(m_pid) : QSharedPointer<ProcessReader>();
+        m_pendingUpdate = false;
         emit processIdChanged(m_pid);
     }
 }
@@ -250,22 +257,27 @@ qint64 ProcessStatus::processId() const
 */
 qreal ProcessStatus::cpuLoad()
 {
-    quint32 value = m_reader->cpuLoad.load();
+    quint32 value = m_reader ? m_reader->cpuLoad.load() : 0;
     return ((qreal)value) / ((qreal)std::numeric_limits<quint32>::max());
 }
 
 void ProcessStatus::fetchMemoryReadings()
 {
     // Although smaps claims to report kB it's actually KiB (2^10 = 1024 Bytes)
-    m_memoryVirtual[qSL("total")] = quint64(m_reader->totalVm.load()) << 10;
-    m_memoryVirtual[qSL("text")] = quint64(m_reader->textVm.load()) << 10;
-    m_memoryVirtual[qSL("heap")] = quint64(m_reader->heapVm.load()) << 10;
-    m_memoryRss[qSL("total")] = quint64(m_reader->totalRss.load()) << 10;
-    m_memoryRss[qSL("text")] = quint64(m_reader->textRss.load()) << 10;
-    m_memoryRss[qSL("heap")] = quint64(m_reader->heapRss.load()) << 10;
-    m_memoryPss[qSL("total")] = quint64(m_reader->totalPss.load()) << 10;
-    m_memoryPss[qSL("text")] = quint64(m_reader->textPss.load()) << 10;
-    m_memoryPss[qSL("heap")] = quint64(m_reader->heapPss.load()) << 10;
+    const ProcessReader *r = m_reader.data();
+    auto bytes = [r](QAtomicInteger<quint32> ProcessReader::*kib) -> quint64 {
+        return r ? (quint64((r->*kib).load()) << 10) : 0;
+    };
+
+    m_memoryVirtual[qSL("total")] = bytes(&ProcessReader::totalVm);
+    m_memoryVirtual[qSL("text")] = bytes(&ProcessReader::textVm);
+    m_memoryVirtual[qSL("heap")] = bytes(&ProcessReader::heapVm);
+    m_memoryRss[qSL("total")] = bytes(&ProcessReader::totalRss);
+    m_memoryRss[qSL("text")] = bytes(&ProcessReader::textRss);
+    m_memoryRss[qSL("heap")] = bytes(&ProcessReader::heapRss);
+    m_memoryPss[qSL("total")] = bytes(&ProcessReader::totalPss);
+    m_memoryPss[qSL("text")] = bytes(&ProcessReader::textPss);
+    m_memoryPss[qSL("heap")] = bytes(&ProcessReader::heapPss);
 
     emit memoryReportingChanged(m_memoryVirtual, m_memoryRss, m_memoryPss);
 }
@@ -324,6 +336,30 @@ QVariantMap ProcessStatus::memoryPss() const
     return m_memoryPss;
 }
 
+/*!
+    \qmlproperty bool ProcessStatus::memoryDetailsEnabled
+
+    If this property is set to \c false, only the \c total values of the memory properties are
+    updated, while \c text and \c heap are reported as \c 0. On Linux 4.14 or newer, this allows
+    for a much cheaper measurement, which is a lot faster for big processes with thousands of
+    memory mappings. If multiple ProcessStatus objects monitor the same process, the details are
+    read whenever at least one of them requests them.
+
+    The default value is \c true.
+*/
+bool ProcessStatus::memoryDetailsEnabled() const
+{
+    return m_memoryDetailsEnabled;
+}
+
+void ProcessStatus::setMemoryDetailsEnabled(bool enabled)
+{
+    if (enabled != m_memoryDetailsEnabled) {
+        m_memoryDetailsEnabled = enabled;
+        emit memoryDetailsEnabledChanged(enabled);
+    }
+}
+
 /*!
     \qmlproperty list<string> ProcessStatus::roleNames
     \readonly
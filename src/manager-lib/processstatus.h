@@ -45,6 +45,7 @@
 #include <QAtomicInteger>
 #include <QObject>
 #include <QPointer>
+#include <QSharedPointer>
 #include <QThread>
 #include <QVariant>
 
@@ -66,6 +67,8 @@ class ProcessStatus : public QObject
     Q_PROPERTY(QVariantMap memoryVirtual READ memoryVirtual NOTIFY memoryReportingChanged)
     Q_PROPERTY(QVariantMap memoryRss READ memoryRss NOTIFY memoryReportingChanged)
     Q_PROPERTY(QVariantMap memoryPss READ memoryPss NOTIFY memoryReportingChanged)
+    Q_PROPERTY(bool memoryDetailsEnabled READ memoryDetailsEnabled WRITE setMemoryDetailsEnabled
+               NOTIFY memoryDetailsEnabledChanged)
     Q_PROPERTY(QStringList roleNames READ roleNames CONSTANT)
 public:
     ProcessStatus(QObject *parent = nullptr);
@@ -84,12 +87,16 @@ public:
     QVariantMap memoryRss() const;
     QVariantMap memoryPss() const;
 
+    bool memoryDetailsEnabled() const;
+    void setMemoryDetailsEnabled(bool enabled);
+
 signals:
     void applicationIdChanged(const QString &applicationId);
     void processIdChanged(qint64 processId);
     void cpuLoadChanged();
     void memoryReportingChanged(const QVariantMap &memoryVirtual, const QVariantMap &memoryRss,
                                                                   const QVariantMap &memoryPss);
+    void memoryDetailsEnabledChanged(bool memoryDetailsEnabled);
 
 private slots:
     void onRunStateChanged(Am::RunState state);
@@ -108,8 +115,8 @@ private:
     QPointer<Application> m_application;
 
     bool m_pendingUpdate = false;
-    QScopedPointer<ProcessReader> m_reader;
-    static QThread *m_workerThread;
+    bool m_memoryDetailsEnabled = true;
+    QSharedPointer<ProcessReader> m_reader;
 };
 
 QT_END_NAMESPACE_AM
@@ -43,6 +43,7 @@
 #include <QCoreApplication>
 #include <QTimer>
 #include <QMetaObject>
+#include <QtMath>
 
 #include "logging.h"
 #include "abstractcontainer.h"
@@ -54,6 +55,16 @@
 
 QT_BEGIN_NAMESPACE_AM
 
+// time constant of the exponentially decaying launch rate of each pool entry
+static const qreal LaunchRateTimeConstant = 60000; // msec
+// a pool that was grown because of a miss shrinks again after this time without further misses
+static const qint64 BurstDecayInterval = 60000; // msec
+// surplus quick-launchers are only stopped after this time without any request
+static const qint64 TrimDelay = 30000; // msec
+static const int RetryInterval = 1000; // msec
+static const int ControlInterval = 1000; // msec
+static const qreal MemoryPressureHysteresis = 0.05;
+
 QuickLauncher *QuickLauncher::s_instance = nullptr;
 
 QuickLauncher *QuickLauncher::instance()
@@ -65,13 +76,18 @@ QuickLauncher *QuickLauncher::instance()
 
 QuickLauncher::QuickLauncher(QObject *parent)
     : QObject(parent)
-{ }
+{
+    m_rebuildTimer.setSingleShot(true);
+    connect(&m_rebuildTimer, &QTimer::timeout, this, &QuickLauncher::rebuild);
+    m_clock.start();
+}
 
 QuickLauncher::~QuickLauncher()
 {
-    if (m_idleTimerId)
-        killTimer(m_idleTimerId);
+    if (m_controlTimerId)
+        killTimer(m_controlTimerId);
     delete m_idleCpu;
+    delete m_memory;
     s_instance = nullptr;
 }
 
@@ -99,7 +115,9 @@ void QuickLauncher::initialize(int runtimesPerContainer, qreal idleLoad)
 
             QuickLaunchEntry entry;
             entry.m_containerId = containerId;
-            entry.m_maximum = runtimesPerContainer;
+            entry.m_minimum = runtimesPerContainer;
+            entry.m_maximum = qMax(runtimesPerContainer, m_maximumRuntimesPerContainer);
+            entry.m_target = runtimesPerContainer;
 
             if (rf->manager(runtimeId)->supportsQuickLaunch())
                 entry.m_runtimeId = runtimeId;
@@ -108,90 +126,221 @@ void QuickLauncher::initialize(int runtimesPerContainer, qreal idleLoad)
 
             qCDebug(LogSystem).nospace().noquote() << " * " << entry.m_containerId << " / "
                                                    << (entry.m_runtimeId.isEmpty() ? qSL("(no runtime)") : entry.m_runtimeId)
-                                                   << " [at max: " << runtimesPerContainer << "]";
+                                                   << " [at min: " << entry.m_minimum
+                                                   << ", at max: " << entry.m_maximum << "]";
         }
     }
 
     if (idleLoad > 0) {
         m_idleThreshold = idleLoad;
         m_idleCpu = new CpuReader();
-        m_idleTimerId = startTimer(1000);
     }
+    if (!m_quickLaunchPool.isEmpty())
+        m_controlTimerId = startTimer(ControlInterval);
     triggerRebuild();
 }
 
+void QuickLauncher::setMaximumRuntimesPerContainer(int maximum)
+{
+    m_maximumRuntimesPerContainer = maximum;
+    for (auto entry = m_quickLaunchPool.begin(); entry != m_quickLaunchPool.end(); ++entry)
+        entry->m_maximum = qMax(entry->m_minimum, maximum);
+}
+
+void QuickLauncher::setMemoryPressureThreshold(qreal threshold)
+{
+    m_memoryPressureThreshold = threshold;
+    if (threshold > 0 && !m_memory)
+        m_memory = new MemoryReader();
+}
+
 void QuickLauncher::timerEvent(QTimerEvent *te)
 {
-    if (te && te->timerId() == m_idleTimerId) {
-        bool nowIdle = (m_idleCpu->readLoadValue() <= m_idleThreshold);
-        if (nowIdle != m_isIdle) {
-            m_isIdle = nowIdle;
+    if (te && te->timerId() == m_controlTimerId) {
+        if (m_shuttingDown)
+            return;
+
+        if (m_memory && m_memoryPressureThreshold > 0 && m_memory->totalValue()) {
+            qreal used = qreal(m_memory->readUsedValue()) / m_memory->totalValue();
+            bool pressure = m_memoryPressure ? (used > m_memoryPressureThreshold - MemoryPressureHysteresis)
+                                             : (used >= m_memoryPressureThreshold);
+            if (pressure != m_memoryPressure) {
+                m_memoryPressure = pressure;
+                qCDebug(LogSystem) << "Quick-launch pool" << (pressure ? "backs off due to" : "recovers from")
+                                   << "memory pressure - memory usage:" << int(used * 100) << "%";
+            }
+        }
+
+        updateTargets();
 
-            if (m_isIdle)
-                rebuild();
+        if (m_idleCpu) {
+            bool nowIdle = (m_idleCpu->readLoadValue() <= m_idleThreshold);
+            if (nowIdle != m_isIdle) {
+                m_isIdle = nowIdle;
+
+                if (m_isIdle)
+                    rebuild();
+            }
         }
     }
 }
 
-void QuickLauncher::rebuild()
+qreal QuickLauncher::decayedLaunchRate(qreal launchRate, qint64 msecSinceLastRequest)
 {
-    if (m_shuttingDown)
-        return;
+    return launchRate * qExp(-qMax(qint64(0), msecSinceLastRequest) / LaunchRateTimeConstant);
+}
 
-    int todo = 0;
-    int done = 0;
+// The pool has to cover the launches we expect while a taken entry is being replaced, plus the
+// boost for recent misses.
+int QuickLauncher::targetPoolSize(int minimum, int maximum, qreal launchRate, qreal spawnTime, int burstBoost)
+{
+    const int demand = qCeil(launchRate * spawnTime / 1000);
+    return qBound(minimum, qMax(minimum, demand) + burstBoost, qMax(minimum, maximum));
+}
+
+qreal QuickLauncher::launchRate(const QuickLaunchEntry &entry) const
+{
+    if (entry.m_lastRequest < 0)
+        return 0;
+    return decayedLaunchRate(entry.m_launchRate, m_clock.elapsed() - entry.m_lastRequest);
+}
+
+void QuickLauncher::updateTargets()
+{
+    const qint64 now = m_clock.elapsed();
 
     for (auto entry = m_quickLaunchPool.begin(); entry != m_quickLaunchPool.end(); ++entry) {
-        if (entry->m_containersAndRuntimes.size() < entry->m_maximum) {
-            todo += (entry->m_maximum - entry->m_containersAndRuntimes.size());
-            if (done >= 1)
-                continue;
+        if (m_memoryPressure) {
+            entry->m_target = 0;
+        } else {
+            if (entry->m_burstBoost > 0 && (now - entry->m_lastMiss) > BurstDecayInterval) {
+                --entry->m_burstBoost;
+                entry->m_lastMiss = now;
+            }
+            entry->m_target = targetPoolSize(entry->m_minimum, entry->m_maximum, launchRate(*entry),
+                                             entry->m_averageSpawnTime, entry->m_burstBoost);
+        }
 
-            QScopedPointer<AbstractContainer> ac(ContainerFactory::instance()->create(entry->m_containerId, nullptr));
-            if (!ac) {
-                qCWarning(LogSystem) << "ERROR: Could not create quick-launch container with id"
-                                     << entry->m_containerId;
+        int surplus = entry->m_containersAndRuntimes.size() - entry->m_target;
+        if (surplus > 0) {
+            if (!m_memoryPressure && (entry->m_lastRequest >= 0) && ((now - entry->m_lastRequest) < TrimDelay))
                 continue;
-            }
 
-            QScopedPointer<AbstractRuntime> ar;
-            if (!entry->m_runtimeId.isEmpty()) {
-                ar.reset(RuntimeFactory::instance()->createQuickLauncher(ac.take(), entry->m_runtimeId));
-                if (!ar) {
-                    qCWarning(LogSystem) << "ERROR: Could not create quick-launch runtime with id"
-                                         << entry->m_runtimeId << "within container with id"
-                                         << entry->m_containerId;
-                    continue;
-                }
-                if (!ar->start()) {
-                    qCWarning(LogSystem) << "ERROR: Could not start quick-launch runtime with id"
-                                         << entry->m_runtimeId << "within container with id"
-                                         << entry->m_containerId;
-                    continue;
+            while (surplus-- > 0) {
+                auto car = entry->m_containersAndRuntimes.takeLast();
+                car.first->disconnect(this);
+                if (car.second) {
+                    car.second->disconnect(this);
+                    car.second->stop();
+                } else {
+                    car.first->deleteLater();
                 }
             }
-            AbstractContainer *container = ar ? ar.data()->container() : ac.take();
-            AbstractRuntime *runtime = ar.take();
+            qCDebug(LogSystem).noquote() << "Shrunk the quick-launch pool for" << entry->m_containerId << "/"
+                                         << (entry->m_runtimeId.isEmpty() ? qSL("(no runtime)") : entry->m_runtimeId)
+                                         << "to" << entry->m_target << "entries";
+        } else if (surplus < 0) {
+            triggerRebuild();
+        }
+    }
+}
+
+void QuickLauncher::rebuild()
+{
+    if (m_shuttingDown)
+        return;
+
+    bool failed = false;
+
+    for (auto entry = m_quickLaunchPool.begin(); entry != m_quickLaunchPool.end(); ++entry) {
+        // spawn the complete deficit right away, so that a raised target is met in a single pass
+        while (entry->m_containersAndRuntimes.size() < entry->m_target) {
+            if (!spawn(&(*entry))) {
+                failed = true;
+                break;
+            }
+        }
+    }
+    if (failed)
+        triggerRebuild(RetryInterval);
+}
 
-            connect(container, &AbstractContainer::destroyed, this, [this, container]() { removeEntry(container, nullptr); });
-            if (runtime)
-                connect(runtime, &AbstractRuntime::destroyed, this, [this, runtime]() { removeEntry(nullptr, runtime); });
+bool QuickLauncher::spawn(QuickLaunchEntry *entry)
+{
+    const qint64 spawnStart = m_clock.elapsed();
 
-            entry->m_containersAndRuntimes << qMakePair(container, runtime);
-            ++done;
+    QScopedPointer<AbstractContainer> ac(ContainerFactory::instance()->create(entry->m_containerId, nullptr));
+    if (!ac) {
+        qCWarning(LogSystem) << "ERROR: Could not create quick-launch container with id"
+                             << entry->m_containerId;
+        return false;
+    }
 
-            qCDebug(LogSystem).noquote() << "Added a new entry to the quick-launch pool:"
-                                         << entry->m_containerId << "/"
-                                         << (entry->m_runtimeId.isEmpty() ? qSL("(no runtime)") : entry->m_runtimeId);
+    QScopedPointer<AbstractRuntime> ar;
+    if (!entry->m_runtimeId.isEmpty()) {
+        ar.reset(RuntimeFactory::instance()->createQuickLauncher(ac.take(), entry->m_runtimeId));
+        if (!ar) {
+            qCWarning(LogSystem) << "ERROR: Could not create quick-launch runtime with id"
+                                 << entry->m_runtimeId << "within container with id"
+                                 << entry->m_containerId;
+            return false;
+        }
+        if (!ar->start()) {
+            qCWarning(LogSystem) << "ERROR: Could not start quick-launch runtime with id"
+                                 << entry->m_runtimeId << "within container with id"
+                                 << entry->m_containerId;
+            return false;
+        }
+    }
+    AbstractContainer *container = ar ? ar.data()->container() : ac.take();
+    AbstractRuntime *runtime = ar.take();
+
+    connect(container, &AbstractContainer::destroyed, this, [this, container]() { removeEntry(container, nullptr); });
+    if (runtime)
+        connect(runtime, &AbstractRuntime::destroyed, this, [this, runtime]() { removeEntry(nullptr, runtime); });
+
+    entry->m_containersAndRuntimes << qMakePair(container, runtime);
+    ++entry->m_spawned;
+
+    // the spawn time is the time until the new entry is actually ready to be used: this can
+    // be a lot longer than the synchronous part above, e.g. for a launcher process
+    if (runtime) {
+        connect(runtime, &AbstractRuntime::quickLauncherReady, this, [this, runtime, spawnStart]() {
+            spawnFinished(nullptr, runtime, m_clock.elapsed() - spawnStart);
+        });
+    } else if (container->isReady()) {
+        spawnFinished(container, nullptr, m_clock.elapsed() - spawnStart);
+    } else {
+        connect(container, &AbstractContainer::ready, this, [this, container, spawnStart]() {
+            spawnFinished(container, nullptr, m_clock.elapsed() - spawnStart);
+        });
+    }
+
+    qCDebug(LogSystem).noquote() << "Added a new entry to the quick-launch pool:"
+                                 << entry->m_containerId << "/"
+                                 << (entry->m_runtimeId.isEmpty() ? qSL("(no runtime)") : entry->m_runtimeId);
+    return true;
+}
+
+void QuickLauncher::spawnFinished(AbstractContainer *container, AbstractRuntime *runtime, qint64 spawnTime)
+{
+    for (auto entry = m_quickLaunchPool.begin(); entry != m_quickLaunchPool.end(); ++entry) {
+        for (const auto &car : qAsConst(entry->m_containersAndRuntimes)) {
+            if ((container && car.first == container) || (runtime && car.second == runtime)) {
+                const bool firstSample = (entry->m_maximumSpawnTime == 0);
+                entry->m_averageSpawnTime = firstSample ? spawnTime
+                                                        : (0.75 * entry->m_averageSpawnTime + 0.25 * spawnTime);
+                entry->m_maximumSpawnTime = qMax(entry->m_maximumSpawnTime, spawnTime);
+                return;
+            }
         }
     }
-    if (todo > done)
-        triggerRebuild(1000);
 }
 
 void QuickLauncher::triggerRebuild(int delay)
 {
-    QTimer::singleShot(delay, this, &QuickLauncher::rebuild);
+    if (!m_rebuildTimer.isActive() || m_rebuildTimer.remainingTime() > delay)
+        m_rebuildTimer.start(delay);
 }
 
 void QuickLauncher::removeEntry(AbstractContainer *container, AbstractRuntime *runtime)
@@ -217,11 +366,15 @@ void QuickLauncher::removeEntry(AbstractContainer *container, AbstractRuntime *r
     // without this guard, it would emit the signal multiple times)
     if (m_shuttingDown && (carRemoved > 0) && (carCount == 0))
         emit shutDownFinished();
+    // an idle quick-launcher died unexpectedly: replace it
+    else if (!m_shuttingDown && (carRemoved > 0))
+        triggerRebuild(RetryInterval);
 }
 
 QPair<AbstractContainer *, AbstractRuntime *> QuickLauncher::take(const QString &containerId, const QString &runtimeId)
 {
     QPair<AbstractContainer *, AbstractRuntime *> result(nullptr, nullptr);
+    QuickLaunchEntry *requested = nullptr; // the best matching entry: used for the statistics
 
     // 1st pass: find entry with matching container and runtime
     // 2nd pass: find entry with matching container and no runtime
@@ -230,6 +383,8 @@ QPair<AbstractContainer *, AbstractRuntime *> QuickLauncher::take(const QString
             if (entry->m_containerId == containerId) {
                 if (((pass == 1) && (entry->m_runtimeId == runtimeId))
                         || ((pass == 2) && (entry->m_runtimeId.isEmpty()))) {
+                    if (!requested)
+                        requested = &(*entry);
                     if (!entry->m_containersAndRuntimes.isEmpty()) {
                         result = entry->m_containersAndRuntimes.takeFirst();
                         result.first->disconnect(this);
@@ -245,12 +400,70 @@ QPair<AbstractContainer *, AbstractRuntime *> QuickLauncher::take(const QString
         }
     }
 
+    if (requested) {
+        const qint64 now = m_clock.elapsed();
+        requested->m_launchRate = launchRate(*requested) + 1000 / LaunchRateTimeConstant;
+        requested->m_lastRequest = now;
+
+        if (result.first) {
+            ++requested->m_hits;
+        } else {
+            // grow the pool to be prepared for the next burst (updateTargets() shrinks it again)
+            ++requested->m_misses;
+            requested->m_burstBoost = qMin(requested->m_burstBoost + 1,
+                                           requested->m_maximum - requested->m_minimum);
+            requested->m_lastMiss = now;
+        }
+        updateTargets();
+    }
+    return result;
+}
+
+int QuickLauncher::preloadImports(const QString &runtimeId, const QStringList &imports)
+{
+    int count = 0;
+    for (const auto &entry : qAsConst(m_quickLaunchPool)) {
+        // take() always hands out the first entry
+        if ((entry.m_runtimeId == runtimeId) && !entry.m_containersAndRuntimes.isEmpty()) {
+            AbstractRuntime *runtime = entry.m_containersAndRuntimes.first().second;
+            if (runtime && runtime->preloadImports(imports))
+                ++count;
+        }
+    }
+    return count;
+}
+
+/*! \internal
+    Returns a list of maps with the current state and the hit/miss/latency statistics of all
+    container/runtime combinations in the pool.
+*/
+QVariantList QuickLauncher::statistics() const
+{
+    QVariantList result;
+    for (const auto &entry : m_quickLaunchPool) {
+        result << QVariantMap {
+            { qSL("containerId"), entry.m_containerId },
+            { qSL("runtimeId"), entry.m_runtimeId },
+            { qSL("available"), entry.m_containersAndRuntimes.size() },
+            { qSL("target"), entry.m_target },
+            { qSL("minimum"), entry.m_minimum },
+            { qSL("maximum"), entry.m_maximum },
+            { qSL("hits"), entry.m_hits },
+            { qSL("misses"), entry.m_misses },
+            { qSL("launchesPerMinute"), launchRate(entry) * 60 },
+            { qSL("spawned"), entry.m_spawned },
+            { qSL("averageSpawnTime"), entry.m_averageSpawnTime },
+            { qSL("maximumSpawnTime"), entry.m_maximumSpawnTime },
+            { qSL("memoryPressure"), m_memoryPressure }
+        };
+    }
     return result;
 }
 
 void QuickLauncher::shutDown()
 {
     m_shuttingDown = true;
+    m_rebuildTimer.stop();
     bool waitForRemove = false;
 
     for (auto entry = m_quickLaunchPool.begin(); entry != m_quickLaunchPool.end(); ++entry) {
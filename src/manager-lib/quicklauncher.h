@@ -45,6 +45,9 @@
 #include <QObject>
 #include <QPair>
 #include <QVector>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVariant>
 #include <QtAppManCommon/global.h>
 
 QT_BEGIN_NAMESPACE_AM
@@ -52,6 +55,7 @@ QT_BEGIN_NAMESPACE_AM
 class AbstractContainer;
 class AbstractRuntime;
 class CpuReader;
+class MemoryReader;
 
 class QuickLauncher : public QObject
 {
@@ -63,10 +67,25 @@ public:
 
     void initialize(int runtimesPerContainer, qreal idleLoad = 0);
 
+    // the pool of a container/runtime combination can temporarily grow up to this size, if the
+    // launch rate or repeated misses suggest that runtimesPerContainer is not enough
+    void setMaximumRuntimesPerContainer(int maximum);
+    // no idle quick-launchers are kept around, while the system's memory usage is above this ratio
+    void setMemoryPressureThreshold(qreal threshold);
+
     QPair<AbstractContainer *, AbstractRuntime *> take(const QString &containerId, const QString &runtimeId);
 
+    // asks the next quick-launcher that would be taken for this runtime to load these QML modules
+    int preloadImports(const QString &runtimeId, const QStringList &imports);
+
+    QVariantList statistics() const;
+
     void shutDown();
 
+    // public solely for testing purposes
+    static qreal decayedLaunchRate(qreal launchRate, qint64 msecSinceLastRequest);
+    static int targetPoolSize(int minimum, int maximum, qreal launchRate, qreal spawnTime, int burstBoost);
+
 public slots:
     void rebuild();
 
@@ -84,20 +103,43 @@ private:
 
     void triggerRebuild(int delay = 0);
     void removeEntry(AbstractContainer *container, AbstractRuntime *runtime);
-
+    void spawnFinished(AbstractContainer *container, AbstractRuntime *runtime, qint64 spawnTime);
     struct QuickLaunchEntry
     {
         QString m_containerId;
         QString m_runtimeId;
+        int m_minimum = 1; // runtimesPerContainer
         int m_maximum = 1;
+        int m_target = 1;  // adaptive: between 0 (memory pressure) and m_maximum
         QList<QPair<AbstractContainer *, AbstractRuntime *>> m_containersAndRuntimes;
+
+        // demand tracking and statistics
+        quint64 m_hits = 0;
+        quint64 m_misses = 0;
+        qreal m_launchRate = 0; // requests per second, exponentially decaying
+        qint64 m_lastRequest = -1;
+        int m_burstBoost = 0;
+        qint64 m_lastMiss = -1;
+        quint64 m_spawned = 0;
+        qreal m_averageSpawnTime = 0; // msec until a new entry is ready
+        qint64 m_maximumSpawnTime = 0; // msec
     };
 
+    bool spawn(QuickLaunchEntry *entry);
+    void updateTargets();
+    qreal launchRate(const QuickLaunchEntry &entry) const;
+
     QVector<QuickLaunchEntry> m_quickLaunchPool;
-    int m_idleTimerId = 0;
+    int m_controlTimerId = 0;
     CpuReader *m_idleCpu = nullptr;
     bool m_isIdle = false;
     qreal m_idleThreshold;
+    MemoryReader *m_memory = nullptr;
+    qreal m_memoryPressureThreshold = 0;
+    bool m_memoryPressure = false;
+    int m_maximumRuntimesPerContainer = 0;
+    QElapsedTimer m_clock;
+    QTimer m_rebuildTimer;
     bool m_shuttingDown = false;
 };
 
@@ -19,6 +19,7 @@ linux:HEADERS += \
 HEADERS += \
     systemreader.h \
     processreader.h \
+    processsampler.h \
 
 linux:SOURCES += \
     sysfsreader.cpp \
@@ -26,5 +27,6 @@ linux:SOURCES += \
 SOURCES += \
     systemreader.cpp \
     processreader.cpp \
+    processsampler.cpp \
 
 load(qt_module)
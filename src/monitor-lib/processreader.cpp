@@ -48,16 +48,12 @@
 #  include <mach/mach.h>
 #elif defined(Q_OS_LINUX)
 #  include <unistd.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <qplatformdefs.h>
+#  include <QFile>
 #endif
 
-namespace {
-    static uint parseValue(const char *pl) {
-        while (*pl && (*pl < '0' || *pl > '9'))
-            pl++;
-        return static_cast<uint>(strtoul(pl, nullptr, 10));
-    }
-}
-
 QT_USE_NAMESPACE_AM
 
 void ProcessReader::setProcessId(qint64 pid)
@@ -67,6 +63,11 @@ void ProcessReader::setProcessId(qint64 pid)
         openCpuLoad();
 }
 
+void ProcessReader::setMemoryReadMode(ProcessReader::MemoryReadMode mode)
+{
+    m_memoryReadMode.store(mode);
+}
+
 void ProcessReader::update()
 {
     // read cpu
@@ -138,195 +139,300 @@ qreal ProcessReader::readCpuLoad()
 }
 
 
+// smaps_rollup is only available since Linux 4.14. The kernel support is probed only once, since
+// failing to open the file of a specific process (e.g. because it just died) says nothing about it.
+static bool hasSmapsRollup()
+{
+    static const bool available = QFile::exists(qSL("/proc/self/smaps_rollup"));
+    return available;
+}
+
 bool ProcessReader::readMemory()
 {
-    QByteArray smapsFile = "/proc/" + QByteArray::number(m_pid) + "/smaps";
-    return readSmaps(smapsFile);
+    const QByteArray procDir = "/proc/" + QByteArray::number(m_pid);
+
+    if ((m_memoryReadMode.load() == TotalMemoryOnly) && hasSmapsRollup()) {
+        if (readSmapsRollup(procDir + "/smaps_rollup", procDir + "/statm"))
+            return true;
+    }
+    return readSmaps(procDir + "/smaps");
 }
 
-bool ProcessReader::readSmaps(const QByteArray &smapsFile)
+// Reads the complete file into buffer with as few syscalls as possible. The buffer is never
+// shrunk, so that the next read can re-use it. Files in /proc report a size of 0, so we have no
+// choice but to read until EOF.
+static bool readFileIntoBuffer(const QByteArray &fileName, QByteArray &buffer, int *length)
 {
-    quint32 _totalVm = 0;
-    quint32 _totalRss = 0;
-    quint32 _totalPss = 0;
-    quint32 _textVm = 0;
-    quint32 _textRss = 0;
-    quint32 _textPss = 0;
-    quint32 _heapVm = 0;
-    quint32 _heapRss = 0;
-    quint32 _heapPss = 0;
-
-    struct ScopedFile {
-        ~ScopedFile() { if (file) fclose(file); }
-        FILE *file = nullptr;
-    };
-
-    ScopedFile sf;
-    sf.file = fopen(smapsFile.constData(), "r");
-
-    if (sf.file == nullptr)
+    int fd = QT_OPEN(fileName.constData(), O_RDONLY);
+    if (fd < 0)
         return false;
 
-    const int lineLen = 100;  // we are not interested in full library paths
-    char line[lineLen + 5];   // padding for highly unlikely trailing perm flags below
-    char *pl;                 // pointer to chars within line
-    bool ok = true;
+    if (buffer.size() < 64 * 1024)
+        buffer.resize(64 * 1024);
 
-    if (fgets(line, lineLen, sf.file) == nullptr)
-        return false;
+    int total = 0;
+    bool ok = true;
+    while (true) {
+        if (total == buffer.size())
+            buffer.resize(buffer.size() * 2);
 
-    // sanity checks
-    pl = line;
-    for (pl = line; pl < (line + 4) && ok; ++pl)
-        ok = ((*pl >= '0' && *pl <= '9') || (*pl >= 'a' && *pl <= 'f'));
-    while (strlen(line) == lineLen - 1 && line[lineLen - 2] != '\n') {
-        if (Q_UNLIKELY(!fgets(line, lineLen, sf.file)))
+        ssize_t bytesRead = QT_READ(fd, buffer.data() + total, size_t(buffer.size() - total));
+        if (bytesRead > 0) {
+            total += int(bytesRead);
+        } else if (bytesRead == 0) {
+            break;
+        } else if (errno != EINTR) {
+            ok = false;
             break;
+        }
     }
-    if (fgets(line, lineLen, sf.file) == nullptr)
-        return false;
-    static const char strSize[] = "Size: ";
-    ok = ok && !qstrncmp(line, strSize, sizeof(strSize) - 1);
-    if (!ok)
+    QT_CLOSE(fd);
+    *length = total;
+    return ok;
+}
+
+namespace {
+
+struct MemoryValues
+{
+    quint32 totalVm = 0;
+    quint32 totalRss = 0;
+    quint32 totalPss = 0;
+    quint32 textVm = 0;
+    quint32 textRss = 0;
+    quint32 textPss = 0;
+    quint32 heapVm = 0;
+    quint32 heapRss = 0;
+    quint32 heapPss = 0;
+};
+
+// Parses the first number between pos and end. Returns false if there is none.
+static bool parseValue(const char *pos, const char *end, quint32 *value)
+{
+    while (pos < end && (*pos < '0' || *pos > '9'))
+        ++pos;
+    if (pos == end)
         return false;
 
-    // Determine block size
-    ok = false;
-    int blockLen = 0;
-    while (fgets(line, lineLen, sf.file) != nullptr && !ok) {
-        if (!(line[0] < '0' || line[0] > '9') && (line[0] < 'a' || line[0] > 'f'))
-            ok = true;
-        ++blockLen;
+    quint32 v = 0;
+    while (pos < end && *pos >= '0' && *pos <= '9')
+        v = v * 10 + quint32(*pos++ - '0');
+    *value = v;
+    return true;
+}
+
+static inline const char *findLineEnd(const char *pos, const char *end)
+{
+    const char *eol = static_cast<const char *>(memchr(pos, '\n', size_t(end - pos)));
+    return eol ? eol : end;
+}
+
+static inline bool isHexDigit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+}
+
+// A single pass scanner for the contents of /proc/<pid>/smaps: every mapping starts with a
+// header line (address, permissions, offset, device, inode and path), followed by a number of
+// "Key: value" attribute lines, which all start with an upper-case letter.
+static bool scanSmaps(const char *data, const char *end, MemoryValues *mv)
+{
+    // sanity checks
+    if (end - data < 4)
+        return false;
+    for (int i = 0; i < 4; ++i) {
+        if (!isHexDigit(data[i]))
+            return false;
     }
-    if (!ok || blockLen < 12 || blockLen > 32)
+    static const char strSize[] = "Size:";
+    const char *secondLine = findLineEnd(data, end) + 1;
+    if ((end - secondLine < int(sizeof(strSize)))
+            || memcmp(secondLine, strSize, sizeof(strSize) - 1)) {
         return false;
+    }
 
-    fseek(sf.file, 0, SEEK_SET);
     bool wasPrivateOnly = false;
-    ok = false;
+    const char *pos = data;
 
-    while (true) {
-        if (Q_UNLIKELY(!(fgets(line, lineLen, sf.file) != nullptr))) {
-            ok = feof(sf.file);
-            break;
-        }
+    while (pos < end) {
+        const char *eol = findLineEnd(pos, end);
+        if (!isHexDigit(*pos))
+            return false;
 
         // Determine permission flags
-        pl = line;
-        while (*pl && *pl != ' ')
+        const char *pl = pos;
+        while (pl < eol && *pl != ' ')
             ++pl;
+        ++pl;
+        if (eol - pl < 4)
+            return false;
         char permissions[4];
-        memcpy(permissions, ++pl, sizeof(permissions));
+        memcpy(permissions, pl, sizeof(permissions));
 
         // Determine inode
         int spaceCount = 0;
-        while (*pl && spaceCount < 3) {
+        while (pl < eol && spaceCount < 3) {
             if (*pl == ' ')
                 ++spaceCount;
             ++pl;
         }
-        bool hasInode = (*pl != '0');
+        bool hasInode = (pl < eol) && (*pl != '0');
 
         // Determine library name
-        while (*pl && *pl != ' ')
+        while (pl < eol && *pl != ' ')
             ++pl;
-        while (*pl && *pl == ' ')
+        while (pl < eol && *pl == ' ')
             ++pl;
 
-        static const char strStack[] = "stack]";
-        bool isMainStack = (Q_UNLIKELY(*pl == '['
-                            && !qstrncmp(pl + 1, strStack, sizeof(strStack) - 1)));
-        // Skip rest of library path
-        while (strlen(line) == lineLen - 1 && line[lineLen - 2] != '\n') {
-            if (Q_UNLIKELY(!fgets(line, lineLen, sf.file)))
-                break;
-        }
+        static const char strStack[] = "[stack]";
+        bool isMainStack = (Q_UNLIKELY((eol - pl >= int(sizeof(strStack) - 1))
+                                       && !memcmp(pl, strStack, sizeof(strStack) - 1)));
 
-        int skipLen = blockLen;
-        uint vm = 0;
-        uint rss = 0;
-        uint pss = 0;
+        quint32 vm = 0;
+        quint32 rss = 0;
+        quint32 pss = 0;
         const int sizeTag = 0x01;
         const int rssTag  = 0x02;
         const int pssTag  = 0x04;
         const int allTags = sizeTag | rssTag | pssTag;
         int foundTags = 0;
 
-        while (foundTags < allTags && skipLen > 0) {
-            skipLen--;
-            if (Q_UNLIKELY(!fgets(line, lineLen, sf.file)))
-                break;
-            pl = line;
+        // the attribute lines of this mapping
+        for (pos = eol + 1; (pos < end) && !isHexDigit(*pos); pos = eol + 1) {
+            eol = findLineEnd(pos, end);
+            if (foundTags == allTags)
+                continue;
 
             static const char strSize[] = "ize:";
             static const char strXss[] = "ss:";
+            const int len = int(eol - pos);
 
-            switch (*pl) {
+            switch (*pos) {
             case 'S':
-                if (!qstrncmp(pl + 1, strSize, sizeof(strSize) - 1)) {
-                    foundTags |= sizeTag;
-                    vm = parseValue(pl + sizeof(strSize));
+                if ((len > int(sizeof(strSize))) && !memcmp(pos + 1, strSize, sizeof(strSize) - 1)) {
+                    if (parseValue(pos + sizeof(strSize), eol, &vm))
+                        foundTags |= sizeTag;
                 }
                 break;
             case 'R':
-                if (!qstrncmp(pl + 1, strXss, sizeof(strXss) - 1)) {
-                    foundTags |= rssTag;
-                    rss = parseValue(pl + sizeof(strXss));
+                if ((len > int(sizeof(strXss))) && !memcmp(pos + 1, strXss, sizeof(strXss) - 1)) {
+                    if (parseValue(pos + sizeof(strXss), eol, &rss))
+                        foundTags |= rssTag;
                 }
                 break;
             case 'P':
-                if (!qstrncmp(pl + 1, strXss, sizeof(strXss) - 1)) {
-                    foundTags |= pssTag;
-                    pss = parseValue(pl + sizeof(strXss));
+                if ((len > int(sizeof(strXss))) && !memcmp(pos + 1, strXss, sizeof(strXss) - 1)) {
+                    if (parseValue(pos + sizeof(strXss), eol, &pss))
+                        foundTags |= pssTag;
                 }
                 break;
             }
         }
 
         if (foundTags < allTags)
-            break;
+            return false;
 
-        _totalVm += vm;
-        _totalRss += rss;
-        _totalPss += pss;
+        mv->totalVm += vm;
+        mv->totalRss += rss;
+        mv->totalPss += pss;
 
         static const char permRXP[] = { 'r', '-', 'x', 'p' };
         static const char permRWP[] = { 'r', 'w', '-', 'p' };
         if (!memcmp(permissions, permRXP, sizeof(permissions))) {
-            _textVm += vm;
-            _textRss += rss;
-            _textPss += pss;
+            mv->textVm += vm;
+            mv->textRss += rss;
+            mv->textPss += pss;
         } else if (!memcmp(permissions, permRWP, sizeof(permissions))
                    && !isMainStack && (vm != 8192 || hasInode || !wasPrivateOnly) // try to exclude stack
                    && !hasInode) {
-            _heapVm += vm;
-            _heapRss += rss;
-            _heapPss += pss;
+            mv->heapVm += vm;
+            mv->heapRss += rss;
+            mv->heapPss += pss;
         }
 
         static const char permP[] = { '-', '-', '-', 'p' };
         wasPrivateOnly = !memcmp(permissions, permP, sizeof(permissions));
-
-        for (int skip = skipLen; skip; --skip) {
-            if (Q_UNLIKELY(!fgets(line, lineLen, sf.file)))
-                break;
-        }
     }
+    return true;
+}
 
-    if (ok) {
-        // publish the readings
-        totalVm.store(_totalVm);
-        totalRss.store(_totalRss);
-        totalPss.store(_totalPss);
-        textVm.store(_textVm);
-        textRss.store(_textRss);
-        textPss.store(_textPss);
-        heapVm.store(_heapVm);
-        heapRss.store(_heapRss);
-        heapPss.store(_heapPss);
+} // namespace
+
+bool ProcessReader::readSmaps(const QByteArray &smapsFile)
+{
+    int length = 0;
+    if (!readFileIntoBuffer(smapsFile, m_buffer, &length))
+        return false;
+
+    MemoryValues mv;
+    if (!scanSmaps(m_buffer.constData(), m_buffer.constData() + length, &mv))
+        return false;
+
+    // publish the readings
+    totalVm.store(mv.totalVm);
+    totalRss.store(mv.totalRss);
+    totalPss.store(mv.totalPss);
+    textVm.store(mv.textVm);
+    textRss.store(mv.textRss);
+    textPss.store(mv.textPss);
+    heapVm.store(mv.heapVm);
+    heapRss.store(mv.heapRss);
+    heapPss.store(mv.heapPss);
+    return true;
+}
+
+bool ProcessReader::readSmapsRollup(const QByteArray &smapsRollupFile, const QByteArray &statmFile)
+{
+    // smaps_rollup has the same format as smaps, but with a single, summed up pseudo mapping. It
+    // has no "Size:" line though, so the virtual size has to be taken from statm.
+    int length = 0;
+    if (!readFileIntoBuffer(smapsRollupFile, m_buffer, &length))
+        return false;
+
+    const char *pos = m_buffer.constData();
+    const char *end = pos + length;
+    if ((end - pos < 4) || !isHexDigit(*pos))
+        return false;
+
+    quint32 rss = 0;
+    quint32 pss = 0;
+    bool hasRss = false;
+    bool hasPss = false;
+
+    for (pos = findLineEnd(pos, end) + 1; pos < end && !(hasRss && hasPss); ) {
+        const char *eol = findLineEnd(pos, end);
+        static const char strRss[] = "Rss:";
+        static const char strPss[] = "Pss:";
+        const int len = int(eol - pos);
+
+        if ((len > int(sizeof(strRss))) && !memcmp(pos, strRss, sizeof(strRss) - 1))
+            hasRss = parseValue(pos + sizeof(strRss) - 1, eol, &rss);
+        else if ((len > int(sizeof(strPss))) && !memcmp(pos, strPss, sizeof(strPss) - 1))
+            hasPss = parseValue(pos + sizeof(strPss) - 1, eol, &pss);
+        pos = eol + 1;
     }
+    if (!hasRss || !hasPss)
+        return false;
 
-    return ok;
+    // the first field in statm is the virtual size in pages
+    if (!readFileIntoBuffer(statmFile, m_buffer, &length))
+        return false;
+    quint32 vmPages = 0;
+    if (!parseValue(m_buffer.constData(), m_buffer.constData() + length, &vmPages))
+        return false;
+    static const quint32 pageSizeKb = quint32(sysconf(_SC_PAGESIZE) / 1024);
+
+    // publish the readings
+    totalVm.store(vmPages * pageSizeKb);
+    totalRss.store(rss);
+    totalPss.store(pss);
+    textVm.store(0);
+    textRss.store(0);
+    textPss.store(0);
+    heapVm.store(0);
+    heapRss.store(0);
+    heapPss.store(0);
+    return true;
 }
 
 #elif defined(Q_OS_MACOS)
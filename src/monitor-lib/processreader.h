@@ -65,6 +65,13 @@ signals:
     void updated();
 
 public:
+    enum MemoryReadMode {
+        FullMemoryReport,  // totals plus text and heap breakdown: needs the complete smaps
+        TotalMemoryOnly    // just the totals: uses the much cheaper smaps_rollup, if available
+    };
+
+    void setMemoryReadMode(MemoryReadMode mode);
+
     QAtomicInteger<quint32> cpuLoad;
 
     QAtomicInteger<quint32> totalVm;
@@ -78,8 +85,9 @@ public:
     QAtomicInteger<quint32> heapPss;
 
 #if defined(Q_OS_LINUX)
-    // it's public solely for testing purposes
+    // these are public solely for testing purposes
     bool readSmaps(const QByteArray &smapsFile);
+    bool readSmapsRollup(const QByteArray &smapsRollupFile, const QByteArray &statmFile);
 #endif
 
 private:
@@ -89,7 +97,9 @@ private:
 
 #if defined(Q_OS_LINUX)
     QScopedPointer<SysFsReader> m_statReader;
+    QByteArray m_buffer; // reused for every read, to avoid reallocations
 #endif
+    QAtomicInteger<int> m_memoryReadMode { FullMemoryReport };
     QElapsedTimer m_elapsedTime;
     quint64 m_lastCpuUsage = 0.0;
 
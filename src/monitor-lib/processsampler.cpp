@@ -0,0 +1,151 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+
+#include "processsampler.h"
+
+QT_BEGIN_NAMESPACE_AM
+
+ProcessSampler *ProcessSampler::s_instance = nullptr;
+
+ProcessSampler *ProcessSampler::instance()
+{
+    if (!s_instance)
+        s_instance = new ProcessSampler(QCoreApplication::instance());
+    return s_instance;
+}
+
+ProcessSampler::ProcessSampler(QObject *parent)
+    : QObject(parent)
+    , m_workerThread(new QThread)
+    , m_worker(new QObject)
+{
+    m_worker->moveToThread(m_workerThread);
+    m_workerThread->setObjectName(qSL("QtAM-ProcessSampler"));
+    m_workerThread->start(QThread::LowPriority);
+}
+
+ProcessSampler::~ProcessSampler()
+{
+    m_workerThread->quit();
+    m_workerThread->wait();
+    delete m_worker;
+    delete m_workerThread;
+    s_instance = nullptr;
+}
+
+QSharedPointer<ProcessReader> ProcessSampler::reader(qint64 pid)
+{
+    QSharedPointer<ProcessReader> r = m_readers.value(pid).toStrongRef();
+    if (!r) {
+        // the last reference might be dropped in the worker thread
+        r = QSharedPointer<ProcessReader>(new ProcessReader, &QObject::deleteLater);
+        r->setProcessId(pid);
+        m_readers.insert(pid, r);
+    }
+    return r;
+}
+
+void ProcessSampler::requestUpdate(qint64 pid, ProcessReader::MemoryReadMode mode)
+{
+    auto it = m_pending.find(pid);
+    if (it == m_pending.end())
+        m_pending.insert(pid, mode);
+    else if (mode == ProcessReader::FullMemoryReport)
+        *it = mode;
+
+    // collect all the requests of this event loop iteration, but do not queue up batches
+    // in case the worker thread cannot keep up
+    if (!m_batchScheduled && !m_batchRunning) {
+        m_batchScheduled = true;
+        QTimer::singleShot(0, this, &ProcessSampler::startBatch);
+    }
+}
+
+void ProcessSampler::startBatch()
+{
+    m_batchScheduled = false;
+
+    QVector<QSharedPointer<ProcessReader>> batch;
+    batch.reserve(m_pending.size());
+    QSet<qint64> pids;
+
+    for (auto pending = m_pending.cbegin(); pending != m_pending.cend(); ++pending) {
+        const qint64 pid = pending.key();
+        auto it = m_readers.find(pid);
+        if (it == m_readers.end())
+            continue;
+        if (QSharedPointer<ProcessReader> r = it->toStrongRef()) {
+            // no batch is running at this point, so the worker thread is not using the reader
+            r->setMemoryReadMode(pending.value());
+            batch.append(r);
+            pids.insert(pid);
+        } else {
+            m_readers.erase(it); // no observers left
+        }
+    }
+    m_pending.clear();
+
+    if (batch.isEmpty())
+        return;
+
+    m_batchRunning = true;
+    QMetaObject::invokeMethod(m_worker, [this, batch, pids]() {
+        for (const auto &r : batch)
+            r->update();
+
+        QMetaObject::invokeMethod(this, [this, pids]() {
+            m_batchRunning = false;
+            emit updated(pids);
+
+            // requests that came in while this batch was running
+            if (!m_pending.isEmpty())
+                startBatch();
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+QT_END_NAMESPACE_AM
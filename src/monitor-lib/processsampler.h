@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QWeakPointer>
+
+#include <QtAppManCommon/global.h>
+#include <QtAppManMonitor/processreader.h>
+
+QT_FORWARD_DECLARE_CLASS(QThread)
+
+QT_BEGIN_NAMESPACE_AM
+
+// Samples the CPU and memory usage of processes on behalf of any number of observers (e.g.
+// ProcessStatus objects): there is only one ProcessReader per pid, no matter how many observers
+// are interested in it, and all update requests that arrive within one event loop iteration are
+// handled as a single batch in a background thread. The readers publish their values via atomic
+// variables, so observers can read them without any locking.
+class ProcessSampler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ProcessSampler *instance();
+    ~ProcessSampler() override;
+
+    // the reader is shared between all observers of the same pid
+    QSharedPointer<ProcessReader> reader(qint64 pid);
+    // if multiple observers request an update within the same batch, the full report wins
+    void requestUpdate(qint64 pid, ProcessReader::MemoryReadMode mode = ProcessReader::FullMemoryReport);
+
+signals:
+    // emitted in the thread the sampler lives in (the main thread), after a batch has been
+    // sampled in the background thread
+    void updated(const QSet<qint64> &pids);
+
+private:
+    ProcessSampler(QObject *parent = nullptr);
+    void startBatch();
+
+    QThread *m_workerThread;
+    QObject *m_worker;
+    QHash<qint64, QWeakPointer<ProcessReader>> m_readers;
+    QHash<qint64, ProcessReader::MemoryReadMode> m_pending;
+    bool m_batchScheduled = false;
+    bool m_batchRunning = false;
+
+    static ProcessSampler *s_instance;
+};
+
+QT_END_NAMESPACE_AM
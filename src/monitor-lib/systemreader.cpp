@@ -59,6 +59,46 @@ quint64 MemoryReader::totalValue() const
     return s_totalValue;
 }
 
+const QVector<qreal> &CpuReader::coreLoads() const
+{
+    return m_coreLoads;
+}
+
+qreal CpuReader::ioWaitLoad() const
+{
+    return m_ioWaitLoad;
+}
+
+qreal CpuReader::irqLoad() const
+{
+    return m_irqLoad;
+}
+
+qreal CpuReader::stealLoad() const
+{
+    return m_stealLoad;
+}
+
+qreal ControlGroupReader::cpuLoad() const
+{
+    return m_cpuLoad;
+}
+
+qreal ControlGroupReader::ioReadRate() const
+{
+    return m_ioReadRate;
+}
+
+qreal ControlGroupReader::ioWriteRate() const
+{
+    return m_ioWriteRate;
+}
+
+ControlGroupReader::Memory ControlGroupReader::memory() const
+{
+    return m_memory;
+}
+
 QT_END_NAMESPACE_AM
 
 
@@ -79,6 +119,7 @@ QT_END_NAMESPACE_AM
 #  endif
 
 #  include <sys/eventfd.h>
+#  include <sys/inotify.h>
 #  include <fcntl.h>
 #  include <unistd.h>
 #  include <sys/ioctl.h>
@@ -110,43 +151,112 @@ int dprintf(int fd, const char *format, ...)
 
 QScopedPointer<SysFsReader> CpuReader::s_sysFs;
 
+static int possibleCpuCount()
+{
+    static int count = qMax(1, int(::sysconf(_SC_NPROCESSORS_CONF)));
+    return count;
+}
+
 CpuReader::CpuReader()
 {
     if (!s_sysFs) {
-        s_sysFs.reset(new SysFsReader("/proc/stat", 256));
+        // big enough for all the "cpu" lines, but not the (huge) interrupt statistics after those
+        s_sysFs.reset(new SysFsReader("/proc/stat", 256 + possibleCpuCount() * 160));
         if (!s_sysFs->isOpen())
             qCWarning(LogSystem) << "WARNING: could not read CPU statistics from" << s_sysFs->fileName();
     }
+    m_coreTimes.resize(possibleCpuCount());
+    m_lastCoreTimes.resize(possibleCpuCount());
+    m_coreLoads.fill(0, possibleCpuCount());
 }
 
-qreal CpuReader::readLoadValue()
+CpuReader::Loads CpuReader::calculateLoads(const Times &last, const Times &current)
 {
-    QByteArray str = s_sysFs->readValue();
-
-    int pos = 0;
-    qint64 total = 0;
-    QVector<qint64> values;
+    // The counters are not guaranteed to be monotonic: proc(5) explicitly states that iowait can
+    // decrease. A negative delta is treated as "no time spent" instead of wrapping around.
+    auto delta = [](quint64 now, quint64 before) -> qint64 {
+        return qMax(qint64(0), qint64(now - before));
+    };
+    const qint64 user = delta(current.user, last.user);
+    const qint64 nice = delta(current.nice, last.nice);
+    const qint64 system = delta(current.system, last.system);
+    const qint64 idle = delta(current.idle, last.idle);
+    const qint64 ioWait = delta(current.iowait, last.iowait);
+    const qint64 irq = delta(current.irq, last.irq) + delta(current.softirq, last.softirq);
+    const qint64 steal = delta(current.steal, last.steal);
+    const qint64 elapsed = user + nice + system + idle + ioWait + irq + steal;
+
+    Loads loads;
+    if (elapsed > 0) {
+        loads.busy = qreal(elapsed - idle - ioWait) / elapsed;
+        loads.ioWait = qreal(ioWait) / elapsed;
+        loads.irq = qreal(irq) / elapsed;
+        loads.steal = qreal(steal) / elapsed;
+    }
+    return loads;
+}
 
-    while (pos < str.size() && values.size() < 4) {
-        if (!isdigit(str.at(pos))) {
-            ++pos;
-            continue;
+int CpuReader::parseProcStat(const QByteArray &procStat, Times *aggregate, QVector<Times> *cores)
+{
+    const char *pos = procStat.constData();
+    const char *end = pos + qstrnlen(pos, uint(procStat.size()));
+    int coreCount = -1;
+
+    while ((end - pos) > 3 && !qstrncmp(pos, "cpu", 3)) {
+        const char *eol = static_cast<const char *>(memchr(pos, '\n', size_t(end - pos)));
+        if (!eol)
+            break; // truncated line
+
+        Times *times = nullptr;
+        char *next = nullptr;
+        if (pos[3] == ' ') {
+            times = aggregate;
+            coreCount = 0;
+            next = const_cast<char *>(pos + 3);
+        } else if (coreCount >= 0) {
+            int core = int(::strtol(pos + 3, &next, 10));
+            ++coreCount;
+            if (core >= 0 && core < cores->size())
+                times = cores->data() + core;
         }
 
-        char *endPtr = nullptr;
-        qint64 val = strtoll(str.constData() + pos, &endPtr, 10); // check missing for over-/underflow
-        values << val;
-        total += val;
-        pos = int(endPtr - str.constData() + 1);
+        if (times) {
+            quint64 *fields[] = { &times->user, &times->nice, &times->system, &times->idle,
+                                  &times->iowait, &times->irq, &times->softirq, &times->steal };
+            for (quint64 *field : fields)
+                *field = (next < eol) ? ::strtoull(next, &next, 10) : 0;
+        }
+        pos = eol + 1;
     }
+    return coreCount;
+}
+
+qreal CpuReader::readLoadValue()
+{
+    Times times;
+    int coreCount = parseProcStat(s_sysFs->readValue(), &times, &m_coreTimes);
 
-    if (values.size() >= 4) {
-        qint64 idle = values.at(3);
+    if (coreCount >= 0) {
+        // the overall load has always been based on the first four fields only: keep it that way
+        const qint64 idle = qint64(times.idle);
+        const qint64 total = qint64(times.user + times.nice + times.system + times.idle);
 
         m_load = qreal(1) - (qreal(idle - m_lastIdle) / qreal(total - m_lastTotal));
 
         m_lastIdle = idle;
         m_lastTotal = total;
+
+        const Loads loads = calculateLoads(m_lastTimes, times);
+        m_ioWaitLoad = loads.ioWait;
+        m_irqLoad = loads.irq;
+        m_stealLoad = loads.steal;
+        m_lastTimes = times;
+
+        // offline cores or cores without any ticks in between report a load of 0
+        for (int i = 0; i < m_coreTimes.size(); ++i) {
+            m_coreLoads[i] = calculateLoads(m_lastCoreTimes.at(i), m_coreTimes.at(i)).busy;
+            m_lastCoreTimes[i] = m_coreTimes.at(i);
+        }
     } else {
         m_load = qreal(1);
     }
@@ -333,15 +443,28 @@ qreal GpuReader::readLoadValue()
 }
 
 // TODO: can we always expect cgroup FS to be mounted on /sys/fs/cgroup?
+static const QString cGroupsBaseDir = qSL("/sys/fs/cgroup/");
 static const QString cGroupsMemoryBaseDir = qSL("/sys/fs/cgroup/memory/");
 
+bool hasUnifiedCGroupHierarchy()
+{
+    // cgroup.controllers only exists in the root of a cgroup v2 hierarchy
+    return QFile::exists(g_systemRootDir + cGroupsBaseDir + qSL("cgroup.controllers"));
+}
+
+static QString memoryCGroupDir(bool unifiedHierarchy, const QString &groupPath)
+{
+    return (unifiedHierarchy ? cGroupsBaseDir : cGroupsMemoryBaseDir) + groupPath;
+}
+
 MemoryReader::MemoryReader() : MemoryReader(QString())
 { }
 
 MemoryReader::MemoryReader(const QString &groupPath)
     : m_groupPath(groupPath)
+    , m_unifiedHierarchy(hasUnifiedCGroupHierarchy())
 {
-    const QString path = g_systemRootDir + cGroupsMemoryBaseDir + m_groupPath + qSL("/memory.stat");
+    const QString path = g_systemRootDir + memoryCGroupDir(m_unifiedHierarchy, m_groupPath) + qSL("/memory.stat");
 
     m_sysFs.reset(new SysFsReader(path.toLocal8Bit(), 1500));
     if (!m_sysFs->isOpen()) {
@@ -365,8 +488,12 @@ MemoryReader::MemoryReader(const QString &groupPath)
 
 quint64 MemoryReader::groupLimit()
 {
-    QString path = g_systemRootDir + cGroupsMemoryBaseDir + m_groupPath + qSL("/memory.limit_in_bytes");
+    const QString path = g_systemRootDir + memoryCGroupDir(m_unifiedHierarchy, m_groupPath)
+            + (m_unifiedHierarchy ? qSL("/memory.max") : qSL("/memory.limit_in_bytes"));
     QByteArray ba = SysFsReader(path.toLocal8Bit(), 41).readValue();
+    // cgroup v2 reports "max" for an unlimited group
+    if (m_unifiedHierarchy && ba.startsWith("max"))
+        return totalValue();
     return ::strtoull(ba, nullptr, 10);
 }
 
@@ -374,10 +501,14 @@ quint64 MemoryReader::readUsedValue() const
 {
     QByteArray buffer = m_sysFs->readValue();
 
-    int i = buffer.indexOf("total_rss ");
+    // cgroup v2 has no rss accounting anymore, but anonymous memory is the equivalent
+    const char *key = m_unifiedHierarchy ? "anon " : "total_rss ";
+    int i = buffer.startsWith(key) ? 0 : buffer.indexOf(QByteArray('\n') + key);
     if (i == -1)
         return 0;
-    return ::strtoull(buffer.data() + i + sizeof("total_rss ")-1, nullptr, 10);
+    if (buffer.at(i) == '\n')
+        ++i;
+    return ::strtoull(buffer.data() + i + qstrlen(key), nullptr, 10);
 }
 
 
@@ -433,6 +564,193 @@ qreal IoReader::readLoadValue()
 }
 
 
+// SysFsReader::readValue() always returns the complete, fixed size buffer
+static QByteArray sysFsContent(const QByteArray &buffer)
+{
+    return QByteArray::fromRawData(buffer.constData(), int(qstrnlen(buffer.constData(), uint(buffer.size()))));
+}
+
+// Finds "key value" at the start of a line
+static bool readStatValue(const QByteArray &stat, const char *key, quint64 *value)
+{
+    const int keyLen = int(qstrlen(key));
+    const char *data = stat.constData();
+    int pos = 0;
+
+    while (pos < stat.size()) {
+        int eol = stat.indexOf('\n', pos);
+        if (eol < 0)
+            eol = stat.size();
+        if (((eol - pos) > keyLen) && (data[pos + keyLen] == ' ') && !qstrncmp(data + pos, key, uint(keyLen))) {
+            *value = ::strtoull(data + pos + keyLen + 1, nullptr, 10);
+            return true;
+        }
+        pos = eol + 1;
+    }
+    return false;
+}
+
+static QByteArray controllerGroupPath(const QMap<QByteArray, QByteArray> &groupPaths, const QByteArray &controller)
+{
+    // cgroup v1 controllers may be co-mounted, e.g. "cpu,cpuacct"
+    for (auto it = groupPaths.cbegin(); it != groupPaths.cend(); ++it) {
+        if (it.key().split(',').contains(controller))
+            return it.value();
+    }
+    return QByteArray();
+}
+
+ControlGroupReader::ControlGroupReader(const QMap<QByteArray, QByteArray> &groupPaths)
+    : m_unifiedHierarchy(hasUnifiedCGroupHierarchy())
+{
+    auto openStat = [](const QString &dir, const QByteArray &groupPath, const char *file) -> SysFsReader * {
+        if (groupPath.isEmpty())
+            return nullptr;
+        const QString path = g_systemRootDir + dir + QString::fromLocal8Bit(groupPath) + qL1C('/') + qL1S(file);
+        auto sysFs = new SysFsReader(path.toLocal8Bit(), 4096);
+        if (!sysFs->isOpen()) {
+            qCWarning(LogSystem) << "WARNING: could not read control group statistics from" << sysFs->fileName();
+            delete sysFs;
+            return nullptr;
+        }
+        return sysFs;
+    };
+
+    if (m_unifiedHierarchy) {
+        const QByteArray groupPath = groupPaths.value(QByteArray());
+        m_cpuFs.reset(openStat(cGroupsBaseDir, groupPath, "cpu.stat"));
+        m_ioFs.reset(openStat(cGroupsBaseDir, groupPath, "io.stat"));
+        m_memoryFs.reset(openStat(cGroupsBaseDir, groupPath, "memory.stat"));
+    } else {
+        m_cpuFs.reset(openStat(cGroupsBaseDir + qSL("cpuacct"), controllerGroupPath(groupPaths, "cpuacct"),
+                           "cpuacct.usage"));
+        m_ioFs.reset(openStat(cGroupsBaseDir + qSL("blkio"), controllerGroupPath(groupPaths, "blkio"),
+                          "blkio.throttle.io_service_bytes"));
+        m_memoryFs.reset(openStat(cGroupsMemoryBaseDir, controllerGroupPath(groupPaths, "memory"),
+                              "memory.stat"));
+    }
+}
+
+ControlGroupReader::~ControlGroupReader()
+{ }
+
+bool ControlGroupReader::isValid() const
+{
+    return m_cpuFs || m_ioFs || m_memoryFs;
+}
+
+void ControlGroupReader::update()
+{
+    quint64 cpuUsage = 0;
+    quint64 readBytes = 0;
+    quint64 writtenBytes = 0;
+    bool hasCpuUsage = m_cpuFs && parseCpuUsage(sysFsContent(m_cpuFs->readValue()), m_unifiedHierarchy, &cpuUsage);
+    bool hasIoBytes = m_ioFs && parseIoBytes(sysFsContent(m_ioFs->readValue()), m_unifiedHierarchy,
+                                             &readBytes, &writtenBytes);
+    if (m_memoryFs)
+        m_memory = parseMemory(sysFsContent(m_memoryFs->readValue()), m_unifiedHierarchy);
+
+    // the first update only establishes the base line for the rates
+    if (m_lastCheck.isValid()) {
+        const qint64 elapsedUSec = m_lastCheck.nsecsElapsed() / 1000;
+        if (elapsedUSec > 0) {
+            // the counters only go backwards, if the group was re-created in between
+            auto rate = [elapsedUSec](bool valid, quint64 value, quint64 lastValue) -> qreal {
+                return (valid && value >= lastValue) ? qreal(value - lastValue) / elapsedUSec : 0;
+            };
+            m_cpuLoad = rate(hasCpuUsage, cpuUsage, m_lastCpuUsage);
+            m_ioReadRate = rate(hasIoBytes, readBytes, m_lastReadBytes) * 1000000;
+            m_ioWriteRate = rate(hasIoBytes, writtenBytes, m_lastWrittenBytes) * 1000000;
+        }
+    }
+    m_lastCheck.start();
+    m_lastCpuUsage = cpuUsage;
+    m_lastReadBytes = readBytes;
+    m_lastWrittenBytes = writtenBytes;
+}
+
+bool ControlGroupReader::parseCpuUsage(const QByteArray &cpuStat, bool unifiedHierarchy, quint64 *usageUSec)
+{
+    if (unifiedHierarchy)
+        return readStatValue(cpuStat, "usage_usec", usageUSec);
+
+    // cpuacct.usage is a single value in nanoseconds
+    if (cpuStat.isEmpty())
+        return false;
+    *usageUSec = ::strtoull(cpuStat.constData(), nullptr, 10) / 1000;
+    return true;
+}
+
+bool ControlGroupReader::parseIoBytes(const QByteArray &ioStat, bool unifiedHierarchy, quint64 *readBytes,
+                                      quint64 *writtenBytes)
+{
+    // v2: "<major>:<minor> rbytes=<n> wbytes=<n> rios=<n> wios=<n> dbytes=<n> dios=<n>"
+    // v1: "<major>:<minor> <Read|Write|Sync|Async|Discard|Total> <n>" plus a final "Total <n>"
+    const char *data = ioStat.constData();
+    const int size = ioStat.size();
+    quint64 r = 0;
+    quint64 w = 0;
+    bool found = false;
+    int pos = 0;
+
+    while (pos < size) {
+        while (pos < size && isspace(data[pos]))
+            ++pos;
+        int tokenEnd = pos;
+        while (tokenEnd < size && !isspace(data[tokenEnd]))
+            ++tokenEnd;
+        const char *token = data + pos;
+        const int tokenLen = tokenEnd - pos;
+
+        if (unifiedHierarchy) {
+            if (tokenLen > 7 && !qstrncmp(token, "rbytes=", 7)) {
+                r += ::strtoull(token + 7, nullptr, 10);
+                found = true;
+            } else if (tokenLen > 7 && !qstrncmp(token, "wbytes=", 7)) {
+                w += ::strtoull(token + 7, nullptr, 10);
+                found = true;
+            }
+        } else if (tokenEnd < size && data[tokenEnd] == ' ') {
+            if (tokenLen == 4 && !qstrncmp(token, "Read", 4)) {
+                r += ::strtoull(token + 5, nullptr, 10);
+                found = true;
+            } else if (tokenLen == 5 && !qstrncmp(token, "Write", 5)) {
+                w += ::strtoull(token + 6, nullptr, 10);
+                found = true;
+            }
+        }
+        pos = tokenEnd;
+    }
+
+    *readBytes = r;
+    *writtenBytes = w;
+    return found;
+}
+
+ControlGroupReader::Memory ControlGroupReader::parseMemory(const QByteArray &memoryStat, bool unifiedHierarchy)
+{
+    Memory memory;
+    if (unifiedHierarchy) {
+        readStatValue(memoryStat, "anon", &memory.anon);
+        readStatValue(memoryStat, "file", &memory.file);
+        readStatValue(memoryStat, "shmem", &memory.shmem);
+        if (!readStatValue(memoryStat, "kernel", &memory.kernel)) {
+            // kernels before 5.18 do not report the sum
+            quint64 value = 0;
+            for (const char *key : { "kernel_stack", "pagetables", "percpu", "sock", "slab" }) {
+                if (readStatValue(memoryStat, key, &value))
+                    memory.kernel += value;
+            }
+        }
+    } else {
+        // v1 does not account kernel memory in memory.stat
+        readStatValue(memoryStat, "total_rss", &memory.anon);
+        readStatValue(memoryStat, "total_cache", &memory.file);
+        readStatValue(memoryStat, "total_shmem", &memory.shmem);
+    }
+    return memory;
+}
+
 MemoryThreshold::MemoryThreshold(const QList<qreal> &thresholds)
     : m_thresholds(thresholds)
 { }
@@ -445,6 +763,12 @@ MemoryThreshold::~MemoryThreshold()
         QT_CLOSE(m_controlFd);
     if (m_eventFd != -1)
         QT_CLOSE(m_eventFd);
+    if (m_inotifyFd != -1)
+        QT_CLOSE(m_inotifyFd);
+    if (m_someStallNotifier)
+        QT_CLOSE(int(m_someStallNotifier->socket()));
+    if (m_fullStallNotifier)
+        QT_CLOSE(int(m_fullStallNotifier->socket()));
 }
 
 QList<qreal> MemoryThreshold::thresholdPercentages() const
@@ -469,60 +793,152 @@ bool MemoryThreshold::setEnabled(bool enabled, const QString &groupPath, MemoryR
         return true;
 
     if (enabled && !m_initialized) {
-        quint64 limit = groupPath.isEmpty() ? reader->totalValue() : reader->groupLimit();
-        const QString cGroup = cGroupsMemoryBaseDir + groupPath;
+        bool ok;
+        if (hasUnifiedCGroupHierarchy()) {
+            ok = enableUnifiedNotifications(groupPath);
+        } else {
+            quint64 limit = groupPath.isEmpty() ? reader->totalValue() : reader->groupLimit();
+            ok = enableLegacyThresholds(groupPath, limit);
+        }
+        if (ok)
+            m_initialized = m_enabled = true;
+        return ok;
+    } else {
+        m_enabled = enabled;
+        setNotifiersEnabled(enabled);
 
-        m_eventFd = ::eventfd(0, EFD_CLOEXEC);
+        return true;
+    }
+}
+
+void MemoryThreshold::setNotifiersEnabled(bool enabled)
+{
+    for (QSocketNotifier *notifier : { m_notifier, m_inotifyNotifier, m_someStallNotifier, m_fullStallNotifier }) {
+        if (notifier)
+            notifier->setEnabled(enabled);
+    }
+}
 
-        if (m_eventFd >= 0) {
-            const QString usagePath = cGroup + qL1S("/memory.usage_in_bytes");
-            m_usageFd = QT_OPEN(usagePath.toLocal8Bit().constData(), QT_OPEN_RDONLY);
+bool MemoryThreshold::enableLegacyThresholds(const QString &groupPath, quint64 limit)
+{
+    const QString cGroup = cGroupsMemoryBaseDir + groupPath;
 
-            if (m_usageFd >= 0) {
-                const QString eventControlPath = cGroup + qSL("/cgroup.event_control");
-                m_controlFd = QT_OPEN(eventControlPath.toLocal8Bit().constData(), QT_OPEN_WRONLY);
+    m_eventFd = ::eventfd(0, EFD_CLOEXEC);
 
-                if (m_controlFd >= 0) {
-                    bool registerOk = true;
+    if (m_eventFd >= 0) {
+        const QString usagePath = cGroup + qL1S("/memory.usage_in_bytes");
+        m_usageFd = QT_OPEN(usagePath.toLocal8Bit().constData(), QT_OPEN_RDONLY);
 
-                    for (qreal percent : qAsConst(m_thresholds)) {
-                        quint64 mem = quint64(limit * percent) / 100;
-                        registerOk = registerOk && (dprintf(m_controlFd, "%d %d %llu", m_eventFd, m_usageFd, mem) > 0);
-                    }
+        if (m_usageFd >= 0) {
+            const QString eventControlPath = cGroup + qSL("/cgroup.event_control");
+            m_controlFd = QT_OPEN(eventControlPath.toLocal8Bit().constData(), QT_OPEN_WRONLY);
 
-                    if (registerOk) {
-                        m_notifier = new QSocketNotifier(m_eventFd, QSocketNotifier::Read, this);
-                        connect(m_notifier, &QSocketNotifier::activated, this, &MemoryThreshold::readEventFd);
-                        return m_initialized = m_enabled = true;
-                    } else {
-                        qWarning() << "Could not register memory limit event handlers";
-                    }
+            if (m_controlFd >= 0) {
+                bool registerOk = true;
 
-                    QT_CLOSE(m_controlFd);
-                    m_controlFd = -1;
+                for (qreal percent : qAsConst(m_thresholds)) {
+                    quint64 mem = quint64(limit * percent) / 100;
+                    registerOk = registerOk && (dprintf(m_controlFd, "%d %d %llu", m_eventFd, m_usageFd, mem) > 0);
+                }
+
+                if (registerOk) {
+                    m_notifier = new QSocketNotifier(m_eventFd, QSocketNotifier::Read, this);
+                    connect(m_notifier, &QSocketNotifier::activated, this, &MemoryThreshold::readEventFd);
+                    return true;
                 } else {
-                    qWarning() << "Cannot open" << eventControlPath;
+                    qWarning() << "Could not register memory limit event handlers";
                 }
 
-                QT_CLOSE(m_usageFd);
-                m_usageFd = -1;
+                QT_CLOSE(m_controlFd);
+                m_controlFd = -1;
             } else {
-                qWarning() << "Cannot open" << usagePath;
+                qWarning() << "Cannot open" << eventControlPath;
             }
 
-            QT_CLOSE(m_eventFd);
-            m_eventFd = -1;
+            QT_CLOSE(m_usageFd);
+            m_usageFd = -1;
         } else {
-            qWarning() << "Cannot create an eventfd";
+            qWarning() << "Cannot open" << usagePath;
         }
 
-        return false;
+        QT_CLOSE(m_eventFd);
+        m_eventFd = -1;
     } else {
-        m_enabled = enabled;
-        m_notifier->setEnabled(enabled);
+        qWarning() << "Cannot create an eventfd";
+    }
 
-        return true;
+    return false;
+}
+
+// cgroup v2 has no usage threshold notifications anymore. Instead we get notified whenever
+// the counters in memory.events change (the group hit its memory.high or memory.max limit)
+// and whenever the kernel's pressure stall information (PSI) for the group crosses the
+// triggers below. In both cases the MemoryWatcher re-evaluates the actual consumption.
+// The 2 second window allows unprivileged processes to register system-wide triggers.
+static const char *psiSomeStallTrigger = "some 150000 2000000";
+static const char *psiFullStallTrigger = "full 100000 2000000";
+// A trigger fires at most once per window, but keeps firing as long as the stall persists.
+static const int psiWindowMSec = 2000;
+
+bool MemoryThreshold::enableUnifiedNotifications(const QString &groupPath)
+{
+    const QString cGroup = g_systemRootDir + cGroupsBaseDir + groupPath;
+
+    // the root group has neither memory.events nor memory.pressure: use the system-wide PSI
+    const QByteArray pressurePath = groupPath.isEmpty() || groupPath == qL1S("/")
+            ? (g_systemRootDir + qSL("/proc/pressure/memory")).toLocal8Bit()
+            : (cGroup + qSL("/memory.pressure")).toLocal8Bit();
+
+    m_someStallNotifier = addPressureTrigger(pressurePath, psiSomeStallTrigger);
+    m_fullStallNotifier = addPressureTrigger(pressurePath, psiFullStallTrigger);
+
+    if (!groupPath.isEmpty() && groupPath != qL1S("/")) {
+        const QByteArray eventsPath = (cGroup + qSL("/memory.events")).toLocal8Bit();
+
+        m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotifyFd >= 0) {
+            if (::inotify_add_watch(m_inotifyFd, eventsPath.constData(), IN_MODIFY) >= 0) {
+                m_inotifyNotifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+                connect(m_inotifyNotifier, &QSocketNotifier::activated, this, &MemoryThreshold::readInotifyFd);
+            } else {
+                qWarning() << "Cannot watch" << eventsPath << ":" << strerror(errno);
+                QT_CLOSE(m_inotifyFd);
+                m_inotifyFd = -1;
+            }
+        } else {
+            qWarning() << "Cannot create an inotify fd";
+        }
+    }
+
+    if (!m_someStallNotifier && !m_fullStallNotifier && !m_inotifyNotifier) {
+        qWarning() << "Could not register any cgroup v2 memory event handlers for" << cGroup;
+        return false;
     }
+    return true;
+}
+
+QSocketNotifier *MemoryThreshold::addPressureTrigger(const QByteArray &pressurePath, const char *trigger)
+{
+    int fd = QT_OPEN(pressurePath.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        qWarning() << "Cannot open" << pressurePath << "(make sure that the kernel supports PSI)";
+        return nullptr;
+    }
+    // the kernel expects the terminating null character to be part of the write
+    if (QT_WRITE(fd, trigger, qstrlen(trigger) + 1) < 0) {
+        qWarning() << "Could not register PSI trigger" << trigger << "on" << pressurePath
+                   << ":" << strerror(errno);
+        QT_CLOSE(fd);
+        return nullptr;
+    }
+
+    // PSI triggers are signaled via POLLPRI, which QSocketNotifier maps to the Exception type
+    auto notifier = new QSocketNotifier(fd, QSocketNotifier::Exception, this);
+    const bool fullStall = (trigger == psiFullStallTrigger);
+    connect(notifier, &QSocketNotifier::activated, this, [this, fullStall]() {
+        emit pressureStallTriggered(fullStall);
+    });
+    return notifier;
 }
 
 void MemoryThreshold::readEventFd()
@@ -548,9 +964,33 @@ void MemoryThreshold::readEventFd()
     }
 }
 
+void MemoryThreshold::readInotifyFd()
+{
+    if (m_inotifyFd >= 0) {
+        // we only watch a single file, so the content of the events is irrelevant
+        char buffer[sizeof(struct inotify_event) * 16];
+        bool modified = false;
+        ssize_t r;
+        while ((r = QT_READ(m_inotifyFd, buffer, sizeof(buffer))) > 0)
+            modified = true;
+        if (r < 0 && errno != EWOULDBLOCK && errno != EINTR)
+            qWarning() << "Error reading from inotify fd:" << strerror(errno);
+
+        if (modified)
+            emit thresholdTriggered();
+    }
+}
+
 MemoryWatcher::MemoryWatcher(QObject *parent)
     : QObject(parent)
-{ }
+{
+    // if the kernel did not report a stall for a complete window, the stall is over
+    for (QTimer *timer : { &m_someStallTimer, &m_fullStallTimer }) {
+        timer->setSingleShot(true);
+        timer->setInterval(psiWindowMSec + psiWindowMSec / 2);
+        connect(timer, &QTimer::timeout, this, &MemoryWatcher::updateWarnings);
+    }
+}
 
 void MemoryWatcher::setThresholds(qreal warning, qreal critical)
 {
@@ -565,23 +1005,45 @@ bool MemoryWatcher::startWatching(const QString &groupPath)
         return false;
     }
 
-    hasMemoryLowWarning = false;
-    hasMemoryCriticalWarning = false;
+    isMemoryLow = isMemoryCritical = false;
+    hasMemoryLowWarning = hasMemoryCriticalWarning = false;
+    m_someStallTimer.stop();
+    m_fullStallTimer.stop();
 
     m_reader.reset(new MemoryReader(groupPath));
     m_memLimit = groupPath.isEmpty() ? m_reader->totalValue() : m_reader->groupLimit();
 
     m_threshold.reset(new MemoryThreshold({m_warning, m_critical}));
     connect(m_threshold.data(), &MemoryThreshold::thresholdTriggered, this, &MemoryWatcher::checkMemoryConsumption);
+    connect(m_threshold.data(), &MemoryThreshold::pressureStallTriggered, this, &MemoryWatcher::reportPressureStall);
     return m_threshold->setEnabled(true, groupPath, m_reader.data());
 }
 
 void MemoryWatcher::checkMemoryConsumption()
 {
     qreal percentUsed = m_reader->readUsedValue() / m_memLimit * 100.0;
-    bool nowMemoryCritical = (percentUsed >= m_critical);
-    bool nowMemoryLow = (percentUsed >= m_warning);
-    if (nowMemoryCritical  && !hasMemoryCriticalWarning)
+    isMemoryCritical = (percentUsed >= m_critical);
+    isMemoryLow = (percentUsed >= m_warning);
+    updateWarnings();
+}
+
+void MemoryWatcher::reportPressureStall(bool fullStall)
+{
+    // Tasks are already stalling on memory reclaim, so we have to warn, even if the consumption
+    // (which does not include the page cache) is still below the configured thresholds.
+    m_someStallTimer.start();
+    if (fullStall)
+        m_fullStallTimer.start();
+    updateWarnings();
+}
+
+// The warnings are only emitted, when the combined state of consumption and stalls changes.
+void MemoryWatcher::updateWarnings()
+{
+    const bool fullStall = m_fullStallTimer.isActive();
+    const bool nowMemoryCritical = isMemoryCritical || fullStall;
+    const bool nowMemoryLow = isMemoryLow || fullStall || m_someStallTimer.isActive();
+    if (nowMemoryCritical && !hasMemoryCriticalWarning)
         emit memoryCritical();
     if (nowMemoryLow && !hasMemoryLowWarning)
         emit memoryLow();
@@ -806,6 +1268,22 @@ qreal IoReader::readLoadValue()
     return qreal(1);
 }
 
+ControlGroupReader::ControlGroupReader(const QMap<QByteArray, QByteArray> &groupPaths)
+{
+    Q_UNUSED(groupPaths)
+}
+
+ControlGroupReader::~ControlGroupReader()
+{ }
+
+bool ControlGroupReader::isValid() const
+{
+    return false;
+}
+
+void ControlGroupReader::update()
+{ }
+
 MemoryThreshold::MemoryThreshold(const QList<qreal> &thresholds)
 {
     Q_UNUSED(thresholds)
@@ -849,6 +1327,14 @@ bool MemoryWatcher::startWatching(const QString &groupPath)
 void MemoryWatcher::checkMemoryConsumption()
 { }
 
+void MemoryWatcher::reportPressureStall(bool fullStall)
+{
+    Q_UNUSED(fullStall)
+}
+
+void MemoryWatcher::updateWarnings()
+{ }
+
 QT_END_NAMESPACE_AM
 
 #endif // !defined(Q_OS_LINUX)
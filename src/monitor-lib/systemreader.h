@@ -43,9 +43,12 @@
 #pragma once
 
 #include <QByteArray>
+#include <QMap>
+#include <QVector>
 #include <QPair>
 #include <QElapsedTimer>
 #include <QObject>
+#include <QTimer>
 #include <QtAppManCommon/global.h>
 
 #if defined(Q_OS_LINUX)
@@ -62,11 +65,54 @@ public:
     CpuReader();
     qreal readLoadValue();
 
+    // The following are updated by readLoadValue() and range from 0 to 1. Only available on Linux.
+    const QVector<qreal> &coreLoads() const;
+    qreal ioWaitLoad() const;
+    qreal irqLoad() const;
+    qreal stealLoad() const;
+
+#if defined(Q_OS_LINUX)
+    // the accumulated times from /proc/stat, in USER_HZ
+    struct Times {
+        quint64 user = 0;
+        quint64 nice = 0;
+        quint64 system = 0;
+        quint64 idle = 0;
+        quint64 iowait = 0;
+        quint64 irq = 0;
+        quint64 softirq = 0;
+        quint64 steal = 0;
+
+        quint64 total() const { return user + nice + system + idle + iowait + irq + softirq + steal; }
+    };
+
+    // Parses the "cpu" lines at the start of /proc/stat. Returns the number of cores, or -1 if
+    // there is no aggregate line. Cores with an index >= cores->size() are ignored.
+    static int parseProcStat(const QByteArray &procStat, Times *aggregate, QVector<Times> *cores);
+
+    // The ratios of the time spent between two samples, ranging from 0 to 1. All are 0 if no
+    // time passed in between.
+    struct Loads {
+        qreal busy = 0; // everything but idle and iowait
+        qreal ioWait = 0;
+        qreal irq = 0;
+        qreal steal = 0;
+    };
+    static Loads calculateLoads(const Times &last, const Times &current);
+#endif
+
 private:
     qint64 m_lastIdle = 0;
     qint64 m_lastTotal = 0;
     qreal m_load = 1;
+    QVector<qreal> m_coreLoads;
+    qreal m_ioWaitLoad = 0;
+    qreal m_irqLoad = 0;
+    qreal m_stealLoad = 0;
 #if defined(Q_OS_LINUX)
+    Times m_lastTimes;
+    QVector<Times> m_lastCoreTimes;
+    QVector<Times> m_coreTimes;
     static QScopedPointer<SysFsReader> s_sysFs;
 #endif
     Q_DISABLE_COPY(CpuReader)
@@ -120,6 +166,7 @@ private:
 #if defined(Q_OS_LINUX)
     QScopedPointer<SysFsReader> m_sysFs;
     const QString m_groupPath;
+    bool m_unifiedHierarchy = false;
 #elif defined(Q_OS_MACOS) || defined(Q_OS_IOS)
     static int s_pageSize;
 #endif
@@ -143,6 +190,58 @@ private:
     Q_DISABLE_COPY(IoReader)
 };
 
+// Reads the accumulated statistics of a whole control group, covering all processes within that
+// group (e.g. an application and all its helper processes) with just a few small reads.
+class ControlGroupReader
+{
+public:
+    struct Memory {
+        quint64 anon = 0;
+        quint64 file = 0;
+        quint64 kernel = 0;
+        quint64 shmem = 0;
+    };
+
+    // groupPaths maps controller names to group paths, as returned by fetchCGroupProcessInfo().
+    // With cgroup v2 the only key is the empty string.
+    explicit ControlGroupReader(const QMap<QByteArray, QByteArray> &groupPaths);
+    ~ControlGroupReader();
+
+    bool isValid() const;
+    void update();
+
+    // number of cores used during the last measurement interval
+    qreal cpuLoad() const;
+    // bytes per second during the last measurement interval
+    qreal ioReadRate() const;
+    qreal ioWriteRate() const;
+    Memory memory() const;
+
+#if defined(Q_OS_LINUX)
+    static bool parseCpuUsage(const QByteArray &cpuStat, bool unifiedHierarchy, quint64 *usageUSec);
+    static bool parseIoBytes(const QByteArray &ioStat, bool unifiedHierarchy, quint64 *readBytes,
+                             quint64 *writtenBytes);
+    static Memory parseMemory(const QByteArray &memoryStat, bool unifiedHierarchy);
+#endif
+
+private:
+#if defined(Q_OS_LINUX)
+    bool m_unifiedHierarchy = false;
+    QScopedPointer<SysFsReader> m_cpuFs;
+    QScopedPointer<SysFsReader> m_ioFs;
+    QScopedPointer<SysFsReader> m_memoryFs;
+    QElapsedTimer m_lastCheck;
+    quint64 m_lastCpuUsage = 0;
+    quint64 m_lastReadBytes = 0;
+    quint64 m_lastWrittenBytes = 0;
+#endif
+    qreal m_cpuLoad = 0;
+    qreal m_ioReadRate = 0;
+    qreal m_ioWriteRate = 0;
+    Memory m_memory;
+    Q_DISABLE_COPY(ControlGroupReader)
+};
+
 class MemoryThreshold : public QObject
 {
     Q_OBJECT
@@ -160,6 +259,7 @@ public:
 
 signals:
     void thresholdTriggered();
+    void pressureStallTriggered(bool fullStall);
 
 private:
     bool m_initialized = false;
@@ -169,12 +269,25 @@ private:
 #if defined(Q_OS_LINUX)
 private slots:
     void readEventFd();
+    void readInotifyFd();
 
 private:
+    bool enableLegacyThresholds(const QString &groupPath, quint64 limit);
+    bool enableUnifiedNotifications(const QString &groupPath);
+    QSocketNotifier *addPressureTrigger(const QByteArray &pressurePath, const char *trigger);
+    void setNotifiersEnabled(bool enabled);
+
+    // cgroup v1
     int m_eventFd = -1;
     int m_controlFd = -1;
     int m_usageFd = -1;
     QSocketNotifier *m_notifier = nullptr;
+
+    // cgroup v2 and PSI
+    int m_inotifyFd = -1;
+    QSocketNotifier *m_inotifyNotifier = nullptr;
+    QSocketNotifier *m_someStallNotifier = nullptr;
+    QSocketNotifier *m_fullStallNotifier = nullptr;
 #endif
 };
 
@@ -187,17 +300,25 @@ public:
     void setThresholds(qreal warning, qreal critical);
     bool startWatching(const QString &groupPath = QString());
     void checkMemoryConsumption();
+    void reportPressureStall(bool fullStall);
 
 signals:
     void memoryLow();
     void memoryCritical();
 
 private:
+    void updateWarnings();
+
     qreal m_warning = 75.0;
     qreal m_critical = 90.0;
     qreal m_memLimit;
+    bool isMemoryLow = false;
+    bool isMemoryCritical = false;
     bool hasMemoryLowWarning = false;
     bool hasMemoryCriticalWarning = false;
+    // active as long as the kernel keeps reporting pressure stalls
+    QTimer m_someStallTimer;
+    QTimer m_fullStallTimer;
     QScopedPointer<MemoryThreshold> m_threshold;
     QScopedPointer<MemoryReader> m_reader;
 };
@@ -207,6 +328,9 @@ private:
 // eg: map["memory"] == "/user.slice"
 QMap<QByteArray, QByteArray> fetchCGroupProcessInfo(qint64 pid);
 
+// Returns true, if the cgroup v2 (unified) hierarchy is mounted on /sys/fs/cgroup
+bool hasUnifiedCGroupHierarchy();
+
 // Where the filesystem root directory is located. This exists solely to enable testing.
 // In production it's naturally "/"
 extern QString g_systemRootDir;
@@ -44,6 +44,8 @@
 
 #include <QThread>
 
+#include <algorithm>
+
 /*!
     \qmltype CpuStatus
     \inqmlmodule QtApplicationManager
@@ -119,18 +121,101 @@ int CpuStatus::cpuCores() const
     return QThread::idealThreadCount();
 }
 
+/*!
+    \qmlproperty list<real> CpuStatus::coreLoads
+    \readonly
+
+    Holds the utilization of each individual CPU core at the point when update() was last called,
+    as values ranging from 0 to 1. Time spent waiting for I/O counts as idle time. Cores that are
+    offline report 0.
+
+    This is only supported on Linux; on other platforms the list is empty.
+
+    \sa maxCoreLoad
+*/
+QList<qreal> CpuStatus::coreLoads() const
+{
+    return m_coreLoads;
+}
+
+/*!
+    \qmlproperty real CpuStatus::maxCoreLoad
+    \readonly
+
+    Holds the highest value in coreLoads. A single saturated core (e.g. one busy render thread) is
+    easy to miss in cpuLoad on a machine with many cores, but shows up here.
+*/
+qreal CpuStatus::maxCoreLoad() const
+{
+    return m_maxCoreLoad;
+}
+
+/*!
+    \qmlproperty real CpuStatus::ioWaitLoad
+    \readonly
+
+    Holds the fraction of the overall CPU time that was spent idle, while waiting for outstanding
+    I/O requests, at the point when update() was last called. Only supported on Linux.
+*/
+qreal CpuStatus::ioWaitLoad() const
+{
+    return m_ioWaitLoad;
+}
+
+/*!
+    \qmlproperty real CpuStatus::irqLoad
+    \readonly
+
+    Holds the fraction of the overall CPU time that was spent servicing hardware and software
+    interrupts, at the point when update() was last called. Only supported on Linux.
+*/
+qreal CpuStatus::irqLoad() const
+{
+    return m_irqLoad;
+}
+
+/*!
+    \qmlproperty real CpuStatus::stealLoad
+    \readonly
+
+    Holds the fraction of the overall CPU time that was stolen by the hypervisor for other virtual
+    machines, at the point when update() was last called. Only supported on Linux.
+*/
+qreal CpuStatus::stealLoad() const
+{
+    return m_stealLoad;
+}
+
 /*!
     \qmlmethod CpuStatus::update
 
-    Updates the cpuLoad property.
+    Updates the cpuLoad, coreLoads, maxCoreLoad, ioWaitLoad, irqLoad and stealLoad properties.
 
     \sa CpuStatus::cpuLoad
 */
 void CpuStatus::update()
 {
     qreal newLoad = m_cpuReader->readLoadValue();
-    if (newLoad != m_cpuLoad) {
+    const QVector<qreal> &coreLoads = m_cpuReader->coreLoads();
+
+    bool changed = (newLoad != m_cpuLoad)
+            || (m_cpuReader->ioWaitLoad() != m_ioWaitLoad)
+            || (m_cpuReader->irqLoad() != m_irqLoad)
+            || (m_cpuReader->stealLoad() != m_stealLoad)
+            || (coreLoads.size() != m_coreLoads.size())
+            || !std::equal(coreLoads.cbegin(), coreLoads.cend(), m_coreLoads.cbegin());
+
+    if (changed) {
         m_cpuLoad = newLoad;
+        m_ioWaitLoad = m_cpuReader->ioWaitLoad();
+        m_irqLoad = m_cpuReader->irqLoad();
+        m_stealLoad = m_cpuReader->stealLoad();
+        m_maxCoreLoad = 0;
+        m_coreLoads.clear();
+        for (qreal coreLoad : coreLoads) {
+            m_coreLoads.append(coreLoad);
+            m_maxCoreLoad = qMax(m_maxCoreLoad, coreLoad);
+        }
         emit cpuLoadChanged();
     }
 }
@@ -145,5 +230,5 @@ void CpuStatus::update()
 */
 QStringList CpuStatus::roleNames() const
 {
-    return { qSL("cpuLoad") };
+    return { qSL("cpuLoad"), qSL("maxCoreLoad") };
 }
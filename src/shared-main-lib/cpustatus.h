@@ -46,6 +46,7 @@
 
 #include <QtAppManMonitor/systemreader.h>
 
+#include <QList>
 #include <QObject>
 #include <QScopedPointer>
 
@@ -57,6 +58,11 @@ class CpuStatus : public QObject
     Q_CLASSINFO("AM-QmlType", "QtApplicationManager/CpuStatus 2.0")
     Q_PROPERTY(qreal cpuLoad READ cpuLoad NOTIFY cpuLoadChanged)
     Q_PROPERTY(int cpuCores READ cpuCores CONSTANT)
+    Q_PROPERTY(QList<qreal> coreLoads READ coreLoads NOTIFY cpuLoadChanged)
+    Q_PROPERTY(qreal maxCoreLoad READ maxCoreLoad NOTIFY cpuLoadChanged)
+    Q_PROPERTY(qreal ioWaitLoad READ ioWaitLoad NOTIFY cpuLoadChanged)
+    Q_PROPERTY(qreal irqLoad READ irqLoad NOTIFY cpuLoadChanged)
+    Q_PROPERTY(qreal stealLoad READ stealLoad NOTIFY cpuLoadChanged)
 
     Q_PROPERTY(QStringList roleNames READ roleNames CONSTANT)
 
@@ -65,6 +71,11 @@ public:
 
     qreal cpuLoad() const;
     int cpuCores() const;
+    QList<qreal> coreLoads() const;
+    qreal maxCoreLoad() const;
+    qreal ioWaitLoad() const;
+    qreal irqLoad() const;
+    qreal stealLoad() const;
 
     QStringList roleNames() const;
 
@@ -76,6 +87,11 @@ signals:
 private:
     QScopedPointer<CpuReader> m_cpuReader;
     qreal m_cpuLoad;
+    QList<qreal> m_coreLoads;
+    qreal m_maxCoreLoad = 0;
+    qreal m_ioWaitLoad = 0;
+    qreal m_irqLoad = 0;
+    qreal m_stealLoad = 0;
 };
 
 QT_END_NAMESPACE_AM
@@ -43,6 +43,8 @@
 #include "frametimer.h"
 
 #include <QQuickWindow>
+#include <QtGui/private/qwindow_p.h>
+#include <QtMath>
 #include <qqmlinfo.h>
 
 /*!
@@ -100,6 +102,31 @@
 
 QT_BEGIN_NAMESPACE_AM
 
+int FrameTimeHistogram::bucketUpperBound(int index)
+{
+    if (index < int(SubBuckets))
+        return index;
+    const int shift = index / int(SubBuckets) - 1;
+    const int subBucket = index % int(SubBuckets);
+    return ((int(SubBuckets) + subBucket) << shift) + (1 << shift) - 1;
+}
+
+int FrameTimeHistogram::percentile(qreal percent) const
+{
+    if (!m_count)
+        return 0;
+
+    // the rank of the requested value, 1-based
+    const qint64 rank = qMax(qint64(1), qint64(qCeil(qBound(qreal(0), percent, qreal(100)) * m_count / 100)));
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank)
+            return bucketUpperBound(i);
+    }
+    return MaxValue;
+}
+
 const qreal FrameTimer::MicrosInSec = qreal(1000 * 1000);
 
 FrameTimer::FrameTimer(QObject *parent)
@@ -109,16 +136,47 @@ FrameTimer::FrameTimer(QObject *parent)
     connect(&m_updateTimer, &QTimer::timeout, this, &FrameTimer::update);
 }
 
+// The scene graph only renders on demand, so the time between two frames can include idle time,
+// in which nothing was requested to be rendered at all. This is called at the start of each frame
+// and marks the end of such an idle period, if the window did not already request this frame
+// before the previous one was swapped.
+void FrameTimer::frameRequested()
+{
+    if (!m_nextFrameRequested && m_timer.isValid())
+        m_idleTime = m_timer.nsecsElapsed() / 1000;
+    m_nextFrameRequested = true;
+}
+
 void FrameTimer::newFrame()
 {
-    int frameTime = m_timer.isValid() ? qMax(1, int(m_timer.nsecsElapsed() / 1000)) : IdealFrameTime;
+    const qint64 usecSinceLastFrame = m_timer.isValid() ? m_timer.nsecsElapsed() / 1000 : -1;
     m_timer.restart();
+    recordFrame(usecSinceLastFrame, m_idleTime);
+    m_idleTime = 0;
+    // if the next frame has already been requested, the window is still animating and everything
+    // up to the next frame counts, no matter how long it takes
+    m_nextFrameRequested = isNextFrameRequested();
+}
+
+void FrameTimer::recordFrame(qint64 usecSinceLastFrame, qint64 usecIdle)
+{
+    // Just like for the very first frame, we do not know how long a frame took, if the idle time
+    // cannot be attributed, and assume the ideal frame time.
+    int frameTime = IdealFrameTime;
+    if ((usecSinceLastFrame >= 0) && (usecIdle >= 0) && (usecIdle <= usecSinceLastFrame))
+        frameTime = int(qBound(qint64(1), usecSinceLastFrame - usecIdle, qint64(std::numeric_limits<int>::max())));
 
     m_count++;
     m_sum += frameTime;
     m_min = qMin(m_min, frameTime);
     m_max = qMax(m_max, frameTime);
     m_jitter += qAbs(MicrosInSec / IdealFrameTime - MicrosInSec / frameTime);
+
+    m_histograms[m_currentHistogram].record(frameTime);
+    // a frame that took 2.6 ideal frame times means that 2 vsyncs were missed
+    m_dropped += qMax(0, (frameTime + IdealFrameTime / 2) / IdealFrameTime - 1);
+    if (frameTime >= LongFrameTime)
+        m_long++;
 }
 
 void FrameTimer::reset()
@@ -126,6 +184,7 @@ void FrameTimer::reset()
     m_count = m_sum = m_max = 0;
     m_jitter = 0;
     m_min = std::numeric_limits<int>::max();
+    m_dropped = m_long = 0;
 }
 
 /*!
@@ -184,6 +243,98 @@ qreal FrameTimer::jitterFps() const
     return m_jitterFps;
 }
 
+/*!
+    \qmlproperty real FrameTimer::medianFrameTime
+    \readonly
+
+    The median time between two frames of the given \l window, in milliseconds, since update()
+    was last called. All frame time percentiles are calculated from a histogram with a resolution
+    of about 6%, so they are only accurate within that range.
+
+    \sa p95FrameTime p99FrameTime frameTimePercentile()
+*/
+qreal FrameTimer::medianFrameTime() const
+{
+    return m_medianFrameTime;
+}
+
+/*!
+    \qmlproperty real FrameTimer::p95FrameTime
+    \readonly
+
+    The 95th percentile of the frame times of the given \l window, in milliseconds, since update()
+    was last called: 95% of all frames were rendered within this time.
+
+    \sa medianFrameTime p99FrameTime frameTimePercentile()
+*/
+qreal FrameTimer::p95FrameTime() const
+{
+    return m_p95FrameTime;
+}
+
+/*!
+    \qmlproperty real FrameTimer::p99FrameTime
+    \readonly
+
+    The 99th percentile of the frame times of the given \l window, in milliseconds, since update()
+    was last called: 99% of all frames were rendered within this time.
+
+    \sa medianFrameTime p95FrameTime frameTimePercentile()
+*/
+qreal FrameTimer::p99FrameTime() const
+{
+    return m_p99FrameTime;
+}
+
+/*!
+    \qmlproperty int FrameTimer::droppedFrames
+    \readonly
+
+    The number of frames of the given \l window that were missed since update() was last called,
+    assuming a display refresh rate of 60Hz. A frame that took 50ms to render for example
+    counts as 2 dropped frames.
+
+    Since the window is only rendered on demand, the time in which no new frame was requested
+    at all is idle time: it neither counts as dropped nor as a long frame. Any delay after a frame
+    has been requested does count, no matter how long it is. For a WindowObject, the System UI
+    cannot see when the application requests a frame, so the complete time between two frames
+    counts.
+
+    \sa longFrames
+*/
+int FrameTimer::droppedFrames() const
+{
+    return m_droppedFrames;
+}
+
+/*!
+    \qmlproperty int FrameTimer::longFrames
+    \readonly
+
+    The number of frames of the given \l window that took 50ms or longer since update() was last
+    called. These are perceived as a stutter by the user. Idle time, in which no new frame was
+    requested, does not count (see \l droppedFrames).
+
+    \sa droppedFrames
+*/
+int FrameTimer::longFrames() const
+{
+    return m_longFrames;
+}
+
+/*!
+    \qmlmethod real FrameTimer::frameTimePercentile(real percentile)
+
+    Returns the given \a percentile (0 to 100) of the frame times, in milliseconds, of the
+    interval that ended when update() was last called.
+
+    \sa medianFrameTime p95FrameTime p99FrameTime
+*/
+qreal FrameTimer::frameTimePercentile(qreal percentile) const
+{
+    return m_histograms[1 - m_currentHistogram].percentile(percentile) / qreal(1000);
+}
+
 /*!
     \qmlproperty Object FrameTimer::window
 
@@ -223,10 +374,19 @@ bool FrameTimer::connectToQuickWindow()
     if (!quickWindow)
         return false;
 
+    connect(quickWindow, &QQuickWindow::afterAnimating, this, &FrameTimer::frameRequested, Qt::UniqueConnection);
     connect(quickWindow, &QQuickWindow::frameSwapped, this, &FrameTimer::newFrame, Qt::UniqueConnection);
     return true;
 }
 
+bool FrameTimer::isNextFrameRequested() const
+{
+    // all render loops request new frames via QWindow::requestUpdate()
+    if (QQuickWindow *quickWindow = qobject_cast<QQuickWindow*>(m_window))
+        return QWindowPrivate::get(quickWindow)->updateRequestPending;
+    return false;
+}
+
 bool FrameTimer::connectToAppManWindow()
 {
     return false;
@@ -246,13 +406,15 @@ void FrameTimer::disconnectFromAppManWindow()
 */
 QStringList FrameTimer::roleNames() const
 {
-    return { qSL("averageFps"), qSL("minimumFps"), qSL("maximumFps"), qSL("jitterFps") };
+    return { qSL("averageFps"), qSL("minimumFps"), qSL("maximumFps"), qSL("jitterFps"),
+             qSL("p95FrameTime"), qSL("p99FrameTime"), qSL("droppedFrames"), qSL("longFrames") };
 }
 
 /*!
     \qmlmethod FrameTimer::update
 
-    Updates the properties averageFps, minimumFps, maximumFps and jitterFps. Then resets internal
+    Updates the properties averageFps, minimumFps, maximumFps, jitterFps, medianFrameTime,
+    p95FrameTime, p99FrameTime, droppedFrames and longFrames. Then resets internal
     counters so that new numbers can be taken for the new time period starting from the moment
     this method is called.
 
@@ -268,6 +430,17 @@ void FrameTimer::update()
     m_maximumFps = m_min ? MicrosInSec / m_min : qreal(0);
     m_jitterFps = m_count ? m_jitter / m_count :  qreal(0);
 
+    const FrameTimeHistogram &histogram = m_histograms[m_currentHistogram];
+    m_medianFrameTime = histogram.percentile(50) / qreal(1000);
+    m_p95FrameTime = histogram.percentile(95) / qreal(1000);
+    m_p99FrameTime = histogram.percentile(99) / qreal(1000);
+    m_droppedFrames = m_dropped;
+    m_longFrames = m_long;
+
+    // keep this interval's histogram around for frameTimePercentile()
+    m_currentHistogram = 1 - m_currentHistogram;
+    m_histograms[m_currentHistogram].clear();
+
     // Start counting again for the next sampling period but keep m_timer running because
     // we still need the diff between the last rendered frame and the upcoming one.
     reset();
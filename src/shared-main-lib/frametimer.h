@@ -49,7 +49,9 @@
 #include <QPointer>
 #include <QTimer>
 #include <QtAppManCommon/global.h>
+#include <QtCore/qalgorithms.h>
 #include <limits>
+#include <string.h>
 
 #if defined(AM_MULTI_PROCESS)
 #  include <QtWaylandCompositor/QWaylandQuickSurface>
@@ -57,6 +59,51 @@
 
 QT_BEGIN_NAMESPACE_AM
 
+// A fixed size, log-linear histogram of frame times in usec (similar to an HdrHistogram): every
+// power of 2 range is split into 16 linear sub-buckets, which gives a relative error of less
+// than 6.25% over the whole range of 1us to 8s. Recording a value is just a few bit operations.
+class FrameTimeHistogram
+{
+public:
+    FrameTimeHistogram() { clear(); }
+
+    void clear()
+    {
+        memset(m_buckets, 0, sizeof(m_buckets));
+        m_count = 0;
+    }
+
+    void record(int usec)
+    {
+        ++m_buckets[bucketIndex(usec)];
+        ++m_count;
+    }
+
+    int count() const { return m_count; }
+
+    // returns the upper bound of the bucket that contains the given percentile (0..100)
+    int percentile(qreal percent) const;
+
+    static int bucketIndex(int usec)
+    {
+        const quint32 value = quint32(qBound(0, usec, MaxValue));
+        if (value < SubBuckets)
+            return int(value);
+        const int msb = 31 - int(qCountLeadingZeroBits(value));
+        return (msb - SubBucketBits + 1) * SubBuckets + int((value >> (msb - SubBucketBits)) & (SubBuckets - 1));
+    }
+    static int bucketUpperBound(int index);
+
+    static const int SubBucketBits = 4;
+    static const quint32 SubBuckets = 1 << SubBucketBits;
+    static const int MaxValue = (1 << 23) - 1;
+    static const int BucketCount = (23 - SubBucketBits + 1) * SubBuckets;
+
+private:
+    quint32 m_buckets[BucketCount];
+    int m_count;
+};
+
 class FrameTimer : public QObject
 {
     Q_OBJECT
@@ -66,6 +113,11 @@ class FrameTimer : public QObject
     Q_PROPERTY(qreal minimumFps READ minimumFps NOTIFY updated)
     Q_PROPERTY(qreal maximumFps READ maximumFps NOTIFY updated)
     Q_PROPERTY(qreal jitterFps READ jitterFps NOTIFY updated)
+    Q_PROPERTY(qreal medianFrameTime READ medianFrameTime NOTIFY updated)
+    Q_PROPERTY(qreal p95FrameTime READ p95FrameTime NOTIFY updated)
+    Q_PROPERTY(qreal p99FrameTime READ p99FrameTime NOTIFY updated)
+    Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY updated)
+    Q_PROPERTY(int longFrames READ longFrames NOTIFY updated)
 
     Q_PROPERTY(QObject* window READ window WRITE setWindow NOTIFY windowChanged)
 
@@ -85,6 +137,13 @@ public:
     qreal minimumFps() const;
     qreal maximumFps() const;
     qreal jitterFps() const;
+    qreal medianFrameTime() const;
+    qreal p95FrameTime() const;
+    qreal p99FrameTime() const;
+    int droppedFrames() const;
+    int longFrames() const;
+
+    Q_INVOKABLE qreal frameTimePercentile(qreal percentile) const;
 
     QObject *window() const;
     void setWindow(QObject *value);
@@ -95,6 +154,10 @@ public:
     int interval() const;
     void setInterval(int value);
 
+    // public solely for testing purposes: a negative usecSinceLastFrame means that there was no
+    // previous frame, while usecIdle is the part of that time, in which no frame was requested
+    void recordFrame(qint64 usecSinceLastFrame, qint64 usecIdle = 0);
+
 signals:
     void updated();
     void intervalChanged();
@@ -102,11 +165,13 @@ signals:
     void windowChanged();
 
 protected slots:
+    void frameRequested();
     void newFrame();
 
 protected:
     virtual bool connectToAppManWindow();
     virtual void disconnectFromAppManWindow();
+    virtual bool isNextFrameRequested() const;
 
     QPointer<QObject> m_window;
 
@@ -119,8 +184,15 @@ private:
     int m_min = std::numeric_limits<int>::max();
     int m_max = 0;
     qreal m_jitter = 0.0;
+    int m_dropped = 0;
+    int m_long = 0;
+    // the histogram of the current interval is filled, while the other one is kept for queries
+    FrameTimeHistogram m_histograms[2];
+    int m_currentHistogram = 0;
 
     QElapsedTimer m_timer;
+    bool m_nextFrameRequested = false;
+    qint64 m_idleTime = 0;
 
     QTimer m_updateTimer;
 
@@ -128,8 +200,14 @@ private:
     qreal m_minimumFps;
     qreal m_maximumFps;
     qreal m_jitterFps;
+    qreal m_medianFrameTime = 0;
+    qreal m_p95FrameTime = 0;
+    qreal m_p99FrameTime = 0;
+    int m_droppedFrames = 0;
+    int m_longFrames = 0;
 
     static const int IdealFrameTime = 16667; // usec - could be made configurable via an env variable
+    static const int LongFrameTime = 50000; // usec - a noticeable stutter, even for non-animated content
     static const qreal MicrosInSec;
 };
 
@@ -44,6 +44,7 @@
 #include "logging.h"
 
 #include <QMetaProperty>
+#include <QtNumeric>
 #include <qqmlinfo.h>
 
 #include <QDebug>
@@ -139,8 +140,12 @@
     Thus, in the MonitorModel above, every row will have two roles: \c foo and \c bar. If plotted, you would see
     an ever incresing foo and an oscillating bar.
 
+    Roles with numeric values are always reported as \c real numbers, even if the data source's
+    property is an \c int. Values of any other type are reported unchanged.
+
     QtApplicationManager comes with a number of components that are readily usable as data sources, namely:
     \list
+    \li ControlGroupStatus
     \li CpuStatus
     \li FrameTimer
     \li GpuStatus
@@ -163,12 +168,13 @@ MonitorModel::MonitorModel(QObject *parent)
     : QAbstractListModel(parent)
 {
     m_timer.setInterval(1000);
+    m_capacity = m_maximumCount;
     connect(&m_timer, &QTimer::timeout, this, &MonitorModel::readDataSourcesAndAddRow);
 }
 
 MonitorModel::~MonitorModel()
 {
-    qDeleteAll(m_rows);
+    qDeleteAll(m_dataSources);
 }
 
 /*!
@@ -219,6 +225,7 @@ void MonitorModel::clearDataSources()
     m_roleNameToIndex.clear();
 
     clear();
+    m_columns.clear();
 }
 
 void MonitorModel::appendDataSource(QObject *dataSourceObj)
@@ -230,6 +237,16 @@ void MonitorModel::appendDataSource(QObject *dataSourceObj)
     if (!extractRoleNamesFromJsArray(dataSource)
             && !extractRoleNamesFromStringList(dataSource))
         qmlWarning(this) << "Could not find a roleNames property containing an array or list of strings.";
+
+    // resolve everything that is needed for sampling once, instead of by name on every update
+    const QMetaObject *metaObj = dataSourceObj->metaObject();
+    int updateIndex = metaObj->indexOfMethod("update()");
+    if (updateIndex >= 0)
+        dataSource->updateMethod = metaObj->method(updateIndex);
+    for (const QByteArray &roleName : qAsConst(dataSource->roleNames)) {
+        int propertyIndex = metaObj->indexOfProperty(roleName);
+        dataSource->properties.append(propertyIndex >= 0 ? metaObj->property(propertyIndex) : QMetaProperty());
+    }
 }
 
 bool MonitorModel::extractRoleNamesFromJsArray(DataSource *dataSource)
@@ -283,6 +300,12 @@ void MonitorModel::addRoleName(QByteArray roleName, DataSource *dataSource)
 
     m_roleNamesList.append(dataSource->roleNames.last());
     m_roleNameToIndex[dataSource->roleNames.last()] = m_roleNamesList.count() - 1;
+
+    // rows that have been sampled before this role existed have no value for it
+    Column column;
+    column.validSince = m_sampleCount;
+    m_columns.append(column);
+    dataSource->columns.append(m_columns.count() - 1);
 }
 
 /*!
@@ -295,7 +318,7 @@ void MonitorModel::addRoleName(QByteArray roleName, DataSource *dataSource)
 */
 int MonitorModel::count() const
 {
-    return m_rows.count();
+    return m_count;
 }
 
 int MonitorModel::rowCount(const QModelIndex &parent) const
@@ -310,10 +333,38 @@ int MonitorModel::rowCount(const QModelIndex &parent) const
 
 QVariant MonitorModel::data(const QModelIndex &index, int role) const
 {
-    if (index.parent().isValid() || !index.isValid() || index.row() < 0 || index.row() >= m_rows.count())
+    if (index.parent().isValid() || !index.isValid() || index.row() < 0 || index.row() >= m_count
+            || role < 0 || role >= m_columns.count()) {
         return QVariant();
+    }
 
-    return m_rows.at(index.row())->dataFromRoleIndex[role];
+    return columnValue(m_columns.at(role), index.row());
+}
+
+int MonitorModel::slotOfRow(int row) const
+{
+    int slot = m_first + row;
+    return (slot >= m_capacity) ? slot - m_capacity : slot;
+}
+
+QVariant MonitorModel::columnValue(const Column &column, int row) const
+{
+    const qint64 sample = m_sampleCount - m_count + row;
+    if (sample < column.validSince)
+        return QVariant();
+
+    const int slot = slotOfRow(row);
+    switch (column.storage) {
+    case Column::Numbers: {
+        // always a double: the first sample of a "var" property might well have been an int
+        const qreal number = column.numbers.at(slot);
+        return qIsNaN(number) ? QVariant() : QVariant(number);
+    }
+    case Column::Variants:
+        return column.variants.at(slot);
+    default:
+        return QVariant();
+    }
 }
 
 QHash<int, QByteArray> MonitorModel::roleNames() const
@@ -375,50 +426,98 @@ void MonitorModel::setInterval(int value)
 
 void MonitorModel::readDataSourcesAndAddRow()
 {
-    if (m_dataSources.count() == 0)
+    if (m_dataSources.count() == 0 || m_capacity == 0)
         return;
 
-    if (m_rows.count() < m_maximumCount) {
-        // create a new row
-        DataRow *dataRow = new DataRow;
-        fillDataRow(dataRow);
-        beginInsertRows(QModelIndex(), /* first */ m_rows.count(), /* last */ m_rows.count());
-        m_rows.append(dataRow);
+    if (m_count < m_capacity) {
+        // fill the next free slot
+        fillSlot(slotOfRow(m_count));
+        beginInsertRows(QModelIndex(), /* first */ m_count, /* last */ m_count);
+        ++m_count;
+        ++m_sampleCount;
         endInsertRows();
         emit countChanged();
     } else {
-        // recycle the oldest row
+        // recycle the oldest row: advancing the start of the ring buffer moves it to the end
         beginMoveRows(QModelIndex(), /* sourceFirst */ 0, /* sourceLast */ 0,
-                QModelIndex(), /* destination */ m_rows.count());
-        m_rows.append(m_rows.takeFirst());
+                QModelIndex(), /* destination */ m_count);
+        const int slot = m_first;
+        m_first = slotOfRow(1);
+        ++m_sampleCount;
         endMoveRows();
 
         {
-            fillDataRow(m_rows.last());
-            QModelIndex modelIndex = index(m_rows.count() - 1 /* row */, 0 /* column */);
+            fillSlot(slot);
+            QModelIndex modelIndex = index(m_count - 1 /* row */, 0 /* column */);
             emit dataChanged(modelIndex, modelIndex);
         }
     }
 }
 
-void MonitorModel::fillDataRow(DataRow *dataRow)
+void MonitorModel::fillSlot(int slot)
 {
     for (int i = 0; i < m_dataSources.count(); ++i) {
-        readDataSource(m_dataSources[i], dataRow);
+        readDataSource(m_dataSources[i], slot);
     }
 }
 
-void MonitorModel::readDataSource(DataSource *dataSource, DataRow *dataRow)
+static bool isNumericType(int metaType)
+{
+    // bool is deliberately not treated as a number, so that it stays a bool in the model
+    switch (metaType) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Double:
+    case QMetaType::Float:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void MonitorModel::readDataSource(DataSource *dataSource, int slot)
 {
     // TODO: check if successful
-    QMetaObject::invokeMethod(dataSource->obj, "update", Qt::DirectConnection);
+    if (dataSource->updateMethod.isValid())
+        dataSource->updateMethod.invoke(dataSource->obj, Qt::DirectConnection);
+    else
+        QMetaObject::invokeMethod(dataSource->obj, "update", Qt::DirectConnection);
 
     for (int i = 0; i < dataSource->roleNames.count(); i++) {
-        // TODO: check index exists
-        int roleIndex = m_roleNameToIndex[dataSource->roleNames[i]];
+        const QMetaProperty &property = dataSource->properties.at(i);
+        QVariant variant = property.isValid()
+                ? property.read(dataSource->obj)
+                : QQmlProperty::read(dataSource->obj, QLatin1String(dataSource->roleNames[i]));
+        if (variant.userType() == qMetaTypeId<QJSValue>())
+            variant = variant.value<QJSValue>().toVariant();
+
+        Column &column = m_columns[dataSource->columns.at(i)];
+        if (column.storage == Column::Undecided) {
+            // an undefined value does not tell us anything about the type yet
+            if (!variant.isValid())
+                continue;
+            if (isNumericType(variant.userType())) {
+                column.storage = Column::Numbers;
+                column.numbers.fill(qQNaN(), m_capacity);
+            } else {
+                column.storage = Column::Variants;
+                column.variants.resize(m_capacity);
+            }
+        }
 
-        QVariant variant = QQmlProperty::read(dataSource->obj, QLatin1String(dataSource->roleNames[i]));
-        dataRow->dataFromRoleIndex[roleIndex] = variant;
+        if (column.storage == Column::Numbers) {
+            bool ok = false;
+            qreal number = variant.toDouble(&ok);
+            column.numbers[slot] = ok ? number : qQNaN();
+        } else {
+            column.variants[slot] = variant;
+        }
     }
 }
 
@@ -442,21 +541,51 @@ void MonitorModel::setMaximumCount(int value)
 
     m_maximumCount = value;
     trimHistory();
+    resizeColumns();
     emit maximumCountChanged();
 }
 
 void MonitorModel::trimHistory()
 {
-    int excess = m_rows.count() - m_maximumCount;
+    int excess = m_count - qMax(0, m_maximumCount);
     if (excess <= 0)
         return;
 
     beginRemoveRows(QModelIndex(), /* first */ 0, /* last */ excess - 1);
 
-    while (m_rows.count() > m_maximumCount)
-        delete m_rows.takeFirst();
+    for (Column &column : m_columns) {
+        if (column.storage == Column::Variants) {
+            for (int row = 0; row < excess; ++row)
+                column.variants[slotOfRow(row)] = QVariant();
+        }
+    }
+    m_first = slotOfRow(excess);
+    m_count -= excess;
 
     endRemoveRows();
+    emit countChanged();
+}
+
+void MonitorModel::resizeColumns()
+{
+    // re-arrange the ring buffers, so that the oldest row ends up in the first slot
+    const int capacity = qMax(0, m_maximumCount);
+
+    for (Column &column : m_columns) {
+        if (column.storage == Column::Numbers) {
+            QVector<qreal> numbers(capacity, qQNaN());
+            for (int row = 0; row < m_count; ++row)
+                numbers[row] = column.numbers.at(slotOfRow(row));
+            column.numbers.swap(numbers);
+        } else if (column.storage == Column::Variants) {
+            QVector<QVariant> variants(capacity);
+            for (int row = 0; row < m_count; ++row)
+                variants[row] = column.variants.at(slotOfRow(row));
+            column.variants.swap(variants);
+        }
+    }
+    m_capacity = capacity;
+    m_first = 0;
 }
 
 /*!
@@ -469,8 +598,12 @@ void MonitorModel::trimHistory()
 void MonitorModel::clear()
 {
     beginResetModel();
-    qDeleteAll(m_rows);
-    m_rows.clear();
+    for (Column &column : m_columns) {
+        if (column.storage == Column::Variants)
+            column.variants.fill(QVariant());
+    }
+    m_first = 0;
+    m_count = 0;
     endResetModel();
 
     emit countChanged();
@@ -496,3 +629,37 @@ QVariantMap MonitorModel::get(int row) const
 
     return map;
 }
+
+/*!
+    \qmlmethod list<real> MonitorModel::values(string roleName)
+
+    Returns all values of the numeric role \a roleName at once, ordered chronologically from the
+    oldest to the newest row. This is considerably cheaper than calling get() for every row,
+    for example when drawing a graph of the complete history. Rows without a value for this role
+    are returned as \c NaN.
+*/
+QList<qreal> MonitorModel::values(const QString &roleName) const
+{
+    QList<qreal> result;
+    auto it = m_roleNameToIndex.constFind(roleName.toLatin1());
+    if (it == m_roleNameToIndex.cend()) {
+        qCWarning(LogSystem) << "MonitorModel::values invalid role:" << roleName;
+        return result;
+    }
+
+    const Column &column = m_columns.at(*it);
+    if (column.storage == Column::Variants) {
+        qCWarning(LogSystem) << "MonitorModel::values role is not numeric:" << roleName;
+        return result;
+    }
+
+    result.reserve(m_count);
+    const qint64 firstSample = m_sampleCount - m_count;
+    for (int row = 0; row < m_count; ++row) {
+        if ((column.storage != Column::Numbers) || (firstSample + row) < column.validSince)
+            result.append(qQNaN());
+        else
+            result.append(column.numbers.at(slotOfRow(row)));
+    }
+    return result;
+}
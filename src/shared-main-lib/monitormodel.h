@@ -46,8 +46,11 @@
 #include <QtAppManCommon/global.h>
 #include <QtQml/qqmllist.h>
 #include <QList>
+#include <QMetaMethod>
+#include <QMetaProperty>
 #include <QStringList>
 #include <QTimer>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE_AM
 
@@ -93,6 +96,7 @@ public:
 
     Q_INVOKABLE void clear();
     Q_INVOKABLE QVariantMap get(int row) const;
+    Q_INVOKABLE QList<qreal> values(const QString &roleName) const;
 
 signals:
     void countChanged();
@@ -104,29 +108,46 @@ private slots:
     void readDataSourcesAndAddRow();
 
 private:
-    struct DataRow {
-        QHash<int, QVariant> dataFromRoleIndex;
+    // The history of a single role, stored in a ring buffer of maximumCount entries. Numeric
+    // values (the common case) are kept in a plain array of doubles; everything else is kept as
+    // QVariant. The storage is chosen by the first valid sample.
+    struct Column {
+        enum Storage { Undecided, Numbers, Variants };
+        Storage storage = Undecided;
+        qint64 validSince = 0; // the first sample that contains a value for this role
+        QVector<qreal> numbers;
+        QVector<QVariant> variants;
     };
 
     struct DataSource {
         QObject *obj;
         QVector<QByteArray> roleNames;
+        QVector<int> columns;
+        QVector<QMetaProperty> properties; // invalid, if only accessible via QQmlProperty
+        QMetaMethod updateMethod;
     };
 
     void clearDataSources();
     void appendDataSource(QObject *dataSource);
-    void fillDataRow(DataRow *dataRow);
-    void readDataSource(DataSource *dataSource, DataRow *dataRow);
+    void fillSlot(int slot);
+    void readDataSource(DataSource *dataSource, int slot);
     void trimHistory();
+    void resizeColumns();
     bool extractRoleNamesFromJsArray(DataSource *dataSource);
     bool extractRoleNamesFromStringList(DataSource *dataSource);
     void addRoleName(QByteArray roleName, DataSource *dataSource);
+    int slotOfRow(int row) const;
+    QVariant columnValue(const Column &column, int row) const;
 
     QList<DataSource*> m_dataSources;
     QList<QByteArray> m_roleNamesList; // also maps a role index to its name
     QHash<QByteArray, int> m_roleNameToIndex;
 
-    QList<DataRow*> m_rows;
+    QVector<Column> m_columns; // indexed by role
+    int m_capacity = 0;
+    int m_first = 0; // slot of the oldest row
+    int m_count = 0;
+    qint64 m_sampleCount = 0; // total number of samples taken, including discarded ones
 
     QTimer m_timer;
     int m_maximumCount = 10;
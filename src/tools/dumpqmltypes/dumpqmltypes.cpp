@@ -57,6 +57,7 @@
 #include <QtAppManSharedMain/memorystatus.h>
 #include <QtAppManSharedMain/iostatus.h>
 #include <QtAppManManager/processstatus.h>
+#include <QtAppManManager/controlgroupstatus.h>
 #include <QtAppManSharedMain/frametimer.h>
 #include <QtAppManSharedMain/monitormodel.h>
 #include <QtAppManCommon/global.h>
@@ -108,6 +109,7 @@ static const QVector<const QMetaObject *> all = {
     &MemoryStatus::staticMetaObject,
     &IoStatus::staticMetaObject,
     &ProcessStatus::staticMetaObject,
+    &ControlGroupStatus::staticMetaObject,
     &FrameTimer::staticMetaObject,
     &MonitorModel::staticMetaObject
 };
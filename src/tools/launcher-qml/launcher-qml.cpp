@@ -52,6 +52,7 @@
 #include <QMetaObject>
 #include <QRegularExpression>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
 
 #include <QDBusConnection>
 #include <QDBusInterface>
@@ -61,6 +62,7 @@
 #include <qplatformdefs.h>
 
 #include <QtAppManLauncher/launchermain.h>
+#include <QtAppManLauncher/zygote.h>
 
 #if !defined(AM_HEADLESS)
 #  include <QGuiApplication>
@@ -107,6 +109,9 @@ QT_USE_NAMESPACE_AM
 
 int main(int argc, char *argv[])
 {
+    // only returns in forked children, if started as a zygote
+    Zygote::runIfRequested(argc, argv);
+
     StartupTimer::instance()->checkpoint("entered main");
 
     QCoreApplication::setApplicationName(qSL("Qt Application Manager QML Launcher"));
@@ -271,10 +276,20 @@ Controller::Controller(LauncherMain *a, bool quickLaunched, const QString &direc
         }
     }
 
+    if (quickLaunched) {
+        preloadImports(variantToStringList(m_configuration.value(qSL("quicklaunchPreload"))));
+        StartupTimer::instance()->checkpoint("after quick-launch preloading");
+    }
+
     if (directLoad.isEmpty()) {
         m_applicationInterface = new QmlApplicationInterface(a->p2pDBusName(), a->notificationDBusName(), this);
         connect(m_applicationInterface, &QmlApplicationInterface::startApplication,
                 this, &Controller::startApplication);
+        if (quickLaunched) {
+            // the System UI expects this application to be started soon
+            connect(m_applicationInterface, &QmlApplicationInterface::preloadImports,
+                    this, &Controller::preloadImports);
+        }
         if (!m_applicationInterface->initialize())
             throw Exception("Could not connect to the application manager's ApplicationInterface on the peer D-Bus");
 
@@ -295,6 +310,57 @@ Controller::Controller(LauncherMain *a, bool quickLaunched, const QString &direc
     StartupTimer::instance()->checkpoint("after application interface initialization");
 }
 
+// Compiles - but does not instantiate - a component for each of the given import specifications
+// ("<module> <version> [<type> ...]"). This loads the module's qmldir, plugins and the listed
+// (QML) types, so this work does not have to be done anymore, when the application is started.
+int Controller::preloadImports(const QStringList &imports)
+{
+    static const QRegularExpression specRe(qSL("^([A-Za-z_][A-Za-z0-9_.]*) (\\d+\\.\\d+)((?: [A-Za-z_]\\w*)*)$"));
+
+    if (m_launched)
+        return 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    int count = 0;
+
+    for (const QString &import : imports) {
+        const QString spec = import.simplified();
+        if (spec.isEmpty() || m_preloadedImports.contains(spec))
+            continue;
+        m_preloadedImports.insert(spec);
+
+        auto match = specRe.match(spec);
+        if (!match.hasMatch()) {
+            qCWarning(LogQmlRuntime) << "Ignoring invalid import specification for preloading:" << import;
+            continue;
+        }
+
+        QByteArray qml = "import QtQml 2.0\nimport " + match.captured(1).toUtf8() + ' '
+                + match.captured(2).toUtf8() + " as Preload\nQtObject {\n";
+        const QStringList types = match.captured(3).split(qL1C(' '), QString::SkipEmptyParts);
+        for (int i = 0; i < types.size(); ++i) {
+            qml += "    property Component t" + QByteArray::number(i) + ": Component { Preload."
+                    + types.at(i).toUtf8() + " { } }\n";
+        }
+        qml += "}\n";
+
+        QQmlComponent component(&m_engine);
+        component.setData(qml, QUrl());
+        if (component.isError()) {
+            // the module might only be available in the application's own import paths
+            qCDebug(LogQmlRuntime) << "Could not preload" << spec << ":" << component.errors();
+        } else {
+            ++count;
+        }
+    }
+
+    if (count)
+        qCDebug(LogQmlRuntime) << "Preloaded" << count << "QML module(s) in" << timer.elapsed() << "msec";
+    m_preloadedModules += count;
+    return count;
+}
+
 void Controller::startApplication(const QString &baseDir, const QString &qmlFile, const QString &document,
                                   const QString &mimeType, const QVariantMap &application,
                                   const QVariantMap &systemProperties)
@@ -304,11 +370,15 @@ void Controller::startApplication(const QString &baseDir, const QString &qmlFile
     m_launched = true;
 
     static QString applicationId = application.value(qSL("id")).toString();
+    const QString fullApplicationId = applicationId; // applicationId gets shortened below
     LauncherMain::instance()->setApplicationId(applicationId);
 
     if (m_quickLaunched) {
         //StartupTimer::instance()->createReport(applicationId  + qSL(" [process launch]"));
         StartupTimer::instance()->reset();
+        StartupTimer::instance()->checkpoint(qSL("attached to quick-launcher (%1 modules preloaded)")
+                                             .arg(m_preloadedModules));
+        StartupTimer::instance()->timelineEvent("launcher attached", fullApplicationId);
     } else {
         StartupTimer::instance()->checkpoint("starting application");
     }
@@ -469,6 +539,7 @@ void Controller::startApplication(const QString &baseDir, const QString &qmlFile
     m_engine.load(qmlFileUrl);
 
     StartupTimer::instance()->checkpoint("after engine loading main qml file");
+    StartupTimer::instance()->timelineEvent("main qml file loaded", fullApplicationId);
 
     auto topLevels = m_engine.rootObjects();
 
@@ -511,13 +582,14 @@ void Controller::startApplication(const QString &baseDir, const QString &qmlFile
 
         // create the startup report on first frame drawn
         static QMetaObject::Connection conn = QObject::connect(m_window, &QQuickWindow::frameSwapped,
-                                                               this, [this, startupPlugins]() {
+                                                               this, [this, startupPlugins, fullApplicationId]() {
             // this is a queued signal, so there may be still one in the queue after calling disconnect()
             if (conn) {
                 QObject::disconnect(conn);
 
                 auto st = StartupTimer::instance();
                 st->checkFirstFrame();
+                st->timelineEvent("first frame drawn", fullApplicationId);
                 st->createAutomaticReport(applicationId);
 
                 for (StartupInterface *iface : qAsConst(startupPlugins))
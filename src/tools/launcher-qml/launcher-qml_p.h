@@ -44,6 +44,7 @@
 
 #include <QObject>
 #include <QVariantMap>
+#include <QSet>
 #include <QVector>
 #include <QPointer>
 #include <QQmlIncubationController>
@@ -81,12 +82,16 @@ public slots:
                           const QString &mimeType, const QVariantMap &application,
                           const QVariantMap &systemProperties);
 
+    int preloadImports(const QStringList &imports);
+
 private:
     QQmlApplicationEngine m_engine;
     QmlApplicationInterface *m_applicationInterface = nullptr;
     QVariantMap m_configuration;
     bool m_launched = false;
     bool m_quickLaunched;
+    QSet<QString> m_preloadedImports;
+    int m_preloadedModules = 0;
 #if !defined(AM_HEADLESS)
     QQuickWindow *m_window = nullptr;
     QVector<QPointer<QQuickWindow>> m_allWindows;
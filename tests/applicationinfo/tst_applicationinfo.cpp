@@ -35,6 +35,7 @@
 #include "applicationinfo.h"
 #include "packageinfo.h"
 #include "yamlpackagescanner.h"
+#include "packagedatabase.h"
 #include "exception.h"
 
 QT_USE_NAMESPACE_AM
@@ -55,6 +56,7 @@ private slots:
     void validApplicationId();
     void validIcon_data();
     void validIcon();
+    void packageDatabaseCache();
 
 private:
     QVector<PackageInfo *> m_pkgs;
@@ -209,6 +211,84 @@ void tst_ApplicationInfo::validIcon()
     QCOMPARE(result, isValid);
 }
 
+void tst_ApplicationInfo::packageDatabaseCache()
+{
+    QTemporaryDir tmpDir;
+    QVERIFY(tmpDir.isValid());
+
+    const QDir srcDir(qL1S(AM_TESTDATA_DIR "manifests"));
+    const QStringList pkgDirNames = srcDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &pkgDirName : pkgDirNames) {
+        QVERIFY(QDir(tmpDir.path()).mkdir(pkgDirName));
+        QVERIFY(QFile::copy(srcDir.absoluteFilePath(pkgDirName + qSL("/info.yaml")),
+                            tmpDir.filePath(pkgDirName + qSL("/info.yaml"))));
+    }
+
+    const QString cacheFilePath = tmpDir.filePath(qSL("packages.cache"));
+
+    auto compareDatabases = [](const PackageDatabase &pdb1, const PackageDatabase &pdb2) {
+        const auto pkgs1 = pdb1.builtInPackages();
+        const auto pkgs2 = pdb2.builtInPackages();
+        QCOMPARE(pkgs1.size(), pkgs2.size());
+
+        QMap<QString, PackageInfo *> pkgs2ById;
+        for (auto pkg : pkgs2)
+            pkgs2ById.insert(pkg->id(), pkg);
+
+        for (auto pkg1 : pkgs1) {
+            PackageInfo *pkg2 = pkgs2ById.value(pkg1->id());
+            QVERIFY(pkg2);
+            QCOMPARE(pkg1->names(), pkg2->names());
+            QCOMPARE(pkg1->icon(), pkg2->icon());
+            QCOMPARE(pkg1->categories(), pkg2->categories());
+            QCOMPARE(pkg1->isBuiltIn(), pkg2->isBuiltIn());
+            QCOMPARE(pkg1->baseDir().absolutePath(), pkg2->baseDir().absolutePath());
+            QCOMPARE(pkg1->applications().size(), pkg2->applications().size());
+            QCOMPARE(pkg1->intents().size(), pkg2->intents().size());
+
+            for (int i = 0; i < pkg1->applications().size(); ++i) {
+                const ApplicationInfo *app1 = pkg1->applications().at(i);
+                const ApplicationInfo *app2 = pkg2->applications().at(i);
+                QCOMPARE(app1->id(), app2->id());
+                QCOMPARE(app2->packageInfo(), pkg2);
+                QCOMPARE(app1->codeFilePath(), app2->codeFilePath());
+                QCOMPARE(app1->runtimeName(), app2->runtimeName());
+                QCOMPARE(app1->runtimeParameters(), app2->runtimeParameters());
+                QCOMPARE(app1->capabilities(), app2->capabilities());
+                QCOMPARE(app1->supportedMimeTypes(), app2->supportedMimeTypes());
+            }
+        }
+    };
+
+    PackageDatabase pdbWrite(QStringList { tmpDir.path() });
+    pdbWrite.setCacheFilePath(cacheFilePath);
+    pdbWrite.enableLoadFromCache();
+    pdbWrite.enableSaveToCache();
+    pdbWrite.parse();
+    QVERIFY(!pdbWrite.isLoadedFromCache());
+    QCOMPARE(pdbWrite.builtInPackages().size(), 2);
+    QVERIFY(QFile::exists(cacheFilePath));
+
+    PackageDatabase pdbRead(QStringList { tmpDir.path() });
+    pdbRead.setCacheFilePath(cacheFilePath);
+    pdbRead.enableLoadFromCache();
+    pdbRead.parse();
+    QVERIFY(pdbRead.isLoadedFromCache());
+    compareDatabases(pdbWrite, pdbRead);
+    if (QTest::currentTestFailed())
+        return;
+
+    // a removed package has to invalidate the cache
+    QVERIFY(QDir(tmpDir.filePath(pkgDirNames.first())).removeRecursively());
+
+    PackageDatabase pdbInvalid(QStringList { tmpDir.path() });
+    pdbInvalid.setCacheFilePath(cacheFilePath);
+    pdbInvalid.enableLoadFromCache();
+    pdbInvalid.parse();
+    QVERIFY(!pdbInvalid.isLoadedFromCache());
+    QCOMPARE(pdbInvalid.builtInPackages().size(), 1);
+}
+
 QTEST_APPLESS_MAIN(tst_ApplicationInfo)
 
 #include "tst_applicationinfo.moc"
@@ -0,0 +1,9 @@
+TARGET = tst_datachangedcoalescer
+
+include($$PWD/../tests.pri)
+
+QT *= \
+    appman_common-private \
+    appman_manager-private \
+
+SOURCES += tst_datachangedcoalescer.cpp
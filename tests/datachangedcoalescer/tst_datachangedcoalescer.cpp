@@ -0,0 +1,242 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtTest>
+
+#include "datachangedcoalescer.h"
+
+QT_USE_NAMESPACE_AM
+
+// a minimal list model that uses the coalescer the same way ApplicationManager and PackageManager do
+class ItemModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    ItemModel(int count)
+    {
+        for (int i = 0; i < count; ++i)
+            m_items << new QObject(this);
+
+        m_coalescer.reset(new DataChangedCoalescer(this, [this](QObject *item) {
+            return m_items.indexOf(item);
+        }, [this](int firstRow, int lastRow, const QVector<int> &roles) {
+            emit dataChanged(index(firstRow), index(lastRow), roles);
+        }, [this](QObject *item, const QVector<int> &roles) {
+            emit itemChanged(m_items.indexOf(item), roles);
+        }));
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_items.size();
+    }
+
+    QVariant data(const QModelIndex &, int) const override
+    {
+        return QVariant();
+    }
+
+    QObject *item(int row) const
+    {
+        return m_items.at(row);
+    }
+
+    void changeItem(int row, const QVector<int> &roles)
+    {
+        m_coalescer->add(m_items.at(row), roles);
+    }
+
+    void removeItem(int row)
+    {
+        m_coalescer->flush();
+        beginRemoveRows(QModelIndex(), row, row);
+        QObject *item = m_items.takeAt(row);
+        endRemoveRows();
+        m_coalescer->remove(item);
+        delete item;
+    }
+
+signals:
+    void itemChanged(int row, const QVector<int> &roles);
+
+private:
+    QVector<QObject *> m_items;
+    QScopedPointer<DataChangedCoalescer> m_coalescer;
+};
+
+class tst_DataChangedCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_DataChangedCoalescer();
+
+private slots:
+    void asyncDelivery();
+    void rangeMerging();
+    void allRoles();
+    void flushOnRemove();
+};
+
+tst_DataChangedCoalescer::tst_DataChangedCoalescer()
+{ }
+
+void tst_DataChangedCoalescer::asyncDelivery()
+{
+    ItemModel model(3);
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy itemChangedSpy(&model, &ItemModel::itemChanged);
+
+    model.changeItem(1, { 1 });
+    model.changeItem(1, { 2 });
+    model.changeItem(1, { 1 });
+    QCOMPARE(dataChangedSpy.count(), 0);
+
+    QTRY_COMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(0).toModelIndex().row(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(1).toModelIndex().row(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(2).value<QVector<int>>(), (QVector<int> { 1, 2 }));
+
+    QCOMPARE(itemChangedSpy.count(), 1);
+    QCOMPARE(itemChangedSpy.at(0).at(0).toInt(), 1);
+    QCOMPARE(itemChangedSpy.at(0).at(1).value<QVector<int>>(), (QVector<int> { 1, 2 }));
+
+    // nothing left to report
+    QTest::qWait(50);
+    QCOMPARE(dataChangedSpy.count(), 1);
+}
+
+void tst_DataChangedCoalescer::rangeMerging()
+{
+    ItemModel model(6);
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy itemChangedSpy(&model, &ItemModel::itemChanged);
+
+    model.changeItem(2, { 3 });
+    model.changeItem(1, { 1 });
+    model.changeItem(4, { 2 });
+    model.changeItem(3, { 1 });
+    model.changeItem(5, { 4 });
+
+    QTRY_COMPARE(dataChangedSpy.count(), 1);
+
+    // rows 1 to 5 are adjacent: one range with the union of all roles
+    QCOMPARE(dataChangedSpy.at(0).at(0).toModelIndex().row(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(1).toModelIndex().row(), 5);
+    QCOMPARE(dataChangedSpy.at(0).at(2).value<QVector<int>>(), (QVector<int> { 1, 2, 3, 4 }));
+
+    // the per-item signals still only carry the item's own roles
+    QCOMPARE(itemChangedSpy.count(), 5);
+    for (const auto &args : qAsConst(itemChangedSpy)) {
+        int row = args.at(0).toInt();
+        const auto roles = args.at(1).value<QVector<int>>();
+        switch (row) {
+        case 1: case 3: QCOMPARE(roles, QVector<int> { 1 }); break;
+        case 2: QCOMPARE(roles, QVector<int> { 3 }); break;
+        case 4: QCOMPARE(roles, QVector<int> { 2 }); break;
+        case 5: QCOMPARE(roles, QVector<int> { 4 }); break;
+        default: QFAIL("unexpected row");
+        }
+    }
+
+    // non-adjacent rows are separate ranges
+    dataChangedSpy.clear();
+    model.changeItem(0, { 1 });
+    model.changeItem(2, { 2 });
+    QTRY_COMPARE(dataChangedSpy.count(), 2);
+    QCOMPARE(dataChangedSpy.at(0).at(0).toModelIndex().row(), 0);
+    QCOMPARE(dataChangedSpy.at(0).at(1).toModelIndex().row(), 0);
+    QCOMPARE(dataChangedSpy.at(0).at(2).value<QVector<int>>(), QVector<int> { 1 });
+    QCOMPARE(dataChangedSpy.at(1).at(0).toModelIndex().row(), 2);
+    QCOMPARE(dataChangedSpy.at(1).at(1).toModelIndex().row(), 2);
+    QCOMPARE(dataChangedSpy.at(1).at(2).value<QVector<int>>(), QVector<int> { 2 });
+}
+
+void tst_DataChangedCoalescer::allRoles()
+{
+    ItemModel model(3);
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+
+    // an empty roles vector means "all roles" and wins over any specific role
+    model.changeItem(0, { 1 });
+    model.changeItem(1, { });
+    model.changeItem(1, { 2 });
+
+    QTRY_COMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(0).toModelIndex().row(), 0);
+    QCOMPARE(dataChangedSpy.at(0).at(1).toModelIndex().row(), 1);
+    QVERIFY(dataChangedSpy.at(0).at(2).value<QVector<int>>().isEmpty());
+}
+
+void tst_DataChangedCoalescer::flushOnRemove()
+{
+    ItemModel model(4);
+    QStringList log;
+    connect(&model, &QAbstractItemModel::dataChanged, this, [&log](const QModelIndex &first, const QModelIndex &last) {
+        log << qSL("changed %1-%2").arg(first.row()).arg(last.row());
+    });
+    connect(&model, &QAbstractItemModel::rowsRemoved, this, [&log](const QModelIndex &, int first, int last) {
+        log << qSL("removed %1-%2").arg(first).arg(last);
+    });
+
+    // the pending changes are reported first, with the rows from before the removal
+    model.changeItem(2, { 1 });
+    model.changeItem(3, { 1 });
+    model.removeItem(1);
+    QCOMPARE(log, QStringList({ qSL("changed 2-3"), qSL("removed 1-1") }));
+
+    // this also applies to changes of the item that is removed
+    log.clear();
+    model.changeItem(0, { 1 });
+    model.removeItem(0);
+    QCOMPARE(log, QStringList({ qSL("changed 0-0"), qSL("removed 0-0") }));
+
+    log.clear();
+    QTest::qWait(50);
+    QVERIFY(log.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(tst_DataChangedCoalescer)
+
+#include "tst_datachangedcoalescer.moc"
@@ -0,0 +1,11 @@
+TARGET = tst_frametimer
+
+include($$PWD/../tests.pri)
+
+requires(!headless)
+
+QT *= quick \
+      appman_shared_main-private \
+      appman_common-private
+
+SOURCES += tst_frametimer.cpp
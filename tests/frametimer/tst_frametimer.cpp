@@ -0,0 +1,236 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtTest>
+
+#include "frametimer.h"
+
+QT_USE_NAMESPACE_AM
+
+class tst_FrameTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_FrameTimer();
+
+private slots:
+    void histogramBuckets();
+    void histogramPercentile();
+    void droppedFrames_data();
+    void droppedFrames();
+    void idleTime();
+    void frameRequests();
+};
+
+tst_FrameTimer::tst_FrameTimer()
+{ }
+
+void tst_FrameTimer::histogramBuckets()
+{
+    // small values have a bucket of their own
+    for (int i = 0; i < int(FrameTimeHistogram::SubBuckets); ++i) {
+        QCOMPARE(FrameTimeHistogram::bucketIndex(i), i);
+        QCOMPARE(FrameTimeHistogram::bucketUpperBound(i), i);
+    }
+
+    // the buckets are contiguous, and the upper bound of each one is at most 6.25% off
+    int lowerBound = 0;
+    for (int i = 0; i < FrameTimeHistogram::BucketCount; ++i) {
+        const int upperBound = FrameTimeHistogram::bucketUpperBound(i);
+        QVERIFY(upperBound >= lowerBound);
+        QCOMPARE(FrameTimeHistogram::bucketIndex(lowerBound), i);
+        QCOMPARE(FrameTimeHistogram::bucketIndex(upperBound), i);
+        if (lowerBound >= int(FrameTimeHistogram::SubBuckets))
+            QVERIFY(qreal(upperBound - lowerBound) / lowerBound < 0.0625);
+        lowerBound = upperBound + 1;
+    }
+    QCOMPARE(FrameTimeHistogram::bucketUpperBound(FrameTimeHistogram::BucketCount - 1),
+             int(FrameTimeHistogram::MaxValue));
+
+    // out of range values are clamped
+    QCOMPARE(FrameTimeHistogram::bucketIndex(-1), 0);
+    QCOMPARE(FrameTimeHistogram::bucketIndex(FrameTimeHistogram::MaxValue + 1),
+             FrameTimeHistogram::BucketCount - 1);
+    QCOMPARE(FrameTimeHistogram::bucketIndex(std::numeric_limits<int>::max()),
+             FrameTimeHistogram::BucketCount - 1);
+}
+
+void tst_FrameTimer::histogramPercentile()
+{
+    FrameTimeHistogram histogram;
+    QCOMPARE(histogram.count(), 0);
+    QCOMPARE(histogram.percentile(50), 0);
+
+    // 1ms .. 100ms
+    for (int i = 1; i <= 100; ++i)
+        histogram.record(i * 1000);
+    QCOMPARE(histogram.count(), 100);
+
+    auto verifyPercentile = [&histogram](qreal percent, int expected) {
+        const int value = histogram.percentile(percent);
+        return (value >= expected) && (value < expected * 1.0625);
+    };
+    QVERIFY(verifyPercentile(0, 1000));
+    QVERIFY(verifyPercentile(50, 50000));
+    QVERIFY(verifyPercentile(95, 95000));
+    QVERIFY(verifyPercentile(99, 99000));
+    QVERIFY(verifyPercentile(100, 100000));
+    QVERIFY(verifyPercentile(200, 100000));
+
+    histogram.clear();
+    QCOMPARE(histogram.count(), 0);
+    QCOMPARE(histogram.percentile(99), 0);
+}
+
+void tst_FrameTimer::droppedFrames_data()
+{
+    QTest::addColumn<QList<int>>("frameTimes");
+    QTest::addColumn<int>("dropped");
+    QTest::addColumn<int>("longFrames");
+
+    QTest::newRow("60fps") << QList<int> { 16667, 16667, 16667 } << 0 << 0;
+    QTest::newRow("jitter") << QList<int> { 10000, 24000, 16000 } << 0 << 0;
+    QTest::newRow("1-missed") << QList<int> { 16667, 33334 } << 1 << 0;
+    QTest::newRow("2.6-vsyncs") << QList<int> { 43000 } << 2 << 0;
+    QTest::newRow("long") << QList<int> { 16667, 50000, 16667 } << 2 << 1;
+    QTest::newRow("very-long") << QList<int> { 200000 } << 11 << 1;
+}
+
+void tst_FrameTimer::droppedFrames()
+{
+    QFETCH(QList<int>, frameTimes);
+    QFETCH(int, dropped);
+    QFETCH(int, longFrames);
+
+    FrameTimer ft;
+    ft.recordFrame(-1); // the first frame has nothing to compare to
+    for (int frameTime : qAsConst(frameTimes))
+        ft.recordFrame(frameTime);
+    ft.update();
+
+    QCOMPARE(ft.droppedFrames(), dropped);
+    QCOMPARE(ft.longFrames(), longFrames);
+
+    // the counters are reset after every update
+    ft.recordFrame(16667);
+    ft.update();
+    QCOMPARE(ft.droppedFrames(), 0);
+    QCOMPARE(ft.longFrames(), 0);
+}
+
+void tst_FrameTimer::idleTime()
+{
+    FrameTimer ft;
+    ft.recordFrame(-1);
+    ft.recordFrame(16667);
+    // nothing was requested for 2 seconds and then the frame took 16ms - this is no slow frame
+    ft.recordFrame(2016667, 2000000);
+    ft.recordFrame(16667);
+    ft.update();
+
+    QCOMPARE(ft.droppedFrames(), 0);
+    QCOMPARE(ft.longFrames(), 0);
+    QVERIFY(ft.p99FrameTime() < 20);
+    QVERIFY(ft.minimumFps() > 55);
+
+    // a frame that was requested right away, but took 2 seconds is a (very) long one
+    ft.recordFrame(2000000);
+    ft.update();
+    QCOMPARE(ft.longFrames(), 1);
+    QVERIFY(ft.droppedFrames() > 100);
+
+    // an idle time longer than the complete frame cannot be attributed
+    ft.recordFrame(16667, 20000);
+    ft.update();
+    QCOMPARE(ft.droppedFrames(), 0);
+    QCOMPARE(ft.longFrames(), 0);
+}
+
+class RequestFrameTimer : public FrameTimer
+{
+public:
+    using FrameTimer::frameRequested;
+    using FrameTimer::newFrame;
+
+    bool nextFrameRequested = false;
+
+protected:
+    bool isNextFrameRequested() const override { return nextFrameRequested; }
+};
+
+void tst_FrameTimer::frameRequests()
+{
+    RequestFrameTimer ft;
+    ft.newFrame();
+
+    // the window is idle: the time until the next frame is requested does not count
+    QTest::qSleep(300);
+    ft.frameRequested();
+    ft.newFrame();
+    ft.update();
+    QCOMPARE(ft.longFrames(), 0);
+    QCOMPARE(ft.droppedFrames(), 0);
+
+    // the window is still animating: a stutter counts, no matter how long it is
+    ft.nextFrameRequested = true;
+    ft.newFrame();
+    QTest::qSleep(300);
+    ft.frameRequested();
+    ft.newFrame();
+    ft.update();
+    QCOMPARE(ft.longFrames(), 1);
+    QVERIFY(ft.droppedFrames() >= 16);
+
+    // without any frame requests (e.g. for a WindowObject) the complete time counts
+    RequestFrameTimer ft2;
+    ft2.newFrame();
+    QTest::qSleep(300);
+    ft2.newFrame();
+    ft2.update();
+    QCOMPARE(ft2.longFrames(), 1);
+}
+
+QTEST_GUILESS_MAIN(tst_FrameTimer)
+
+#include "tst_frametimer.moc"
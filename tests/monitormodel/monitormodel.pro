@@ -0,0 +1,10 @@
+TARGET = tst_monitormodel
+
+include($$PWD/../tests.pri)
+
+QT *= \
+    qml \
+    appman_common-private \
+    appman_shared_main-private \
+
+SOURCES += tst_monitormodel.cpp
@@ -0,0 +1,235 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtTest>
+#include <QQmlEngine>
+#include <QQmlComponent>
+
+#include "monitormodel.h"
+
+QT_USE_NAMESPACE_AM
+
+class tst_MonitorModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_MonitorModel();
+
+private slots:
+    void initTestCase();
+    void numericRoles();
+    void ringBuffer();
+    void resizeViaMaximumCount();
+    void values();
+
+private:
+    MonitorModel *createModel(int maximumCount);
+    void sample(MonitorModel *model, int times = 1);
+    QVariant value(MonitorModel *model, int row, const char *roleName);
+
+    QQmlEngine m_engine;
+};
+
+// number: an int first, doubles afterwards - label: a string - late: undefined for the first two samples
+static const char *modelQml = R"(
+import QtQml 2.0
+import QtApplicationManager 2.0
+
+MonitorModel {
+    QtObject {
+        property var roleNames: [ "number", "label", "late" ]
+        property int counter: 0
+        property var number
+        property string label
+        property var late
+
+        function update() {
+            ++counter;
+            number = (counter === 1) ? 0 : counter + 0.5;
+            label = "s" + counter;
+            late = (counter >= 3) ? counter + 0.25 : undefined;
+        }
+    }
+}
+)";
+
+tst_MonitorModel::tst_MonitorModel()
+{ }
+
+void tst_MonitorModel::initTestCase()
+{
+    qmlRegisterType<MonitorModel>("QtApplicationManager", 2, 0, "MonitorModel");
+}
+
+MonitorModel *tst_MonitorModel::createModel(int maximumCount)
+{
+    QQmlComponent component(&m_engine);
+    component.setData(modelQml, QUrl());
+    auto model = qobject_cast<MonitorModel *>(component.create());
+    if (!model) {
+        qWarning() << component.errors();
+        return nullptr;
+    }
+    model->setMaximumCount(maximumCount);
+    return model;
+}
+
+void tst_MonitorModel::sample(MonitorModel *model, int times)
+{
+    for (int i = 0; i < times; ++i)
+        QMetaObject::invokeMethod(model, "readDataSourcesAndAddRow", Qt::DirectConnection);
+}
+
+QVariant tst_MonitorModel::value(MonitorModel *model, int row, const char *roleName)
+{
+    return model->data(model->index(row), model->roleNames().key(roleName, -1));
+}
+
+void tst_MonitorModel::numericRoles()
+{
+    QScopedPointer<MonitorModel> model(createModel(10));
+    QVERIFY(model);
+
+    sample(model.data(), 3);
+    QCOMPARE(model->count(), 3);
+
+    // the first sample is an int, but the later ones must not be truncated
+    QCOMPARE(value(model.data(), 0, "number").userType(), int(QMetaType::Double));
+    QCOMPARE(value(model.data(), 0, "number").toDouble(), 0.0);
+    QCOMPARE(value(model.data(), 1, "number").toDouble(), 2.5);
+    QCOMPARE(value(model.data(), 2, "number").toDouble(), 3.5);
+
+    QCOMPARE(value(model.data(), 2, "label").toString(), qSL("s3"));
+
+    // undefined until the 3rd sample
+    QVERIFY(!value(model.data(), 0, "late").isValid());
+    QVERIFY(!value(model.data(), 1, "late").isValid());
+    QCOMPARE(value(model.data(), 2, "late").toDouble(), 3.25);
+
+    const QVariantMap row = model->get(1);
+    QCOMPARE(row.value(qSL("number")).toDouble(), 2.5);
+    QCOMPARE(row.value(qSL("label")).toString(), qSL("s2"));
+}
+
+void tst_MonitorModel::ringBuffer()
+{
+    QScopedPointer<MonitorModel> model(createModel(3));
+    QVERIFY(model);
+
+    QSignalSpy insertedSpy(model.data(), &QAbstractItemModel::rowsInserted);
+    QSignalSpy movedSpy(model.data(), &QAbstractItemModel::rowsMoved);
+
+    sample(model.data(), 5);
+    QCOMPARE(model->count(), 3);
+    QCOMPARE(insertedSpy.count(), 3);
+    QCOMPARE(movedSpy.count(), 2);
+
+    // oldest first, after wrapping around
+    for (int row = 0; row < 3; ++row) {
+        QCOMPARE(value(model.data(), row, "label").toString(), qSL("s%1").arg(row + 3));
+        QCOMPARE(value(model.data(), row, "number").toDouble(), row + 3.5);
+    }
+
+    model->clear();
+    QCOMPARE(model->count(), 0);
+    sample(model.data());
+    QCOMPARE(model->count(), 1);
+    QCOMPARE(value(model.data(), 0, "label").toString(), qSL("s6"));
+}
+
+void tst_MonitorModel::resizeViaMaximumCount()
+{
+    QScopedPointer<MonitorModel> model(createModel(4));
+    QVERIFY(model);
+
+    sample(model.data(), 6); // s3 .. s6, wrapped around
+    QCOMPARE(model->count(), 4);
+
+    // shrinking drops the oldest rows
+    QSignalSpy removedSpy(model.data(), &QAbstractItemModel::rowsRemoved);
+    model->setMaximumCount(2);
+    QCOMPARE(model->count(), 2);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(value(model.data(), 0, "label").toString(), qSL("s5"));
+    QCOMPARE(value(model.data(), 1, "label").toString(), qSL("s6"));
+
+    // growing keeps all rows in order and makes room for new ones
+    model->setMaximumCount(5);
+    QCOMPARE(model->count(), 2);
+    sample(model.data(), 4);
+    QCOMPARE(model->count(), 5);
+    for (int row = 0; row < 5; ++row)
+        QCOMPARE(value(model.data(), row, "label").toString(), qSL("s%1").arg(row + 6));
+
+    model->setMaximumCount(0);
+    QCOMPARE(model->count(), 0);
+    sample(model.data());
+    QCOMPARE(model->count(), 0);
+}
+
+void tst_MonitorModel::values()
+{
+    QScopedPointer<MonitorModel> model(createModel(3));
+    QVERIFY(model);
+
+    QVERIFY(model->values(qSL("number")).isEmpty());
+
+    sample(model.data(), 4); // s2 .. s4
+    QCOMPARE(model->values(qSL("number")), (QList<qreal> { 2.5, 3.5, 4.5 }));
+
+    const QList<qreal> late = model->values(qSL("late"));
+    QCOMPARE(late.size(), 3);
+    QVERIFY(qIsNaN(late.at(0)));
+    QCOMPARE(late.at(1), 3.25);
+    QCOMPARE(late.at(2), 4.25);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(qSL("not numeric")));
+    QVERIFY(model->values(qSL("label")).isEmpty());
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(qSL("invalid role")));
+    QVERIFY(model->values(qSL("unknown")).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(tst_MonitorModel)
+
+#include "tst_monitormodel.moc"
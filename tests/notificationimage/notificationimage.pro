@@ -0,0 +1,11 @@
+TARGET = tst_notificationimage
+
+include($$PWD/../tests.pri)
+
+requires(!headless)
+
+QT *= gui \
+      appman_manager-private \
+      appman_common-private
+
+SOURCES += tst_notificationimage.cpp
@@ -0,0 +1,242 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtTest>
+#include <QImage>
+#if defined(QT_DBUS_LIB)
+#  include <QDBusUnixFileDescriptor>
+#endif
+#if defined(Q_OS_LINUX)
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <linux/memfd.h>
+#endif
+
+#include "notificationimageprovider.h"
+
+QT_USE_NAMESPACE_AM
+
+#if defined(QT_DBUS_LIB) && defined(Q_OS_LINUX) && defined(F_GET_SEALS) && defined(SYS_memfd_create)
+#  define AM_TEST_MEMFD
+#endif
+
+class tst_NotificationImage : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_NotificationImage();
+
+private slots:
+    void decodeImageHint_data();
+    void decodeImageHint();
+    void decodeMemFdImageHint_data();
+    void decodeMemFdImageHint();
+    void imageUrl();
+    void unchangedImageHint();
+};
+
+// a 2x2 RGB image: red, green / blue, white - every row is padded with 'padding' bytes
+static QByteArray rgbPixels(int padding, int truncate = 0)
+{
+    QByteArray pad(padding, '\xaa');
+    QByteArray pixels = QByteArray("\xff\x00\x00\x00\xff\x00", 6) + pad
+            + QByteArray("\x00\x00\xff\xff\xff\xff", 6) + pad;
+    pixels.chop(truncate);
+    return pixels;
+}
+
+static QVariantList imageHint(int rowStride, const QVariant &data, int channels = 3)
+{
+    return QVariantList { 2, 2, rowStride, false, 8, channels, data };
+}
+
+static void verifyPixels(const QImage &image)
+{
+    QCOMPARE(image.size(), QSize(2, 2));
+    QCOMPARE(image.pixel(0, 0), qRgb(0xff, 0, 0));
+    QCOMPARE(image.pixel(1, 0), qRgb(0, 0xff, 0));
+    QCOMPARE(image.pixel(0, 1), qRgb(0, 0, 0xff));
+    QCOMPARE(image.pixel(1, 1), qRgb(0xff, 0xff, 0xff));
+}
+
+tst_NotificationImage::tst_NotificationImage()
+{ }
+
+void tst_NotificationImage::decodeImageHint_data()
+{
+    QTest::addColumn<QVariant>("hint");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("valid") << QVariant(imageHint(6, rgbPixels(0))) << true;
+    QTest::newRow("stride-padded") << QVariant(imageHint(8, rgbPixels(2))) << true;
+    QTest::newRow("unpadded-last-row") << QVariant(imageHint(8, rgbPixels(2, 2))) << true;
+    QTest::newRow("short") << QVariant(imageHint(6, rgbPixels(0, 1))) << false;
+    QTest::newRow("short-padded") << QVariant(imageHint(8, rgbPixels(2, 3))) << false;
+    QTest::newRow("stride-too-small") << QVariant(imageHint(5, rgbPixels(0))) << false;
+    QTest::newRow("wrong-channels") << QVariant(imageHint(6, rgbPixels(0), 4)) << false;
+    QTest::newRow("no-pixels") << QVariant(imageHint(6, QVariant())) << false;
+    QTest::newRow("incomplete") << QVariant(QVariantList { 2, 2, 6 }) << false;
+    QTest::newRow("string") << QVariant(qSL("foo")) << false;
+}
+
+void tst_NotificationImage::decodeImageHint()
+{
+    QFETCH(QVariant, hint);
+    QFETCH(bool, valid);
+
+    QImage image = NotificationImageCache::decodeImageHint(hint);
+    QCOMPARE(!image.isNull(), valid);
+    if (valid)
+        verifyPixels(image);
+}
+
+void tst_NotificationImage::decodeMemFdImageHint_data()
+{
+    QTest::addColumn<QByteArray>("pixels");
+    QTest::addColumn<int>("rowStride");
+    QTest::addColumn<bool>("sealed");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("valid") << rgbPixels(0) << 6 << true << true;
+    QTest::newRow("stride-padded") << rgbPixels(2) << 8 << true << true;
+    QTest::newRow("unpadded-last-row") << rgbPixels(2, 2) << 8 << true << true;
+    QTest::newRow("short") << rgbPixels(2, 3) << 8 << true << false;
+    QTest::newRow("not-sealed") << rgbPixels(0) << 6 << false << false;
+}
+
+void tst_NotificationImage::decodeMemFdImageHint()
+{
+#if defined(AM_TEST_MEMFD)
+    QFETCH(QByteArray, pixels);
+    QFETCH(int, rowStride);
+    QFETCH(bool, sealed);
+    QFETCH(bool, valid);
+
+    int fd = int(syscall(SYS_memfd_create, "tst_notificationimage", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (fd < 0)
+        QSKIP("memfd_create is not supported by this kernel");
+    QCOMPARE(write(fd, pixels.constData(), size_t(pixels.size())), ssize_t(pixels.size()));
+    if (sealed)
+        QVERIFY(fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0);
+
+    // QDBusUnixFileDescriptor duplicates the fd
+    QVariant memFd = QVariant::fromValue(QDBusUnixFileDescriptor(fd));
+    ::close(fd);
+
+    QImage image = NotificationImageCache::decodeImageHint(imageHint(rowStride, memFd), true);
+    QCOMPARE(!image.isNull(), valid);
+    if (valid)
+        verifyPixels(image);
+
+    // a raw byte array is not accepted as a memfd hint and vice versa
+    QVERIFY(NotificationImageCache::decodeImageHint(imageHint(rowStride, pixels), true).isNull());
+    QVERIFY(NotificationImageCache::decodeImageHint(imageHint(rowStride, memFd), false).isNull());
+#else
+    QSKIP("memfd image hints are not supported on this platform");
+#endif
+}
+
+void tst_NotificationImage::imageUrl()
+{
+    NotificationImageCache cache;
+    QImage image = NotificationImageCache::decodeImageHint(imageHint(8, rgbPixels(2)));
+    QVERIFY(!image.isNull());
+
+    const QString url = cache.insert(1, image);
+    QVERIFY(url.startsWith(qSL("image://notification/1/")));
+    const uint generation = url.mid(url.lastIndexOf(qL1C('/')) + 1).toUInt();
+    QCOMPARE(cache.image(1, generation), image);
+    QVERIFY(cache.image(1, generation + 1).isNull());
+    QVERIFY(cache.image(2, generation).isNull());
+
+    // the same pixels - even with a different stride - keep the url stable
+    QImage samePixels = NotificationImageCache::decodeImageHint(imageHint(6, rgbPixels(0)));
+    QCOMPARE(cache.insert(1, samePixels), url);
+
+    // changed pixels result in a new url
+    QImage changed = image.copy();
+    changed.setPixel(1, 1, qRgb(0, 0, 0));
+    const QString changedUrl = cache.insert(1, changed);
+    QVERIFY(changedUrl != url);
+    QVERIFY(cache.image(1, generation).isNull());
+
+    cache.remove(1);
+    QVERIFY(cache.image(1, changedUrl.mid(changedUrl.lastIndexOf(qL1C('/')) + 1).toUInt()).isNull());
+}
+
+void tst_NotificationImage::unchangedImageHint()
+{
+    NotificationImageCache cache;
+    const QByteArray pixels = rgbPixels(2);
+    const QString url = cache.insertImageHint(1, imageHint(8, pixels));
+    QVERIFY(url.startsWith(qSL("image://notification/1/")));
+    const uint generation = url.mid(url.lastIndexOf(qL1C('/')) + 1).toUInt();
+    const QImage image = cache.image(1, generation);
+    verifyPixels(image);
+
+    // re-sending the same buffer does not decode the image again
+    QCOMPARE(cache.insertImageHint(1, imageHint(8, pixels)), url);
+    QCOMPARE(cache.image(1, generation).cacheKey(), image.cacheKey());
+
+    // neither does an identical copy, as received via D-Bus
+    const QByteArray copy(pixels.constData(), pixels.size());
+    QCOMPARE(cache.insertImageHint(1, imageHint(8, copy)), url);
+    QCOMPARE(cache.image(1, generation).cacheKey(), image.cacheKey());
+
+    // a different layout is decoded again, but the same visible pixels keep the url stable
+    QCOMPARE(cache.insertImageHint(1, imageHint(6, rgbPixels(0))), url);
+    QVERIFY(cache.image(1, generation).cacheKey() != image.cacheKey());
+    verifyPixels(cache.image(1, generation));
+
+    QByteArray changed = rgbPixels(0);
+    changed[0] = '\x00';
+    QVERIFY(cache.insertImageHint(1, imageHint(6, changed)) != url);
+
+    QVERIFY(cache.insertImageHint(1, QVariant(qSL("foo"))).isEmpty());
+}
+
+QTEST_APPLESS_MAIN(tst_NotificationImage)
+
+#include "tst_notificationimage.moc"
@@ -30,6 +30,8 @@
 #include <QtCore>
 #include <QtTest>
 #include <QtAppManMonitor/processreader.h>
+#include <QtAppManMonitor/processsampler.h>
+#include <unistd.h>
 
 QT_USE_NAMESPACE_AM
 
@@ -46,6 +48,11 @@ private slots:
     void memTestProcess();
     void memBasic();
     void memAdvanced();
+    void memRollup();
+    void memBenchmark_data();
+    void memBenchmark();
+    void samplerSharedReader();
+    void samplerBatch();
 
 private:
     void printMem(const ProcessReader &reader);
@@ -125,6 +132,140 @@ void tst_ProcessReader::memAdvanced()
     QCOMPARE(reader.heapPss.load(), 15740u);
 }
 
+void tst_ProcessReader::memRollup()
+{
+    QVERIFY(reader.readSmapsRollup(QFINDTESTDATA("rollup.smaps").toLocal8Bit(),
+                                   QFINDTESTDATA("statm").toLocal8Bit()));
+    //printMem(reader);
+    QCOMPARE(reader.totalVm.load(), quint32(26846 * (sysconf(_SC_PAGESIZE) / 1024)));
+    QCOMPARE(reader.totalRss.load(), 20352u);
+    QCOMPARE(reader.totalPss.load(), 13814u);
+    QCOMPARE(reader.textVm.load(), 0u);
+    QCOMPARE(reader.heapVm.load(), 0u);
+
+    QVERIFY(!reader.readSmapsRollup(QFINDTESTDATA("basic.smaps").toLocal8Bit(),
+                                    QFINDTESTDATA("statm").toLocal8Bit()));
+    QVERIFY(!reader.readSmapsRollup(QFINDTESTDATA("rollup.smaps").toLocal8Bit(),
+                                    QFINDTESTDATA("invalid.smaps").toLocal8Bit()));
+
+    const QByteArray procDir = "/proc/" + QByteArray::number(QCoreApplication::applicationPid());
+    if (!QFile::exists(QString::fromLocal8Bit(procDir + "/smaps_rollup")))
+        QSKIP("This kernel does not support /proc/<pid>/smaps_rollup");
+    QVERIFY(reader.readSmapsRollup(procDir + "/smaps_rollup", procDir + "/statm"));
+    QVERIFY(reader.totalVm.load() >= reader.totalRss.load());
+    QVERIFY(reader.totalRss.load() >= reader.totalPss.load());
+}
+
+void tst_ProcessReader::memBenchmark_data()
+{
+    QTest::addColumn<int>("mappings");
+    QTest::addColumn<bool>("rollup");
+
+    // both read modes on the same synthetic process
+    for (int mappings : { 1000, 10000, 20000 }) {
+        QTest::newRow(("smaps-" + QByteArray::number(mappings)).constData()) << mappings << false;
+        QTest::newRow(("smaps_rollup-" + QByteArray::number(mappings)).constData()) << mappings << true;
+    }
+}
+
+void tst_ProcessReader::memBenchmark()
+{
+    QFETCH(int, mappings);
+    QFETCH(bool, rollup);
+
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+    const QString smapsFile = tmp.filePath(qSL("smaps"));
+    const QString rollupFile = tmp.filePath(qSL("smaps_rollup"));
+    const QString statmFile = tmp.filePath(qSL("statm"));
+
+    // a synthetic smaps file, modeled after the mappings of a big QML application: a mix of
+    // shared library code, data and anonymous heap mappings
+    {
+        QFile f(smapsFile);
+        QVERIFY(f.open(QIODevice::WriteOnly));
+        static const char *permissions[] = { "r-xp", "r--p", "rw-p", "rw-p" };
+        quint64 address = 0x400000;
+
+        for (int i = 0; i < mappings; ++i) {
+            const char *perm = permissions[i % 4];
+            bool anonymous = (i % 4 == 3);
+            QByteArray header = QByteArray::number(address, 16) + '-'
+                    + QByteArray::number(address + 0x21000, 16) + ' ' + perm + " 00000000 "
+                    + (anonymous ? "00:00 0" : "b3:01 266877") + "                          "
+                    + (anonymous ? "" : "/usr/lib/libQt5Quick.so.5.13.2");
+            address += 0x22000;
+
+            f.write(header + "\n"
+                    "Size:                132 kB\n"
+                    "KernelPageSize:        4 kB\n"
+                    "MMUPageSize:           4 kB\n"
+                    "Rss:                  76 kB\n"
+                    "Pss:                  38 kB\n"
+                    "Shared_Clean:         76 kB\n"
+                    "Shared_Dirty:          0 kB\n"
+                    "Private_Clean:         0 kB\n"
+                    "Private_Dirty:         0 kB\n"
+                    "Referenced:           76 kB\n"
+                    "Anonymous:             0 kB\n"
+                    "LazyFree:              0 kB\n"
+                    "AnonHugePages:         0 kB\n"
+                    "ShmemPmdMapped:        0 kB\n"
+                    "FilePmdMapped:         0 kB\n"
+                    "Shared_Hugetlb:        0 kB\n"
+                    "Private_Hugetlb:       0 kB\n"
+                    "Swap:                  0 kB\n"
+                    "SwapPss:               0 kB\n"
+                    "Locked:                0 kB\n"
+                    "THPeligible:           0\n"
+                    "VmFlags: rd ex mr mw me dw\n");
+        }
+    }
+    // the smaps_rollup and statm files the kernel would generate for the same process
+    const quint32 pageSize = quint32(sysconf(_SC_PAGESIZE));
+    const quint32 vmPages = quint32(quint64(mappings) * 132 * 1024 / pageSize);
+    {
+        QFile f(rollupFile);
+        QVERIFY(f.open(QIODevice::WriteOnly));
+        f.write("00400000-ffffffffff601000 ---p 00000000 00:00 0                          [rollup]\n"
+                "Rss:               " + QByteArray::number(mappings * 76) + " kB\n"
+                "Pss:               " + QByteArray::number(mappings * 38) + " kB\n"
+                "Shared_Clean:      " + QByteArray::number(mappings * 76) + " kB\n"
+                "Shared_Dirty:          0 kB\n"
+                "Private_Clean:         0 kB\n"
+                "Private_Dirty:         0 kB\n"
+                "Referenced:        " + QByteArray::number(mappings * 76) + " kB\n"
+                "Anonymous:             0 kB\n"
+                "Swap:                  0 kB\n"
+                "SwapPss:               0 kB\n"
+                "Locked:                0 kB\n");
+    }
+    {
+        QFile f(statmFile);
+        QVERIFY(f.open(QIODevice::WriteOnly));
+        f.write(QByteArray::number(vmPages) + " 0 0 0 0 0 0\n");
+    }
+
+    if (rollup) {
+        QBENCHMARK {
+            QVERIFY(reader.readSmapsRollup(rollupFile.toLocal8Bit(), statmFile.toLocal8Bit()));
+        }
+        QCOMPARE(reader.totalVm.load(), vmPages * (pageSize / 1024));
+        QCOMPARE(reader.textPss.load(), quint32(0));
+        QCOMPARE(reader.heapPss.load(), quint32(0));
+    } else {
+        QBENCHMARK {
+            QVERIFY(reader.readSmaps(smapsFile.toLocal8Bit()));
+        }
+        QCOMPARE(reader.totalVm.load(), quint32(mappings * 132));
+        QCOMPARE(reader.textPss.load(), quint32(mappings / 4 * 38));
+        QCOMPARE(reader.heapPss.load(), quint32(mappings / 4 * 38));
+    }
+    // both modes have to agree on the totals
+    QCOMPARE(reader.totalRss.load(), quint32(mappings * 76));
+    QCOMPARE(reader.totalPss.load(), quint32(mappings * 38));
+}
+
 void tst_ProcessReader::printMem(const ProcessReader &reader)
 {
     qDebug() << "totalVm:" << reader.totalVm.load();
@@ -138,6 +279,65 @@ void tst_ProcessReader::printMem(const ProcessReader &reader)
     qDebug() << "heapPss:" << reader.heapPss.load();
 }
 
-QTEST_APPLESS_MAIN(tst_ProcessReader)
+void tst_ProcessReader::samplerSharedReader()
+{
+    ProcessSampler *sampler = ProcessSampler::instance();
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QSharedPointer<ProcessReader> r1 = sampler->reader(pid);
+    QSharedPointer<ProcessReader> r2 = sampler->reader(pid);
+    QVERIFY(r1);
+    QCOMPARE(r1, r2);
+    QVERIFY(sampler->reader(getppid()) != r1);
+
+    // the sampler does not keep the reader alive once all observers are gone
+    QWeakPointer<ProcessReader> weak = r1;
+    r1.clear();
+    r2.clear();
+    QVERIFY(weak.isNull());
+    r1 = sampler->reader(pid);
+    QVERIFY(r1);
+}
+
+void tst_ProcessReader::samplerBatch()
+{
+    qRegisterMetaType<QSet<qint64>>();
+
+    ProcessSampler *sampler = ProcessSampler::instance();
+    const qint64 pid = QCoreApplication::applicationPid();
+    const qint64 ppid = getppid();
+
+    QSharedPointer<ProcessReader> self = sampler->reader(pid);
+    QSharedPointer<ProcessReader> parent = sampler->reader(ppid);
+    QSignalSpy spy(sampler, &ProcessSampler::updated);
+
+    // all requests of one event loop iteration end up in a single batch
+    sampler->requestUpdate(pid, ProcessReader::TotalMemoryOnly);
+    sampler->requestUpdate(ppid, ProcessReader::TotalMemoryOnly);
+    sampler->requestUpdate(pid, ProcessReader::FullMemoryReport);
+    QCOMPARE(spy.count(), 0);
+
+    QVERIFY(spy.wait(5000));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QSet<qint64>>(), (QSet<qint64> { pid, ppid }));
+
+    // the full report wins over the totals only: the text breakdown needs the complete smaps
+    QVERIFY(self->totalVm.load() >= self->totalRss.load());
+    QVERIFY(self->totalRss.load() > 0);
+    QVERIFY(self->textVm.load() > 0);
+
+    // pids without any observers are not sampled at all
+    spy.clear();
+    parent.clear();
+    sampler->requestUpdate(ppid);
+    QTest::qWait(200);
+    QCOMPARE(spy.count(), 0);
+
+    sampler->requestUpdate(pid);
+    QVERIFY(spy.wait(5000));
+    QCOMPARE(spy.at(0).at(0).value<QSet<qint64>>(), QSet<qint64> { pid });
+}
+
+QTEST_GUILESS_MAIN(tst_ProcessReader)
 
 #include "tst_processreader.moc"
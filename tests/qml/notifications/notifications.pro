@@ -0,0 +1,8 @@
+AM_CONFIG = am-config.yaml
+TEST_FILES = tst_notifications.qml
+TEST_CONFIGURATIONS = "--force-single-process" \
+                      "--force-single-process -c $$_PRO_FILE_PWD_/am-config-coalescing.yaml"
+
+OTHER_FILES += am-config-coalescing.yaml
+
+load(am-qml-testcase)
@@ -0,0 +1,190 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+import QtQuick 2.3
+import QtTest 1.0
+import QtApplicationManager 2.0
+import QtApplicationManager.SystemUI 2.0
+
+TestCase {
+    id: testCase
+    when: windowShown
+    name: "Notifications"
+
+    Notification {
+        id: notification
+        summary: "Summary"
+        body: "Body"
+        sticky: true
+    }
+
+    Notification {
+        id: timedNotification
+        summary: "Timed"
+        body: "Body"
+        timeout: 1000
+    }
+
+    SignalSpy {
+        id: changedSpy
+        target: NotificationManager
+        signalName: "notificationChanged"
+    }
+
+    function expectChangedRoles(roles) {
+        tryCompare(changedSpy, "count", 1);
+        compare(changedSpy.signalArguments[0][0], notification.notificationId);
+        compare(changedSpy.signalArguments[0][1].sort(), roles.sort());
+        changedSpy.clear();
+    }
+
+    function initTestCase() {
+        notification.show();
+        tryCompare(NotificationManager, "count", 1);
+        verify(notification.notificationId !== 0);
+        changedSpy.clear();
+    }
+
+    function cleanup() {
+        if (timedNotification.visible) {
+            timedNotification.hide();
+            tryCompare(NotificationManager, "count", 1);
+        }
+        timedNotification.body = "Body";
+        timedNotification.timeout = 1000;
+        changedSpy.clear();
+    }
+
+    function cleanupTestCase() {
+        notification.hide();
+        tryCompare(NotificationManager, "count", 0);
+    }
+
+    function test_changedRoles() {
+        notification.summary = "Summary 2";
+        expectChangedRoles(["summary"]);
+        compare(NotificationManager.notification(notification.notificationId).summary, "Summary 2");
+
+        notification.body = "Body 2";
+        expectChangedRoles(["body"]);
+
+        // the progress is not sent at all, as long as it is not shown
+        notification.progress = 0.5;
+        notification.showProgress = true;
+        expectChangedRoles(["isShowingProgress", "progress"]);
+
+        notification.progress = 0.75;
+        expectChangedRoles(["progress"]);
+
+        notification.priority = 2;
+        expectChangedRoles(["priority"]);
+
+        // re-sending identical data must not report any change
+        notification.update();
+        wait(250);
+        compare(changedSpy.count, 0);
+    }
+
+    function test_timeoutExpiry() {
+        var start = Date.now();
+        timedNotification.show();
+        tryCompare(NotificationManager, "count", 2);
+        tryCompare(NotificationManager, "count", 1, 5000);
+        verify(Date.now() - start >= timedNotification.timeout);
+        // closed by the server, not by us
+        compare(timedNotification.visible, false);
+        compare(timedNotification.notificationId, 0);
+    }
+
+    function test_timeoutRestartedByReplace() {
+        var start = Date.now();
+        timedNotification.show();
+        tryCompare(NotificationManager, "count", 2);
+        wait(600);
+        timedNotification.body = "Body 2";
+        tryCompare(NotificationManager, "count", 1, 5000);
+        // the replace-update restarted the timeout
+        verify(Date.now() - start >= 600 + timedNotification.timeout);
+    }
+
+    function test_timeoutCancelledBySticky() {
+        timedNotification.timeout = 500;
+        timedNotification.show();
+        tryCompare(NotificationManager, "count", 2);
+        timedNotification.sticky = true;
+        wait(1000);
+        compare(NotificationManager.count, 2);
+        verify(timedNotification.visible);
+    }
+
+    function test_updateBurst() {
+        var interval = ApplicationManager.systemProperties.updateCoalescingInterval || 0;
+        var id = notification.notificationId;
+
+        // the first update after a quiet period is always reported right away
+        wait(interval * 2);
+        changedSpy.clear();
+        notification.body = "Burst 0";
+        tryCompare(changedSpy, "count", 1);
+        compare(changedSpy.signalArguments[0][0], id);
+        changedSpy.clear();
+
+        // a burst within the coalescing interval is reported once, with the latest data
+        for (var i = 1; i <= 10; ++i)
+            notification.body = "Burst " + i;
+
+        if (interval > 0) {
+            tryCompare(changedSpy, "count", 1);
+            wait(interval * 2);
+            compare(changedSpy.count, 1);
+        } else {
+            tryCompare(changedSpy, "count", 10);
+        }
+        var last = changedSpy.count - 1;
+        compare(changedSpy.signalArguments[last][0], id);
+        compare(changedSpy.signalArguments[last][1], ["body"]);
+        compare(NotificationManager.notification(id).body, "Burst 10");
+
+        notification.body = "Body";
+        tryVerify(function() { return NotificationManager.notification(id).body === "Body"; });
+    }
+}
@@ -16,4 +16,5 @@ SUBDIRS = \
     crash \
     configs \
     lifecycle \
+    notifications \
     resources
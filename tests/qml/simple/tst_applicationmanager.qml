@@ -428,6 +428,41 @@ TestCase {
         runStateChangedSpy.clear()
     }
 
+    SignalSpy {
+        id: queuedStartSpy
+        target: ApplicationManager
+        signalName: "queuedApplicationStartFinished"
+    }
+
+    function test_queueApplicationStart() {
+        compare(ApplicationManager.queueApplicationStart("invalidApplication"), -1);
+
+        var request1 = ApplicationManager.queueApplicationStart("tld.test.simple1");
+        var request2 = ApplicationManager.queueApplicationStart("tld.test.simple2");
+        verify(request1 > 0);
+        verify(request2 > request1);
+
+        while (queuedStartSpy.count < 2)
+            queuedStartSpy.wait(10000);
+
+        for (var i = 0; i < 2; ++i) {
+            var args = queuedStartSpy.signalArguments[i];
+            verify(args[0] === request1 || args[0] === request2);
+            verify(args[2]);
+            verify(args[3].preflight >= 0);
+            verify(args[3].startup >= 0);
+            verify(args[3].total >= args[3].startup);
+        }
+        compare(ApplicationManager.application("tld.test.simple1").runState, Am.Running);
+        compare(ApplicationManager.application("tld.test.simple2").runState, Am.Running);
+
+        ApplicationManager.stopAllApplications(true);
+        tryCompare(ApplicationManager.application("tld.test.simple1"), "runState", Am.NotRunning, 10000);
+        tryCompare(ApplicationManager.application("tld.test.simple2"), "runState", Am.NotRunning, 10000);
+        queuedStartSpy.clear();
+        runStateChangedSpy.clear();
+    }
+
     function test_errors() {
         ignoreWarning("ApplicationManager::application(index): invalid index: -1");
         verify(!ApplicationManager.application(-1));
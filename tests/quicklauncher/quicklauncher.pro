@@ -0,0 +1,9 @@
+TARGET = tst_quicklauncher
+
+include($$PWD/../tests.pri)
+
+QT *= \
+    appman_common-private \
+    appman_manager-private \
+
+SOURCES += tst_quicklauncher.cpp
@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtTest>
+
+#include "quicklauncher.h"
+
+QT_USE_NAMESPACE_AM
+
+class tst_QuickLauncher : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QuickLauncher();
+
+private slots:
+    void launchRateDecay();
+    void targetPoolSize_data();
+    void targetPoolSize();
+};
+
+tst_QuickLauncher::tst_QuickLauncher()
+{ }
+
+void tst_QuickLauncher::launchRateDecay()
+{
+    QCOMPARE(QuickLauncher::decayedLaunchRate(2, 0), qreal(2));
+    // the time constant is 1 minute
+    QVERIFY(qAbs(QuickLauncher::decayedLaunchRate(2, 60000) - 2 / M_E) < 0.0001);
+    QVERIFY(QuickLauncher::decayedLaunchRate(2, 600000) < 0.001);
+    // a clock going backwards must not increase the rate
+    QCOMPARE(QuickLauncher::decayedLaunchRate(2, -1000), qreal(2));
+}
+
+void tst_QuickLauncher::targetPoolSize_data()
+{
+    QTest::addColumn<int>("minimum");
+    QTest::addColumn<int>("maximum");
+    QTest::addColumn<qreal>("launchRate");
+    QTest::addColumn<qreal>("spawnTime");
+    QTest::addColumn<int>("burstBoost");
+    QTest::addColumn<int>("target");
+
+    QTest::newRow("no-demand") << 1 << 4 << qreal(0) << qreal(0) << 0 << 1;
+    QTest::newRow("below-minimum") << 2 << 4 << qreal(0.5) << qreal(1000) << 0 << 2;
+    // 2 launches per second, while a launcher takes 1.5 seconds to become ready
+    QTest::newRow("demand") << 1 << 8 << qreal(2) << qreal(1500) << 0 << 3;
+    QTest::newRow("demand-capped") << 1 << 4 << qreal(10) << qreal(2000) << 0 << 4;
+    QTest::newRow("burst-boost") << 1 << 8 << qreal(0) << qreal(0) << 2 << 3;
+    QTest::newRow("demand-and-boost") << 1 << 8 << qreal(2) << qreal(1500) << 2 << 5;
+    QTest::newRow("boost-capped") << 2 << 3 << qreal(0) << qreal(0) << 5 << 3;
+    QTest::newRow("maximum-below-minimum") << 2 << 0 << qreal(10) << qreal(1000) << 1 << 2;
+}
+
+void tst_QuickLauncher::targetPoolSize()
+{
+    QFETCH(int, minimum);
+    QFETCH(int, maximum);
+    QFETCH(qreal, launchRate);
+    QFETCH(qreal, spawnTime);
+    QFETCH(int, burstBoost);
+    QFETCH(int, target);
+
+    QCOMPARE(QuickLauncher::targetPoolSize(minimum, maximum, launchRate, spawnTime, burstBoost), target);
+}
+
+QTEST_APPLESS_MAIN(tst_QuickLauncher)
+
+#include "tst_quicklauncher.moc"
@@ -45,6 +45,17 @@ private slots:
     void cgroupProcessInfo();
     void memoryReaderReadUsedValue();
     void memoryReaderGroupLimit();
+    void unifiedMemoryReaderReadUsedValue();
+    void unifiedMemoryReaderGroupLimit();
+    void controlGroupReaderParse();
+    void unifiedControlGroupReader();
+    void cpuReaderParseProcStat();
+    void cpuReaderCalculateLoads();
+    void memoryWatcherThresholds();
+    void memoryWatcherPressureStall();
+
+private:
+    QString copyRoot(const QString &root, QTemporaryDir *tmp);
 };
 
 tst_SystemReader::tst_SystemReader()
@@ -72,6 +83,264 @@ void tst_SystemReader::memoryReaderGroupLimit()
     QCOMPARE(value, Q_UINT64_C(524288000));
 }
 
-QTEST_APPLESS_MAIN(tst_SystemReader)
+void tst_SystemReader::unifiedMemoryReaderReadUsedValue()
+{
+    QVERIFY(!hasUnifiedCGroupHierarchy());
+    g_systemRootDir = QFINDTESTDATA("root-v2");
+    QVERIFY(hasUnifiedCGroupHierarchy());
+
+    MemoryReader memoryReader(qSL("/system.slice/run-u5853.scope"));
+    quint64 value = memoryReader.readUsedValue();
+    g_systemRootDir = QFINDTESTDATA("root");
+    QCOMPARE(value, Q_UINT64_C(66809856));
+}
+
+void tst_SystemReader::unifiedMemoryReaderGroupLimit()
+{
+    g_systemRootDir = QFINDTESTDATA("root-v2");
+
+    MemoryReader memoryReader(qSL("/system.slice/run-u5853.scope"));
+    quint64 value = memoryReader.groupLimit();
+    MemoryReader unlimitedReader(qSL("/system.slice/unlimited.scope"));
+    quint64 unlimitedValue = unlimitedReader.groupLimit();
+    g_systemRootDir = QFINDTESTDATA("root");
+
+    QCOMPARE(value, Q_UINT64_C(524288000));
+    QCOMPARE(unlimitedValue, unlimitedReader.totalValue());
+}
+
+void tst_SystemReader::controlGroupReaderParse()
+{
+    quint64 usage = 0;
+    QVERIFY(ControlGroupReader::parseCpuUsage("123456789\n", false, &usage));
+    QCOMPARE(usage, Q_UINT64_C(123456));
+    QVERIFY(ControlGroupReader::parseCpuUsage("usage_usec 42\nuser_usec 40\n", true, &usage));
+    QCOMPARE(usage, Q_UINT64_C(42));
+    QVERIFY(!ControlGroupReader::parseCpuUsage("user_usec 40\n", true, &usage));
+
+    quint64 readBytes = 0;
+    quint64 writtenBytes = 0;
+    QVERIFY(ControlGroupReader::parseIoBytes("8:0 Read 1000\n8:0 Write 200\n8:0 Sync 1200\n8:0 Async 0\n"
+                                             "8:0 Total 1200\n8:16 Read 10\n8:16 Write 2\nTotal 1212\n",
+                                             false, &readBytes, &writtenBytes));
+    QCOMPARE(readBytes, Q_UINT64_C(1010));
+    QCOMPARE(writtenBytes, Q_UINT64_C(202));
+    QVERIFY(!ControlGroupReader::parseIoBytes("", true, &readBytes, &writtenBytes));
+
+    auto mem = ControlGroupReader::parseMemory("cache 10\nrss 20\nshmem 1\ntotal_cache 100\n"
+                                               "total_rss 200\ntotal_shmem 3\n", false);
+    QCOMPARE(mem.anon, Q_UINT64_C(200));
+    QCOMPARE(mem.file, Q_UINT64_C(100));
+    QCOMPARE(mem.shmem, Q_UINT64_C(3));
+    QCOMPARE(mem.kernel, Q_UINT64_C(0));
+
+    // no "kernel" line: the sum of the individual kernel counters is used instead
+    mem = ControlGroupReader::parseMemory("anon 5\nfile 6\nkernel_stack 1\npagetables 2\nslab 3\n"
+                                          "inactive_anon 4\n", true);
+    QCOMPARE(mem.anon, Q_UINT64_C(5));
+    QCOMPARE(mem.file, Q_UINT64_C(6));
+    QCOMPARE(mem.kernel, Q_UINT64_C(6));
+}
+
+void tst_SystemReader::unifiedControlGroupReader()
+{
+    g_systemRootDir = QFINDTESTDATA("root-v2");
+
+    auto groupPaths = fetchCGroupProcessInfo(1234);
+    QCOMPARE(groupPaths.value(QByteArray()), QByteArray("/system.slice/run-u5853.scope"));
+
+    ControlGroupReader reader(groupPaths);
+    g_systemRootDir = QFINDTESTDATA("root");
+    QVERIFY(reader.isValid());
+
+    reader.update();
+    auto mem = reader.memory();
+    QCOMPARE(mem.anon, Q_UINT64_C(66809856));
+    QCOMPARE(mem.file, Q_UINT64_C(18284544));
+    QCOMPARE(mem.kernel, Q_UINT64_C(1703936));
+
+    // the counters in the test data are static, so all rates are 0
+    reader.update();
+    QCOMPARE(reader.cpuLoad(), qreal(0));
+    QCOMPARE(reader.ioReadRate(), qreal(0));
+
+    quint64 readBytes = 0;
+    quint64 writtenBytes = 0;
+    QVERIFY(ControlGroupReader::parseIoBytes("8:0 rbytes=1048576 wbytes=4096 rios=12 wios=1 dbytes=0 dios=0\n"
+                                             "259:0 rbytes=2097152 wbytes=8192 rios=20 wios=2 dbytes=0 dios=0\n",
+                                             true, &readBytes, &writtenBytes));
+    QCOMPARE(readBytes, Q_UINT64_C(3145728));
+    QCOMPARE(writtenBytes, Q_UINT64_C(12288));
+}
+
+void tst_SystemReader::cpuReaderParseProcStat()
+{
+    const QByteArray procStat = "cpu  10 1 5 100 7 2 3 4 0 0\n"
+                                "cpu0 5 0 3 50 4 1 1 2 0 0\n"
+                                "cpu1 5 1 2 50 3 1 2 2 0 0\n"
+                                "cpu2 1 1 1 1 1 1 1 1 0 0\n"
+                                "intr 12345 0 0 0\n";
+    CpuReader::Times aggregate;
+    QVector<CpuReader::Times> cores(2);
+
+    QCOMPARE(CpuReader::parseProcStat(procStat, &aggregate, &cores), 3);
+    QCOMPARE(aggregate.user, Q_UINT64_C(10));
+    QCOMPARE(aggregate.idle, Q_UINT64_C(100));
+    QCOMPARE(aggregate.iowait, Q_UINT64_C(7));
+    QCOMPARE(aggregate.steal, Q_UINT64_C(4));
+    QCOMPARE(aggregate.total(), Q_UINT64_C(132));
+    QCOMPARE(cores.at(0).steal, Q_UINT64_C(2));
+    QCOMPARE(cores.at(1).softirq, Q_UINT64_C(2));
+
+    // a truncated line is ignored
+    QCOMPARE(CpuReader::parseProcStat("cpu  10 1 5 100 7 2 3 4 0 0\ncpu0 5 0 3", &aggregate, &cores), 0);
+    QCOMPARE(CpuReader::parseProcStat("intr 1 2 3\n", &aggregate, &cores), -1);
+}
+
+void tst_SystemReader::cpuReaderCalculateLoads()
+{
+    CpuReader::Times last;
+    last.user = 100;
+    last.system = 50;
+    last.idle = 800;
+    last.iowait = 40;
+    last.irq = 5;
+    last.softirq = 5;
+
+    CpuReader::Times current = last;
+    current.user += 30;
+    current.idle += 50;
+    current.iowait += 10;
+    current.irq += 5;
+    current.steal += 5;
+
+    CpuReader::Loads loads = CpuReader::calculateLoads(last, current);
+    QCOMPARE(loads.busy, qreal(0.4));
+    QCOMPARE(loads.ioWait, qreal(0.1));
+    QCOMPARE(loads.irq, qreal(0.05));
+    QCOMPARE(loads.steal, qreal(0.05));
+
+    // iowait is allowed to decrease (see proc(5)): this must neither wrap around, nor result
+    // in negative or out-of-range loads
+    current.iowait = last.iowait - 20;
+    loads = CpuReader::calculateLoads(last, current);
+    QCOMPARE(loads.ioWait, qreal(0));
+    QCOMPARE(loads.busy, qreal(40) / qreal(90));
+    QVERIFY(loads.busy >= 0 && loads.busy <= 1);
+
+    // no ticks in between
+    loads = CpuReader::calculateLoads(last, last);
+    QCOMPARE(loads.busy, qreal(0));
+    QCOMPARE(loads.ioWait, qreal(0));
+}
+
+// the memory watcher tests modify the cgroup files, so they work on a copy of the test data
+QString tst_SystemReader::copyRoot(const QString &root, QTemporaryDir *tmp)
+{
+    const QString src = QFINDTESTDATA(root);
+    QDirIterator it(src, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString file = it.next();
+        const QString dest = tmp->path() + file.mid(src.length());
+        if (!QDir().mkpath(QFileInfo(dest).path()) || !QFile::copy(file, dest))
+            return QString();
+    }
+    return tmp->path();
+}
+
+static bool writeFile(const QString &fileName, const QByteArray &content, bool append = false)
+{
+    QFile f(fileName);
+    return f.open(append ? QFile::Append : (QFile::WriteOnly | QFile::Truncate))
+            && (f.write(content) == content.size());
+}
+
+void tst_SystemReader::memoryWatcherThresholds()
+{
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+    g_systemRootDir = copyRoot(qSL("root-v2"), &tmp);
+    QVERIFY(!g_systemRootDir.isEmpty());
+    const QString groupDir = g_systemRootDir + qSL("/sys/fs/cgroup/system.slice/run-u5853.scope");
+    QVERIFY(writeFile(groupDir + qSL("/memory.events"), "low 0\nhigh 0\nmax 0\noom 0\n"));
+
+    // 66809856 of 524288000 bytes are used, which is about 12.7%
+    MemoryWatcher watcher(nullptr);
+    watcher.setThresholds(10, 90);
+    QSignalSpy lowSpy(&watcher, &MemoryWatcher::memoryLow);
+    QSignalSpy criticalSpy(&watcher, &MemoryWatcher::memoryCritical);
+    // the copied group has no memory.pressure, so only the inotify watch on memory.events works
+    QVERIFY(watcher.startWatching(qSL("/system.slice/run-u5853.scope")));
+    g_systemRootDir = QFINDTESTDATA("root");
+
+    QVERIFY(writeFile(groupDir + qSL("/memory.events"), "high 1\n", true));
+    QTRY_COMPARE(lowSpy.count(), 1);
+    QCOMPARE(criticalSpy.count(), 0);
+
+    // the warning is only emitted once, while the consumption stays above the threshold
+    QVERIFY(writeFile(groupDir + qSL("/memory.events"), "high 2\n", true));
+    QTest::qWait(100);
+    QCOMPARE(lowSpy.count(), 1);
+
+    QVERIFY(writeFile(groupDir + qSL("/memory.stat"), "anon 500000000\n"));
+    QVERIFY(writeFile(groupDir + qSL("/memory.events"), "max 1\n", true));
+    QTRY_COMPARE(criticalSpy.count(), 1);
+    QCOMPARE(lowSpy.count(), 1);
+
+    // dropping below and crossing the threshold again warns again
+    QVERIFY(writeFile(groupDir + qSL("/memory.stat"), "anon 1000\n"));
+    watcher.checkMemoryConsumption();
+    QVERIFY(writeFile(groupDir + qSL("/memory.stat"), "anon 100000000\n"));
+    QVERIFY(writeFile(groupDir + qSL("/memory.events"), "high 3\n", true));
+    QTRY_COMPARE(lowSpy.count(), 2);
+    QCOMPARE(criticalSpy.count(), 1);
+}
+
+void tst_SystemReader::memoryWatcherPressureStall()
+{
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+    g_systemRootDir = copyRoot(qSL("root-v2"), &tmp);
+    QVERIFY(!g_systemRootDir.isEmpty());
+    const QString groupDir = g_systemRootDir + qSL("/sys/fs/cgroup/system.slice/run-u5853.scope");
+    QVERIFY(writeFile(groupDir + qSL("/memory.events"), "high 0\n"));
+
+    // the consumption of about 12.7% is below both thresholds
+    MemoryWatcher watcher(nullptr);
+    watcher.setThresholds(50, 90);
+    QSignalSpy lowSpy(&watcher, &MemoryWatcher::memoryLow);
+    QSignalSpy criticalSpy(&watcher, &MemoryWatcher::memoryCritical);
+    QVERIFY(watcher.startWatching(qSL("/system.slice/run-u5853.scope")));
+    g_systemRootDir = QFINDTESTDATA("root");
+
+    // a stall warns, even below the thresholds - but only once, while it persists
+    watcher.reportPressureStall(false);
+    QCOMPARE(lowSpy.count(), 1);
+    QCOMPARE(criticalSpy.count(), 0);
+    watcher.reportPressureStall(false);
+    watcher.checkMemoryConsumption();
+    QVERIFY(writeFile(groupDir + qSL("/memory.events"), "high 1\n", true));
+    QTest::qWait(100);
+    QCOMPARE(lowSpy.count(), 1);
+    QCOMPARE(criticalSpy.count(), 0);
+
+    watcher.reportPressureStall(true);
+    QCOMPARE(criticalSpy.count(), 1);
+    watcher.reportPressureStall(true);
+    watcher.checkMemoryConsumption();
+    QCOMPARE(criticalSpy.count(), 1);
+    QCOMPARE(lowSpy.count(), 1);
+
+    // the kernel re-triggers every 2 seconds while the stall persists: once it did not do so
+    // for a while, the stall is over and a new one warns again
+    QTest::qWait(3500);
+    watcher.checkMemoryConsumption();
+    QCOMPARE(lowSpy.count(), 1);
+    watcher.reportPressureStall(false);
+    QCOMPARE(lowSpy.count(), 2);
+    QCOMPARE(criticalSpy.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(tst_SystemReader)
 
 #include "tst_systemreader.moc"
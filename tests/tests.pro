@@ -15,12 +15,18 @@ SUBDIRS = \
     packager-tool \
     applicationinstaller \
     debugwrapper \
+    frametimer \
+    monitormodel \
+    quicklauncher \
+    datachangedcoalescer \
+    notificationimage \
     qml \
 
 linux*:SUBDIRS += \
     sudo \
     processreader \
     systemreader \
+    zygote \
 
 OTHER_FILES += \
     tests.pri \
@@ -31,6 +31,17 @@
 #include <QtTest>
 
 #include "utilities.h"
+#if defined(QT_QML_LIB)
+#  include "qml-utilities.h"
+#endif
+#include "qtyaml.h"
+#include "exception.h"
+#include "binaryconfiguration.h"
+
+#if defined(Q_OS_UNIX)
+#  include <unistd.h>
+#  include <fcntl.h>
+#endif
 
 QT_USE_NAMESPACE_AM
 
@@ -42,12 +53,532 @@ public:
     tst_Utilities();
 
 private slots:
+    void yamlParser();
+    void yamlParserFields();
+    void yamlScalars_data();
+    void yamlScalars();
+    void yamlBenchmark_data();
+    void yamlBenchmark();
+    void yamlScalarBenchmark_data();
+    void yamlScalarBenchmark();
+    void binaryConfiguration();
+    void processStartTime();
+    void qmlModuleImports();
+    void qmlModuleInImportPaths();
 };
 
 
 tst_Utilities::tst_Utilities()
 { }
 
+void tst_Utilities::yamlParser()
+{
+    QByteArray yaml =
+            "formatVersion: 1\n"
+            "formatType: test\n"
+            "---\n"
+            "string: 'quoted'\n"
+            "plain: text\n"
+            "int: 42\n"
+            "hex: 0x2a\n"
+            "double: 4.2\n"
+            "bool: yes\n"
+            "nothing: ~\n"
+            "list: [ 1, two, &anchor { three: 3 } ]\n"
+            "alias: *anchor\n";
+
+    QVector<QVariant> docs;
+    try {
+        docs = YamlParser::parseAllDocuments(yaml);
+    } catch (const Exception &e) {
+        QFAIL(qPrintable(e.errorString()));
+    }
+
+    // the streaming parser has to produce exactly the same result as the document based one
+    QCOMPARE(docs, QtYaml::variantDocumentsFromYaml(yaml));
+    QCOMPARE(docs.size(), 2);
+
+    const QVariantMap map = docs.at(1).toMap();
+    QCOMPARE(map.value(qSL("string")), QVariant(qSL("quoted")));
+    QCOMPARE(map.value(qSL("int")), QVariant(42));
+    QCOMPARE(map.value(qSL("hex")), QVariant(42));
+    QCOMPARE(map.value(qSL("double")), QVariant(4.2));
+    QCOMPARE(map.value(qSL("bool")), QVariant(true));
+    QVERIFY(!map.value(qSL("nothing")).isValid());
+    QCOMPARE(map.value(qSL("alias")), QVariant(QVariantMap { { qSL("three"), 3 } }));
+
+    YamlParser p("[ 1");
+    QVERIFY_EXCEPTION_THROWN(p.nextDocument() && p.parseVariant().isValid(), Exception);
+}
+
+void tst_Utilities::yamlParserFields()
+{
+    QByteArray yaml =
+            "formatVersion: 2\n"
+            "formatType: test\n"
+            "---\n"
+            "name: foo\n"
+            "version: 1.10\n"
+            "empty: ~\n"
+            "list: single\n"
+            "map: { a: 1, b: 2 }\n";
+
+    QString name, version, empty = qSL("not-null");
+    QStringList list;
+    QVariantMap map;
+
+    YamlParser::Fields fields;
+    fields.emplace_back("name", true, YamlParser::Scalar, [&name](YamlParser *p) { name = p->parseString(); });
+    fields.emplace_back("version", true, YamlParser::Scalar, [&version](YamlParser *p) { version = p->parseString(); });
+    fields.emplace_back("empty", false, YamlParser::Scalar, [&empty](YamlParser *p) { empty = p->parseString(); });
+    fields.emplace_back("list", false, YamlParser::Scalar | YamlParser::List, [&list](YamlParser *p) {
+        list = p->parseStringOrStringList(); });
+    fields.emplace_back("map", false, YamlParser::Map, [&map](YamlParser *p) { map = p->parseMap(); });
+
+    try {
+        YamlParser p(yaml);
+        auto header = p.parseHeader();
+        QCOMPARE(header.first, qSL("test"));
+        QCOMPARE(header.second, 2);
+        QVERIFY(p.nextDocument());
+        p.parseFields(fields);
+        QVERIFY(!p.nextDocument());
+    } catch (const Exception &e) {
+        QFAIL(qPrintable(e.errorString()));
+    }
+
+    QCOMPARE(name, qSL("foo"));
+    QCOMPARE(version, qSL("1.10"));
+    QVERIFY(empty.isNull());
+    QCOMPARE(list, QStringList { qSL("single") });
+    QCOMPARE(map.size(), 2);
+
+    // unsupported field
+    YamlParser p1("name: foo\nunknown: bar\n");
+    QVERIFY(p1.nextDocument());
+    QVERIFY_EXCEPTION_THROWN(p1.parseFields(fields), Exception);
+
+    // missing required field
+    YamlParser p2("name: foo\n");
+    QVERIFY(p2.nextDocument());
+    QVERIFY_EXCEPTION_THROWN(p2.parseFields(fields), Exception);
+
+    // wrong type
+    YamlParser p3("name: [ foo ]\nversion: 1\n");
+    QVERIFY(p3.nextDocument());
+    QVERIFY_EXCEPTION_THROWN(p3.parseFields(fields), Exception);
+
+    // null values are accepted as empty maps, but quoted empty strings are not
+    map = QVariantMap { { qSL("x"), 1 } };
+    YamlParser p4("name: foo\nversion: 1\nmap:\n");
+    QVERIFY(p4.nextDocument());
+    try {
+        p4.parseFields(fields);
+    } catch (const Exception &e) {
+        QFAIL(qPrintable(e.errorString()));
+    }
+    QVERIFY(map.isEmpty());
+
+    YamlParser p5("name: foo\nversion: 1\nmap: ''\n");
+    QVERIFY(p5.nextDocument());
+    QVERIFY_EXCEPTION_THROWN(p5.parseFields(fields), Exception);
+}
+
+void tst_Utilities::yamlScalars_data()
+{
+    QTest::addColumn<QByteArray>("yaml");
+    QTest::addColumn<QVariant>("value");
+
+    QTest::newRow("null-empty") << QByteArray("") << QVariant();
+    QTest::newRow("null-tilde") << QByteArray("~") << QVariant();
+    QTest::newRow("null-word") << QByteArray("Null") << QVariant();
+    QTest::newRow("true-y") << QByteArray("y") << QVariant(true);
+    QTest::newRow("true-on") << QByteArray("ON") << QVariant(true);
+    QTest::newRow("false-no") << QByteArray("no") << QVariant(false);
+    QTest::newRow("false-word") << QByteArray("False") << QVariant(false);
+    QTest::newRow("not-bool") << QByteArray("oN") << QVariant(qSL("oN"));
+    QTest::newRow("inf") << QByteArray(".Inf") << QVariant(qInf());
+    QTest::newRow("decimal") << QByteArray("1_000") << QVariant(1000);
+    QTest::newRow("negative") << QByteArray("-42") << QVariant(-42);
+    QTest::newRow("zero") << QByteArray("0") << QVariant(0);
+    QTest::newRow("binary") << QByteArray("-0b101") << QVariant(-5);
+    QTest::newRow("octal") << QByteArray("017") << QVariant(15);
+    QTest::newRow("hex") << QByteArray("0xfF") << QVariant(255);
+    QTest::newRow("int64") << QByteArray("4294967296") << QVariant(Q_INT64_C(4294967296));
+    QTest::newRow("negative-int64") << QByteArray("-2147483649") << QVariant(Q_INT64_C(-2147483649));
+    QTest::newRow("uint64") << QByteArray("18446744073709551615") << QVariant(Q_UINT64_C(18446744073709551615));
+    QTest::newRow("overflow") << QByteArray("18446744073709551616") << QVariant(qSL("18446744073709551616"));
+    QTest::newRow("float") << QByteArray("1_0.5") << QVariant(10.5);
+    QTest::newRow("float-dot") << QByteArray(".5") << QVariant(0.5);
+    QTest::newRow("float-exp") << QByteArray("1.5e+2") << QVariant(150.);
+    QTest::newRow("float-leading-0") << QByteArray("01.5") << QVariant(1.5);
+    QTest::newRow("not-octal") << QByteArray("08") << QVariant(qSL("08"));
+    QTest::newRow("not-binary") << QByteArray("0b_") << QVariant(qSL("0b_"));
+    QTest::newRow("not-float") << QByteArray("1.5e2") << QVariant(qSL("1.5e2"));
+    QTest::newRow("dot") << QByteArray(".") << QVariant(qSL("."));
+    QTest::newRow("version") << QByteArray("1.2.3") << QVariant(qSL("1.2.3"));
+    QTest::newRow("quoted") << QByteArray("'42'") << QVariant(qSL("42"));
+}
+
+void tst_Utilities::yamlScalars()
+{
+    QFETCH(QByteArray, yaml);
+    QFETCH(QVariant, value);
+
+    const QVariant treeValue = QtYaml::variantDocumentsFromYaml("value: " + yaml).value(0).toMap().value(qSL("value"));
+    const QVariant streamValue = YamlParser::parseAllDocuments("value: " + yaml).value(0).toMap().value(qSL("value"));
+
+    QCOMPARE(treeValue, value);
+    QCOMPARE(streamValue, value);
+}
+
+void tst_Utilities::yamlBenchmark_data()
+{
+    QTest::addColumn<QByteArray>("yaml");
+    QTest::addColumn<bool>("streaming");
+
+    // a manifest with lots of applications and intents
+    QByteArray manifest = "formatVersion: 1\nformatType: am-package\n---\n"
+                          "id: com.example.benchmark\nicon: icon.png\n"
+                          "name: { en: 'Benchmark', de: 'Benchmark' }\n"
+                          "applications:\n";
+    for (int i = 0; i < 500; ++i) {
+        manifest += "- id: com.example.benchmark.app" + QByteArray::number(i) + "\n"
+                    "  code: main.qml\n"
+                    "  runtime: qml\n"
+                    "  supportsApplicationInterface: yes\n"
+                    "  capabilities: [ cameraAccess, locationAccess ]\n"
+                    "  runtimeParameters: { loadDummyData: true, importPaths: [ imports ] }\n"
+                    "  applicationProperties: { protected: { level: " + QByteArray::number(i) + ", ratio: 0.5 } }\n";
+    }
+    manifest += "intents:\n";
+    for (int i = 0; i < 500; ++i) {
+        manifest += "- id: intent" + QByteArray::number(i) + "\n"
+                    "  handlingApplicationId: com.example.benchmark.app" + QByteArray::number(i) + "\n"
+                    "  visibility: public\n"
+                    "  parameterMatch: { mimeType: '^image/.*$', size: 0x100 }\n";
+    }
+
+    // a config file with lots of scalars
+    QByteArray config = "formatVersion: 1\nformatType: am-configuration\n---\n"
+                        "systemProperties:\n  public:\n";
+    for (int i = 0; i < 5000; ++i) {
+        config += "    property" + QByteArray::number(i) + ": { enabled: on, count: "
+                + QByteArray::number(i) + ", factor: " + QByteArray::number(i) + ".5, name: 'p"
+                + QByteArray::number(i) + "', mode: default }\n";
+    }
+
+    QTest::newRow("manifest-tree") << manifest << false;
+    QTest::newRow("manifest-streaming") << manifest << true;
+    QTest::newRow("config-tree") << config << false;
+    QTest::newRow("config-streaming") << config << true;
+}
+
+void tst_Utilities::yamlBenchmark()
+{
+    QFETCH(QByteArray, yaml);
+    QFETCH(bool, streaming);
+
+    QVector<QVariant> docs;
+    QBENCHMARK {
+        docs = streaming ? YamlParser::parseAllDocuments(yaml)
+                         : QtYaml::variantDocumentsFromYaml(yaml);
+    }
+    QCOMPARE(docs.size(), 2);
+}
+
+// The scalar conversion as it was done before: a bsearch over the special values and a
+// sequence of regular expressions for everything that might be a number.
+static QVariant legacyConvertPlainScalarToVariant(const QByteArray &ba)
+{
+    enum ValueIndex {
+        ValueNull,
+        ValueTrue,
+        ValueFalse,
+        ValueNaN,
+        ValueInf
+    };
+
+    struct StaticMapping
+    {
+        const char *text;
+        ValueIndex index;
+    };
+
+    static QVariant staticValues[] = {
+        QVariant(),                    // ValueNull
+        QVariant(true),                // ValueTrue
+        QVariant(false),               // ValueFalse
+        QVariant(qQNaN()),             // ValueNaN
+        QVariant(qInf()),              // ValueInf
+    };
+
+    static const StaticMapping staticMappings[] = { // keep this sorted for bsearch !!
+        { "",      ValueNull },
+        { ".INF",  ValueInf },
+        { ".Inf",  ValueInf },
+        { ".NAN",  ValueNaN },
+        { ".NaN",  ValueNaN },
+        { ".inf",  ValueInf },
+        { ".nan",  ValueNaN },
+        { "FALSE", ValueFalse },
+        { "False", ValueFalse },
+        { "N",     ValueFalse },
+        { "NO",    ValueFalse },
+        { "NULL",  ValueNull },
+        { "No",    ValueFalse },
+        { "Null",  ValueNull },
+        { "OFF",   ValueFalse },
+        { "Off",   ValueFalse },
+        { "ON",    ValueTrue },
+        { "On",    ValueTrue },
+        { "TRUE",  ValueTrue },
+        { "True",  ValueTrue },
+        { "Y",     ValueTrue },
+        { "YES",   ValueTrue },
+        { "Yes",   ValueTrue },
+        { "false", ValueFalse },
+        { "n",     ValueFalse },
+        { "no",    ValueFalse },
+        { "null",  ValueNull },
+        { "off",   ValueFalse },
+        { "on",    ValueTrue },
+        { "true",  ValueTrue },
+        { "y",     ValueTrue },
+        { "yes",   ValueTrue },
+        { "~",     ValueNull }
+    };
+
+    static const char *firstCharStaticMappings = ".FNOTYfnoty~";
+    char firstChar = ba.isEmpty() ? 0 : ba.at(0);
+
+    if (strchr(firstCharStaticMappings, firstChar)) { // cheap check to avoid expensive bsearch
+        StaticMapping key { ba.constData(), ValueNull };
+        auto found = bsearch(&key,
+                             staticMappings,
+                             sizeof(staticMappings)/sizeof(staticMappings[0]),
+                sizeof(staticMappings[0]),
+                [](const void *m1, const void *m2) {
+            return strcmp(static_cast<const StaticMapping *>(m1)->text,
+                          static_cast<const StaticMapping *>(m2)->text); });
+
+        if (found)
+            return staticValues[static_cast<StaticMapping *>(found)->index];
+    }
+
+    QString str = QString::fromUtf8(ba);
+
+    if ((firstChar >= '0' && firstChar <= '9')   // cheap check to avoid expensive regexps
+            || firstChar == '+' || firstChar == '-' || firstChar == '.') {
+        static const QRegExp numberRegExps[] = {
+            QRegExp(qSL("[-+]?0b[0-1_]+")),        // binary
+            QRegExp(qSL("[-+]?0x[0-9a-fA-F_]+")),  // hexadecimal
+            QRegExp(qSL("[-+]?0[0-7_]+")),         // octal
+            QRegExp(qSL("[-+]?(0|[1-9][0-9_]*)")), // decimal
+            QRegExp(qSL("[-+]?([0-9][0-9_]*)?\\.[0-9.]*([eE][-+][0-9]+)?")), // float
+            QRegExp()
+        };
+
+        for (int numberIndex = 0; !numberRegExps[numberIndex].isEmpty(); ++numberIndex) {
+            if (numberRegExps[numberIndex].exactMatch(str)) {
+                bool ok = false;
+                QVariant val;
+
+                // YAML allows _ as a grouping separator
+                if (str.contains(qL1C('_')))
+                    str = str.replace(qL1C('_'), qSL(""));
+
+                if (numberIndex == 4) {
+                    val = str.toDouble(&ok);
+                } else {
+                    int base = 10;
+
+                    switch (numberIndex) {
+                    case 0: base = 2; str.replace(qSL("0b"), qSL("")); break; // Qt chokes on 0b
+                    case 1: base = 16; break;
+                    case 2: base = 8; break;
+                    case 3: base = 10; break;
+                    }
+
+                    qint64 s64 = str.toLongLong(&ok, base);
+                    if (ok && (s64 <= std::numeric_limits<qint32>::max())) {
+                        val = qint32(s64);
+                    } else if (ok) {
+                        val = s64;
+                    } else {
+                        quint64 u64 = str.toULongLong(&ok, base);
+
+                        if (ok && (u64 <= std::numeric_limits<quint32>::max()))
+                            val = quint32(u64);
+                        else if (ok)
+                            val = u64;
+                    }
+                }
+                if (ok)
+                    return val;
+            }
+        }
+    }
+    return str;
+}
+
+void tst_Utilities::yamlScalarBenchmark_data()
+{
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("legacy") << true;
+    QTest::newRow("current") << false;
+}
+
+void tst_Utilities::yamlScalarBenchmark()
+{
+    QFETCH(bool, legacy);
+
+    // roughly the mix of plain scalars found in manifests and config files: mostly strings,
+    // followed by booleans, small integers and a few floats and special values
+    static const QVector<QByteArray> scalars = {
+        "main.qml", "qml", "native", "com.example.app", "icon.png", "cameraAccess",
+        "locationAccess", "public", "default", "en", "de_DE", "image/png", "^image/.*$",
+        "/opt/am/apps", "16:9", "1.2.3", "-", "yes", "no", "true", "false", "on", "off",
+        "~", "", "0", "1", "42", "-1", "100", "1_000", "0x100", "0755", "0b101", "0.5",
+        "1.10", "-2.5", "2.5e+3", ".inf"
+    };
+
+    // the results need to be the same
+    for (const QByteArray &scalar : scalars)
+        QCOMPARE(QtYaml::convertPlainScalarToVariant(scalar), legacyConvertPlainScalarToVariant(scalar));
+
+    QBENCHMARK {
+        for (const QByteArray &scalar : scalars) {
+            QVariant v = legacy ? legacyConvertPlainScalarToVariant(scalar)
+                                : QtYaml::convertPlainScalarToVariant(scalar);
+            Q_UNUSED(v)
+        }
+    }
+}
+
+void tst_Utilities::binaryConfiguration()
+{
+    const QVariantMap config = {
+        { qSL("baseDir"), qSL("/opt/am") },
+        { qSL("logging"), QVariantMap { { qSL("dlt"), false },
+                                        { qSL("rules"), QStringList { qSL("*=false"), qSL("am.*=true") } } } },
+        { qSL("runtimeConfiguration"), QVariantMap { { qSL("quicklaunchQml"), qSL("ql.qml") },
+                                                     { qSL("importPaths"), QVariantList { qSL("a"), qSL("b") } },
+                                                     { qSL("scale"), 1.5 } } },
+        { qSL("securityToken"), qSL("0123456789abcdef") }
+    };
+
+    QByteArray data = BinaryConfiguration::serialize(config);
+    QCOMPARE(BinaryConfiguration::deserialize(data), config);
+
+    QVERIFY_EXCEPTION_THROWN(BinaryConfiguration::deserialize("YAML"), Exception);
+    QVERIFY_EXCEPTION_THROWN(BinaryConfiguration::deserialize(data.left(data.size() / 2)), Exception);
+    data[5] = 42; // the version
+    QVERIFY_EXCEPTION_THROWN(BinaryConfiguration::deserialize(data), Exception);
+
+#if defined(Q_OS_LINUX)
+    int fd = BinaryConfiguration::createFileDescriptor(config);
+    if (fd < 0)
+        QSKIP("memfds are not supported on this system");
+    QVERIFY(fcntl(fd, F_GETFD) & FD_CLOEXEC);
+    QCOMPARE(::write(fd, "x", 1), ssize_t(-1)); // sealed
+    QCOMPARE(BinaryConfiguration::readFileDescriptor(fd), config);
+    // a second reader gets the same result
+    QCOMPARE(BinaryConfiguration::readFileDescriptor(fd), config);
+    ::close(fd);
+#endif
+}
+
+void tst_Utilities::processStartTime()
+{
+#if defined(Q_OS_LINUX)
+    qint64 pid = QCoreApplication::applicationPid();
+    quint64 startTime = getProcessStartTime(pid);
+    QVERIFY(startTime > 0);
+    QCOMPARE(getProcessStartTime(pid), startTime);
+    QVERIFY(getProcessStartTime(getParentPid(pid)) <= startTime);
+    QCOMPARE(getProcessStartTime(-1), quint64(0));
+
+    qint64 ppid = 0;
+    quint64 statStartTime = 0;
+    QVERIFY(getProcessStat(pid, &ppid, &statStartTime));
+    QCOMPARE(ppid, getParentPid(pid));
+    QCOMPARE(statStartTime, startTime);
+    QVERIFY(!getProcessStat(-1, &ppid, &statStartTime));
+    QCOMPARE(ppid, qint64(0));
+    QCOMPARE(statStartTime, quint64(0));
+#else
+    QSKIP("process start times are only supported on Linux");
+#endif
+}
+
+void tst_Utilities::qmlModuleImports()
+{
+#if defined(QT_QML_LIB)
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+
+    const QString qmlFile = tmp.path() + qSL("/main.qml");
+    QFile f(qmlFile);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write("/* a comment\n"
+            "   import Commented 1.0\n"
+            "*/\n"
+            "pragma Singleton\n"
+            "import QtQuick 2.11\n"
+            "import QtQuick.Window 2.2 as W // a trailing comment\n"
+            "import \"components\"\n"
+            "import \"logic.js\" as Logic\n"
+            "// import LineCommented 1.0\n"
+            "\n"
+            "import shared.Module 1.0;\n"
+            "\n"
+            "Item {\n"
+            "}\n"
+            "import AfterHeader 1.0\n");
+    f.close();
+
+    QCOMPARE(QT_PREPEND_NAMESPACE_AM(qmlModuleImports)(qmlFile),
+             QStringList({ qSL("QtQuick 2.11"), qSL("QtQuick.Window 2.2"), qSL("shared.Module 1.0") }));
+    QVERIFY(QT_PREPEND_NAMESPACE_AM(qmlModuleImports)(tmp.path() + qSL("/missing.qml")).isEmpty());
+#else
+    QSKIP("the QML import parser is only available when building with QtQml");
+#endif
+}
+
+void tst_Utilities::qmlModuleInImportPaths()
+{
+#if defined(QT_QML_LIB)
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+
+    const QStringList qmldirs = { qSL("a/Plain/Module/qmldir"), qSL("b/Versioned/Module.2/qmldir"),
+                                  qSL("b/Partial.1/Module/qmldir"), qSL("b/Full/Module.1.5/qmldir") };
+    for (const QString &qmldir : qmldirs) {
+        QVERIFY(QDir(tmp.path()).mkpath(QFileInfo(qmldir).path()));
+        QFile f(tmp.path() + qL1C('/') + qmldir);
+        QVERIFY(f.open(QIODevice::WriteOnly));
+    }
+    // a directory without a qmldir file is not a module
+    QVERIFY(QDir(tmp.path()).mkpath(qSL("a/NoQmldir")));
+
+    const QStringList importPaths = { tmp.path() + qSL("/a"), tmp.path() + qSL("/b") };
+
+    QVERIFY(isQmlModuleInImportPaths(qSL("Plain.Module"), qSL("1.0"), importPaths));
+    QVERIFY(isQmlModuleInImportPaths(qSL("Versioned.Module"), qSL("2.3"), importPaths));
+    QVERIFY(!isQmlModuleInImportPaths(qSL("Versioned.Module"), qSL("1.0"), importPaths));
+    QVERIFY(isQmlModuleInImportPaths(qSL("Partial.Module"), qSL("1.0"), importPaths));
+    QVERIFY(isQmlModuleInImportPaths(qSL("Full.Module"), qSL("1.5"), importPaths));
+    QVERIFY(!isQmlModuleInImportPaths(qSL("Full.Module"), qSL("1.4"), importPaths));
+    QVERIFY(!isQmlModuleInImportPaths(qSL("NoQmldir"), qSL("1.0"), importPaths));
+    QVERIFY(!isQmlModuleInImportPaths(qSL("Plain.Module"), qSL("1.0"), { tmp.path() + qSL("/b") }));
+    QVERIFY(!isQmlModuleInImportPaths(qSL("Plain.Module"), qSL("1.0"), QStringList()));
+#else
+    QSKIP("the QML import lookup is only available when building with QtQml");
+#endif
+}
+
 QTEST_APPLESS_MAIN(tst_Utilities)
 
 #include "tst_utilities.moc"
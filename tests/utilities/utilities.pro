@@ -3,5 +3,6 @@ TARGET = tst_utilities
 include($$PWD/../tests.pri)
 
 QT *= appman_common-private
+qtHaveModule(qml):QT *= qml
 
 SOURCES += tst_utilities.cpp
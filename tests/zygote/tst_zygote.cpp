@@ -0,0 +1,174 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Luxoft Sweden AB
+** Copyright (C) 2018 Pelagicore AG
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Application Manager.
+**
+** $QT_BEGIN_LICENSE:LGPL-QTAS$
+** Commercial License Usage
+** Licensees holding valid commercial Qt Automotive Suite licenses may use
+** this file in accordance with the commercial license agreement provided
+** with the Software or, alternatively, in accordance with the terms
+** contained in a written agreement between you and The Qt Company.  For
+** licensing terms and conditions see https://www.qt.io/terms-conditions.
+** For further information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+** SPDX-License-Identifier: LGPL-3.0
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtTest>
+
+#include <csignal>
+#include <unistd.h>
+
+#include "global.h"
+#include "amnamespace.h"
+#include "binaryconfiguration.h"
+#include "processcontainer.h"
+#include "zygote.h"
+
+QT_USE_NAMESPACE_AM
+
+// This test executable doubles as the launcher: started with AM_ZYGOTE_FD it acts as a zygote
+// and the forked children run childMain() instead of the test functions.
+static const char *ChildArgument = "--zygote-child";
+static const char *SleepArgument = "--sleep";
+
+static int childMain(int argc, char *argv[])
+{
+    if (argc == 4 && qstrcmp(argv[3], SleepArgument) == 0) {
+        ::sleep(30);
+        return 0;
+    }
+
+    // the exit code tells the test which check failed
+    if (argc != 3 || qgetenv("ZYGOTE_TEST") != "child")
+        return 10;
+    if (QDir::currentPath() != QDir(QString::fromLocal8Bit(argv[2])).canonicalPath())
+        return 11;
+    if (qEnvironmentVariableIsSet("AM_ZYGOTE_FD"))
+        return 12;
+
+    bool ok;
+    int configFd = qEnvironmentVariableIntValue("AM_CONFIG_FD", &ok);
+    if (!ok)
+        return 13;
+    try {
+        const QVariantMap config = BinaryConfiguration::readFileDescriptor(configFd);
+        ::close(configFd);
+        return config.value(qSL("exitCode"), 14).toInt();
+    } catch (...) {
+        return 15;
+    }
+}
+
+class tst_Zygote : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_Zygote();
+
+private slots:
+    void initTestCase();
+    void fork();
+    void exitStatus();
+};
+
+tst_Zygote::tst_Zygote()
+{ }
+
+void tst_Zygote::initTestCase()
+{
+    qRegisterMetaType<Am::ExitStatus>();
+}
+
+void tst_Zygote::fork()
+{
+    // the zygote is started with the same environment, so it needs e.g. LD_LIBRARY_PATH as well
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(qSL("ZYGOTE_TEST"), qSL("child"));
+    const QString workingDirectory = QDir::tempPath();
+
+    // two children in a row, so that the second one is forked by the already running zygote
+    for (int exitCode : { 42, 43 }) {
+        ZygoteProcess process;
+        QSignalSpy startedSpy(&process, &AbstractContainerProcess::started);
+        QSignalSpy finishedSpy(&process, &AbstractContainerProcess::finished);
+
+        int configFd = BinaryConfiguration::createFileDescriptor({ { qSL("exitCode"), exitCode } });
+        QVERIFY(configFd >= 0);
+        bool started = process.start(QCoreApplication::applicationFilePath(),
+                                     { qL1S(ChildArgument), workingDirectory },
+                                     env, workingDirectory, QStringList(), configFd);
+        ::close(configFd);
+        QVERIFY(started);
+        QCOMPARE(process.state(), Am::StartingUp);
+
+        QTRY_COMPARE(startedSpy.count(), 1);
+        QVERIFY(process.processId() > 0);
+        QVERIFY(process.processId() != QCoreApplication::applicationPid());
+
+        QTRY_COMPARE(finishedSpy.count(), 1);
+        QCOMPARE(finishedSpy.at(0).at(0).toInt(), exitCode);
+        QCOMPARE(finishedSpy.at(0).at(1).value<Am::ExitStatus>(), Am::NormalExit);
+        QCOMPARE(process.state(), Am::NotRunning);
+    }
+}
+
+void tst_Zygote::exitStatus()
+{
+    ZygoteProcess process;
+    QSignalSpy startedSpy(&process, &AbstractContainerProcess::started);
+    QSignalSpy finishedSpy(&process, &AbstractContainerProcess::finished);
+
+    QVERIFY(process.start(QCoreApplication::applicationFilePath(),
+                          { qL1S(ChildArgument), QDir::tempPath(), qL1S(SleepArgument) },
+                          QProcessEnvironment::systemEnvironment(), QDir::tempPath(), QStringList()));
+    QTRY_COMPARE(startedSpy.count(), 1);
+    QCOMPARE(process.state(), Am::Running);
+    process.kill();
+
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QCOMPARE(finishedSpy.at(0).at(0).toInt(), SIGKILL);
+    QCOMPARE(finishedSpy.at(0).at(1).value<Am::ExitStatus>(), Am::CrashExit);
+}
+
+int main(int argc, char *argv[])
+{
+    // only returns in the forked children, if started as a zygote
+    Zygote::runIfRequested(argc, argv);
+    if (argc > 1 && qstrcmp(argv[1], ChildArgument) == 0)
+        return childMain(argc, argv);
+
+    QCoreApplication a(argc, argv);
+    tst_Zygote tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "tst_zygote.moc"
@@ -0,0 +1,14 @@
+TARGET = tst_zygote
+
+include($$PWD/../tests.pri)
+
+requires(qtHaveModule(qml):qtHaveModule(dbus))
+
+QT *= \
+    appman_common-private \
+    appman_manager-private \
+    appman_launcher-private \
+
+LIBS *= -ldl
+
+SOURCES += tst_zygote.cpp